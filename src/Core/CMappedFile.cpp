@@ -0,0 +1,119 @@
+#include "CMappedFile.h"
+#include <Common/Log.h>
+
+#if WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+CMappedFile::CMappedFile()
+    : mpkData(nullptr)
+    , mSize(0)
+#if WIN32
+    , mFileHandle(INVALID_HANDLE_VALUE)
+    , mMappingHandle(nullptr)
+#else
+    , mFileDescriptor(-1)
+#endif
+{}
+
+CMappedFile::CMappedFile(const TString& rkPath)
+    : CMappedFile()
+{
+    Open(rkPath);
+}
+
+CMappedFile::~CMappedFile()
+{
+    Close();
+}
+
+bool CMappedFile::Open(const TString& rkPath)
+{
+    Close();
+    mPath = rkPath;
+
+#if WIN32
+    mFileHandle = CreateFileA(*rkPath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (mFileHandle == INVALID_HANDLE_VALUE)
+    {
+        errorf("Failed to open file for mapping: %s", *rkPath);
+        return false;
+    }
+
+    LARGE_INTEGER FileSize;
+    GetFileSizeEx(mFileHandle, &FileSize);
+    mSize = (uint32) FileSize.QuadPart;
+
+    if (mSize > 0)
+    {
+        mMappingHandle = CreateFileMappingA(mFileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+        if (mMappingHandle)
+            mpkData = (const uint8*) MapViewOfFile(mMappingHandle, FILE_MAP_READ, 0, 0, 0);
+    }
+#else
+    mFileDescriptor = open(*rkPath, O_RDONLY);
+
+    if (mFileDescriptor == -1)
+    {
+        errorf("Failed to open file for mapping: %s", *rkPath);
+        return false;
+    }
+
+    struct stat FileStat;
+    fstat(mFileDescriptor, &FileStat);
+    mSize = (uint32) FileStat.st_size;
+
+    if (mSize > 0)
+    {
+        void *pMapping = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, mFileDescriptor, 0);
+
+        if (pMapping != MAP_FAILED)
+            mpkData = (const uint8*) pMapping;
+    }
+#endif
+
+    if (!mpkData)
+    {
+        errorf("Failed to map file: %s", *rkPath);
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void CMappedFile::Close()
+{
+#if WIN32
+    if (mpkData)
+        UnmapViewOfFile(mpkData);
+
+    if (mMappingHandle)
+        CloseHandle(mMappingHandle);
+
+    if (mFileHandle != INVALID_HANDLE_VALUE)
+        CloseHandle(mFileHandle);
+
+    mMappingHandle = nullptr;
+    mFileHandle = INVALID_HANDLE_VALUE;
+#else
+    if (mpkData)
+        munmap((void*) mpkData, mSize);
+
+    if (mFileDescriptor != -1)
+        close(mFileDescriptor);
+
+    mFileDescriptor = -1;
+#endif
+
+    mpkData = nullptr;
+    mSize = 0;
+}
@@ -0,0 +1,43 @@
+#ifndef CMAPPEDFILE_H
+#define CMAPPEDFILE_H
+
+#include <Common/BasicTypes.h>
+#include <Common/TString.h>
+
+/**
+ * Read-only memory mapping of a file on disk. The mapped data stays valid until
+ * the mapping is closed, and since it is never written to, it can be read from
+ * any number of threads at once.
+ */
+class CMappedFile
+{
+    TString mPath;
+    const uint8 *mpkData;
+    uint32 mSize;
+
+#if WIN32
+    void *mFileHandle;
+    void *mMappingHandle;
+#else
+    int mFileDescriptor;
+#endif
+
+public:
+    CMappedFile();
+    explicit CMappedFile(const TString& rkPath);
+    ~CMappedFile();
+
+    bool Open(const TString& rkPath);
+    void Close();
+
+    CMappedFile(const CMappedFile&) = delete;
+    CMappedFile& operator=(const CMappedFile&) = delete;
+
+    // Accessors
+    inline bool IsValid() const         { return mpkData != nullptr; }
+    inline TString Path() const         { return mPath; }
+    inline const uint8* Data() const    { return mpkData; }
+    inline uint32 Size() const          { return mSize; }
+};
+
+#endif // CMAPPEDFILE_H
@@ -22,6 +22,7 @@ public:
     CRayCollisionTester(const CRay& rkRay);
     ~CRayCollisionTester();
     const CRay& Ray() const { return mRay; }
+    uint32 NumBoxIntersections() const { return mBoxIntersectList.size(); }
 
     void AddNode(CSceneNode *pNode, uint32 AssetIndex, float Distance);
     void AddNodeModel(CSceneNode *pNode, CBasicModel *pModel);
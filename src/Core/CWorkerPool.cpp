@@ -0,0 +1,110 @@
+#include "CWorkerPool.h"
+#include <Common/Math/MathUtil.h>
+#include <atomic>
+#include <chrono>
+
+CWorkerPool::CWorkerPool(uint NumThreads /*= 0*/)
+    : mNumRunningJobs(0)
+    , mShuttingDown(false)
+{
+    if (NumThreads == 0)
+        NumThreads = DefaultThreadCount();
+
+    mThreads.reserve(NumThreads);
+
+    for (uint ThreadIdx = 0; ThreadIdx < NumThreads; ThreadIdx++)
+        mThreads.emplace_back(&CWorkerPool::WorkerMain, this);
+}
+
+CWorkerPool::~CWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> Lock(mMutex);
+        mShuttingDown = true;
+    }
+    mJobAvailable.notify_all();
+
+    for (std::thread& rThread : mThreads)
+        rThread.join();
+}
+
+void CWorkerPool::AddJob(std::function<void()> Job)
+{
+    {
+        std::lock_guard<std::mutex> Lock(mMutex);
+        mJobs.push( std::move(Job) );
+    }
+    mJobAvailable.notify_one();
+}
+
+void CWorkerPool::WaitForAll()
+{
+    std::unique_lock<std::mutex> Lock(mMutex);
+    mJobsFinished.wait(Lock, [this]() { return IsIdle(); });
+}
+
+bool CWorkerPool::WaitForAll(uint TimeoutMs)
+{
+    // Returns whether all jobs are finished. This allows the calling thread to wake up
+    // periodically to do things like report progress while the workers are busy.
+    std::unique_lock<std::mutex> Lock(mMutex);
+    return mJobsFinished.wait_for(Lock, std::chrono::milliseconds(TimeoutMs), [this]() { return IsIdle(); });
+}
+
+void CWorkerPool::ParallelFor(uint NumItems, const std::function<void(uint)>& rkFunc)
+{
+    // Runs rkFunc once for every index in [0, NumItems) and blocks until they have all finished.
+    // Indices are handed out dynamically, so items don't need to take the same amount of time.
+    // Must not be called from a job running on this pool, since it waits for the pool to go idle.
+    if (NumItems == 0) return;
+
+    std::atomic<uint> NextItem(0);
+    uint NumJobs = Math::Min(NumThreads(), NumItems);
+
+    for (uint JobIdx = 0; JobIdx < NumJobs; JobIdx++)
+    {
+        AddJob([&NextItem, NumItems, &rkFunc]()
+        {
+            for (uint ItemIdx = NextItem++; ItemIdx < NumItems; ItemIdx = NextItem++)
+                rkFunc(ItemIdx);
+        });
+    }
+
+    WaitForAll();
+}
+
+uint CWorkerPool::DefaultThreadCount()
+{
+    uint NumCores = std::thread::hardware_concurrency();
+    return (NumCores > 0 ? NumCores : 1);
+}
+
+void CWorkerPool::WorkerMain()
+{
+    while (true)
+    {
+        std::function<void()> Job;
+
+        {
+            std::unique_lock<std::mutex> Lock(mMutex);
+            mJobAvailable.wait(Lock, [this]() { return mShuttingDown || !mJobs.empty(); });
+
+            if (mJobs.empty())
+                return;
+
+            Job = std::move(mJobs.front());
+            mJobs.pop();
+            mNumRunningJobs++;
+        }
+
+        Job();
+
+        {
+            std::lock_guard<std::mutex> Lock(mMutex);
+            mNumRunningJobs--;
+
+            if (IsIdle())
+                mJobsFinished.notify_all();
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef CWORKERPOOL_H
+#define CWORKERPOOL_H
+
+#include <Common/BasicTypes.h>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed-size pool of worker threads. Jobs are run in the order they are queued,
+ * but may finish in any order; callers that need ordered output should write
+ * results into preallocated slots and consume them after WaitForAll().
+ * Jobs must not touch gpResourceStore or any other non-thread-safe global state.
+ */
+class CWorkerPool
+{
+    std::vector<std::thread> mThreads;
+    std::queue< std::function<void()> > mJobs;
+    std::mutex mMutex;
+    std::condition_variable mJobAvailable;
+    std::condition_variable mJobsFinished;
+    uint mNumRunningJobs;
+    bool mShuttingDown;
+
+public:
+    explicit CWorkerPool(uint NumThreads = 0);
+    ~CWorkerPool();
+
+    void AddJob(std::function<void()> Job);
+    void WaitForAll();
+    bool WaitForAll(uint TimeoutMs);
+    void ParallelFor(uint NumItems, const std::function<void(uint)>& rkFunc);
+
+    inline uint NumThreads() const  { return mThreads.size(); }
+
+    static uint DefaultThreadCount();
+
+protected:
+    void WorkerMain();
+    inline bool IsIdle() const      { return mJobs.empty() && mNumRunningJobs == 0; }
+};
+
+#endif // CWORKERPOOL_H
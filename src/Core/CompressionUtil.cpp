@@ -1,4 +1,5 @@
 #include "CompressionUtil.h"
+#include "CWorkerPool.h"
 #include <Common/Common.h>
 
 #if USE_LZOKAY
@@ -67,7 +68,7 @@ namespace CompressionUtil
 #endif
 
     // ************ DECOMPRESS ************
-    bool DecompressZlib(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen, uint32& rTotalOut)
+    bool DecompressZlib(const uint8 *pkSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen, uint32& rTotalOut)
     {
         // Initialize z_stream
         z_stream z;
@@ -75,7 +76,7 @@ namespace CompressionUtil
         z.zfree = Z_NULL;
         z.opaque = Z_NULL;
         z.avail_in = SrcLen;
-        z.next_in = pSrc;
+        z.next_in = (Bytef*) pkSrc; // zlib doesn't modify the input, it just isn't declared const
         z.avail_out = DstLen;
         z.next_out = pDst;
 
@@ -102,10 +103,10 @@ namespace CompressionUtil
         else return true;
     }
 
-    bool DecompressLZO(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32& rTotalOut)
+    bool DecompressLZO(const uint8 *pkSrc, uint32 SrcLen, uint8 *pDst, uint32& rTotalOut)
     {
 #if USE_LZOKAY
-        lzokay::EResult Result = lzokay::decompress(pSrc, (size_t) SrcLen, pDst, (size_t&) rTotalOut);
+        lzokay::EResult Result = lzokay::decompress(pkSrc, (size_t) SrcLen, pDst, (size_t&) rTotalOut);
 
         if (Result < lzokay::EResult::Success)
         {
@@ -117,7 +118,7 @@ namespace CompressionUtil
 #else
         lzo_init();
         lzo_uint TotalOut;
-        int32 Error = lzo1x_decompress(pSrc, SrcLen, pDst, &TotalOut, LZO1X_MEM_DECOMPRESS);
+        int32 Error = lzo1x_decompress(pkSrc, SrcLen, pDst, &TotalOut, LZO1X_MEM_DECOMPRESS);
         rTotalOut = (uint32) TotalOut;
 
         if (Error)
@@ -130,9 +131,10 @@ namespace CompressionUtil
 #endif
     }
 
-    bool DecompressSegmentedData(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen)
+    bool DecompressSegmentedData(const uint8 *pkSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen)
     {
-        uint8 *pSrcEnd = pSrc + SrcLen;
+        const uint8 *pSrc = pkSrc;
+        const uint8 *pSrcEnd = pSrc + SrcLen;
         uint8 *pDstEnd = pDst + DstLen;
 
         while ((pSrc < pSrcEnd) && (pDst < pDstEnd))
@@ -183,8 +185,11 @@ namespace CompressionUtil
     }
 
     // ************ COMPRESS ************
-    bool CompressZlib(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen, uint32& rTotalOut)
+    bool CompressZlib(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen, uint32& rTotalOut, ECompressionLevel Level /*= ECompressionLevel::Max*/)
     {
+        // Only levels that produce the 0x7801/0x789C/0x78DA headers are used, since those are what segmented decompression checks for
+        int32 ZlibLevel = (Level == ECompressionLevel::Fast ? 1 : Level == ECompressionLevel::Balanced ? 6 : 9);
+
         z_stream z;
         z.zalloc = Z_NULL;
         z.zfree = Z_NULL;
@@ -194,7 +199,7 @@ namespace CompressionUtil
         z.avail_out = DstLen;
         z.next_out = pDst;
 
-        int32 Error = deflateInit(&z, 9);
+        int32 Error = deflateInit(&z, ZlibLevel);
 
         if (!Error)
         {
@@ -215,9 +220,11 @@ namespace CompressionUtil
         else return true;
     }
 
-    bool CompressLZO(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen, uint32& rTotalOut)
+    bool CompressLZO(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen, uint32& rTotalOut, ECompressionLevel Level /*= ECompressionLevel::Max*/)
     {
 #if USE_LZOKAY
+        // lzokay only has one compressor, so the level doesn't apply
+        (void) Level;
         rTotalOut = DstLen;
         lzokay::EResult Result = lzokay::compress(pSrc, (size_t) SrcLen, pDst, (size_t&) rTotalOut);
 
@@ -231,9 +238,20 @@ namespace CompressionUtil
 #else
         lzo_init();
 
-        uint8 *pWorkMem = new uint8[LZO1X_999_MEM_COMPRESS];
-        int32 Error = lzo1x_999_compress(pSrc, SrcLen, pDst, (lzo_uint*) &rTotalOut, pWorkMem);
-        delete[] pWorkMem;
+        // The work memory is large, so each thread keeps its own instead of allocating it on every call
+        static thread_local std::vector<uint8> WorkMem(LZO1X_999_MEM_COMPRESS);
+        lzo_uint TotalOut = 0;
+        int32 Error;
+
+        // All of these produce LZO1X data, so the games decompress them the same way
+        if (Level == ECompressionLevel::Fast)
+            Error = lzo1x_1_compress(pSrc, SrcLen, pDst, &TotalOut, WorkMem.data());
+        else if (Level == ECompressionLevel::Balanced)
+            Error = lzo1x_999_compress_level(pSrc, SrcLen, pDst, &TotalOut, WorkMem.data(), nullptr, 0, nullptr, 5);
+        else
+            Error = lzo1x_999_compress(pSrc, SrcLen, pDst, &TotalOut, WorkMem.data());
+
+        rTotalOut = (uint32) TotalOut;
 
         if (Error)
         {
@@ -245,64 +263,116 @@ namespace CompressionUtil
 #endif
     }
 
-    bool CompressSegmentedData(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32& rTotalOut, bool IsZlib, bool AllowUncompressedSegments)
+    // Each segment is compressed separately. Segment size should always be 0x4000 unless there's less than 0x4000 bytes left.
+    const uint32 gkSegmentSize = 0x4000;
+
+    // Compressed segments are written to scratch space of twice the segment size
+    const uint32 gkSegmentScratchSize = gkSegmentSize * 2;
+
+    static inline uint32 SegmentSize(uint32 SrcLen, uint32 SegmentIdx)
     {
-        uint8 *pSrcEnd = pSrc + SrcLen;
-        uint8 *pDstStart = pDst;
+        uint32 Remaining = SrcLen - (SegmentIdx * gkSegmentSize);
+        return (Remaining < gkSegmentSize ? Remaining : gkSegmentSize);
+    }
 
-        while (pSrc < pSrcEnd)
+    static void CompressSegment(uint8 *pSrc, uint32 Size, uint8 *pScratch, uint32& rTotalOut, bool IsZlib, ECompressionLevel Level)
+    {
+        // DstLen stays at twice the segment size so the output is the same no matter how big the scratch buffer is
+        if (IsZlib)
+            CompressZlib(pSrc, Size, pScratch, Size * 2, rTotalOut, Level);
+        else
+            CompressLZO(pSrc, Size, pScratch, Size * 2, rTotalOut, Level);
+    }
+
+    static uint8* WriteSegment(uint8 *pDst, const uint8 *pkSrc, uint32 Size, const uint8 *pkCompressed, uint32 TotalOut, bool AllowUncompressedSegments)
+    {
+        // Verify that the compressed data is actually smaller.
+        if (AllowUncompressedSegments && TotalOut >= Size)
         {
-            // Each segment is compressed separately. Segment size should always be 0x4000 unless there's less than 0x4000 bytes left.
-            uint16 Size;
-            uint32 Remaining = (uint32) (pSrcEnd - pSrc);
+            // Write negative size value to destination (which signifies uncompressed)
+            uint16 NegSize = (uint16) -(int32) Size;
+            *pDst++ = NegSize >> 8;
+            *pDst++ = NegSize & 0xFF;
+
+            // Write original uncompressed data to destination
+            memcpy(pDst, pkSrc, Size);
+            return pDst + Size;
+        }
 
-            if (Remaining < 0x4000) Size = (uint16) Remaining;
-            else Size = 0x4000;
+        // If it IS smaller, write the compressed data
+        else
+        {
+            // Write new compressed size + data to destination
+            *pDst++ = (TotalOut >> 8) & 0xFF;
+            *pDst++ = (TotalOut & 0xFF);
+            memcpy(pDst, pkCompressed, TotalOut);
+            return pDst + TotalOut;
+        }
+    }
 
-            std::vector<uint8> Compressed(Size * 2);
-            uint32 TotalOut;
+    bool CompressSegmentedData(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32& rTotalOut, bool IsZlib, bool AllowUncompressedSegments,
+                               ECompressionLevel Level /*= ECompressionLevel::Max*/, CWorkerPool *pPool /*= nullptr*/)
+    {
+        // If a worker pool is provided, segments are compressed in parallel into their own scratch slots,
+        // then written out in order, so the output is identical to compressing them one at a time.
+        // The pool must not be running any other jobs, and this can't be called from one of its jobs.
+        uint32 NumSegments = (SrcLen + gkSegmentSize - 1) / gkSegmentSize;
+        uint8 *pDstStart = pDst;
 
-            if (IsZlib)
-                CompressZlib(pSrc, Size, Compressed.data(), Compressed.size(), TotalOut);
-            else
-                CompressLZO(pSrc, Size, Compressed.data(), Compressed.size(), TotalOut);
+        if (pPool && pPool->NumThreads() > 1 && NumSegments > 1)
+        {
+            std::vector<uint8> Scratch(NumSegments * gkSegmentScratchSize);
+            std::vector<uint32> CompressedSizes(NumSegments, 0);
 
-            // Verify that the compressed data is actually smaller.
-            if (AllowUncompressedSegments && TotalOut >= Size)
+            pPool->ParallelFor(NumSegments, [&](uint SegmentIdx)
             {
-                // Write negative size value to destination (which signifies uncompressed)
-                *pDst++ = -Size >> 8;
-                *pDst++ = -Size & 0xFF;
+                uint32 Offset = SegmentIdx * gkSegmentSize;
+                CompressSegment(pSrc + Offset, SegmentSize(SrcLen, SegmentIdx), &Scratch[SegmentIdx * gkSegmentScratchSize], CompressedSizes[SegmentIdx], IsZlib, Level);
+            });
 
-                // Write original uncompressed data to destination
-                memcpy(pDst, pSrc, Size);
-                TotalOut = Size;
+            for (uint32 SegmentIdx = 0; SegmentIdx < NumSegments; SegmentIdx++)
+            {
+                uint32 Offset = SegmentIdx * gkSegmentSize;
+                pDst = WriteSegment(pDst, pSrc + Offset, SegmentSize(SrcLen, SegmentIdx), &Scratch[SegmentIdx * gkSegmentScratchSize],
+                                    CompressedSizes[SegmentIdx], AllowUncompressedSegments);
             }
+        }
 
-            // If it IS smaller, write the compressed data
-            else
+        else
+        {
+            std::vector<uint8> Scratch(gkSegmentScratchSize);
+
+            for (uint32 SegmentIdx = 0; SegmentIdx < NumSegments; SegmentIdx++)
             {
-                // Write new compressed size + data to destination
-                *pDst++ = (TotalOut >> 8) & 0xFF;
-                *pDst++ = (TotalOut & 0xFF);
-                memcpy(pDst, Compressed.data(), TotalOut);
-            }
+                uint32 Offset = SegmentIdx * gkSegmentSize;
+                uint32 Size = SegmentSize(SrcLen, SegmentIdx);
+                uint32 TotalOut = 0;
 
-            pSrc += Size;
-            pDst += TotalOut;
+                CompressSegment(pSrc + Offset, Size, Scratch.data(), TotalOut, IsZlib, Level);
+                pDst = WriteSegment(pDst, pSrc + Offset, Size, Scratch.data(), TotalOut, AllowUncompressedSegments);
+            }
         }
 
         rTotalOut = (uint32) (pDst - pDstStart);
         return true;
     }
 
-    bool CompressZlibSegmented(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32& rTotalOut, bool AllowUncompressedSegments)
+    bool CompressZlibSegmented(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32& rTotalOut, bool AllowUncompressedSegments, ECompressionLevel Level /*= ECompressionLevel::Max*/)
+    {
+        return CompressSegmentedData(pSrc, SrcLen, pDst, rTotalOut, true, AllowUncompressedSegments, Level);
+    }
+
+    bool CompressLZOSegmented(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32& rTotalOut, bool AllowUncompressedSegments, ECompressionLevel Level /*= ECompressionLevel::Max*/)
     {
-        return CompressSegmentedData(pSrc, SrcLen, pDst, rTotalOut, true, AllowUncompressedSegments);
+        return CompressSegmentedData(pSrc, SrcLen, pDst, rTotalOut, false, AllowUncompressedSegments, Level);
     }
 
-    bool CompressLZOSegmented(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32& rTotalOut, bool AllowUncompressedSegments)
+    bool LZOSupportsCompressionLevels()
     {
-        return CompressSegmentedData(pSrc, SrcLen, pDst, rTotalOut, false, AllowUncompressedSegments);
+#if USE_LZOKAY
+        return false;
+#else
+        return true;
+#endif
     }
 }
@@ -5,19 +5,33 @@
 #include <Common/FileIO.h>
 #include <Common/TString.h>
 
+class CWorkerPool;
+
+// Compression effort used when cooking. Every level produces data the games can read;
+// lower levels trade compression ratio for cook speed. Builds that use lzokay for LZO only
+// have one LZO compressor, so there the level only applies to zlib.
+enum class ECompressionLevel
+{
+    Fast,       // Fastest compressors; intended for quick test cooks
+    Balanced,   // Medium effort
+    Max         // Best ratio; the same settings as the original games
+};
+
 namespace CompressionUtil
 {
     // Decompression
-    bool DecompressZlib(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen, uint32& rTotalOut);
-    bool DecompressLZO(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32& rTotalOut);
-    bool DecompressSegmentedData(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen);
+    bool DecompressZlib(const uint8 *pkSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen, uint32& rTotalOut);
+    bool DecompressLZO(const uint8 *pkSrc, uint32 SrcLen, uint8 *pDst, uint32& rTotalOut);
+    bool DecompressSegmentedData(const uint8 *pkSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen);
 
     // Compression
-    bool CompressZlib(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen, uint32& rTotalOut);
-    bool CompressLZO(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32& rTotalOut);
-    bool CompressSegmentedData(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32& rTotalOut, bool IsZlib, bool AllowUncompressedSegments);
-    bool CompressZlibSegmented(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32& rTotalOut, bool AllowUncompressedSegments);
-    bool CompressLZOSegmented(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32& rTotalOut, bool AllowUncompressedSegments);
+    bool CompressZlib(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen, uint32& rTotalOut, ECompressionLevel Level = ECompressionLevel::Max);
+    bool CompressLZO(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen, uint32& rTotalOut, ECompressionLevel Level = ECompressionLevel::Max);
+    bool CompressSegmentedData(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32& rTotalOut, bool IsZlib, bool AllowUncompressedSegments,
+                               ECompressionLevel Level = ECompressionLevel::Max, CWorkerPool *pPool = nullptr);
+    bool CompressZlibSegmented(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32& rTotalOut, bool AllowUncompressedSegments, ECompressionLevel Level = ECompressionLevel::Max);
+    bool CompressLZOSegmented(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32& rTotalOut, bool AllowUncompressedSegments, ECompressionLevel Level = ECompressionLevel::Max);
+    bool LZOSupportsCompressionLevels();
 }
 
 #endif // COMPRESSIONUTIL_H
@@ -104,6 +104,7 @@ HEADERS += \
     Resource/Model/CModel.h \
     Resource/Model/CStaticModel.h \
     Resource/Model/CVertex.h \
+    Resource/Model/CSurfaceRayTree.h \
     Resource/Model/SSurface.h \
     Resource/Script/CScriptLayer.h \
     Resource/Script/CScriptObject.h \
@@ -128,6 +129,8 @@ HEADERS += \
     Scene/CLightNode.h \
     Scene/CModelNode.h \
     Scene/CRootNode.h \
+    Scene/CSceneBVH.h \
+    Scene/CLightGrid.h \
     Scene/CSceneNode.h \
     Scene/CScriptNode.h \
     Scene/CStaticNode.h \
@@ -201,6 +204,7 @@ HEADERS += \
     Resource/Animation/CAnimationParameters.h \
     Resource/Animation/CAnimEventData.h \
     Resource/Animation/CAnimSet.h \
+    Resource/Animation/CPoseEvaluator.h \
     Resource/Animation/CSkeleton.h \
     Resource/Animation/CSkin.h \
     Resource/Animation/IMetaTransition.h \
@@ -260,7 +264,14 @@ HEADERS += \
     Resource/Collision/SCollisionIndexData.h \
     Resource/Collision/CCollisionRenderData.h \
     Resource/Collision/SOBBTreeNode.h \
-    Resource/Collision/CCollidableOBBTree.h
+    Resource/Collision/CCollidableOBBTree.h \
+    CWorkerPool.h \
+    CMappedFile.h \
+    GameProject/TAssetMap.h \
+    TSlabAllocator.h \
+    GameProject/CResourceLoadContext.h \
+    GameProject/CAsyncResourceLoader.h \
+    GameProject/CDependencyIndex.h
 
 # Source Files
 SOURCES += \
@@ -288,6 +299,7 @@ SOURCES += \
     Resource/Model/CBasicModel.cpp \
     Resource/Model/CModel.cpp \
     Resource/Model/CStaticModel.cpp \
+    Resource/Model/CSurfaceRayTree.cpp \
     Resource/Model/SSurface.cpp \
     Resource/Script/CScriptObject.cpp \
     Resource/Script/CScriptTemplate.cpp \
@@ -301,6 +313,8 @@ SOURCES += \
     Scene/CCollisionNode.cpp \
     Scene/CLightNode.cpp \
     Scene/CModelNode.cpp \
+    Scene/CSceneBVH.cpp \
+    Scene/CLightGrid.cpp \
     Scene/CSceneNode.cpp \
     Scene/CScriptNode.cpp \
     Scene/CStaticNode.cpp \
@@ -354,6 +368,7 @@ SOURCES += \
     Resource/Factory/CAnimEventLoader.cpp \
     Resource/Animation/CAnimation.cpp \
     Resource/Animation/CAnimationParameters.cpp \
+    Resource/Animation/CPoseEvaluator.cpp \
     Resource/Animation/CSkeleton.cpp \
     Resource/Animation/IMetaAnimation.cpp \
     Resource/Animation/IMetaTransition.cpp \
@@ -381,7 +396,12 @@ SOURCES += \
     Resource/Cooker/CScanCooker.cpp \
     NCoreTests.cpp \
     Resource/Collision/CCollisionRenderData.cpp \
-    Resource/Collision/CCollidableOBBTree.cpp
+    Resource/Collision/CCollidableOBBTree.cpp \
+    CWorkerPool.cpp \
+    CMappedFile.cpp \
+    GameProject/CResourceLoadContext.cpp \
+    GameProject/CAsyncResourceLoader.cpp \
+    GameProject/CDependencyIndex.cpp
 
 # Codegen
 CODEGEN_DIR = $$EXTERNALS_DIR/CodeGen
@@ -1,6 +1,8 @@
 #include "AssetNameGeneration.h"
 #include "CGameProject.h"
 #include "CResourceIterator.h"
+#include "CResourceLoadContext.h"
+#include "Core/CWorkerPool.h"
 #include "Core/Resource/CAudioMacro.h"
 #include "Core/Resource/CFont.h"
 #include "Core/Resource/CWorld.h"
@@ -9,6 +11,10 @@
 #include "Core/Resource/Scan/SScanParametersMP1.h"
 #include "Core/Resource/Script/CScriptLayer.h"
 #include <Common/Math/MathUtil.h>
+#include <algorithm>
+#include <functional>
+#include <set>
+#include <unordered_map>
 
 #define REVERT_AUTO_NAMES 1
 #define PROCESS_PACKAGES 1
@@ -22,126 +28,669 @@
 #define PROCESS_SCANS 1
 #define PROCESS_FONTS 1
 
-void ApplyGeneratedName(CResourceEntry *pEntry, const TString& rkDir, const TString& rkName)
+/*
+ * Name generation runs in two phases. First, every resource that names are derived from is loaded on
+ * a worker thread (in its own load context) and turned into a list of name requests. The requests are
+ * applied to an in-memory plan on the calling thread, in the same order the old sequential pass used,
+ * so the results don't depend on thread timing. Nothing touches the disk during this phase.
+ * Second, every entry whose planned path differs from its current path is moved in a single batch.
+ */
+
+// ************ NAME REQUESTS ************
+/** A single generated name for an entry. Recorded by the workers and applied to the plan afterwards. */
+struct SNameRequest
+{
+    CResourceEntry *pEntry;
+    TString Dir;
+    TString Name;
+
+    // If set, the directory/name are read from the plan for these entries when the request is applied.
+    // The name source's name is prefixed onto Name.
+    CResourceEntry *pDirSource;
+    CResourceEntry *pNameSource;
+
+    // Conditions checked against the plan when the request is applied; pConditionEntry defaults to pEntry.
+    // InheritCondition reuses the result of the previous request's check instead.
+    CResourceEntry *pConditionEntry;
+    bool RequireUnnamed;
+    bool RequireUncategorized;
+    bool InheritCondition;
+
+    // Whether to hide the entry when the request is applied
+    bool Hide;
+
+    SNameRequest(CResourceEntry *_pEntry, const TString& rkDir, const TString& rkName)
+        : pEntry(_pEntry)
+        , Dir(rkDir)
+        , Name(rkName)
+        , pDirSource(nullptr)
+        , pNameSource(nullptr)
+        , pConditionEntry(nullptr)
+        , RequireUnnamed(false)
+        , RequireUncategorized(false)
+        , InheritCondition(false)
+        , Hide(false)
+    {}
+};
+typedef std::vector<SNameRequest> TNameRequestList;
+
+inline SNameRequest& AddNameRequest(TNameRequestList& rList, CResourceEntry *pEntry, const TString& rkDir, const TString& rkName)
 {
     ASSERT(pEntry != nullptr);
+    rList.emplace_back(pEntry, rkDir, rkName);
+    return rList.back();
+}
+
+// ************ NAME PLAN ************
+struct SPathHash
+{
+    inline size_t operator()(const TString& rkPath) const
+    {
+        return std::hash<uint32>()( rkPath.Hash32() );
+    }
+};
+
+/** In-memory copy of every entry's directory and name that generated names are applied to */
+class CAssetNamePlan
+{
+    struct SPlannedPath
+    {
+        TString Dir;
+        TString Name;
+    };
+
+    CResourceStore *mpStore;
+    TString mDefaultDir;
+    std::unordered_map<CResourceEntry*, SPlannedPath> mPaths;
+    std::unordered_map<TString, CResourceEntry*, SPathHash> mOccupiedPaths;
+    std::unordered_map<TString, TString, SPathHash> mDirectoryCasing;
+    std::vector<CResourceEntry*> mHiddenEntries;
+
+    struct SMove
+    {
+        CResourceEntry *pEntry;
+        TString Dir;
+        TString Name;
+        TString OldDir;
+        TString OldName;
+        bool Parked;
+    };
+
+public:
+    CAssetNamePlan(CResourceStore *pStore, bool RevertAutoNames)
+        : mpStore(pStore)
+        , mDefaultDir(pStore->DefaultResourceDirPath())
+    {
+        for (CResourceIterator It(pStore); It; ++It)
+        {
+            SPlannedPath& rPath = mPaths[*It];
+            rPath.Dir = It->DirectoryPath();
+            rPath.Name = It->Name();
+            mOccupiedPaths[PathKey(rPath.Dir, rPath.Name, It->ResourceType())] = *It;
+        }
+
+        // Revert all auto-generated asset names back to default to prevent name conflicts resulting in inconsistent results.
+        if (RevertAutoNames)
+        {
+            for (CResourceIterator It(pStore); It; ++It)
+            {
+                CResourceEntry *pEntry = *It;
+                bool HasCustomDir = !pEntry->HasFlag(EResEntryFlag::AutoResDir);
+                bool HasCustomName = !pEntry->HasFlag(EResEntryFlag::AutoResName);
+                if (HasCustomDir && HasCustomName) continue;
+
+                TString NewDir = (HasCustomDir ? Directory(pEntry) : ResolveDirectory(mDefaultDir));
+                TString NewName = (HasCustomName ? Name(pEntry) : pEntry->ID().ToString());
+
+                if (!FindEntry(NewDir, NewName, pEntry->ResourceType()))
+                    SetPath(pEntry, NewDir, NewName);
+            }
+        }
+    }
+
+    inline CResourceStore* Store() const
+    {
+        return mpStore;
+    }
+
+    const TString& Directory(CResourceEntry *pEntry) const
+    {
+        auto Iter = mPaths.find(pEntry);
+        ASSERT(Iter != mPaths.end());
+        return Iter->second.Dir;
+    }
+
+    const TString& Name(CResourceEntry *pEntry) const
+    {
+        auto Iter = mPaths.find(pEntry);
+        ASSERT(Iter != mPaths.end());
+        return Iter->second.Name;
+    }
 
-    // Don't overwrite hand-picked names and directories with auto-generated ones
-    bool HasCustomDir = !pEntry->HasFlag(EResEntryFlag::AutoResDir);
-    bool HasCustomName = !pEntry->HasFlag(EResEntryFlag::AutoResName);
-    if (HasCustomDir && HasCustomName) return;
+    inline bool IsNamed(CResourceEntry *pEntry) const
+    {
+        return Name(pEntry) != pEntry->ID().ToString();
+    }
 
-    // Determine final directory to use
-    CVirtualDirectory *pNewDir = nullptr;
+    inline bool IsCategorized(CResourceEntry *pEntry) const
+    {
+        return !Directory(pEntry).CaseInsensitiveCompare(mDefaultDir);
+    }
 
-    if (HasCustomDir)
+    void ApplyGeneratedName(CResourceEntry *pEntry, const TString& rkDir, const TString& rkName)
     {
-        pNewDir = pEntry->Directory();
+        ASSERT(pEntry != nullptr);
+        if (mPaths.find(pEntry) == mPaths.end()) return;
+
+        // Don't overwrite hand-picked names and directories with auto-generated ones
+        bool HasCustomDir = !pEntry->HasFlag(EResEntryFlag::AutoResDir);
+        bool HasCustomName = !pEntry->HasFlag(EResEntryFlag::AutoResName);
+        if (HasCustomDir && HasCustomName) return;
+
+        // Determine final directory to use
+        TString NewDir;
+
+        if (HasCustomDir)
+        {
+            NewDir = Directory(pEntry);
+        }
+        else
+        {
+            TString SanitizedDir = FileUtil::SanitizePath(rkDir, true);
+
+            // trying to keep these as consistent with Retro's naming scheme as possible, and
+            // for some reason in MP3 they started using all lowercase folder names...
+            if (pEntry->Game() >= EGame::CorruptionProto)
+                SanitizedDir = SanitizedDir.ToLower();
+
+            if (!CVirtualDirectory::IsValidDirectoryPath(SanitizedDir)) return;
+            NewDir = ResolveDirectory(SanitizedDir);
+        }
+
+        // Determine final name to use
+        TString NewName;
+
+        if (HasCustomName)
+        {
+            NewName = Name(pEntry);
+        }
+        else
+        {
+            TString SanitizedName = FileUtil::SanitizeName(rkName, false);
+            if (SanitizedName.IsEmpty()) return;
+
+            // Find an unused variant of this name
+            NewName = SanitizedName;
+            int AppendNum = 0;
+
+            while (CResourceEntry *pConflict = FindEntry(NewDir, NewName, pEntry->ResourceType()))
+            {
+                if (pConflict == pEntry)
+                    return;
+
+                NewName = TString::Format("%s_%d", *SanitizedName, AppendNum);
+                AppendNum++;
+            }
+        }
+
+        // Check if we're actually moving anything. Custom names aren't checked for conflicts above, so check them here.
+        if (Directory(pEntry) == NewDir && Name(pEntry) == NewName) return;
+        if (FindEntry(NewDir, NewName, pEntry->ResourceType()) != nullptr) return;
+
+        SetPath(pEntry, NewDir, NewName);
+    }
+
+    void Apply(const TNameRequestList& rkRequests)
+    {
+        bool ConditionPassed = true;
+
+        for (const SNameRequest& rkRequest : rkRequests)
+        {
+            if (!rkRequest.InheritCondition)
+            {
+                CResourceEntry *pCheckEntry = (rkRequest.pConditionEntry ? rkRequest.pConditionEntry : rkRequest.pEntry);
+                ConditionPassed = (!rkRequest.RequireUnnamed || !IsNamed(pCheckEntry)) &&
+                                  (!rkRequest.RequireUncategorized || !IsCategorized(pCheckEntry));
+            }
+
+            if (!ConditionPassed)
+                continue;
+
+            TString NewDir = (rkRequest.pDirSource ? Directory(rkRequest.pDirSource) : rkRequest.Dir);
+            TString NewName = (rkRequest.pNameSource ? Name(rkRequest.pNameSource) + rkRequest.Name : rkRequest.Name);
+            ApplyGeneratedName(rkRequest.pEntry, NewDir, NewName);
+
+            if (rkRequest.Hide)
+                mHiddenEntries.push_back(rkRequest.pEntry);
+        }
+    }
+
+    /** Moves every entry whose planned path differs from its current one. Returns the number of entries moved. */
+    uint32 Commit()
+    {
+        std::vector<SMove> Moves;
+
+        for (CResourceIterator It(mpStore); It; ++It)
+        {
+            const SPlannedPath& rkPath = mPaths[*It];
+
+            if (!It->DirectoryPath().CaseInsensitiveCompare(rkPath.Dir) || It->Name() != rkPath.Name)
+                Moves.push_back( SMove { *It, rkPath.Dir, rkPath.Name, It->DirectoryPath(), It->Name(), false } );
+        }
+
+        // An entry can't move while another entry still occupies its new path, so keep making passes
+        // until everything has moved. Entries waiting on each other in a cycle are parked on a temporary name.
+        uint32 NumMoved = 0;
+
+        while (!Moves.empty())
+        {
+            std::vector<SMove> Blocked;
+
+            for (SMove& rMove : Moves)
+            {
+                if (rMove.pEntry->CanMoveTo(rMove.Dir, rMove.Name))
+                {
+                    if (MoveEntry(rMove.pEntry, rMove.Dir, rMove.Name))
+                        NumMoved++;
+                    else
+                    {
+                        errorf("Failed to move %s to generated path %s%s", *rMove.pEntry->CookedAssetPath(true), *rMove.Dir, *rMove.Name);
+                        Unpark(rMove);
+                    }
+                }
+                else
+                    Blocked.push_back(rMove);
+            }
+
+            if (!Blocked.empty() && Blocked.size() == Moves.size())
+            {
+                // Nothing moved on this pass, so every remaining entry is either part of a rename cycle or
+                // blocked by something else. Break one cycle; if there are none, the rest can't be moved.
+                SMove *pCycleMove = FindRenameCycle(Blocked);
+                TString ParkName = (pCycleMove ? pCycleMove->pEntry->ID().ToString() + "_swap" : "");
+
+                if (pCycleMove && pCycleMove->pEntry->CanMoveTo(pCycleMove->OldDir, ParkName) &&
+                    MoveEntry(pCycleMove->pEntry, pCycleMove->OldDir, ParkName))
+                {
+                    pCycleMove->Parked = true;
+                }
+                else
+                {
+                    for (const SMove& rkMove : Blocked)
+                    {
+                        errorf("Failed to move %s to generated path %s%s", *rkMove.pEntry->CookedAssetPath(true), *rkMove.Dir, *rkMove.Name);
+                        Unpark(rkMove);
+                    }
+
+                    break;
+                }
+            }
+
+            Moves = std::move(Blocked);
+        }
+
+        for (CResourceEntry *pEntry : mHiddenEntries)
+            pEntry->SetHidden(true);
+
+        return NumMoved;
     }
-    else
+
+protected:
+    static TString PathKey(const TString& rkDir, const TString& rkName, EResourceType Type)
     {
-        TString SanitizedDir = FileUtil::SanitizePath(rkDir, true);
+        return TString::Format("%s%s|%d", *rkDir.ToUpper(), *rkName.ToUpper(), (int) Type);
+    }
 
-        // trying to keep these as consistent with Retro's naming scheme as possible, and
-        // for some reason in MP3 they started using all lowercase folder names...
-        if (pEntry->Game() >= EGame::CorruptionProto)
-            SanitizedDir = SanitizedDir.ToLower();
+    CResourceEntry* FindEntry(const TString& rkDir, const TString& rkName, EResourceType Type) const
+    {
+        auto Iter = mOccupiedPaths.find( PathKey(rkDir, rkName, Type) );
+        return (Iter != mOccupiedPaths.end() ? Iter->second : nullptr);
+    }
 
-        pNewDir = pEntry->ResourceStore()->GetVirtualDirectory(SanitizedDir, true);
+    void SetPath(CResourceEntry *pEntry, const TString& rkDir, const TString& rkName)
+    {
+        SPlannedPath& rPath = mPaths[pEntry];
+        mOccupiedPaths.erase( PathKey(rPath.Dir, rPath.Name, pEntry->ResourceType()) );
+        rPath.Dir = rkDir;
+        rPath.Name = rkName;
+        mOccupiedPaths[PathKey(rkDir, rkName, pEntry->ResourceType())] = pEntry;
     }
 
-    // Determine final name to use
-    TString NewName;
+    /** Returns the full path of a directory as the store would name it, matching the casing of existing directories */
+    TString ResolveDirectory(const TString& rkPath)
+    {
+        TStringList Components = rkPath.Split("/\\");
+        TString Resolved;
+
+        for (auto Iter = Components.begin(); Iter != Components.end(); Iter++)
+        {
+            TString Path = Resolved + *Iter + '/';
+            TString Key = Path.ToUpper();
+            auto CasingIter = mDirectoryCasing.find(Key);
+
+            if (CasingIter != mDirectoryCasing.end())
+            {
+                Resolved = CasingIter->second;
+            }
+            else
+            {
+                CVirtualDirectory *pDir = mpStore->GetVirtualDirectory(Path, false);
+                Resolved = (pDir ? pDir->FullPath() : Path);
+                mDirectoryCasing[Key] = Resolved;
+            }
+        }
+
+        return Resolved;
+    }
 
-    if (HasCustomName)
+    static bool MoveEntry(CResourceEntry *pEntry, const TString& rkDir, const TString& rkName)
     {
-        NewName = pEntry->Name();
+        // Only auto-generated parts of the path are moved, so the flags stay as they are
+        return pEntry->MoveAndRename(rkDir, rkName, pEntry->HasFlag(EResEntryFlag::AutoResDir), pEntry->HasFlag(EResEntryFlag::AutoResName));
     }
-    else
+
+    /** Returns a move that's part of a cycle of moves each waiting on the next one's entry to move out of the way, if there is one */
+    SMove* FindRenameCycle(std::vector<SMove>& rBlocked) const
     {
-        TString SanitizedName = FileUtil::SanitizeName(rkName, false);
-        if (SanitizedName.IsEmpty()) return;
+        std::unordered_map<CResourceEntry*, SMove*> MovesByEntry;
+
+        for (SMove& rMove : rBlocked)
+            MovesByEntry[rMove.pEntry] = &rMove;
 
-        // Find an unused variant of this name
-        NewName = SanitizedName;
-        int AppendNum = 0;
+        // Follow each chain of blockers until it either leaves the blocked moves or loops back on itself
+        enum class EVisit { OnChain, Done };
+        std::unordered_map<SMove*, EVisit> Visited;
 
-        while (CResourceEntry *pConflict = pNewDir->FindChildResource(NewName, pEntry->ResourceType()))
+        for (SMove& rStart : rBlocked)
         {
-            if (pConflict == pEntry)
-                return;
+            std::vector<SMove*> Chain;
+            SMove *pMove = &rStart;
+
+            while (pMove && Visited.find(pMove) == Visited.end())
+            {
+                Visited[pMove] = EVisit::OnChain;
+                Chain.push_back(pMove);
+
+                CVirtualDirectory *pDir = mpStore->GetVirtualDirectory(pMove->Dir, false);
+                CResourceEntry *pBlocker = (pDir ? pDir->FindChildResource(pMove->Name, pMove->pEntry->ResourceType()) : nullptr);
+                auto Iter = MovesByEntry.find(pBlocker);
+                pMove = (Iter != MovesByEntry.end() ? Iter->second : nullptr);
+            }
 
-            NewName = TString::Format("%s_%d", *SanitizedName, AppendNum);
-            AppendNum++;
+            if (pMove && Visited[pMove] == EVisit::OnChain)
+                return pMove;
+
+            for (SMove *pChainMove : Chain)
+                Visited[pChainMove] = EVisit::Done;
         }
+
+        return nullptr;
     }
 
-    // Check if we're actually moving anything
-    if (pEntry->Directory() == pNewDir && pEntry->Name() == NewName) return;
+    /** Moves a parked entry back to where it was before Commit() started */
+    static void Unpark(const SMove& rkMove)
+    {
+        if (rkMove.Parked && !MoveEntry(rkMove.pEntry, rkMove.OldDir, rkMove.OldName))
+            errorf("Failed to restore %s to its original path %s%s", *rkMove.pEntry->CookedAssetPath(true), *rkMove.OldDir, *rkMove.OldName);
+    }
+};
+
+// ************ REQUEST GATHERING ************
+std::vector<CResourceEntry*> EntriesOfType(CResourceStore *pStore, EResourceType Type)
+{
+    std::vector<CResourceEntry*> Entries;
 
-    // Perform the move
-    bool Success = pEntry->MoveAndRename(pNewDir->FullPath(), NewName, true, true);
-    ASSERT(Success);
+    for (CResourceIterator It(pStore); It; ++It)
+    {
+        if (It->ResourceType() == Type)
+            Entries.push_back(*It);
+    }
+
+    return Entries;
 }
 
-void GenerateAssetNames(CGameProject *pProj)
+/** Loads every entry on the worker pool to gather its name requests, then applies them to the plan in entry order */
+void GatherNames(CAssetNamePlan& rPlan, CWorkerPool& rPool, const std::vector<CResourceEntry*>& rkEntries,
+                 const std::function<void(CResourceEntry*, TNameRequestList&)>& rkGatherFunc)
 {
-    debugf("*** Generating Asset Names ***");
-    CResourceStore *pStore = pProj->ResourceStore();
+    std::vector<TNameRequestList> Requests(rkEntries.size());
+    CResourceStore *pStore = rPlan.Store();
 
-#if REVERT_AUTO_NAMES
-    // Revert all auto-generated asset names back to default to prevent name conflicts resulting in inconsistent results.
-    debugf("Reverting auto-generated names");
+    rPool.ParallelFor(rkEntries.size(), [pStore, &rkEntries, &Requests, &rkGatherFunc](uint EntryIdx)
+    {
+        CResourceLoadContext Context(pStore);
+        rkGatherFunc(rkEntries[EntryIdx], Requests[EntryIdx]);
+    });
 
-    for (CResourceIterator It(pStore); It; ++It)
+    for (const TNameRequestList& rkList : Requests)
+        rPlan.Apply(rkList);
+}
+
+void GatherAreaNames(const CAssetNamePlan& rkPlan, CGameProject *pProj, CResourceEntry *pAreaEntry,
+                     const TString& rkAreaName, const TString& rkWorldDir, const TString& rkWorldMasterDir, TNameRequestList& rOut)
+{
+    // Move area dependencies
+    CResourceStore *pStore = rkPlan.Store();
+    TString AreaCookedDir = rkWorldDir + rkAreaName + "/cooked/";
+    CGameArea *pArea = (CGameArea*) pAreaEntry->Load();
+    if (!pArea) return;
+
+    // Area lightmaps. Textures that were already handled by an earlier material count as categorized.
+    std::set<CResourceEntry*> NamedTextures;
+    uint32 LightmapNum = 0;
+    CMaterialSet *pMaterials = pArea->Materials();
+
+    for (uint32 iMat = 0; iMat < pMaterials->NumMaterials(); iMat++)
     {
-        bool HasCustomDir = !It->HasFlag(EResEntryFlag::AutoResDir);
-        bool HasCustomName = !It->HasFlag(EResEntryFlag::AutoResName);
-        if (HasCustomDir && HasCustomName) continue;
+        CMaterial *pMat = pMaterials->MaterialByIndex(iMat);
+        bool FoundLightmap = false;
 
-        TString NewDir = (HasCustomDir ? It->DirectoryPath() : pStore->DefaultResourceDirPath());
-        TString NewName = (HasCustomName ? It->Name() : It->ID().ToString());
-        It->MoveAndRename(NewDir, NewName, true, true);
-    }
-#endif
+        for (uint32 iPass = 0; iPass < pMat->PassCount(); iPass++)
+        {
+            CMaterialPass *pPass = pMat->Pass(iPass);
 
-#if PROCESS_PACKAGES
-    // Generate names for package named resources
-    debugf("Processing packages");
+            bool IsLightmap = ( (pArea->Game() <= EGame::Echoes && pMat->Options().HasFlag(EMaterialOption::Lightmap) && iPass == 0) ||
+                                (pArea->Game() >= EGame::CorruptionProto && pPass->Type() == "DIFF") );
+            bool IsBloomLightmap = (pArea->Game() >= EGame::CorruptionProto && pPass->Type() == "BLOL");
 
-    for (uint32 iPkg = 0; iPkg < pProj->NumPackages(); iPkg++)
+            TString TexName;
+
+            if (IsLightmap)
+            {
+                TexName = TString::Format("%s_lit_lightmap%d", *rkAreaName, LightmapNum);
+            }
+            else if (IsBloomLightmap)
+            {
+                TexName = TString::Format("%s_lit_lightmap_bloom%d", *rkAreaName, LightmapNum);
+            }
+
+            if (!TexName.IsEmpty())
+            {
+                CTexture *pLightmapTex = pPass->Texture();
+                CResourceEntry *pTexEntry = pLightmapTex->Entry();
+                if (rkPlan.IsCategorized(pTexEntry) || NamedTextures.find(pTexEntry) != NamedTextures.end()) continue;
+
+                SNameRequest& rRequest = AddNameRequest(rOut, pTexEntry, AreaCookedDir, TexName);
+                rRequest.RequireUncategorized = true;
+                rRequest.Hide = true;
+                NamedTextures.insert(pTexEntry);
+                FoundLightmap = true;
+            }
+        }
+
+        if (FoundLightmap)
+            LightmapNum++;
+    }
+
+    // Generate names from script instance names
+    for (uint32 iLyr = 0; iLyr < pArea->NumScriptLayers(); iLyr++)
     {
-        CPackage *pPkg = pProj->PackageByIndex(iPkg);
+        CScriptLayer *pLayer = pArea->ScriptLayer(iLyr);
 
-        for (uint32 iRes = 0; iRes < pPkg->NumNamedResources(); iRes++)
+        for (uint32 iInst = 0; iInst < pLayer->NumInstances(); iInst++)
         {
-            const SNamedResource& rkRes = pPkg->NamedResourceByIndex(iRes);
-            if (rkRes.Name.EndsWith("NODEPEND")) continue;
+            CScriptObject* pInst = pLayer->InstanceByIndex(iInst);
+            CStructProperty* pProperties = pInst->Template()->Properties();
 
-            // Some of Retro's paks reference assets that don't exist, so we need this check here.
-            CResourceEntry *pRes = pStore->FindEntry(rkRes.ID);
+            if (pInst->ObjectTypeID() == 0x42 || pInst->ObjectTypeID() == FOURCC('POIN'))
+            {
+                TString Name = pInst->InstanceName();
 
-            if (pRes)
-                ApplyGeneratedName(pRes, pPkg->Name(), rkRes.Name);
+                if (Name.StartsWith("POI_", false))
+                {
+                    TIDString ScanIDString = (pProj->Game() <= EGame::Prime ? "0x4:0x0" : "0xBDBEC295:0xB94E9BE7");
+                    CAssetProperty *pScanProperty = TPropCast<CAssetProperty>(pProperties->ChildByIDString(ScanIDString));
+                    ASSERT(pScanProperty); // Temporary assert to remind myself later to update this code when uncooked properties are added to the template
+
+                    if (pScanProperty)
+                    {
+                        CAssetID ScanID = pScanProperty->Value(pInst->PropertyData());
+                        CResourceEntry *pEntry = pStore->FindEntry(ScanID);
+
+                        if (pEntry && !rkPlan.IsNamed(pEntry))
+                        {
+                            TString ScanName = Name.ChopFront(4);
+
+                            if (ScanName.EndsWith(".SCAN", false))
+                                ScanName = ScanName.ChopBack(5);
+
+                            // Several instances can share a scan, so the first one to be applied wins
+                            SNameRequest& rScanRequest = AddNameRequest(rOut, pEntry, "", ScanName);
+                            rScanRequest.pDirSource = pEntry;
+                            rScanRequest.RequireUnnamed = true;
+
+                            CScan *pScan = (CScan*) pEntry->Load();
+                            if (pScan)
+                            {
+                                CAssetID StringID = pScan->ScanStringPropertyRef();
+                                CResourceEntry* pStringEntry = pStore->FindEntry(StringID);
+
+                                if (pStringEntry)
+                                {
+                                    SNameRequest& rStringRequest = AddNameRequest(rOut, pStringEntry, "", ScanName);
+                                    rStringRequest.pDirSource = pStringEntry;
+                                    rStringRequest.InheritCondition = true;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+
+            else if (pInst->ObjectTypeID() == 0x17 || pInst->ObjectTypeID() == FOURCC('MEMO'))
+            {
+                TString Name = pInst->InstanceName();
+
+                if (Name.EndsWith(".STRG", false))
+                {
+                    uint32 StringPropID = (pProj->Game() <= EGame::Prime ? 0x4 : 0x9182250C);
+                    CAssetProperty *pStringProperty = TPropCast<CAssetProperty>(pProperties->ChildByID(StringPropID));
+                    ASSERT(pStringProperty); // Temporary assert to remind myself later to update this code when uncooked properties are added to the template
+
+                    if (pStringProperty)
+                    {
+                        CAssetID StringID = pStringProperty->Value(pInst->PropertyData());
+                        CResourceEntry *pEntry = pStore->FindEntry(StringID);
+
+                        if (pEntry && !rkPlan.IsNamed(pEntry))
+                        {
+                            TString StringName = Name.ChopBack(5);
+
+                            if (StringName.StartsWith("HUDMemo - "))
+                                StringName = StringName.ChopFront(10);
+
+                            SNameRequest& rRequest = AddNameRequest(rOut, pEntry, "", StringName);
+                            rRequest.pDirSource = pEntry;
+                            rRequest.RequireUnnamed = true;
+                        }
+                    }
+                }
+            }
+
+            // Look for lightmapped models - these are going to be unique to this area
+            else if (pInst->ObjectTypeID() == 0x0 || pInst->ObjectTypeID() == FOURCC('ACTR') ||
+                     pInst->ObjectTypeID() == 0x8 || pInst->ObjectTypeID() == FOURCC('PLAT'))
+            {
+                uint32 ModelPropID = (pProj->Game() <= EGame::Prime ? (pInst->ObjectTypeID() == 0x0 ? 0xA : 0x6) : 0xC27FFA8F);
+                CAssetProperty *pModelProperty = TPropCast<CAssetProperty>(pProperties->ChildByID(ModelPropID));
+                ASSERT(pModelProperty); // Temporary assert to remind myself later to update this code when uncooked properties are added to the template
+
+                if (pModelProperty)
+                {
+                    CAssetID ModelID = pModelProperty->Value(pInst->PropertyData());
+                    CResourceEntry *pEntry = pStore->FindEntry(ModelID);
+
+                    if (pEntry && !rkPlan.IsCategorized(pEntry))
+                    {
+                        CModel *pModel = (CModel*) pEntry->Load();
+
+                        if (pModel && pModel->IsLightmapped())
+                        {
+                            SNameRequest& rRequest = AddNameRequest(rOut, pEntry, AreaCookedDir, "");
+                            rRequest.pNameSource = pEntry;
+                            rRequest.RequireUncategorized = true;
+                        }
+                    }
+                }
+            }
         }
     }
-#endif
 
-#if PROCESS_WORLDS
-    // Generate world/area names
-    debugf("Processing worlds");
-    const TString kWorldsRoot = "Worlds/";
+    // Other area assets
+    CResourceEntry *pPathEntry = pStore->FindEntry(pArea->PathID());
+    CResourceEntry *pPoiMapEntry = pArea->PoiToWorldMap() ? pArea->PoiToWorldMap()->Entry() : nullptr;
+    CResourceEntry *pPortalEntry = pStore->FindEntry(pArea->PortalAreaID());
+
+    if (pPathEntry)
+        AddNameRequest(rOut, pPathEntry, rkWorldMasterDir, rkAreaName);
+
+    if (pPoiMapEntry)
+        AddNameRequest(rOut, pPoiMapEntry, rkWorldMasterDir, rkAreaName);
 
-    for (TResourceIterator<EResourceType::World> It(pStore); It; ++It)
+    if (pPortalEntry)
+        AddNameRequest(rOut, pPortalEntry, rkWorldMasterDir, rkAreaName);
+}
+
+void GatherWorldNames(CAssetNamePlan& rPlan, CWorkerPool& rPool, CGameProject *pProj)
+{
+    struct SAreaNames
     {
+        CResourceEntry *pAreaEntry;
+        TString AreaName;
+        TString WorldDir;
+        TString WorldMasterDir;
+        TNameRequestList AreaRequests;
+        TNameRequestList DependencyRequests;
+    };
+
+    struct SWorldNames
+    {
+        TNameRequestList WorldRequests;
+        std::vector<SAreaNames> Areas;
+    };
+
+    CResourceStore *pStore = rPlan.Store();
+    std::vector<CResourceEntry*> WorldEntries = EntriesOfType(pStore, EResourceType::World);
+    std::vector<SWorldNames> Worlds(WorldEntries.size());
+
+    // Generate world/area names
+    rPool.ParallelFor(WorldEntries.size(), [pStore, &WorldEntries, &Worlds](uint WorldIdx)
+    {
+        CResourceLoadContext Context(pStore);
+        CResourceEntry *pWorldEntry = WorldEntries[WorldIdx];
+        TNameRequestList& rOut = Worlds[WorldIdx].WorldRequests;
+        const TString kWorldsRoot = "Worlds/";
+
         // Set world name
-        TResPtr<CWorld> pWorld = It->Load();
+        CWorld *pWorld = (CWorld*) pWorldEntry->Load();
+        if (!pWorld) return;
+
         TString WorldName = pWorld->Name();
         TString WorldDir = kWorldsRoot + WorldName + '/';
 
         TString WorldMasterName = "!" + WorldName + "_Master";
         TString WorldMasterDir = WorldDir + WorldMasterName + '/';
-        ApplyGeneratedName(*It, WorldMasterDir, WorldMasterName);
+        AddNameRequest(rOut, pWorldEntry, WorldMasterDir, WorldMasterName);
 
         // Move world stuff
         const TString WorldNamesDir = "Strings/Worlds/General/";
@@ -154,16 +703,17 @@ void GenerateAssetNames(CGameProject *pProj)
         CResource *pMapWorld = pWorld->MapWorld();
 
         if (pSaveWorld)
-            ApplyGeneratedName(pSaveWorld->Entry(), WorldMasterDir, WorldMasterName);
+            AddNameRequest(rOut, pSaveWorld->Entry(), WorldMasterDir, WorldMasterName);
 
         if (pMapWorld)
-            ApplyGeneratedName(pMapWorld->Entry(), WorldMasterDir, WorldMasterName);
+            AddNameRequest(rOut, pMapWorld->Entry(), WorldMasterDir, WorldMasterName);
 
-        if (pSkyModel && !pSkyModel->Entry()->IsCategorized())
+        if (pSkyModel)
         {
             // Move sky model
             CResourceEntry *pSkyEntry = pSkyModel->Entry();
-            ApplyGeneratedName(pSkyEntry, WorldDir + "sky/cooked/", WorldName + "_sky");
+            SNameRequest& rSkyRequest = AddNameRequest(rOut, pSkyEntry, WorldDir + "sky/cooked/", WorldName + "_sky");
+            rSkyRequest.RequireUncategorized = true;
 
             // Move sky textures
             for (uint32 iSet = 0; iSet < pSkyModel->GetMatSetCount(); iSet++)
@@ -179,23 +729,22 @@ void GenerateAssetNames(CGameProject *pProj)
                         CMaterialPass *pPass = pMat->Pass(iPass);
 
                         if (pPass->Texture())
-                            ApplyGeneratedName(pPass->Texture()->Entry(), WorldDir + "sky/sourceimages/", pPass->Texture()->Entry()->Name());
+                        {
+                            CResourceEntry *pTexEntry = pPass->Texture()->Entry();
+                            SNameRequest& rTexRequest = AddNameRequest(rOut, pTexEntry, WorldDir + "sky/sourceimages/", "");
+                            rTexRequest.pNameSource = pTexEntry;
+                            rTexRequest.InheritCondition = true;
+                        }
                     }
                 }
             }
         }
 
         if (pWorldNameTable)
-        {
-            CResourceEntry *pNameEntry = pWorldNameTable->Entry();
-            ApplyGeneratedName(pNameEntry, WorldNamesDir, WorldName);
-        }
+            AddNameRequest(rOut, pWorldNameTable->Entry(), WorldNamesDir, WorldName);
 
         if (pDarkWorldNameTable)
-        {
-            CResourceEntry *pDarkNameEntry = pDarkWorldNameTable->Entry();
-            ApplyGeneratedName(pDarkNameEntry, WorldNamesDir, WorldName + "Dark");
-        }
+            AddNameRequest(rOut, pDarkWorldNameTable->Entry(), WorldNamesDir, WorldName + "Dark");
 
         // Areas
         for (uint32 iArea = 0; iArea < pWorld->NumAreas(); iArea++)
@@ -210,11 +759,13 @@ void GenerateAssetNames(CGameProject *pProj)
             // Rename area stuff
             CResourceEntry *pAreaEntry = pStore->FindEntry(AreaID);
             if (!pAreaEntry) continue; // Some DKCR worlds reference areas that don't exist
-            ApplyGeneratedName(pAreaEntry, WorldMasterDir, AreaName);
+
+            SAreaNames Area { pAreaEntry, AreaName, WorldDir, WorldMasterDir };
+            AddNameRequest(Area.AreaRequests, pAreaEntry, WorldMasterDir, AreaName);
 
             CStringTable *pAreaNameTable = pWorld->AreaName(iArea);
             if (pAreaNameTable)
-                ApplyGeneratedName(pAreaNameTable->Entry(), AreaNamesDir, AreaName);
+                AddNameRequest(Area.AreaRequests, pAreaNameTable->Entry(), AreaNamesDir, AreaName);
 
             if (pMapWorld)
             {
@@ -225,188 +776,107 @@ void GenerateAssetNames(CGameProject *pProj)
                 CResourceEntry *pMapEntry = pStore->FindEntry(MapID);
                 ASSERT(pMapEntry != nullptr);
 
-                ApplyGeneratedName(pMapEntry, WorldMasterDir, AreaName);
+                AddNameRequest(Area.AreaRequests, pMapEntry, WorldMasterDir, AreaName);
             }
 
-#if PROCESS_AREAS
-            // Move area dependencies
-            TString AreaCookedDir = WorldDir + AreaName + "/cooked/";
-            CGameArea *pArea = (CGameArea*) pAreaEntry->Load();
-
-            // Area lightmaps
-            uint32 LightmapNum = 0;
-            CMaterialSet *pMaterials = pArea->Materials();
-
-            for (uint32 iMat = 0; iMat < pMaterials->NumMaterials(); iMat++)
-            {
-                CMaterial *pMat = pMaterials->MaterialByIndex(iMat);
-                bool FoundLightmap = false;
-
-                for (uint32 iPass = 0; iPass < pMat->PassCount(); iPass++)
-                {
-                    CMaterialPass *pPass = pMat->Pass(iPass);
-
-                    bool IsLightmap = ( (pArea->Game() <= EGame::Echoes && pMat->Options().HasFlag(EMaterialOption::Lightmap) && iPass == 0) ||
-                                        (pArea->Game() >= EGame::CorruptionProto && pPass->Type() == "DIFF") );
-                    bool IsBloomLightmap = (pArea->Game() >= EGame::CorruptionProto && pPass->Type() == "BLOL");
-
-                    TString TexName;
-
-                    if (IsLightmap)
-                    {
-                        TexName = TString::Format("%s_lit_lightmap%d", *AreaName, LightmapNum);
-                    }
-                    else if (IsBloomLightmap)
-                    {
-                        TexName = TString::Format("%s_lit_lightmap_bloom%d", *AreaName, LightmapNum);
-                    }
-
-                    if (!TexName.IsEmpty())
-                    {
-                        CTexture *pLightmapTex = pPass->Texture();
-                        CResourceEntry *pTexEntry = pLightmapTex->Entry();
-                        if (pTexEntry->IsCategorized()) continue;
-
-                        ApplyGeneratedName(pTexEntry, AreaCookedDir, TexName);
-                        pTexEntry->SetHidden(true);
-                        FoundLightmap = true;
-                    }
-                }
-
-                if (FoundLightmap)
-                    LightmapNum++;
-            }
-
-            // Generate names from script instance names
-            for (uint32 iLyr = 0; iLyr < pArea->NumScriptLayers(); iLyr++)
-            {
-                CScriptLayer *pLayer = pArea->ScriptLayer(iLyr);
-
-                for (uint32 iInst = 0; iInst < pLayer->NumInstances(); iInst++)
-                {
-                    CScriptObject* pInst = pLayer->InstanceByIndex(iInst);
-                    CStructProperty* pProperties = pInst->Template()->Properties();
-
-                    if (pInst->ObjectTypeID() == 0x42 || pInst->ObjectTypeID() == FOURCC('POIN'))
-                    {
-                        TString Name = pInst->InstanceName();
-
-                        if (Name.StartsWith("POI_", false))
-                        {
-                            TIDString ScanIDString = (pProj->Game() <= EGame::Prime ? "0x4:0x0" : "0xBDBEC295:0xB94E9BE7");
-                            CAssetProperty *pScanProperty = TPropCast<CAssetProperty>(pProperties->ChildByIDString(ScanIDString));
-                            ASSERT(pScanProperty); // Temporary assert to remind myself later to update this code when uncooked properties are added to the template
-
-                            if (pScanProperty)
-                            {
-                                CAssetID ScanID = pScanProperty->Value(pInst->PropertyData());
-                                CResourceEntry *pEntry = pStore->FindEntry(ScanID);
-
-                                if (pEntry && !pEntry->IsNamed())
-                                {
-                                    TString ScanName = Name.ChopFront(4);
-
-                                    if (ScanName.EndsWith(".SCAN", false))
-                                        ScanName = ScanName.ChopBack(5);
-
-                                    ApplyGeneratedName(pEntry, pEntry->DirectoryPath(), ScanName);
-
-                                    CScan *pScan = (CScan*) pEntry->Load();
-                                    if (pScan)
-                                    {
-                                        CAssetID StringID = pScan->ScanStringPropertyRef();
-                                        CResourceEntry* pStringEntry = gpResourceStore->FindEntry(StringID);
+            Worlds[WorldIdx].Areas.push_back( std::move(Area) );
+        }
+    });
 
-                                        if (pStringEntry)
-                                        {
-                                            ApplyGeneratedName(pStringEntry, pStringEntry->DirectoryPath(), ScanName);
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
+#if PROCESS_AREAS
+    // Areas are the most expensive resources to load, so they get a job each instead of being loaded by their world's job
+    std::vector<SAreaNames*> Areas;
 
-                    else if (pInst->ObjectTypeID() == 0x17 || pInst->ObjectTypeID() == FOURCC('MEMO'))
-                    {
-                        TString Name = pInst->InstanceName();
+    for (SWorldNames& rWorld : Worlds)
+    {
+        for (SAreaNames& rArea : rWorld.Areas)
+            Areas.push_back(&rArea);
+    }
 
-                        if (Name.EndsWith(".STRG", false))
-                        {
-                            uint32 StringPropID = (pProj->Game() <= EGame::Prime ? 0x4 : 0x9182250C);
-                            CAssetProperty *pStringProperty = TPropCast<CAssetProperty>(pProperties->ChildByID(StringPropID));
-                            ASSERT(pStringProperty); // Temporary assert to remind myself later to update this code when uncooked properties are added to the template
+    const CAssetNamePlan& rkPlan = rPlan;
 
-                            if (pStringProperty)
-                            {
-                                CAssetID StringID = pStringProperty->Value(pInst->PropertyData());
-                                CResourceEntry *pEntry = pStore->FindEntry(StringID);
-
-                                if (pEntry && !pEntry->IsNamed())
-                                {
-                                    TString StringName = Name.ChopBack(5);
+    rPool.ParallelFor(Areas.size(), [pStore, pProj, &rkPlan, &Areas](uint AreaIdx)
+    {
+        CResourceLoadContext Context(pStore);
+        SAreaNames& rArea = *Areas[AreaIdx];
+        GatherAreaNames(rkPlan, pProj, rArea.pAreaEntry, rArea.AreaName, rArea.WorldDir, rArea.WorldMasterDir, rArea.DependencyRequests);
+    });
+#endif
 
-                                    if (StringName.StartsWith("HUDMemo - "))
-                                        StringName = StringName.ChopFront(10);
+    for (const SWorldNames& rkWorld : Worlds)
+    {
+        rPlan.Apply(rkWorld.WorldRequests);
 
-                                    ApplyGeneratedName(pEntry, pEntry->DirectoryPath(), StringName);
-                                }
-                            }
-                        }
-                    }
+        for (const SAreaNames& rkArea : rkWorld.Areas)
+        {
+            rPlan.Apply(rkArea.AreaRequests);
+            rPlan.Apply(rkArea.DependencyRequests);
+        }
+    }
+}
 
-                    // Look for lightmapped models - these are going to be unique to this area
-                    else if (pInst->ObjectTypeID() == 0x0 || pInst->ObjectTypeID() == FOURCC('ACTR') ||
-                             pInst->ObjectTypeID() == 0x8 || pInst->ObjectTypeID() == FOURCC('PLAT'))
-                    {
-                        uint32 ModelPropID = (pProj->Game() <= EGame::Prime ? (pInst->ObjectTypeID() == 0x0 ? 0xA : 0x6) : 0xC27FFA8F);
-                        CAssetProperty *pModelProperty = TPropCast<CAssetProperty>(pProperties->ChildByID(ModelPropID));
-                        ASSERT(pModelProperty); // Temporary assert to remind myself later to update this code when uncooked properties are added to the template
+// ************ NAME GENERATION ************
+void GenerateAssetNames(CGameProject *pProj)
+{
+    debugf("*** Generating Asset Names ***");
+    CResourceStore *pStore = pProj->ResourceStore();
 
-                        if (pModelProperty)
-                        {
-                            CAssetID ModelID = pModelProperty->Value(pInst->PropertyData());
-                            CResourceEntry *pEntry = pStore->FindEntry(ModelID);
+    // Make sure gpResourceStore points to this store. Loaders on the worker threads resolve dependencies through it,
+    // so it must not change until all names have been gathered.
+    CResourceStore *pOldStore = gpResourceStore;
+    gpResourceStore = pStore;
 
-                            if (pEntry && !pEntry->IsCategorized())
-                            {
-                                CModel *pModel = (CModel*) pEntry->Load();
+    // Make sure audio manager is loaded correctly so AGSC dependencies can be looked up, that nothing
+    // that loaders lazily initialize gets initialized from several threads at once, and that editor
+    // display assets are already loaded, since the workers can't load them into gpEditorStore
+    pProj->AudioManager()->LoadAssets();
+    CResourceLoadContext::PrepareStore(pStore);
 
-                                if (pModel->IsLightmapped())
-                                    ApplyGeneratedName(pEntry, AreaCookedDir, pEntry->Name());
-                            }
-                        }
-                    }
-                }
-            }
+    CAssetNamePlan Plan(pStore, REVERT_AUTO_NAMES);
+    CWorkerPool Pool;
 
-            // Other area assets
-            CResourceEntry *pPathEntry = pStore->FindEntry(pArea->PathID());
-            CResourceEntry *pPoiMapEntry = pArea->PoiToWorldMap() ? pArea->PoiToWorldMap()->Entry() : nullptr;
-            CResourceEntry *pPortalEntry = pStore->FindEntry(pArea->PortalAreaID());
+#if PROCESS_PACKAGES
+    // Generate names for package named resources
+    debugf("Processing packages");
 
-            if (pPathEntry)
-                ApplyGeneratedName(pPathEntry, WorldMasterDir, AreaName);
+    for (uint32 iPkg = 0; iPkg < pProj->NumPackages(); iPkg++)
+    {
+        CPackage *pPkg = pProj->PackageByIndex(iPkg);
+        TNameRequestList Requests;
 
-            if (pPoiMapEntry)
-                ApplyGeneratedName(pPoiMapEntry, WorldMasterDir, AreaName);
+        for (uint32 iRes = 0; iRes < pPkg->NumNamedResources(); iRes++)
+        {
+            const SNamedResource& rkRes = pPkg->NamedResourceByIndex(iRes);
+            if (rkRes.Name.EndsWith("NODEPEND")) continue;
 
-            if (pPortalEntry)
-                ApplyGeneratedName(pPortalEntry, WorldMasterDir, AreaName);
+            // Some of Retro's paks reference assets that don't exist, so we need this check here.
+            CResourceEntry *pRes = pStore->FindEntry(rkRes.ID);
 
-            pStore->DestroyUnreferencedResources();
-#endif
+            if (pRes)
+                AddNameRequest(Requests, pRes, pPkg->Name(), rkRes.Name);
         }
+
+        Plan.Apply(Requests);
     }
 #endif
 
+#if PROCESS_WORLDS
+    debugf("Processing worlds");
+    GatherWorldNames(Plan, Pool, pProj);
+#endif
+
 #if PROCESS_MODELS
     // Generate Model Lightmap names
     debugf("Processing model lightmaps");
+    const CAssetNamePlan& rkPlan = Plan;
 
-    for (TResourceIterator<EResourceType::Model> It(pStore); It; ++It)
+    GatherNames(Plan, Pool, EntriesOfType(pStore, EResourceType::Model), [&rkPlan](CResourceEntry *pEntry, TNameRequestList& rOut)
     {
-        CModel *pModel = (CModel*) It->Load();
+        CModel *pModel = (CModel*) pEntry->Load();
+        if (!pModel) return;
+
+        // Textures that were already handled by an earlier material count as named.
+        std::set<CResourceEntry*> NamedTextures;
         uint32 LightmapNum = 0;
 
         for (uint32 iSet = 0; iSet < pModel->GetMatSetCount(); iSet++)
@@ -428,51 +898,56 @@ void GenerateAssetNames(CGameProject *pProj)
                     {
                         CTexture *pLightmapTex = pPass->Texture();
                         CResourceEntry *pTexEntry = pLightmapTex->Entry();
-                        if (pTexEntry->IsNamed() || pTexEntry->IsCategorized()) continue;
-
-                        TString TexName = TString::Format("%s_lightmap%d", *It->Name(), LightmapNum);
-                        ApplyGeneratedName(pTexEntry, pModel->Entry()->DirectoryPath(), TexName);
-                        pTexEntry->SetHidden(true);
+                        if (rkPlan.IsNamed(pTexEntry) || rkPlan.IsCategorized(pTexEntry) || NamedTextures.find(pTexEntry) != NamedTextures.end()) continue;
+
+                        SNameRequest& rRequest = AddNameRequest(rOut, pTexEntry, "", TString::Format("_lightmap%d", LightmapNum));
+                        rRequest.pDirSource = pEntry;
+                        rRequest.pNameSource = pEntry;
+                        rRequest.RequireUnnamed = true;
+                        rRequest.RequireUncategorized = true;
+                        rRequest.Hide = true;
+                        NamedTextures.insert(pTexEntry);
                         LightmapNum++;
                     }
                 }
             }
         }
-
-        pStore->DestroyUnreferencedResources();
-    }
+    });
 #endif
 
 #if PROCESS_AUDIO_GROUPS
     // Generate Audio Group names
     debugf("Processing audio groups");
-    const TString kAudioGrpDir = "Audio/";
 
-    for (TResourceIterator<EResourceType::AudioGroup> It(pStore); It; ++It)
+    GatherNames(Plan, Pool, EntriesOfType(pStore, EResourceType::AudioGroup), [](CResourceEntry *pEntry, TNameRequestList& rOut)
     {
-        CAudioGroup *pGroup = (CAudioGroup*) It->Load();
-        TString GroupName = pGroup->GroupName();
-        ApplyGeneratedName(*It, kAudioGrpDir, GroupName);
-    }
+        const TString kAudioGrpDir = "Audio/";
+        CAudioGroup *pGroup = (CAudioGroup*) pEntry->Load();
+
+        if (pGroup)
+            AddNameRequest(rOut, pEntry, kAudioGrpDir, pGroup->GroupName());
+    });
 #endif
 
 #if PROCESS_AUDIO_MACROS
     // Process audio macro/sample names
     debugf("Processing audio macros");
-    const TString kSfxDir = "Audio/Uncategorized/";
 
-    for (TResourceIterator<EResourceType::AudioMacro> It(pStore); It; ++It)
+    GatherNames(Plan, Pool, EntriesOfType(pStore, EResourceType::AudioMacro), [pStore](CResourceEntry *pEntry, TNameRequestList& rOut)
     {
-        CAudioMacro *pMacro = (CAudioMacro*) It->Load();
+        const TString kSfxDir = "Audio/Uncategorized/";
+        CAudioMacro *pMacro = (CAudioMacro*) pEntry->Load();
+        if (!pMacro) return;
+
         TString MacroName = pMacro->MacroName();
-        ApplyGeneratedName(*It, kSfxDir, MacroName);
+        AddNameRequest(rOut, pEntry, kSfxDir, MacroName);
 
         for (uint32 iSamp = 0; iSamp < pMacro->NumSamples(); iSamp++)
         {
             CAssetID SampleID = pMacro->SampleByIndex(iSamp);
             CResourceEntry *pSample = pStore->FindEntry(SampleID);
 
-            if (pSample && !pSample->IsNamed())
+            if (pSample)
             {
                 TString SampleName;
 
@@ -481,26 +956,30 @@ void GenerateAssetNames(CGameProject *pProj)
                 else
                     SampleName = TString::Format("%s_%d", *MacroName, iSamp);
 
-                ApplyGeneratedName(pSample, kSfxDir, SampleName);
+                AddNameRequest(rOut, pSample, kSfxDir, SampleName).RequireUnnamed = true;
             }
         }
-    }
+    });
 #endif
 
 #if PROCESS_ANIM_CHAR_SETS
     // Generate animation format names
-    // Hacky syntax because animsets are under eAnimSet in MP1/2 and eCharacter in MP3/DKCR
+    // Animsets are under eAnimSet in MP1/2 and eCharacter in MP3/DKCR
     debugf("Processing animation data");
-    CResourceIterator *pIter = (pProj->Game() <= EGame::Echoes ?
-                                    (CResourceIterator*) new TResourceIterator<EResourceType::AnimSet> :
-                                    (CResourceIterator*) new TResourceIterator<EResourceType::Character>);
-    CResourceIterator& It = *pIter;
+    EResourceType SetType = (pProj->Game() <= EGame::Echoes ? EResourceType::AnimSet : EResourceType::Character);
 
-    for (; It; ++It)
+    GatherNames(Plan, Pool, EntriesOfType(pStore, SetType), [pStore, pProj](CResourceEntry *pEntry, TNameRequestList& rOut)
     {
-        TString SetDir = It->DirectoryPath();
+        // Everything is moved into the set's directory, which is read from the plan when the requests are applied
         TString NewSetName;
-        CAnimSet *pSet = (CAnimSet*) It->Load();
+        CAnimSet *pSet = (CAnimSet*) pEntry->Load();
+        if (!pSet) return;
+
+        auto AddSetRequest = [pEntry, &rOut](CResourceEntry *pResEntry, const TString& rkName)
+        {
+            if (pResEntry)
+                AddNameRequest(rOut, pResEntry, "", rkName).pDirSource = pEntry;
+        };
 
         for (uint32 iChar = 0; iChar < pSet->NumCharacters(); iChar++)
         {
@@ -509,19 +988,14 @@ void GenerateAssetNames(CGameProject *pProj)
             TString CharName = pkChar->Name;
             if (iChar == 0) NewSetName = CharName;
 
-            if (pkChar->pModel)     ApplyGeneratedName(pkChar->pModel->Entry(), SetDir, CharName);
-            if (pkChar->pSkeleton)  ApplyGeneratedName(pkChar->pSkeleton->Entry(), SetDir, CharName);
-            if (pkChar->pSkin)      ApplyGeneratedName(pkChar->pSkin->Entry(), SetDir, CharName);
+            if (pkChar->pModel)     AddSetRequest(pkChar->pModel->Entry(), CharName);
+            if (pkChar->pSkeleton)  AddSetRequest(pkChar->pSkeleton->Entry(), CharName);
+            if (pkChar->pSkin)      AddSetRequest(pkChar->pSkin->Entry(), CharName);
 
             if (pProj->Game() >= EGame::CorruptionProto && pProj->Game() <= EGame::Corruption && pkChar->ID == 0)
             {
-                CResourceEntry *pAnimDataEntry = gpResourceStore->FindEntry( pkChar->AnimDataID );
-
-                if (pAnimDataEntry)
-                {
-                    TString AnimDataName = TString::Format("%s_animdata", *CharName);
-                    ApplyGeneratedName(pAnimDataEntry, SetDir, AnimDataName);
-                }
+                CResourceEntry *pAnimDataEntry = pStore->FindEntry( pkChar->AnimDataID );
+                AddSetRequest(pAnimDataEntry, TString::Format("%s_animdata", *CharName));
             }
 
             for (uint32 iOverlay = 0; iOverlay < pkChar->OverlayModels.size(); iOverlay++)
@@ -542,21 +1016,16 @@ void GenerateAssetNames(CGameProject *pProj)
                     TString OverlayName = TString::Format("%s_%s", *CharName, *TypeName);
 
                     if (rkOverlay.ModelID.IsValid())
-                    {
-                        CResourceEntry *pModelEntry = pStore->FindEntry(rkOverlay.ModelID);
-                        ApplyGeneratedName(pModelEntry, SetDir, OverlayName);
-                    }
+                        AddSetRequest(pStore->FindEntry(rkOverlay.ModelID), OverlayName);
+
                     if (rkOverlay.SkinID.IsValid())
-                    {
-                        CResourceEntry *pSkinEntry = pStore->FindEntry(rkOverlay.SkinID);
-                        ApplyGeneratedName(pSkinEntry, SetDir, OverlayName);
-                    }
+                        AddSetRequest(pStore->FindEntry(rkOverlay.SkinID), OverlayName);
                 }
             }
         }
 
         if (!NewSetName.IsEmpty())
-            ApplyGeneratedName(*It, SetDir, NewSetName);
+            AddSetRequest(pEntry, NewSetName);
 
         std::set<CAnimPrimitive> AnimPrimitives;
         pSet->GetUniquePrimitives(AnimPrimitives);
@@ -568,26 +1037,28 @@ void GenerateAssetNames(CGameProject *pProj)
 
             if (pAnim)
             {
-                ApplyGeneratedName(pAnim->Entry(), SetDir, rkPrim.Name());
+                AddSetRequest(pAnim->Entry(), rkPrim.Name());
                 CAnimEventData *pEvents = pAnim->EventData();
 
                 if (pEvents)
-                    ApplyGeneratedName(pEvents->Entry(), SetDir, rkPrim.Name());
+                    AddSetRequest(pEvents->Entry(), rkPrim.Name());
             }
         }
-    }
-    delete pIter;
+    });
 #endif
 
 #if PROCESS_STRINGS
     // Generate string names
     debugf("Processing strings");
-    const TString kStringsDir = "Strings/Uncategorized/";
+    std::vector<CResourceEntry*> Strings = EntriesOfType(pStore, EResourceType::StringTable);
+    Strings.erase( std::remove_if(Strings.begin(), Strings.end(), [&Plan](CResourceEntry *pEntry) { return Plan.IsNamed(pEntry); }), Strings.end() );
 
-    for (TResourceIterator<EResourceType::StringTable> It(pStore); It; ++It)
+    GatherNames(Plan, Pool, Strings, [](CResourceEntry *pEntry, TNameRequestList& rOut)
     {
-        if (It->IsNamed()) continue;
-        CStringTable *pString = (CStringTable*) It->Load();
+        const TString kStringsDir = "Strings/Uncategorized/";
+        CStringTable *pString = (CStringTable*) pEntry->Load();
+        if (!pString) return;
+
         TString String;
 
         for (uint32 iStr = 0; iStr < pString->NumStrings() && String.IsEmpty(); iStr++)
@@ -598,68 +1069,86 @@ void GenerateAssetNames(CGameProject *pProj)
             TString Name = String.SubString(0, Math::Min<uint32>(String.Size(), 50)).Trimmed();
             Name.Replace("\n", " ");
 
-            while (Name.EndsWith(".") || TString::IsWhitespace(Name.Back()))
+            while (!Name.IsEmpty() && (Name.EndsWith(".") || TString::IsWhitespace(Name.Back())))
                 Name = Name.ChopBack(1);
 
-            ApplyGeneratedName(pString->Entry(), kStringsDir, Name);
+            AddNameRequest(rOut, pEntry, kStringsDir, Name);
         }
-    }
+    });
 #endif
 
 #if PROCESS_SCANS
-    // Generate scan names
+    // Generate scan names. Scans are named after their string, whose name is read from the plan when the requests are applied.
     debugf("Processing scans");
-    for (TResourceIterator<EResourceType::Scan> It(pStore); It; ++It)
+    std::vector<CResourceEntry*> Scans = EntriesOfType(pStore, EResourceType::Scan);
+    Scans.erase( std::remove_if(Scans.begin(), Scans.end(), [&Plan](CResourceEntry *pEntry) { return Plan.IsNamed(pEntry); }), Scans.end() );
+
+    GatherNames(Plan, Pool, Scans, [pStore, pProj](CResourceEntry *pEntry, TNameRequestList& rOut)
     {
-        if (It->IsNamed()) continue;
-        CScan *pScan = (CScan*) It->Load();
-        TString ScanName;
+        CScan *pScan = (CScan*) pEntry->Load();
+        if (!pScan) return;
 
-        if (ScanName.IsEmpty())
-        {
-            CAssetID StringID = pScan->ScanStringPropertyRef().Get();
-            CStringTable *pString = (CStringTable*) gpResourceStore->LoadResource(StringID, EResourceType::StringTable);
-            if (pString) ScanName = pString->Entry()->Name();
-        }
+        CAssetID StringID = pScan->ScanStringPropertyRef().Get();
+        CResourceEntry *pStringEntry = pStore->FindEntry(StringID);
+        if (!pStringEntry || pStringEntry->ResourceType() != EResourceType::StringTable) return;
 
-        ApplyGeneratedName(pScan->Entry(), It->DirectoryPath(), ScanName);
+        SNameRequest& rScanRequest = AddNameRequest(rOut, pEntry, "", "");
+        rScanRequest.pDirSource = pEntry;
+        rScanRequest.pNameSource = pStringEntry;
 
-        if (!ScanName.IsEmpty() && pProj->Game() <= EGame::Prime)
+        if (pProj->Game() <= EGame::Prime)
         {
             const SScanParametersMP1& kParms = *static_cast<SScanParametersMP1*>(pScan->ScanData().DataPointer());
 
-            CResourceEntry *pEntry = pStore->FindEntry(kParms.GuiFrame);
-            if (pEntry) ApplyGeneratedName(pEntry, pEntry->DirectoryPath(), "ScanFrame");
+            CResourceEntry *pFrameEntry = pStore->FindEntry(kParms.GuiFrame);
+            if (pFrameEntry) AddNameRequest(rOut, pFrameEntry, "", "ScanFrame").pDirSource = pFrameEntry;
 
             for (uint32 iImg = 0; iImg < 4; iImg++)
             {
                 CAssetID ImageID = kParms.ScanImages[iImg].Texture;
                 CResourceEntry *pImgEntry = pStore->FindEntry(ImageID);
-                if (pImgEntry) ApplyGeneratedName(pImgEntry, pImgEntry->DirectoryPath(), TString::Format("%s_Image%d", *ScanName, iImg));
+
+                if (pImgEntry)
+                {
+                    SNameRequest& rImgRequest = AddNameRequest(rOut, pImgEntry, "", TString::Format("_Image%d", iImg));
+                    rImgRequest.pDirSource = pImgEntry;
+                    rImgRequest.pNameSource = pStringEntry;
+                }
             }
         }
-    }
+    });
 #endif
 
 #if PROCESS_FONTS
     // Generate font names
     debugf("Processing fonts");
-    for (TResourceIterator<EResourceType::Font> It(pStore); It; ++It)
+
+    GatherNames(Plan, Pool, EntriesOfType(pStore, EResourceType::Font), [](CResourceEntry *pEntry, TNameRequestList& rOut)
     {
-        CFont *pFont = (CFont*) It->Load();
+        CFont *pFont = (CFont*) pEntry->Load();
 
         if (pFont)
         {
-            ApplyGeneratedName(pFont->Entry(), pFont->Entry()->DirectoryPath(), pFont->FontName());
+            AddNameRequest(rOut, pEntry, "", pFont->FontName()).pDirSource = pEntry;
 
             CTexture *pFontTex = pFont->Texture();
 
             if (pFontTex)
-                ApplyGeneratedName(pFontTex->Entry(), pFont->Entry()->DirectoryPath(), pFont->Entry()->Name() + "_tex");
+            {
+                SNameRequest& rTexRequest = AddNameRequest(rOut, pFontTex->Entry(), "", "_tex");
+                rTexRequest.pDirSource = pEntry;
+                rTexRequest.pNameSource = pEntry;
+            }
         }
-    }
+    });
 #endif
 
+    gpResourceStore = pOldStore;
+
+    // Apply the plan
+    uint32 NumMoved = Plan.Commit();
+    debugf("Moved %d resources", NumMoved);
+
     pStore->RootDirectory()->DeleteEmptySubdirectories();
     pStore->ConditionalSaveStore();
     debugf("*** Asset Name Generation FINISHED ***");
@@ -0,0 +1,352 @@
+#include "CAsyncResourceLoader.h"
+#include "CResourceEntry.h"
+#include "CResourceLoadContext.h"
+#include "CResourceStore.h"
+#include "Core/CWorkerPool.h"
+#include "Core/Resource/CResource.h"
+#include <Common/Log.h>
+#include <Common/Macros.h>
+#include <Common/Math/MathUtil.h>
+#include <algorithm>
+
+// ************ CResourceLoadHandle ************
+CResource* CResourceLoadHandle::Get() const
+{
+    // Load() picks up the result of the request, or loads the resource on this thread if the request didn't go through
+    return mpEntry ? mpEntry->Load() : nullptr;
+}
+
+// ************ CAsyncResourceLoader ************
+std::thread::id CAsyncResourceLoader::smMainThreadID;
+
+CAsyncResourceLoader::CAsyncResourceLoader(CResourceStore *pStore)
+    : mpStore(pStore)
+    , mGeneration(0)
+{
+    ASSERT(mpStore);
+}
+
+CAsyncResourceLoader::~CAsyncResourceLoader()
+{
+    // Queued jobs still run when the pool shuts down, but they're all cancelled at this point
+    CancelAll();
+    mpPool.reset();
+
+    // The store destroys unreferenced orphans along with its own resources, so anything left has circular references
+    if (!mOrphanedResources.empty())
+        warnf("Async resource loader leaked %d resources with circular references", (uint32) mOrphanedResources.size());
+}
+
+CResourceLoadHandle CAsyncResourceLoader::Load(CResourceEntry *pEntry)
+{
+    ASSERT(pEntry->ResourceStore() == mpStore);
+
+    // Nothing to do if the resource is already loaded
+    if (pEntry->IsLoaded())
+        return CResourceLoadHandle(pEntry, nullptr);
+
+    std::shared_ptr<SAsyncLoadRequest> pRequest = mRequestsByEntry.Find(pEntry->ID());
+
+    if (pRequest)
+    {
+        // Somebody wants the result now, so a new prefetch must not drop it
+        pRequest->IsPrefetch = false;
+        return CResourceLoadHandle(pEntry, pRequest);
+    }
+
+    // Loaders read gpResourceStore, so only the active store can load in the background
+    if (gpResourceStore != mpStore)
+    {
+        pEntry->Load();
+        return CResourceLoadHandle(pEntry, nullptr);
+    }
+
+    CResourceLoadContext::PrepareStore(mpStore);
+    pRequest = QueueRequest(std::vector<CResourceEntry*>(1, pEntry), false);
+    return CResourceLoadHandle(pEntry, pRequest);
+}
+
+void CAsyncResourceLoader::Prefetch(const std::vector<CResourceEntry*>& rkEntries)
+{
+    // Prefetching is only worthwhile if it doesn't get in the way; skip it if the store isn't active
+    if (gpResourceStore != mpStore)
+        return;
+
+    // Done first, since preloading editor assets can cancel the requests that are checked below
+    CResourceLoadContext::PrepareStore(mpStore);
+
+    // A new prefetch replaces the previous one. Keep earlier prefetches that only cover entries we still want.
+    TAssetMap<bool> Wanted;
+    Wanted.Reserve(rkEntries.size());
+
+    for (CResourceEntry *pEntry : rkEntries)
+        Wanted.Insert(pEntry->ID(), true);
+
+    std::vector< std::shared_ptr<SAsyncLoadRequest> > Requests = mRequests;
+
+    for (const std::shared_ptr<SAsyncLoadRequest>& rkRequest : Requests)
+    {
+        if (!rkRequest->IsPrefetch || rkRequest->IsDropped)
+            continue;
+
+        bool KeepRequest = true;
+
+        for (CResourceEntry *pEntry : rkRequest->Entries)
+        {
+            if (!Wanted.Contains(pEntry->ID()))
+            {
+                KeepRequest = false;
+                break;
+            }
+        }
+
+        if (!KeepRequest)
+            DropRequest(rkRequest);
+    }
+
+    Update();
+
+    // Queue everything that isn't loaded or on its way as one request, so resources shared between the entries are only loaded once
+    std::vector<CResourceEntry*> NewEntries;
+    TAssetMap<bool> Queued;
+
+    for (CResourceEntry *pEntry : rkEntries)
+    {
+        ASSERT(pEntry->ResourceStore() == mpStore);
+
+        if (!pEntry->IsLoaded() && !mRequestsByEntry.Contains(pEntry->ID()) && !Queued.Contains(pEntry->ID()))
+        {
+            NewEntries.push_back(pEntry);
+            Queued.Insert(pEntry->ID(), true);
+        }
+    }
+
+    if (!NewEntries.empty())
+        QueueRequest(NewEntries, true);
+}
+
+bool CAsyncResourceLoader::FinishLoad(CResourceEntry *pEntry)
+{
+    // Called from CResourceEntry::Load for every resource that isn't loaded, so keep the common case fast
+    if (mRequests.empty())
+        return false;
+
+    std::shared_ptr<SAsyncLoadRequest> pRequest = mRequestsByEntry.Find(pEntry->ID());
+    if (!pRequest) return false;
+
+    // If no worker has picked the request up yet, load it right here instead of waiting for the queue.
+    // Otherwise, wait for the worker to finish it.
+    RunRequest(*pRequest);
+    WaitForRequest(*pRequest);
+    RemoveRequest(pRequest);
+
+    if (pRequest->State == SAsyncLoadRequest::EState::Finished)
+        AttachRequest(*pRequest);
+
+    return pEntry->IsLoaded();
+}
+
+void CAsyncResourceLoader::Update()
+{
+    // Free the results of dropped requests once their workers are done with them
+    for (uint32 ReqIdx = mRequests.size(); ReqIdx-- > 0;)
+    {
+        std::shared_ptr<SAsyncLoadRequest> pRequest = mRequests[ReqIdx];
+
+        if (pRequest->IsDropped && pRequest->IsDone())
+        {
+            DiscardRequest(*pRequest);
+            mRequests.erase(mRequests.begin() + ReqIdx);
+        }
+    }
+}
+
+void CAsyncResourceLoader::CancelAll()
+{
+    // Called before every change to the store, so keep the common case fast
+    if (mRequests.empty())
+        return;
+
+    // A worker waiting for its own request here would never wake up
+    ASSERT(IsMainThread());
+    mGeneration++;
+
+    // Anything a worker is in the middle of loading may read the data that's about to change, so wait for it
+    for (const std::shared_ptr<SAsyncLoadRequest>& rkRequest : mRequests)
+    {
+        TryCancelRequest(*rkRequest);
+        WaitForRequest(*rkRequest);
+        DiscardRequest(*rkRequest);
+    }
+
+    mRequests.clear();
+    mRequestsByEntry.Clear();
+}
+
+uint32 CAsyncResourceLoader::DestroyUnreferencedOrphans()
+{
+    return CResourceLoadContext::DeleteUnreferencedResources(mOrphanedResources);
+}
+
+std::shared_ptr<SAsyncLoadRequest> CAsyncResourceLoader::QueueRequest(const std::vector<CResourceEntry*>& rkEntries, bool IsPrefetch)
+{
+    ASSERT(gpResourceStore == mpStore);
+    ASSERT(IsMainThread());
+
+    if (!mpPool)
+    {
+        // Leave a core free for the UI thread
+        uint NumThreads = Math::Max<uint>(CWorkerPool::DefaultThreadCount(), 2) - 1;
+        mpPool = std::make_unique<CWorkerPool>(NumThreads);
+    }
+
+    // Callers prepare the store with CResourceLoadContext::PrepareStore first, so the workers never have
+    // to load anything into another store (such as editor display assets into gpEditorStore)
+    std::shared_ptr<SAsyncLoadRequest> pRequest = std::make_shared<SAsyncLoadRequest>();
+    pRequest->Entries = rkEntries;
+    pRequest->Generation = mGeneration;
+    pRequest->IsPrefetch = IsPrefetch;
+
+    mRequests.push_back(pRequest);
+
+    for (CResourceEntry *pEntry : rkEntries)
+        mRequestsByEntry.Insert(pEntry->ID(), pRequest);
+
+    mpPool->AddJob([this, pRequest]()
+    {
+        RunRequest(*pRequest);
+    });
+
+    return pRequest;
+}
+
+void CAsyncResourceLoader::RunRequest(SAsyncLoadRequest& rRequest)
+{
+    // Claim the request. This fails if another thread got to it first, or if it was cancelled.
+    SAsyncLoadRequest::EState Expected = SAsyncLoadRequest::EState::Queued;
+
+    if (!rRequest.State.compare_exchange_strong(Expected, SAsyncLoadRequest::EState::Loading))
+        return;
+
+    SAsyncLoadRequest::EState NewState = SAsyncLoadRequest::EState::Cancelled;
+
+    if (rRequest.Generation == mGeneration)
+    {
+        // Everything is loaded into one context, so resources shared by the entries are only loaded once
+        CResourceLoadContext Context(mpStore);
+
+        for (CResourceEntry *pEntry : rRequest.Entries)
+            pEntry->Load();
+
+        rRequest.Resources = Context.ReleaseResources();
+        NewState = SAsyncLoadRequest::EState::Finished;
+    }
+
+    {
+        std::lock_guard<std::mutex> Lock(mFinishedMutex);
+        rRequest.State = NewState;
+    }
+    mRequestFinished.notify_all();
+}
+
+void CAsyncResourceLoader::WaitForRequest(SAsyncLoadRequest& rRequest)
+{
+    std::unique_lock<std::mutex> Lock(mFinishedMutex);
+    mRequestFinished.wait(Lock, [&rRequest]() { return rRequest.State != SAsyncLoadRequest::EState::Loading; });
+}
+
+void CAsyncResourceLoader::RemoveRequest(const std::shared_ptr<SAsyncLoadRequest>& rkRequest)
+{
+    auto Iter = std::find(mRequests.begin(), mRequests.end(), rkRequest);
+    if (Iter != mRequests.end()) mRequests.erase(Iter);
+
+    for (CResourceEntry *pEntry : rkRequest->Entries)
+    {
+        if (mRequestsByEntry.Find(pEntry->ID()) == rkRequest)
+            mRequestsByEntry.Erase(pEntry->ID());
+    }
+}
+
+void CAsyncResourceLoader::DropRequest(const std::shared_ptr<SAsyncLoadRequest>& rkRequest)
+{
+    // A request that's being loaded can't be interrupted; it's discarded by Update once it's finished
+    RemoveRequest(rkRequest);
+    TryCancelRequest(*rkRequest);
+
+    if (rkRequest->IsDone())
+        DiscardRequest(*rkRequest);
+    else
+    {
+        rkRequest->IsDropped = true;
+        mRequests.push_back(rkRequest);
+    }
+}
+
+bool CAsyncResourceLoader::TryCancelRequest(SAsyncLoadRequest& rRequest)
+{
+    SAsyncLoadRequest::EState Expected = SAsyncLoadRequest::EState::Queued;
+    return rRequest.State.compare_exchange_strong(Expected, SAsyncLoadRequest::EState::Cancelled);
+}
+
+void CAsyncResourceLoader::AttachRequest(SAsyncLoadRequest& rRequest)
+{
+    ASSERT(rRequest.State == SAsyncLoadRequest::EState::Finished);
+
+    // The store or the files may have changed since the request was loaded
+    if (rRequest.Generation != mGeneration)
+    {
+        DiscardRequest(rRequest);
+        return;
+    }
+
+    std::vector<CResource*> AttachedResources;
+    AttachedResources.reserve(rRequest.Resources.size());
+
+    for (CResource *pRes : rRequest.Resources)
+    {
+        CResourceEntry *pEntry = pRes->Entry();
+
+        if (pEntry->IsLoaded())
+            mOrphanedResources.push_back(pRes);
+
+        else
+        {
+            pEntry->mpResource = pRes;
+            mpStore->TrackLoadedResource(pEntry);
+            AttachedResources.push_back(pRes);
+        }
+    }
+
+    rRequest.Resources.clear();
+
+    for (CResource *pRes : AttachedResources)
+        pRes->OnBackgroundLoadAttached();
+
+    DestroyUnreferencedOrphans();
+}
+
+void CAsyncResourceLoader::DiscardRequest(SAsyncLoadRequest& rRequest)
+{
+    if (rRequest.Resources.empty())
+        return;
+
+    CResourceLoadContext::DeleteUnreferencedResources(rRequest.Resources);
+
+    if (!rRequest.Resources.empty())
+    {
+        warnf("Async resource loader leaked %d resources with circular references", (uint32) rRequest.Resources.size());
+        rRequest.Resources.clear();
+    }
+}
+
+// ************ STATIC ************
+void CAsyncResourceLoader::SetMainThread()
+{
+    smMainThreadID = std::this_thread::get_id();
+}
+
+bool CAsyncResourceLoader::IsMainThread()
+{
+    // Until the main thread is set, assume every thread is, so tools that never set it still work
+    return smMainThreadID == std::thread::id() || smMainThreadID == std::this_thread::get_id();
+}
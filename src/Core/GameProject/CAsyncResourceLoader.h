@@ -0,0 +1,140 @@
+#ifndef CASYNCRESOURCELOADER_H
+#define CASYNCRESOURCELOADER_H
+
+#include "TAssetMap.h"
+#include <Common/BasicTypes.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class CResource;
+class CResourceEntry;
+class CResourceStore;
+class CWorkerPool;
+
+/** One batch of entries loaded together on a worker thread */
+struct SAsyncLoadRequest
+{
+    enum class EState
+    {
+        Queued,     // Waiting for a worker
+        Loading,    // A worker is loading the entries
+        Finished,   // Loaded; waiting to be attached to the entries on the main thread
+        Cancelled   // Never loaded
+    };
+
+    std::vector<CResourceEntry*> Entries;
+    std::vector<CResource*> Resources;  // Everything the worker loaded, in load order. Only valid once finished.
+    std::atomic<EState> State;
+    uint32 Generation;
+    bool IsPrefetch;
+    bool IsDropped;     // Nobody is going to pick the result up; discard it once it's finished
+
+    SAsyncLoadRequest()
+        : State(EState::Queued), Generation(0), IsPrefetch(false), IsDropped(false) {}
+
+    inline bool IsDone() const  { EState CurState = State; return CurState == EState::Finished || CurState == EState::Cancelled; }
+};
+
+/** Future-style handle to a resource that is being loaded in the background */
+class CResourceLoadHandle
+{
+    CResourceEntry *mpEntry;
+    std::shared_ptr<SAsyncLoadRequest> mpRequest;
+
+public:
+    CResourceLoadHandle()
+        : mpEntry(nullptr) {}
+
+    CResourceLoadHandle(CResourceEntry *pEntry, const std::shared_ptr<SAsyncLoadRequest>& rkRequest)
+        : mpEntry(pEntry), mpRequest(rkRequest) {}
+
+    /** Returns the resource, waiting for the background load to finish if needed. Main thread only. */
+    CResource* Get() const;
+
+    template<typename ResType> ResType* Get() const  { return static_cast<ResType*>(Get()); }
+
+    // Accessors
+    inline bool IsValid() const                 { return mpEntry != nullptr; }
+    inline bool IsReady() const                 { return !mpRequest || mpRequest->IsDone(); }
+    inline CResourceEntry* Entry() const        { return mpEntry; }
+};
+
+/**
+ * Loads resources for a store on a background worker pool.
+ * Each request is loaded into a private CResourceLoadContext on a worker thread, so the
+ * parsing of raw and cooked assets happens entirely off the main thread. The finished
+ * resources are handed over to their entries on the main thread the next time one of the
+ * requested entries is loaded, so callers keep calling CResourceEntry::Load() as before.
+ * GL buffers aren't touched by any loader; resources create them lazily when they are first
+ * drawn, which always happens on the UI thread.
+ *
+ * Loader functions read gpResourceStore, so background loads only happen while the loader's
+ * store is the active store. Loading from another store on the main thread cancels them first.
+ *
+ * The store bumps the loader's generation counter (through CancelAll) before anything that
+ * changes the store or the files on disk. Requests from an older generation are skipped if
+ * they haven't started yet and discarded if they have, so a stale copy of a resource is never
+ * attached to its entry. Polling a request is lock-free; the mutex is only used to sleep while
+ * waiting for a request that is in the middle of loading.
+ *
+ * Unless noted otherwise, every function must be called from the main thread. Store operations
+ * that run on other threads (such as cooking or rebuilding the database) must call CancelAll()
+ * on the main thread before they start, and nothing may be loaded in the background until they
+ * finish. Worker threads never cancel requests; a request's own worker can't wait for it.
+ */
+class CAsyncResourceLoader
+{
+    CResourceStore *mpStore;
+    std::unique_ptr<CWorkerPool> mpPool;
+    std::atomic<uint32> mGeneration;
+
+    // Requests that haven't been attached or discarded yet, and a lookup for them by entry
+    std::vector< std::shared_ptr<SAsyncLoadRequest> > mRequests;
+    TAssetMap< std::shared_ptr<SAsyncLoadRequest> > mRequestsByEntry;
+
+    // Resources from finished requests whose entries were loaded on the main thread in the meantime.
+    // Other resources from the same request may still reference them, so they're kept until they're unreferenced.
+    std::vector<CResource*> mOrphanedResources;
+
+    std::mutex mFinishedMutex;
+    std::condition_variable mRequestFinished;
+
+    static std::thread::id smMainThreadID;
+
+public:
+    explicit CAsyncResourceLoader(CResourceStore *pStore);
+    ~CAsyncResourceLoader();
+
+    CResourceLoadHandle Load(CResourceEntry *pEntry);
+    void Prefetch(const std::vector<CResourceEntry*>& rkEntries);
+    bool FinishLoad(CResourceEntry *pEntry);
+    void Update();
+    void CancelAll();
+    uint32 DestroyUnreferencedOrphans();
+
+    static void SetMainThread();
+    static bool IsMainThread();
+
+    CAsyncResourceLoader(const CAsyncResourceLoader&) = delete;
+    CAsyncResourceLoader& operator=(const CAsyncResourceLoader&) = delete;
+
+    // Accessors
+    inline uint32 NumPendingRequests() const    { return mRequests.size(); }
+    inline uint32 Generation() const            { return mGeneration; }
+
+protected:
+    std::shared_ptr<SAsyncLoadRequest> QueueRequest(const std::vector<CResourceEntry*>& rkEntries, bool IsPrefetch);
+    void RunRequest(SAsyncLoadRequest& rRequest);
+    void WaitForRequest(SAsyncLoadRequest& rRequest);
+    void RemoveRequest(const std::shared_ptr<SAsyncLoadRequest>& rkRequest);
+    void DropRequest(const std::shared_ptr<SAsyncLoadRequest>& rkRequest);
+    bool TryCancelRequest(SAsyncLoadRequest& rRequest);
+    void AttachRequest(SAsyncLoadRequest& rRequest);
+    void DiscardRequest(SAsyncLoadRequest& rRequest);
+};
+
+#endif // CASYNCRESOURCELOADER_H
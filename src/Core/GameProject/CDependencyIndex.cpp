@@ -0,0 +1,323 @@
+#include "CDependencyIndex.h"
+#include "CDependencyTree.h"
+#include "CGameProject.h"
+#include "CResourceEntry.h"
+#include "CResourceIterator.h"
+#include "CResourceStore.h"
+#include <Common/Macros.h>
+#include <algorithm>
+
+CDependencyIndex::CDependencyIndex(CResourceStore *pStore)
+    : mpStore(pStore)
+    , mIsBuilt(false)
+    , mPackagesDirty(true)
+{
+    ASSERT(mpStore);
+}
+
+void CDependencyIndex::Clear()
+{
+    // Rebuilt on the next query
+    std::vector<SNode>().swap(mNodes);
+    mNodeIndices.Clear();
+    mPackages.clear();
+    mIsBuilt = false;
+    mPackagesDirty = true;
+}
+
+void CDependencyIndex::UpdateEntry(CResourceEntry *pEntry)
+{
+    // Nothing to keep up to date until somebody queries the index
+    if (!mIsBuilt) return;
+
+    uint32 NodeIdx = FindOrAddNode(pEntry->ID());
+    CResourceEntry *pNodeEntry = (pEntry->IsMarkedForDeletion() ? nullptr : pEntry);
+    SetNodeEntry(NodeIdx, pNodeEntry);
+
+    std::set<CAssetID> Dependencies;
+
+    if (pNodeEntry && pNodeEntry->Dependencies())
+        pNodeEntry->Dependencies()->GetAllResourceReferences(Dependencies);
+
+    SetNodeDependencies(NodeIdx, Dependencies);
+}
+
+void CDependencyIndex::RemoveEntry(const CAssetID& rkID)
+{
+    if (!mIsBuilt) return;
+
+    // Other assets may still reference the ID, so the node itself stays
+    uint32 NodeIdx = FindNode(rkID);
+    if (NodeIdx == -1) return;
+
+    SetNodeEntry(NodeIdx, nullptr);
+    SetNodeDependencies(NodeIdx, std::set<CAssetID>());
+}
+
+void CDependencyIndex::InvalidatePackages()
+{
+    mPackagesDirty = true;
+}
+
+void CDependencyIndex::FindReferencers(const CAssetID& rkID, std::vector<CResourceEntry*>& rOut)
+{
+    if (!mIsBuilt) Build();
+
+    uint32 NodeIdx = FindNode(rkID);
+    if (NodeIdx == -1) return;
+
+    for (uint32 ReferencerIdx : mNodes[NodeIdx].Referencers)
+    {
+        CResourceEntry *pEntry = mNodes[ReferencerIdx].pEntry;
+        if (pEntry) rOut.push_back(pEntry);
+    }
+}
+
+void CDependencyIndex::FindPackagesContaining(const CAssetID& rkID, std::vector<CPackage*>& rOut)
+{
+    if (!mIsBuilt) Build();
+    ConditionalUpdatePackages();
+
+    uint32 NodeIdx = FindNode(rkID);
+    if (NodeIdx == -1) return;
+
+    for (uint32 PackageIdx : mNodes[NodeIdx].Packages)
+        rOut.push_back(mPackages[PackageIdx]);
+}
+
+bool CDependencyIndex::PackageContainsAsset(const CPackage *pkPackage, const CAssetID& rkID)
+{
+    if (!mIsBuilt) Build();
+    ConditionalUpdatePackages();
+
+    uint32 NodeIdx = FindNode(rkID);
+    if (NodeIdx == -1) return false;
+
+    auto PackageIter = std::find(mPackages.begin(), mPackages.end(), pkPackage);
+    if (PackageIter == mPackages.end()) return false;
+
+    const std::vector<uint32>& rkPackages = mNodes[NodeIdx].Packages;
+    return std::binary_search(rkPackages.begin(), rkPackages.end(), (uint32) (PackageIter - mPackages.begin()));
+}
+
+void CDependencyIndex::Build()
+{
+    Clear();
+    mNodes.reserve(mpStore->NumTotalResources());
+    mNodeIndices.Reserve(mpStore->NumTotalResources());
+
+    // Create the nodes for all entries first, so dependencies on them find their types
+    for (CResourceIterator It(mpStore); It; ++It)
+        mNodes[FindOrAddNode(It->ID())].pEntry = *It;
+
+    for (CResourceIterator It(mpStore); It; ++It)
+    {
+        if (!It->Dependencies())
+            continue;
+
+        std::set<CAssetID> Dependencies;
+        It->Dependencies()->GetAllResourceReferences(Dependencies);
+        SetNodeDependencies(FindNode(It->ID()), Dependencies);
+    }
+
+    mIsBuilt = true;
+}
+
+void CDependencyIndex::ConditionalUpdatePackages()
+{
+    // The project's package list can change without telling us; check it matches the one we indexed
+    CGameProject *pProject = mpStore->Project();
+    uint32 NumPackages = (pProject ? pProject->NumPackages() : 0);
+
+    if (!mPackagesDirty && mPackages.size() == NumPackages)
+    {
+        for (uint32 PackageIdx = 0; PackageIdx < NumPackages; PackageIdx++)
+        {
+            if (mPackages[PackageIdx] != pProject->PackageByIndex(PackageIdx))
+            {
+                mPackagesDirty = true;
+                break;
+            }
+        }
+    }
+    else
+        mPackagesDirty = true;
+
+    if (!mPackagesDirty)
+        return;
+
+    mPackages.clear();
+
+    for (SNode& rNode : mNodes)
+        rNode.Packages.clear();
+
+    for (uint32 PackageIdx = 0; PackageIdx < NumPackages; PackageIdx++)
+    {
+        CPackage *pPackage = pProject->PackageByIndex(PackageIdx);
+        mPackages.push_back(pPackage);
+
+        for (uint32 ResIdx = 0; ResIdx < pPackage->NumNamedResources(); ResIdx++)
+        {
+            const SNamedResource& rkRes = pPackage->NamedResourceByIndex(ResIdx);
+            uint32 NodeIdx = FindNode(rkRes.ID);
+
+            if (NodeIdx == -1 || !mNodes[NodeIdx].pEntry)
+                continue;
+
+            // Same rules as CPackageDependencyListBuilder::BuildDependencyList
+            if (rkRes.Name.EndsWith("NODEPEND") || rkRes.Type == "CSNG")
+            {
+                std::vector<uint32>& rPackages = mNodes[NodeIdx].Packages;
+
+                if (rPackages.empty() || rPackages.back() != PackageIdx)
+                    rPackages.push_back(PackageIdx);
+            }
+
+            else if (IsValidPackageAsset(mNodes[NodeIdx].pEntry->ResourceType()))
+                AddToPackage(NodeIdx, PackageIdx);
+        }
+    }
+
+    mPackagesDirty = false;
+}
+
+uint32 CDependencyIndex::FindNode(const CAssetID& rkID) const
+{
+    return mNodeIndices.Find(rkID, (uint32) -1);
+}
+
+uint32 CDependencyIndex::FindOrAddNode(const CAssetID& rkID)
+{
+    uint32 NodeIdx = FindNode(rkID);
+
+    if (NodeIdx == -1)
+    {
+        NodeIdx = mNodes.size();
+        mNodes.emplace_back();
+        mNodes.back().ID = rkID;
+        mNodes.back().pEntry = nullptr;
+        mNodeIndices.Insert(rkID, NodeIdx);
+    }
+
+    return NodeIdx;
+}
+
+void CDependencyIndex::SetNodeEntry(uint32 NodeIdx, CResourceEntry *pEntry)
+{
+    SNode& rNode = mNodes[NodeIdx];
+
+    // Which dependencies are followed into a package depends on the entry's type, so this needs a full package update
+    if ((rNode.pEntry != nullptr) != (pEntry != nullptr))
+        mPackagesDirty = true;
+
+    rNode.pEntry = pEntry;
+}
+
+void CDependencyIndex::SetNodeDependencies(uint32 NodeIdx, const std::set<CAssetID>& rkDependencies)
+{
+    std::vector<uint32> NewDependencies;
+    NewDependencies.reserve(rkDependencies.size());
+
+    for (const CAssetID& rkID : rkDependencies)
+    {
+        if (rkID.IsValid() && rkID != mNodes[NodeIdx].ID)
+            NewDependencies.push_back(FindOrAddNode(rkID));
+    }
+
+    std::sort(NewDependencies.begin(), NewDependencies.end());
+
+    SNode& rNode = mNodes[NodeIdx];
+    std::vector<uint32> AddedDependencies;
+    bool RemovedAny = false;
+
+    for (uint32 OldIdx : rNode.Dependencies)
+    {
+        if (!std::binary_search(NewDependencies.begin(), NewDependencies.end(), OldIdx))
+        {
+            std::vector<uint32>& rReferencers = mNodes[OldIdx].Referencers;
+            rReferencers.erase(std::find(rReferencers.begin(), rReferencers.end(), NodeIdx));
+            RemovedAny = true;
+        }
+    }
+
+    for (uint32 NewIdx : NewDependencies)
+    {
+        if (!std::binary_search(rNode.Dependencies.begin(), rNode.Dependencies.end(), NewIdx))
+        {
+            mNodes[NewIdx].Referencers.push_back(NodeIdx);
+            AddedDependencies.push_back(NewIdx);
+        }
+    }
+
+    rNode.Dependencies = std::move(NewDependencies);
+
+    // Dependencies of assets that aren't in any package don't affect the packages.
+    // Anything removed may or may not still be reachable some other way, so that needs a full update.
+    if (mPackagesDirty || rNode.Packages.empty())
+        return;
+
+    if (RemovedAny)
+    {
+        mPackagesDirty = true;
+        return;
+    }
+
+    std::vector<uint32> Packages = rNode.Packages;
+
+    for (uint32 AddedIdx : AddedDependencies)
+    {
+        if (CanFollowDependency(NodeIdx, AddedIdx))
+        {
+            for (uint32 PackageIdx : Packages)
+                AddToPackage(AddedIdx, PackageIdx);
+        }
+    }
+}
+
+void CDependencyIndex::AddToPackage(uint32 NodeIdx, uint32 PackageIdx)
+{
+    // Flood fill the package through the node's dependencies; asset graphs can get deep, so use an explicit stack
+    std::vector<uint32> Stack(1, NodeIdx);
+
+    while (!Stack.empty())
+    {
+        uint32 CurIdx = Stack.back();
+        Stack.pop_back();
+
+        std::vector<uint32>& rPackages = mNodes[CurIdx].Packages;
+        auto Iter = std::lower_bound(rPackages.begin(), rPackages.end(), PackageIdx);
+
+        if (Iter != rPackages.end() && *Iter == PackageIdx)
+            continue;
+
+        rPackages.insert(Iter, PackageIdx);
+
+        for (uint32 DepIdx : mNodes[CurIdx].Dependencies)
+        {
+            if (CanFollowDependency(CurIdx, DepIdx))
+                Stack.push_back(DepIdx);
+        }
+    }
+}
+
+bool CDependencyIndex::IsValidPackageAsset(EResourceType Type) const
+{
+    return Type != EResourceType::Midi &&
+          (Type != EResourceType::AudioGroup || mpStore->Game() >= EGame::EchoesDemo);
+}
+
+bool CDependencyIndex::CanFollowDependency(uint32 FromIdx, uint32 ToIdx) const
+{
+    // Same rules as CPackageDependencyListBuilder::AddDependency
+    CResourceEntry *pFrom = mNodes[FromIdx].pEntry;
+    CResourceEntry *pTo = mNodes[ToIdx].pEntry;
+    if (!pFrom || !pTo) return false;
+
+    EResourceType FromType = pFrom->ResourceType();
+    EResourceType ToType = pTo->ResourceType();
+
+    return FromType != EResourceType::DependencyGroup &&
+           IsValidPackageAsset(ToType) &&
+           ToType != EResourceType::World &&
+           (ToType != EResourceType::Area || FromType == EResourceType::World);
+}
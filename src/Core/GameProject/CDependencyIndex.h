@@ -0,0 +1,80 @@
+#ifndef CDEPENDENCYINDEX_H
+#define CDEPENDENCYINDEX_H
+
+#include "TAssetMap.h"
+#include "Core/Resource/EResType.h"
+#include <Common/BasicTypes.h>
+#include <Common/CAssetID.h>
+#include <set>
+#include <vector>
+
+class CPackage;
+class CResourceEntry;
+class CResourceStore;
+
+/**
+ * Reverse lookup of the cached dependency trees: which assets reference a given asset, and
+ * which packages it ends up in. Answering either question from the trees alone means walking
+ * every entry in the store (or running a full dependency list build per package), which is
+ * far too slow to do every time a resource is saved.
+ *
+ * The index is built from the entries' cached dependency trees the first time it's queried,
+ * and kept up to date as entries are created, deleted and have their dependencies updated.
+ * Package membership is the set of assets reachable from each package's named resources
+ * following the same traversal rules as CPackageDependencyListBuilder. Character usage and
+ * duplicate filtering are ignored, so it may include a few assets the builder would leave
+ * out, but it never misses one. New dependencies are added to packages incrementally; removed
+ * dependencies and changes to the package list mark the membership dirty, and it is
+ * recalculated on the next package query.
+ *
+ * Main thread only.
+ */
+class CDependencyIndex
+{
+    struct SNode
+    {
+        CAssetID ID;
+        CResourceEntry *pEntry;             // Null if the asset isn't in the store or is marked for deletion
+        std::vector<uint32> Dependencies;   // Sorted node indices
+        std::vector<uint32> Referencers;    // Node indices, unsorted
+        std::vector<uint32> Packages;       // Sorted indices into mPackages
+    };
+
+    CResourceStore *mpStore;
+    std::vector<SNode> mNodes;
+    TAssetMap<uint32> mNodeIndices;
+    std::vector<CPackage*> mPackages;
+    bool mIsBuilt;
+    bool mPackagesDirty;
+
+public:
+    explicit CDependencyIndex(CResourceStore *pStore);
+
+    void Clear();
+    void UpdateEntry(CResourceEntry *pEntry);
+    void RemoveEntry(const CAssetID& rkID);
+    void InvalidatePackages();
+
+    void FindReferencers(const CAssetID& rkID, std::vector<CResourceEntry*>& rOut);
+    void FindPackagesContaining(const CAssetID& rkID, std::vector<CPackage*>& rOut);
+    bool PackageContainsAsset(const CPackage *pkPackage, const CAssetID& rkID);
+
+    CDependencyIndex(const CDependencyIndex&) = delete;
+    CDependencyIndex& operator=(const CDependencyIndex&) = delete;
+
+    // Accessors
+    inline bool IsBuilt() const     { return mIsBuilt; }
+
+protected:
+    void Build();
+    void ConditionalUpdatePackages();
+    uint32 FindNode(const CAssetID& rkID) const;
+    uint32 FindOrAddNode(const CAssetID& rkID);
+    void SetNodeEntry(uint32 NodeIdx, CResourceEntry *pEntry);
+    void SetNodeDependencies(uint32 NodeIdx, const std::set<CAssetID>& rkDependencies);
+    void AddToPackage(uint32 NodeIdx, uint32 PackageIdx);
+    bool IsValidPackageAsset(EResourceType Type) const;
+    bool CanFollowDependency(uint32 FromIdx, uint32 ToIdx) const;
+};
+
+#endif // CDEPENDENCYINDEX_H
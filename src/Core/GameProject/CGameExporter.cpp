@@ -1,9 +1,13 @@
 #include "CGameExporter.h"
+#include "CDependencyTree.h"
 #include "CGameInfo.h"
 #include "CResourceIterator.h"
 #include "CResourceStore.h"
+#include "Core/CMappedFile.h"
 #include "Core/CompressionUtil.h"
+#include "Core/CWorkerPool.h"
 #include "Core/Resource/CWorld.h"
+#include "Core/Resource/TResPtr.h"
 #include "Core/Resource/Script/CGameTemplate.h"
 #include <Common/Macros.h>
 #include <Common/CScopedTimer.h>
@@ -13,11 +17,25 @@
 
 #include <nod/nod.hpp>
 #include <tinyxml2.h>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <list>
+#include <unordered_map>
 
 #define LOAD_PAKS 1
 #define SAVE_PACKAGE_DEFINITIONS 1
 #define USE_ASSET_NAME_MAP 1
 #define EXPORT_COOKED 1
+#define EXPORT_COOKED_MULTITHREADED 1
+
+// Reads a big endian long from a pak mapping and advances the pointer past it
+static inline uint32 ReadMappedLong(const uint8*& rpkData)
+{
+    uint32 Value = ((uint32) rpkData[0] << 24) | ((uint32) rpkData[1] << 16) | ((uint32) rpkData[2] << 8) | (uint32) rpkData[3];
+    rpkData += 4;
+    return Value;
+}
 
 CGameExporter::CGameExporter(EDiscType DiscType, EGame Game, bool FrontEnd, ERegion Region, const TString& rkGameName, const TString& rkGameID, float BuildVersion)
     : mGame(Game)
@@ -76,6 +94,7 @@ bool CGameExporter::Export(nod::DiscBase *pDisc, const TString& rkOutputDir, CAs
 
     // Export cooked data
     LoadPaks();
+    MapPaks();
     ExportCookedResources();
 
     // Export editor data
@@ -86,6 +105,7 @@ bool CGameExporter::Export(nod::DiscBase *pDisc, const TString& rkOutputDir, CAs
     }
 
     // Export finished!
+    UnmapPaks();
     mProjectPath = mpProject->ProjectPath();
     delete mpProject;
     if (pOldStore) gpResourceStore = pOldStore;
@@ -427,106 +447,209 @@ void CGameExporter::LoadPaks()
 
 void CGameExporter::LoadResource(const SResourceInstance& rkResource, std::vector<uint8>& rBuffer)
 {
-    CFileInStream Pak(rkResource.PakFile, EEndian::BigEndian);
+    // Resource data is read straight out of the pak mapping, so nothing here touches the
+    // filesystem and compressed data is decompressed directly into the output buffer.
+    auto MappingIt = mPakMappings.find(rkResource.PakFile);
 
-    if (Pak.IsValid())
+    if (MappingIt == mPakMappings.end() || !MappingIt->second->IsValid())
     {
-        Pak.Seek(rkResource.PakOffset, SEEK_SET);
+        errorf("Couldn't load resource %s; pak is not mapped: %s", *rkResource.ResourceID.ToString(), *rkResource.PakFile);
+        return;
+    }
 
-        // Handle compression
-        if (rkResource.Compressed)
-        {
-            bool ZlibCompressed = (mGame <= EGame::EchoesDemo || mGame == EGame::DKCReturns);
+    const CMappedFile *pkPak = MappingIt->second;
 
-            if (mGame <= EGame::CorruptionProto)
-            {
-                std::vector<uint8> CompressedData(rkResource.PakSize);
+    if (rkResource.PakOffset + rkResource.PakSize > pkPak->Size())
+    {
+        errorf("Couldn't load resource %s; resource data extends past the end of the pak: %s", *rkResource.ResourceID.ToString(), *rkResource.PakFile);
+        return;
+    }
 
-                uint32 UncompressedSize = Pak.ReadLong();
-                rBuffer.resize(UncompressedSize);
-                Pak.ReadBytes(CompressedData.data(), CompressedData.size());
+    const uint8 *pkData = pkPak->Data() + rkResource.PakOffset;
+    const uint8 *pkDataEnd = pkData + rkResource.PakSize;
 
-                if (ZlibCompressed)
-                {
-                    uint32 TotalOut;
-                    CompressionUtil::DecompressZlib(CompressedData.data(), CompressedData.size(), rBuffer.data(), rBuffer.size(), TotalOut);
-                }
-                else
-                {
-                    CompressionUtil::DecompressSegmentedData(CompressedData.data(), CompressedData.size(), rBuffer.data(), rBuffer.size());
-                }
-            }
+    // Handle compression
+    if (rkResource.Compressed)
+    {
+        bool ZlibCompressed = (mGame <= EGame::EchoesDemo || mGame == EGame::DKCReturns);
 
+        if (mGame <= EGame::CorruptionProto)
+        {
+            uint32 UncompressedSize = ReadMappedLong(pkData);
+            uint32 CompressedSize = (uint32) (pkDataEnd - pkData);
+            rBuffer.resize(UncompressedSize);
+
+            if (ZlibCompressed)
+            {
+                uint32 TotalOut;
+                CompressionUtil::DecompressZlib(pkData, CompressedSize, rBuffer.data(), rBuffer.size(), TotalOut);
+            }
             else
             {
-                CFourCC Magic = Pak.ReadLong();
-                ASSERT(Magic == "CMPD");
+                CompressionUtil::DecompressSegmentedData(pkData, CompressedSize, rBuffer.data(), rBuffer.size());
+            }
+        }
 
-                uint32 NumBlocks = Pak.ReadLong();
+        else
+        {
+            CFourCC Magic = ReadMappedLong(pkData);
+            ASSERT(Magic == "CMPD");
 
-                struct SCompressedBlock {
-                    uint32 CompressedSize; uint32 UncompressedSize;
-                };
-                std::vector<SCompressedBlock> CompressedBlocks;
+            uint32 NumBlocks = ReadMappedLong(pkData);
 
-                uint32 TotalUncompressedSize = 0;
-                for (uint32 iBlock = 0; iBlock < NumBlocks; iBlock++)
-                {
-                    uint32 CompressedSize = (Pak.ReadLong() & 0x00FFFFFF);
-                    uint32 UncompressedSize = Pak.ReadLong();
+            struct SCompressedBlock {
+                uint32 CompressedSize; uint32 UncompressedSize;
+            };
+            std::vector<SCompressedBlock> CompressedBlocks;
 
-                    TotalUncompressedSize += UncompressedSize;
-                    CompressedBlocks.push_back( SCompressedBlock { CompressedSize, UncompressedSize } );
-                }
+            uint32 TotalUncompressedSize = 0;
+            for (uint32 iBlock = 0; iBlock < NumBlocks; iBlock++)
+            {
+                uint32 CompressedSize = (ReadMappedLong(pkData) & 0x00FFFFFF);
+                uint32 UncompressedSize = ReadMappedLong(pkData);
 
-                rBuffer.resize(TotalUncompressedSize);
-                uint32 Offset = 0;
+                TotalUncompressedSize += UncompressedSize;
+                CompressedBlocks.push_back( SCompressedBlock { CompressedSize, UncompressedSize } );
+            }
 
-                for (uint32 iBlock = 0; iBlock < NumBlocks; iBlock++)
+            rBuffer.resize(TotalUncompressedSize);
+            uint32 Offset = 0;
+
+            for (uint32 iBlock = 0; iBlock < NumBlocks; iBlock++)
+            {
+                uint32 CompressedSize = CompressedBlocks[iBlock].CompressedSize;
+                uint32 UncompressedSize = CompressedBlocks[iBlock].UncompressedSize;
+
+                if (pkData + CompressedSize > pkDataEnd)
                 {
-                    uint32 CompressedSize = CompressedBlocks[iBlock].CompressedSize;
-                    uint32 UncompressedSize = CompressedBlocks[iBlock].UncompressedSize;
+                    errorf("Couldn't load resource %s; compressed block %d is truncated", *rkResource.ResourceID.ToString(), iBlock);
+                    break;
+                }
 
-                    // Block is compressed
-                    if (CompressedSize != UncompressedSize)
+                // Block is compressed
+                if (CompressedSize != UncompressedSize)
+                {
+                    if (ZlibCompressed)
                     {
-                        std::vector<uint8> CompressedData(CompressedBlocks[iBlock].CompressedSize);
-                        Pak.ReadBytes(CompressedData.data(), CompressedData.size());
-
-                        if (ZlibCompressed)
-                        {
-                            uint32 TotalOut;
-                            CompressionUtil::DecompressZlib(CompressedData.data(), CompressedData.size(), rBuffer.data() + Offset, UncompressedSize, TotalOut);
-                        }
-                        else
-                        {
-                            CompressionUtil::DecompressSegmentedData(CompressedData.data(), CompressedData.size(), rBuffer.data() + Offset, UncompressedSize);
-                        }
+                        uint32 TotalOut;
+                        CompressionUtil::DecompressZlib(pkData, CompressedSize, rBuffer.data() + Offset, UncompressedSize, TotalOut);
                     }
-                    // Block is uncompressed
                     else
-                        Pak.ReadBytes(rBuffer.data() + Offset, UncompressedSize);
-
-                    Offset += UncompressedSize;
+                    {
+                        CompressionUtil::DecompressSegmentedData(pkData, CompressedSize, rBuffer.data() + Offset, UncompressedSize);
+                    }
                 }
+                // Block is uncompressed
+                else
+                    memcpy(rBuffer.data() + Offset, pkData, UncompressedSize);
+
+                pkData += CompressedSize;
+                Offset += UncompressedSize;
             }
         }
+    }
 
-        // Handle uncompressed
-        else
-        {
-            rBuffer.resize(rkResource.PakSize);
-            Pak.ReadBytes(rBuffer.data(), rBuffer.size());
-        }
+    // Handle uncompressed
+    else
+    {
+        rBuffer.assign(pkData, pkDataEnd);
     }
 }
 
+void CGameExporter::MapPaks()
+{
+    // Map every pak once up front. Mappings are read-only after this point,
+    // which allows resources to be extracted from multiple threads at once.
+    for (auto It = mPaks.begin(); It != mPaks.end(); It++)
+    {
+        if (mPakMappings.find(*It) == mPakMappings.end())
+            mPakMappings[*It] = new CMappedFile(*It);
+    }
+}
+
+void CGameExporter::UnmapPaks()
+{
+    for (auto It = mPakMappings.begin(); It != mPakMappings.end(); It++)
+        delete It->second;
+
+    mPakMappings.clear();
+}
+
 void CGameExporter::ExportCookedResources()
 {
     SCOPED_TIMER(ExportCookedResources);
     FileUtil::MakeDirectory(mResourcesDir);
 
     mpProgress->SetTask(eES_ExportCooked, "Unpacking cooked assets");
+
+#if EXPORT_COOKED_MULTITHREADED
+    // Register every resource up front. The resource store isn't thread-safe so this has to be
+    // done on this thread, but it's cheap compared to decompressing and writing the asset data.
+    struct SExportJob
+    {
+        SResourceInstance *pInstance;
+        CResourceEntry *pEntry;
+        TString OutCookedPath;
+    };
+    std::vector<SExportJob> Jobs;
+    Jobs.reserve(mResourceMap.size());
+
+    for (auto It = mResourceMap.begin(); It != mResourceMap.end(); It++)
+    {
+        SResourceInstance& rRes = It->second;
+
+        if (!rRes.Exported)
+        {
+            CResourceEntry *pEntry = RegisterResource(rRes);
+            TString OutCookedPath = pEntry->CookedAssetPath();
+            FileUtil::MakeDirectory(OutCookedPath.GetFileDirectory());
+            Jobs.push_back( SExportJob { &rRes, pEntry, OutCookedPath } );
+        }
+    }
+
+    // Unpack assets on the worker pool. Each job opens its own pak stream, so the only
+    // state shared between jobs is the progress counter and the cancel flag.
+    std::atomic<uint32> NumExported(0);
+    std::atomic<bool> Cancelled(false);
+    CWorkerPool Pool;
+
+    for (uint32 JobIdx = 0; JobIdx < Jobs.size(); JobIdx++)
+    {
+        Pool.AddJob([this, &Jobs, &NumExported, &Cancelled, JobIdx]()
+        {
+            if (Cancelled) return;
+
+            SExportJob& rJob = Jobs[JobIdx];
+            WriteCookedResource(*rJob.pInstance, rJob.OutCookedPath);
+            NumExported++;
+        });
+    }
+
+    // Progress reporting and cancellation are handled on this thread while the workers run
+    while (!Pool.WaitForAll(50))
+    {
+        if (mpProgress->ShouldCancel())
+            Cancelled = true;
+
+        uint32 ResIndex = NumExported;
+        mpProgress->Report(ResIndex, Jobs.size(), TString::Format("Unpacking asset %d/%d", ResIndex, (uint32) Jobs.size()) );
+    }
+
+    if (Cancelled)
+    {
+        // Entries were registered ahead of their files, so unregister the ones that never got written
+        for (SExportJob& rJob : Jobs)
+        {
+            if (!rJob.pInstance->Exported)
+                mpStore->DeleteResourceEntry(rJob.pEntry);
+        }
+    }
+    else
+    {
+        uint32 NumJobs = Jobs.size();
+        mpProgress->Report(NumJobs, NumJobs, TString::Format("Unpacking asset %d/%d", NumJobs, NumJobs) );
+    }
+#else
     int ResIndex = 0;
 
     for (auto It = mResourceMap.begin(); It != mResourceMap.end() && !mpProgress->ShouldCancel(); It++, ResIndex++)
@@ -540,8 +663,68 @@ void CGameExporter::ExportCookedResources()
         // Export resource
         ExportResource(rRes);
     }
+#endif
 }
 
+// Keeps the most recently processed resources loaded while generating editor data, since resources
+// that are processed close together tend to share dependencies (e.g. areas in the same world).
+// The cache is limited by the cooked size of the resources it holds, which is a rough estimate of their
+// memory use. Resources also keep their dependencies loaded, so the actual memory use is higher.
+class CRecentResourceCache
+{
+    struct SCachedResource
+    {
+        TResPtr<CResource> pResource;
+        uint64 Size;
+    };
+
+    typedef std::list<SCachedResource> TResourceList;
+    TResourceList mResources;
+    std::unordered_map<CResource*, TResourceList::iterator> mLookup;
+    uint64 mBudget;
+    uint64 mTotalSize;
+
+public:
+    CRecentResourceCache(uint64 Budget)
+        : mBudget(Budget)
+        , mTotalSize(0)
+    {}
+
+    void Touch(CResource *pRes)
+    {
+        if (!pRes) return;
+        auto Find = mLookup.find(pRes);
+
+        if (Find != mLookup.end())
+        {
+            mResources.splice(mResources.begin(), mResources, Find->second);
+        }
+        else
+        {
+            uint64 Size = pRes->Entry()->Size();
+            mResources.push_front( SCachedResource { TResPtr<CResource>(pRes), Size } );
+            mLookup[pRes] = mResources.begin();
+            mTotalSize += Size;
+
+            // Releasing the oldest resource doesn't unload it right away; it'll be cleaned
+            // up the next time the store destroys unreferenced resources.
+            while (mTotalSize > mBudget && mResources.size() > 1)
+            {
+                mTotalSize -= mResources.back().Size;
+                mLookup.erase(mResources.back().pResource.RawPointer());
+                mResources.pop_back();
+            }
+        }
+    }
+
+    void Clear()
+    {
+        mLookup.clear();
+        mResources.clear();
+        mTotalSize = 0;
+    }
+};
+
 void CGameExporter::ExportResourceEditorData()
 {
     {
@@ -553,46 +736,68 @@ void CGameExporter::ExportResourceEditorData()
         mpProgress->SetTask(eES_GenerateRaw, "Generating editor data");
         int ResIndex = 0;
 
-        // todo: we're wasting a ton of time loading the same resources over and over because most resources automatically
-        // load all their dependencies and then we just clear it out from memory even though we'll need it again later. we
-        // should really be doing this by dependency order instead of by ID order.
-        for (CResourceIterator It(mpStore); It && !mpProgress->ShouldCancel(); ++It, ++ResIndex)
+        // Most resources load all their dependencies when they're loaded, so to avoid loading the same resources over and
+        // over, we walk the dependency graph depth-first starting from worlds and areas. Each resource is kept loaded while
+        // its dependencies are processed, and recently processed resources are kept around in case they're needed again.
+        std::vector<CResourceEntry*> Roots;
+        Roots.reserve(mpStore->NumTotalResources());
+
+        for (CResourceIterator It(mpStore); It; ++It)
+            Roots.push_back(*It);
+
+        std::stable_sort(Roots.begin(), Roots.end(), [](CResourceEntry *pLeft, CResourceEntry *pRight) -> bool {
+            return EditorDataPriority(pLeft->ResourceType()) < EditorDataPriority(pRight->ResourceType());
+        });
+
+        std::set<CResourceEntry*> ProcessedEntries;
+        // A few areas' worth of cooked data; the area dependencies that this keeps loaded add considerably more
+        CRecentResourceCache RecentResources(32 * 1024 * 1024);
+
+        std::function<void(CResourceEntry*)> ProcessEntry = [&](CResourceEntry *pEntry)
         {
+            if (mpProgress->ShouldCancel() || !ProcessedEntries.insert(pEntry).second)
+                return;
+
             // Update progress
-            if ((ResIndex & 0x3) == 0 || It->ResourceType() == EResourceType::Area)
+            if ((ResIndex & 0x3) == 0 || pEntry->ResourceType() == EResourceType::Area)
                 mpProgress->Report(ResIndex, mpStore->NumTotalResources(), TString::Format("Processing asset %d/%d: %s",
-                    ResIndex, mpStore->NumTotalResources(), *It->CookedAssetPath(true).GetFileName()) );
+                    ResIndex, mpStore->NumTotalResources(), *pEntry->CookedAssetPath(true).GetFileName()) );
 
-            // Worlds need some info we can only get from the pak at export time; namely, which areas can
-            // have duplicates, as well as the world's internal name.
-            if (It->ResourceType() == EResourceType::World)
+            // Hold a reference so the resource (and anything it loaded) stays in memory until its dependencies have been processed
+            TResPtr<CResource> pRes;
+
+            if (pEntry->TypeInfo()->CanBeSerialized() || pEntry->TypeInfo()->CanHaveDependencies())
+                pRes = pEntry->Load();
+
+            ExportEntryEditorData(pEntry);
+            ResIndex++;
+
+            // Periodically clean up resources that nothing is holding onto anymore
+            if ((ResIndex & 0x3F) == 0)
+                mpStore->DestroyUnreferencedResources();
+
+            if (pEntry->Dependencies())
             {
-                CWorld *pWorld = (CWorld*) It->Load();
+                std::set<CAssetID> Dependencies;
+                pEntry->Dependencies()->GetAllResourceReferences(Dependencies);
 
-                // Set area duplicate flags
-                for (uint32 iArea = 0; iArea < pWorld->NumAreas(); iArea++)
+                for (auto Iter = Dependencies.begin(); Iter != Dependencies.end(); Iter++)
                 {
-                    CAssetID AreaID = pWorld->AreaResourceID(iArea);
-                    auto Find = mAreaDuplicateMap.find(AreaID);
+                    CResourceEntry *pDependency = mpStore->FindEntry(*Iter);
 
-                    if (Find != mAreaDuplicateMap.end())
-                        pWorld->SetAreaAllowsPakDuplicates(iArea, Find->second);
+                    if (pDependency)
+                        ProcessEntry(pDependency);
                 }
-
-                // Set world name
-                TString WorldName = MakeWorldName(pWorld->ID());
-                pWorld->SetName(WorldName);
             }
 
-            // Save raw resource + generate dependencies
-            if (It->TypeInfo()->CanBeSerialized())
-                It->Save(true);
-            else
-                It->UpdateDependencies();
+            RecentResources.Touch(pRes);
+        };
 
-            // Set flags, save metadata
-            It->SaveMetadata(true);
-        }
+        for (uint32 RootIdx = 0; RootIdx < Roots.size() && !mpProgress->ShouldCancel(); RootIdx++)
+            ProcessEntry(Roots[RootIdx]);
+
+        RecentResources.Clear();
+        mpStore->DestroyUnreferencedResources();
     }
 
     if (!mpProgress->ShouldCancel())
@@ -605,6 +810,56 @@ void CGameExporter::ExportResourceEditorData()
 #endif
         bool ProjectSaveSuccess = mpProject->Save();
         ASSERT(ProjectSaveSuccess);
+
+        uint32 NumResources = mpStore->NumTotalResources();
+        mpProgress->Report(NumResources, NumResources, "Finished generating editor data");
+    }
+}
+
+void CGameExporter::ExportEntryEditorData(CResourceEntry *pEntry)
+{
+    // Worlds need some info we can only get from the pak at export time; namely, which areas can
+    // have duplicates, as well as the world's internal name.
+    if (pEntry->ResourceType() == EResourceType::World)
+    {
+        CWorld *pWorld = (CWorld*) pEntry->Load();
+
+        // Set area duplicate flags
+        for (uint32 iArea = 0; iArea < pWorld->NumAreas(); iArea++)
+        {
+            CAssetID AreaID = pWorld->AreaResourceID(iArea);
+            auto Find = mAreaDuplicateMap.find(AreaID);
+
+            if (Find != mAreaDuplicateMap.end())
+                pWorld->SetAreaAllowsPakDuplicates(iArea, Find->second);
+        }
+
+        // Set world name
+        TString WorldName = MakeWorldName(pWorld->ID());
+        pWorld->SetName(WorldName);
+    }
+
+    // Save raw resource + generate dependencies
+    if (pEntry->TypeInfo()->CanBeSerialized())
+        pEntry->Save(true);
+    else
+        pEntry->UpdateDependencies();
+
+    // Set flags, save metadata
+    pEntry->SaveMetadata(true);
+}
+
+uint32 CGameExporter::EditorDataPriority(EResourceType Type)
+{
+    // Resources that pull in the most dependencies are processed first
+    switch (Type)
+    {
+    case EResourceType::World:          return 0;
+    case EResourceType::Area:           return 1;
+    case EResourceType::AnimSet:
+    case EResourceType::Character:      return 2;
+    case EResourceType::Model:          return 3;
+    default:                            return 4;
     }
 }
 
@@ -612,43 +867,55 @@ void CGameExporter::ExportResource(SResourceInstance& rRes)
 {
     if (!rRes.Exported)
     {
-        std::vector<uint8> ResourceData;
-        LoadResource(rRes, ResourceData);
+        CResourceEntry *pEntry = RegisterResource(rRes);
+        WriteCookedResource(rRes, pEntry->CookedAssetPath());
+#if EXPORT_COOKED
+        ASSERT(pEntry->HasCookedVersion());
+#endif
+    }
+}
 
-        // Register resource and write to file
-        TString Directory, Name;
-        bool AutoDir, AutoName;
+CResourceEntry* CGameExporter::RegisterResource(const SResourceInstance& rkRes)
+{
+    // Register resource with the resource store. Not thread-safe.
+    TString Directory, Name;
+    bool AutoDir, AutoName;
 
 #if USE_ASSET_NAME_MAP
-        mpNameMap->GetNameInfo(rRes.ResourceID, Directory, Name, AutoDir, AutoName);
+    mpNameMap->GetNameInfo(rkRes.ResourceID, Directory, Name, AutoDir, AutoName);
 #else
-        Directory = mpStore->DefaultAssetDirectoryPath(mpStore->Game());
-        Name = rRes.ResourceID.ToString();
+    Directory = mpStore->DefaultAssetDirectoryPath(mpStore->Game());
+    Name = rkRes.ResourceID.ToString();
 #endif
 
-        CResourceEntry *pEntry = mpStore->CreateNewResource(rRes.ResourceID,
-                                                            CResTypeInfo::TypeForCookedExtension(mGame, rRes.ResourceType)->Type(),
-                                                            Directory, Name, true);
+    CResourceEntry *pEntry = mpStore->CreateNewResource(rkRes.ResourceID,
+                                                        CResTypeInfo::TypeForCookedExtension(mGame, rkRes.ResourceType)->Type(),
+                                                        Directory, Name, true);
 
-        // Set flags
-        pEntry->SetFlag(EResEntryFlag::IsBaseGameResource);
-        pEntry->SetFlagEnabled(EResEntryFlag::AutoResDir, AutoDir);
-        pEntry->SetFlagEnabled(EResEntryFlag::AutoResName, AutoName);
+    // Set flags
+    pEntry->SetFlag(EResEntryFlag::IsBaseGameResource);
+    pEntry->SetFlagEnabled(EResEntryFlag::AutoResDir, AutoDir);
+    pEntry->SetFlagEnabled(EResEntryFlag::AutoResName, AutoName);
+    return pEntry;
+}
 
+void CGameExporter::WriteCookedResource(SResourceInstance& rRes, const TString& rkOutCookedPath)
+{
+    // Extract the asset from its pak and write it to the given path. This doesn't access the
+    // resource store, so it's safe to call from worker threads as long as the output directory exists.
 #if EXPORT_COOKED
-        // Save cooked asset
-        TString OutCookedPath = pEntry->CookedAssetPath();
-        FileUtil::MakeDirectory(OutCookedPath.GetFileDirectory());
-        CFileOutStream Out(OutCookedPath, EEndian::BigEndian);
+    std::vector<uint8> ResourceData;
+    LoadResource(rRes, ResourceData);
 
-        if (Out.IsValid())
-            Out.WriteBytes(ResourceData.data(), ResourceData.size());
+    CFileOutStream Out(rkOutCookedPath, EEndian::BigEndian);
 
-        ASSERT(pEntry->HasCookedVersion());
+    if (Out.IsValid())
+        Out.WriteBytes(ResourceData.data(), ResourceData.size());
+    else
+        errorf("Failed to write cooked asset: %s", *rkOutCookedPath);
 #endif
 
-        rRes.Exported = true;
-    }
+    rRes.Exported = true;
 }
 
 TString CGameExporter::MakeWorldName(CAssetID WorldID)
@@ -11,6 +11,8 @@
 #include <map>
 #include <nod/nod.hpp>
 
+class CMappedFile;
+
 enum class EDiscType
 {
     Normal,
@@ -59,6 +61,7 @@ class CGameExporter
         bool Exported;
     };
     std::map<CAssetID, SResourceInstance> mResourceMap;
+    std::map<TString, CMappedFile*> mPakMappings;
 
     // Progress
     IProgressNotifier *mpProgress;
@@ -85,10 +88,16 @@ protected:
     bool ExtractDiscNodeRecursive(const nod::Node *pkNode, const TString& rkDir, bool RootNode, const nod::ExtractionContext& rkContext);
     void LoadPaks();
     void LoadResource(const SResourceInstance& rkResource, std::vector<uint8>& rBuffer);
+    void MapPaks();
+    void UnmapPaks();
     void ExportCookedResources();
     void ExportResourceEditorData();
+    void ExportEntryEditorData(CResourceEntry *pEntry);
     void ExportResource(SResourceInstance& rRes);
+    CResourceEntry* RegisterResource(const SResourceInstance& rkRes);
+    void WriteCookedResource(SResourceInstance& rRes, const TString& rkOutCookedPath);
     TString MakeWorldName(CAssetID WorldID);
+    static uint32 EditorDataPriority(EResourceType Type);
 
     // Convenience Functions
     inline SResourceInstance* FindResourceInstance(const CAssetID& rkID)
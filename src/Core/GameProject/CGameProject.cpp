@@ -35,7 +35,8 @@ bool CGameProject::Serialize(IArchive& rArc)
     rArc << SerialParameter("Name", mProjectName)
          << SerialParameter("Region", mRegion)
          << SerialParameter("GameID", mGameID)
-         << SerialParameter("BuildVersion", mBuildVersion);
+         << SerialParameter("BuildVersion", mBuildVersion)
+         << SerialParameter("CookCompressionLevel", mCookCompressionLevel, SH_Optional, ECompressionLevel::Max);
 
     // Serialize package list
     std::vector<TString> PackageList;
@@ -5,6 +5,7 @@
 #include "CPackage.h"
 #include "CResourceStore.h"
 #include "Core/CAudioManager.h"
+#include "Core/CompressionUtil.h"
 #include "Core/IProgressNotifier.h"
 #include "Core/Resource/Script/CGameTemplate.h"
 #include "Core/Tweaks/CTweakManager.h"
@@ -33,6 +34,7 @@ class CGameProject
     ERegion mRegion;
     TString mGameID;
     float mBuildVersion;
+    ECompressionLevel mCookCompressionLevel;
 
     TString mProjectRoot;
     std::vector<CPackage*> mPackages;
@@ -52,6 +54,7 @@ class CGameProject
         , mRegion(ERegion::Unknown)
         , mGameID("000000")
         , mBuildVersion(0.f)
+        , mCookCompressionLevel(ECompressionLevel::Max)
         , mpResourceStore(nullptr)
     {
         mpGameInfo = std::make_unique<CGameInfo>();
@@ -85,6 +88,7 @@ public:
     inline TString ProjectRoot() const                      { return mProjectRoot; }
     inline TString ProjectPath() const                      { return mProjectRoot + FileUtil::SanitizeName(mProjectName, false) + ".prj"; }
     inline TString HiddenFilesDir() const                   { return mProjectRoot + ".project/"; }
+    inline TString PakCacheDir() const                      { return HiddenFilesDir() + "PakCache/"; }
     inline TString DiscDir(bool Relative) const             { return Relative ? "Disc/" : mProjectRoot + "Disc/"; }
     inline TString PackagesDir(bool Relative) const         { return Relative ? "Packages/" : mProjectRoot + "Packages/"; }
     inline TString ResourcesDir(bool Relative) const        { return Relative ? "Resources/" : mProjectRoot + "Resources/"; }
@@ -94,6 +98,7 @@ public:
 
     // Accessors
     inline void SetProjectName(const TString& rkName)   { mProjectName = rkName; }
+    inline void SetCookCompressionLevel(ECompressionLevel Level) { mCookCompressionLevel = Level; }
 
     inline TString Name() const                         { return mProjectName; }
     inline uint32 NumPackages() const                   { return mPackages.size(); }
@@ -107,7 +112,9 @@ public:
     inline ERegion Region() const                       { return mRegion; }
     inline TString GameID() const                       { return mGameID; }
     inline float BuildVersion() const                   { return mBuildVersion; }
+    inline ECompressionLevel CookCompressionLevel() const { return mCookCompressionLevel; }
     inline bool IsWiiBuild() const                      { return mBuildVersion >= 3.f; }
+    inline bool UsesZlibCompression() const             { return mGame <= EGame::EchoesDemo || mGame == EGame::DKCReturns; }
     inline bool IsTrilogy() const                       { return mGame <= EGame::Corruption && mBuildVersion >= 3.593f; }
     inline bool IsWiiDeAsobu() const                    { return mGame <= EGame::Corruption && mBuildVersion >= 3.570f && mBuildVersion < 3.593f; }
 };
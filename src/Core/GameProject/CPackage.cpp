@@ -1,12 +1,18 @@
 #include "CPackage.h"
+#include "CDependencyIndex.h"
 #include "DependencyListBuilders.h"
 #include "CGameProject.h"
 #include "Core/CompressionUtil.h"
+#include "Core/CWorkerPool.h"
 #include "Core/Resource/Cooker/CWorldCooker.h"
 #include <Common/Macros.h>
 #include <Common/FileIO.h>
 #include <Common/FileUtil.h>
+#include <Common/Hash/CFNV1A.h>
 #include <Common/Serialization/XML.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 
 using namespace tinyxml2;
 
@@ -18,7 +24,7 @@ bool CPackage::Load()
     if (Reader.IsValid())
     {
         Serialize(Reader);
-        mCacheDirty = true;
+        InvalidateDependencyIndex();
         return true;
     }
     else return false;
@@ -43,20 +49,16 @@ void CPackage::Serialize(IArchive& rArc)
 void CPackage::AddResource(const TString& rkName, const CAssetID& rkID, const CFourCC& rkType)
 {
     mResources.push_back( SNamedResource { rkName, rkID, rkType } );
-    mCacheDirty = true;
+    InvalidateDependencyIndex();
 }
 
-void CPackage::UpdateDependencyCache() const
+void CPackage::InvalidateDependencyIndex()
 {
-    CPackageDependencyListBuilder Builder(this);
-    std::list<CAssetID> AssetList;
-    Builder.BuildDependencyList(false, AssetList);
+    // The store's dependency index tracks which assets are in each package
+    CResourceStore *pStore = (mpProject ? mpProject->ResourceStore() : nullptr);
 
-    mCachedDependencies.clear();
-    for (auto Iter = AssetList.begin(); Iter != AssetList.end(); Iter++)
-        mCachedDependencies.insert(*Iter);
-
-    mCacheDirty = false;
+    if (pStore)
+        pStore->DependencyIndex()->InvalidatePackages();
 }
 
 void CPackage::MarkDirty()
@@ -65,10 +67,182 @@ void CPackage::MarkDirty()
     {
         mNeedsRecook = true;
         Save();
-        UpdateDependencyCache();
     }
 }
 
+struct SPackedAsset
+{
+    std::vector<uint8> Data;
+    uint32 DataSize;
+    uint32 UncompressedSize;
+    bool Compressed;
+};
+
+// Pak cache files store the compressed payload of an asset so it doesn't need to be recompressed
+// when the pak is recooked. They are keyed by asset ID + a hash of the cooked asset data, and are
+// only reused if they were compressed at the same compression level.
+const uint32 kPakCacheMagic = FOURCC('PCCH');
+const uint32 kPakCacheVersion = 2;
+
+static bool LoadCachedAsset(const TString& rkCachePath, uint64 ContentHash, uint32 UncompressedSize, ECompressionLevel Level, SPackedAsset& rOut)
+{
+    CFileInStream Cache(rkCachePath, EEndian::BigEndian);
+
+    if (!Cache.IsValid() || Cache.Size() < 0x16)
+        return false;
+
+    uint32 Magic = Cache.ReadLong();
+    uint32 Version = Cache.ReadLong();
+    uint64 CachedHash = Cache.ReadLongLong();
+    uint32 CachedUncompressedSize = Cache.ReadLong();
+
+    if (Magic != kPakCacheMagic || Version != kPakCacheVersion || CachedHash != ContentHash || CachedUncompressedSize != UncompressedSize)
+        return false;
+
+    ECompressionLevel CachedLevel = (ECompressionLevel) Cache.ReadByte();
+
+    if (CachedLevel != Level)
+        return false;
+
+    rOut.UncompressedSize = UncompressedSize;
+    rOut.Compressed = (Cache.ReadByte() != 0);
+
+    // If the asset is cached as uncompressed, that means compression didn't make it any smaller
+    if (rOut.Compressed)
+    {
+        rOut.DataSize = Cache.ReadLong();
+
+        if (Cache.Size() - Cache.Tell() < rOut.DataSize)
+            return false;
+
+        rOut.Data.resize(rOut.DataSize);
+        Cache.ReadBytes(rOut.Data.data(), rOut.DataSize);
+    }
+
+    return true;
+}
+
+static void SaveCachedAsset(const TString& rkCachePath, uint64 ContentHash, ECompressionLevel Level, const SPackedAsset& rkAsset)
+{
+    CFileOutStream Cache(rkCachePath, EEndian::BigEndian);
+
+    if (!Cache.IsValid())
+    {
+        warnf("Failed to write pak cache file: %s", *rkCachePath);
+        return;
+    }
+
+    Cache.WriteLong(kPakCacheMagic);
+    Cache.WriteLong(kPakCacheVersion);
+    Cache.WriteLongLong(ContentHash);
+    Cache.WriteLong(rkAsset.UncompressedSize);
+    Cache.WriteByte((uint8) Level);
+    Cache.WriteByte(rkAsset.Compressed ? 1 : 0);
+
+    if (rkAsset.Compressed)
+    {
+        Cache.WriteLong(rkAsset.DataSize);
+        Cache.WriteBytes(rkAsset.Data.data(), rkAsset.DataSize);
+    }
+}
+
+// Loads a cooked asset and compresses it if it should be compressed in the pak, reusing the
+// compressed data from the pak cache if the asset hasn't changed since it was last cooked.
+// Doesn't access the resource store, so it's safe to call from worker threads.
+static void PackAsset(const CAssetID& rkID, EResourceType Type, const TString& rkCookedPath, const TString& rkCacheDir, EGame Game,
+                      ECompressionLevel Level, SPackedAsset& rOut)
+{
+    uint32 Alignment = (Game <= EGame::CorruptionProto ? 0x20 : 0x40);
+    uint32 AlignmentMinusOne = Alignment - 1;
+
+    // Load resource data
+    CFileInStream CookedAsset(rkCookedPath, EEndian::BigEndian);
+    ASSERT(CookedAsset.IsValid());
+    uint32 ResourceSize = CookedAsset.Size();
+
+    std::vector<uint8> ResourceData(ResourceSize);
+    CookedAsset.ReadBytes(ResourceData.data(), ResourceData.size());
+
+    rOut.UncompressedSize = ResourceSize;
+    rOut.Compressed = false;
+
+    // Check if this asset should be compressed; there are a few resource types that are
+    // always compressed, and some types that are compressed if they're over a certain size
+    uint32 CompressThreshold = (Game <= EGame::CorruptionProto ? 0x400 : 0x80);
+
+    bool ShouldAlwaysCompress = (Type == EResourceType::Texture || Type == EResourceType::Model ||
+                                 Type == EResourceType::Skin || Type == EResourceType::AnimSet ||
+                                 Type == EResourceType::Animation || Type == EResourceType::Font);
+
+    if (Game >= EGame::Corruption)
+    {
+        ShouldAlwaysCompress = ShouldAlwaysCompress ||
+                               (Type == EResourceType::Character || Type == EResourceType::SourceAnimData ||
+                                Type == EResourceType::Scan || Type == EResourceType::AudioSample ||
+                                Type == EResourceType::StringTable || Type == EResourceType::AudioAmplitudeData ||
+                                Type == EResourceType::DynamicCollision);
+    }
+
+    bool ShouldCompressConditional = !ShouldAlwaysCompress &&
+            (Type == EResourceType::Particle || Type == EResourceType::ParticleElectric ||
+             Type == EResourceType::ParticleSwoosh || Type == EResourceType::ParticleWeapon ||
+             Type == EResourceType::ParticleDecal || Type == EResourceType::ParticleCollisionResponse ||
+             Type == EResourceType::ParticleSpawn || Type == EResourceType::ParticleSorted ||
+             Type == EResourceType::BurstFireData);
+
+    bool ShouldCompress = ShouldAlwaysCompress || (ShouldCompressConditional && ResourceSize >= CompressThreshold);
+
+    if (ShouldCompress)
+    {
+        // Check whether we already have compressed data for this exact asset
+        CFNV1A Hash(CFNV1A::k64Bit);
+        Hash.HashData(ResourceData.data(), ResourceData.size());
+        uint64 ContentHash = Hash.GetHash64();
+        TString CachePath = rkCacheDir + rkID.ToString() + ".pcache";
+
+        if (LoadCachedAsset(CachePath, ContentHash, ResourceSize, Level, rOut))
+        {
+            if (!rOut.Compressed)
+            {
+                rOut.Data = std::move(ResourceData);
+                rOut.DataSize = ResourceSize;
+            }
+            return;
+        }
+
+        uint32 CompressedSize;
+        std::vector<uint8> CompressedData(ResourceData.size() * 2);
+        bool Success = false;
+
+        if (Game <= EGame::EchoesDemo || Game == EGame::DKCReturns)
+            Success = CompressionUtil::CompressZlib(ResourceData.data(), ResourceData.size(), CompressedData.data(), CompressedData.size(), CompressedSize, Level);
+        else
+            Success = CompressionUtil::CompressLZOSegmented(ResourceData.data(), ResourceData.size(), CompressedData.data(), CompressedSize, false, Level);
+
+        // Make sure that the compressed data is actually smaller, accounting for padding + uncompressed size value
+        if (Success)
+        {
+            uint32 CompressionHeaderSize = (Game <= EGame::CorruptionProto ? 4 : 0x10);
+            uint32 PaddedUncompressedSize = (ResourceSize + AlignmentMinusOne) & ~AlignmentMinusOne;
+            uint32 PaddedCompressedSize = (CompressedSize + CompressionHeaderSize + AlignmentMinusOne) & ~AlignmentMinusOne;
+            Success = (PaddedCompressedSize < PaddedUncompressedSize);
+        }
+
+        if (Success)
+        {
+            rOut.Data = std::move(CompressedData);
+            rOut.DataSize = CompressedSize;
+            rOut.Compressed = true;
+        }
+
+        SaveCachedAsset(CachePath, ContentHash, Level, rOut);
+        if (Success) return;
+    }
+
+    rOut.Data = std::move(ResourceData);
+    rOut.DataSize = ResourceSize;
+}
+
 void CPackage::Cook(IProgressNotifier *pProgress)
 {
     SCOPED_TIMER(CookPackage);
@@ -93,7 +267,6 @@ void CPackage::Cook(IProgressNotifier *pProgress)
 
     EGame Game = mpProject->Game();
     uint32 Alignment = (Game <= EGame::CorruptionProto ? 0x20 : 0x40);
-    uint32 AlignmentMinusOne = Alignment - 1;
 
     uint32 TocOffset = 0;
     uint32 NamesSize = 0;
@@ -163,7 +336,31 @@ void CPackage::Cook(IProgressNotifier *pProgress)
     Pak.WriteToBoundary(Alignment, 0);
     ResTableSize = Pak.Tell() - ResTableOffset;
 
-    // Start writing resources
+    // Recook any assets that need it. This touches the resource store, so it has to happen on this thread
+    // before any compression jobs are started.
+    std::vector<CResourceEntry*> Entries;
+    std::vector<TString> CookedPaths;
+    Entries.reserve(AssetList.size());
+    CookedPaths.reserve(AssetList.size());
+
+    for (auto Iter = AssetList.begin(); Iter != AssetList.end() && !pProgress->ShouldCancel(); Iter++)
+    {
+        CAssetID ID = *Iter;
+        CResourceEntry *pEntry = gpResourceStore->FindEntry(ID);
+        ASSERT(pEntry != nullptr);
+
+        if (pEntry->NeedsRecook())
+        {
+            pProgress->Report(Entries.size(), AssetList.size(), "Cooking asset: " + pEntry->Name() + "." + pEntry->CookedExtension());
+            pEntry->Cook();
+        }
+
+        Entries.push_back(pEntry);
+        CookedPaths.push_back(pEntry->CookedAssetPath());
+    }
+
+    // Start writing resources. Assets are loaded and compressed on the worker pool ahead of the writer,
+    // and written back in AssetList order, so the output is identical to compressing them one at a time.
     struct SResourceTableInfo
     {
         CResourceEntry *pEntry;
@@ -172,23 +369,48 @@ void CPackage::Cook(IProgressNotifier *pProgress)
         bool Compressed;
     };
     std::vector<SResourceTableInfo> ResourceTableData(AssetList.size());
+    std::vector<SPackedAsset> PackedAssets(Entries.size());
+    std::vector<bool> PackedAssetReady(Entries.size(), false);
+    std::mutex ReadyMutex;
+    std::condition_variable ReadyCondition;
+    std::atomic<bool> Cancelled( pProgress->ShouldCancel() );
+
+    TString CacheDir = mpProject->PakCacheDir();
+    FileUtil::MakeDirectory(CacheDir);
+    ECompressionLevel CompressionLevel = mpProject->CookCompressionLevel();
+
+    // Declared after everything the jobs reference so that it's destroyed (and its jobs finished) first
+    CWorkerPool Pool;
+    uint32 MaxAssetsInFlight = Pool.NumThreads() * 4;
+    uint32 NumQueuedAssets = 0;
+
     uint32 ResIdx = 0;
     uint32 ResDataOffset = Pak.Tell();
 
-    for (auto Iter = AssetList.begin(); Iter != AssetList.end() && !pProgress->ShouldCancel(); Iter++, ResIdx++)
+    for (; ResIdx < Entries.size() && !Cancelled; ResIdx++)
     {
-        // Initialize entry, recook assets if needed
-        uint32 AssetOffset = Pak.Tell();
-        CAssetID ID = *Iter;
-        CResourceEntry *pEntry = gpResourceStore->FindEntry(ID);
-        ASSERT(pEntry != nullptr);
+        // Keep the workers a limited number of assets ahead of the writer so we don't hold the whole pak in memory
+        uint32 QueueLimit = Math::Min<uint32>(Entries.size(), ResIdx + MaxAssetsInFlight);
 
-        if (pEntry->NeedsRecook())
+        for (; NumQueuedAssets < QueueLimit; NumQueuedAssets++)
         {
-            pProgress->Report(ResIdx, AssetList.size(), "Cooking asset: " + pEntry->Name() + "." + pEntry->CookedExtension());
-            pEntry->Cook();
+            uint32 JobIdx = NumQueuedAssets;
+
+            Pool.AddJob([&, JobIdx]()
+            {
+                if (!Cancelled)
+                    PackAsset(Entries[JobIdx]->ID(), Entries[JobIdx]->ResourceType(), CookedPaths[JobIdx], CacheDir, Game, CompressionLevel, PackedAssets[JobIdx]);
+
+                std::lock_guard<std::mutex> Lock(ReadyMutex);
+                PackedAssetReady[JobIdx] = true;
+                ReadyCondition.notify_all();
+            });
         }
 
+        // Initialize entry
+        uint32 AssetOffset = Pak.Tell();
+        CResourceEntry *pEntry = Entries[ResIdx];
+
         // Update progress bar
         if (ResIdx & 0x1 || ResIdx == AssetList.size() - 1)
         {
@@ -200,103 +422,52 @@ void CPackage::Cook(IProgressNotifier *pProgress)
         rTableInfo.pEntry = pEntry;
         rTableInfo.Offset = (Game <= EGame::Echoes ? AssetOffset : AssetOffset - ResDataOffset);
 
-        // Load resource data
-        CFileInStream CookedAsset(pEntry->CookedAssetPath(), EEndian::BigEndian);
-        ASSERT(CookedAsset.IsValid());
-        uint32 ResourceSize = CookedAsset.Size();
-
-        std::vector<uint8> ResourceData(ResourceSize);
-        CookedAsset.ReadBytes(ResourceData.data(), ResourceData.size());
-
-        // Check if this asset should be compressed; there are a few resource types that are
-        // always compressed, and some types that are compressed if they're over a certain size
-        EResourceType Type = pEntry->ResourceType();
-        uint32 CompressThreshold = (Game <= EGame::CorruptionProto ? 0x400 : 0x80);
-
-        bool ShouldAlwaysCompress = (Type == EResourceType::Texture || Type == EResourceType::Model ||
-                                     Type == EResourceType::Skin || Type == EResourceType::AnimSet ||
-                                     Type == EResourceType::Animation || Type == EResourceType::Font);
-
-        if (Game >= EGame::Corruption)
+        // Wait for the asset to finish compressing
         {
-            ShouldAlwaysCompress = ShouldAlwaysCompress ||
-                                   (Type == EResourceType::Character || Type == EResourceType::SourceAnimData ||
-                                    Type == EResourceType::Scan || Type == EResourceType::AudioSample ||
-                                    Type == EResourceType::StringTable || Type == EResourceType::AudioAmplitudeData ||
-                                    Type == EResourceType::DynamicCollision);
+            std::unique_lock<std::mutex> Lock(ReadyMutex);
+            ReadyCondition.wait(Lock, [&]() { return PackedAssetReady[ResIdx]; });
         }
 
-        bool ShouldCompressConditional = !ShouldAlwaysCompress &&
-                (Type == EResourceType::Particle || Type == EResourceType::ParticleElectric ||
-                 Type == EResourceType::ParticleSwoosh || Type == EResourceType::ParticleWeapon ||
-                 Type == EResourceType::ParticleDecal || Type == EResourceType::ParticleCollisionResponse ||
-                 Type == EResourceType::ParticleSpawn || Type == EResourceType::ParticleSorted ||
-                 Type == EResourceType::BurstFireData);
-
-        bool ShouldCompress = ShouldAlwaysCompress || (ShouldCompressConditional && ResourceSize >= CompressThreshold);
-
         // Write resource data to pak
-        if (!ShouldCompress)
-        {
-            Pak.WriteBytes(ResourceData.data(), ResourceSize);
-            rTableInfo.Compressed = false;
-        }
+        SPackedAsset& rAsset = PackedAssets[ResIdx];
 
-        else
+        if (rAsset.Compressed)
         {
-            uint32 CompressedSize;
-            std::vector<uint8> CompressedData(ResourceData.size() * 2);
-            bool Success = false;
-
-            if (Game <= EGame::EchoesDemo || Game == EGame::DKCReturns)
-                Success = CompressionUtil::CompressZlib(ResourceData.data(), ResourceData.size(), CompressedData.data(), CompressedData.size(), CompressedSize);
-            else
-                Success = CompressionUtil::CompressLZOSegmented(ResourceData.data(), ResourceData.size(), CompressedData.data(), CompressedSize, false);
-
-            // Make sure that the compressed data is actually smaller, accounting for padding + uncompressed size value
-            if (Success)
+            // Write MP1/2 compressed asset
+            if (Game <= EGame::CorruptionProto)
             {
-                uint32 CompressionHeaderSize = (Game <= EGame::CorruptionProto ? 4 : 0x10);
-                uint32 PaddedUncompressedSize = (ResourceSize + AlignmentMinusOne) & ~AlignmentMinusOne;
-                uint32 PaddedCompressedSize = (CompressedSize + CompressionHeaderSize + AlignmentMinusOne) & ~AlignmentMinusOne;
-                Success = (PaddedCompressedSize < PaddedUncompressedSize);
+                Pak.WriteLong(rAsset.UncompressedSize);
             }
-
-            // Write file to pak
-            if (Success)
+            // Write MP3/DKCR compressed asset
+            else
             {
-                // Write MP1/2 compressed asset
-                if (Game <= EGame::CorruptionProto)
-                {
-                    Pak.WriteLong(ResourceSize);
-                }
-                // Write MP3/DKCR compressed asset
-                else
-                {
-                    // Note: Compressed asset data can be stored in multiple blocks. Normally, the only assets that make use of this are textures,
-                    // which can store each separate component of the file (header, palette, image data) in separate blocks. However, some textures
-                    // are stored in one block, and I've had no luck figuring out why. The game doesn't generally seem to care whether textures use
-                    // multiple blocks or not, so for the sake of simplicity we compress everything to one block.
-                    Pak.WriteFourCC( FOURCC('CMPD') );
-                    Pak.WriteLong(1);
-                    Pak.WriteLong(0xA0000000 | CompressedSize);
-                    Pak.WriteLong(ResourceSize);
-                }
-                Pak.WriteBytes(CompressedData.data(), CompressedSize);
+                // Note: Compressed asset data can be stored in multiple blocks. Normally, the only assets that make use of this are textures,
+                // which can store each separate component of the file (header, palette, image data) in separate blocks. However, some textures
+                // are stored in one block, and I've had no luck figuring out why. The game doesn't generally seem to care whether textures use
+                // multiple blocks or not, so for the sake of simplicity we compress everything to one block.
+                Pak.WriteFourCC( FOURCC('CMPD') );
+                Pak.WriteLong(1);
+                Pak.WriteLong(0xA0000000 | rAsset.DataSize);
+                Pak.WriteLong(rAsset.UncompressedSize);
             }
-            else
-                Pak.WriteBytes(ResourceData.data(), ResourceSize);
-
-            rTableInfo.Compressed = Success;
         }
 
+        Pak.WriteBytes(rAsset.Data.data(), rAsset.DataSize);
+        rTableInfo.Compressed = rAsset.Compressed;
+
+        // Release the asset data now that it's been written
+        std::vector<uint8>().swap(rAsset.Data);
+
         Pak.WriteToBoundary(Alignment, 0xFF);
         rTableInfo.Size = Pak.Tell() - AssetOffset;
+
+        if (pProgress->ShouldCancel())
+            Cancelled = true;
     }
     ResDataSize = Pak.Tell() - ResDataOffset;
 
     // If we cancelled, don't finish writing the pak; delete the file instead and make sure the package is flagged for recook
-    if (pProgress->ShouldCancel())
+    if (Cancelled || ResIdx < AssetList.size())
     {
         Pak.Close();
         FileUtil::DeleteFile(PakPath);
@@ -445,10 +616,8 @@ void CPackage::CompareOriginalAssetList(const std::list<CAssetID>& rkNewList)
 
 bool CPackage::ContainsAsset(const CAssetID& rkID) const
 {
-    if (mCacheDirty)
-        UpdateDependencyCache();
-
-    return mCachedDependencies.find(rkID) != mCachedDependencies.end();
+    CResourceStore *pStore = (mpProject ? mpProject->ResourceStore() : nullptr);
+    return pStore && pStore->DependencyIndex()->PackageContainsAsset(this, rkID);
 }
 
 TString CPackage::DefinitionPath(bool Relative) const
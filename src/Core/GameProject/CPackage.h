@@ -40,10 +40,6 @@ class CPackage
     std::vector<SNamedResource> mResources;
     bool mNeedsRecook;
 
-    // Cached dependency list; used to figure out if a given resource is in this package
-    mutable bool mCacheDirty;
-    mutable std::set<CAssetID> mCachedDependencies;
-
 public:
     CPackage() {}
 
@@ -52,14 +48,12 @@ public:
         , mPakName(rkName)
         , mPakPath(rkPath)
         , mNeedsRecook(false)
-        , mCacheDirty(true)
     {}
 
     bool Load();
     bool Save();
     void Serialize(IArchive& rArc);
     void AddResource(const TString& rkName, const CAssetID& rkID, const CFourCC& rkType);
-    void UpdateDependencyCache() const;
     void MarkDirty();
 
     void Cook(IProgressNotifier *pProgress);
@@ -78,6 +72,9 @@ public:
     inline bool NeedsRecook() const                                     { return mNeedsRecook; }
 
     inline void SetPakName(TString NewName) { mPakName = NewName; }
+
+protected:
+    void InvalidateDependencyIndex();
 };
 
 #endif // CPACKAGE
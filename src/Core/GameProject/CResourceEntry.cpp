@@ -1,15 +1,30 @@
 #include "CResourceEntry.h"
+#include "CDependencyIndex.h"
 #include "CGameProject.h"
+#include "CResourceLoadContext.h"
 #include "CResourceStore.h"
 #include "Core/Resource/CResource.h"
 #include "Core/Resource/Cooker/CResourceCooker.h"
 #include "Core/Resource/Factory/CResourceFactory.h"
+#include "Core/TSlabAllocator.h"
 #include <Common/FileIO.h>
 #include <Common/FileUtil.h>
 #include <Common/TString.h>
 #include <Common/Serialization/CXMLReader.h>
 #include <Common/Serialization/CXMLWriter.h>
 
+// Loaders on background threads read gpResourceStore, so background loads for the active store
+// have to be stopped before it's pointed at a different store. This is never reached inside a load
+// context, since Load() refuses to load from other stores there, and CancelAll() asserts that it
+// only has anything to cancel on the main thread.
+static void CancelOtherStoreAsyncLoads(CResourceStore *pActiveStore, CResourceStore *pNewStore)
+{
+    ASSERT(!CResourceLoadContext::Current());
+
+    if (pActiveStore && pActiveStore != pNewStore)
+        pActiveStore->AsyncLoader()->CancelAll();
+}
+
 CResourceEntry::CResourceEntry(CResourceStore *pStore)
     : mpResource(nullptr)
     , mpTypeInfo(nullptr)
@@ -66,10 +81,29 @@ CResourceEntry* CResourceEntry::BuildFromArchive(CResourceStore *pStore, IArchiv
     return pEntry;
 }
 
+CResourceEntry* CResourceEntry::BuildFromDatabaseCache(CResourceStore *pStore, const CAssetID& rkID, CResTypeInfo *pTypeInfo,
+                                                       FResEntryFlags Flags, const TString& rkName, const TString& rkUppercaseName,
+                                                       CVirtualDirectory *pDirectory)
+{
+    // Initialize entry info from the flat database cache. Dependencies are read separately by the store.
+    ASSERT(pTypeInfo && pDirectory);
+
+    CResourceEntry *pEntry = new CResourceEntry(pStore);
+    pEntry->mID = rkID;
+    pEntry->mpTypeInfo = pTypeInfo;
+    pEntry->mFlags = Flags;
+    pEntry->mName = rkName;
+    pEntry->mCachedUppercaseName = rkUppercaseName;
+    pEntry->mpDirectory = pDirectory;
+    pEntry->mpDirectory->AddChild("", pEntry);
+    return pEntry;
+}
+
 CResourceEntry* CResourceEntry::BuildFromDirectory(CResourceStore *pStore, CResTypeInfo *pTypeInfo,
                                                    const TString& rkDirPath, const TString& rkName)
 {
-    // Initialize as much entry info as possible from the input data, then load the rest from the metadata file.
+    // Initialize as much entry info as possible from the input data. The rest needs to be loaded from the
+    // metadata file with LoadMetadata(); that's left to the caller so it can be done on worker threads.
     ASSERT(pTypeInfo);
 
     CResourceEntry *pEntry = new CResourceEntry(pStore);
@@ -80,12 +114,6 @@ CResourceEntry* CResourceEntry::BuildFromDirectory(CResourceStore *pStore, CResT
     pEntry->mpDirectory = pStore->GetVirtualDirectory(rkDirPath, true);
     ASSERT(pEntry->mpDirectory);
     pEntry->mpDirectory->AddChild("", pEntry);
-
-    // Make sure we're valid, then load the remaining data from the metadata file
-    ASSERT(pEntry->HasCookedVersion() || pEntry->HasRawVersion());
-    bool Success = pEntry->LoadMetadata();
-    ASSERT(Success);
-
     return pEntry;
 }
 
@@ -95,6 +123,24 @@ CResourceEntry::~CResourceEntry()
     if (mpDependencies) delete mpDependencies;
 }
 
+static TSlabAllocator<CResourceEntry>& EntryAllocator()
+{
+    // Intentionally never destroyed, so entries that outlive static destruction (e.g. in gpEditorStore) can still be freed
+    static TSlabAllocator<CResourceEntry> *spAllocator = new TSlabAllocator<CResourceEntry>;
+    return *spAllocator;
+}
+
+void* CResourceEntry::operator new(size_t Size)
+{
+    ASSERT(Size == sizeof(CResourceEntry));
+    return EntryAllocator().Allocate();
+}
+
+void CResourceEntry::operator delete(void *pData)
+{
+    EntryAllocator().Free(pData);
+}
+
 bool CResourceEntry::LoadMetadata()
 {
     ASSERT(!mMetadataDirty);
@@ -162,13 +208,31 @@ void CResourceEntry::SerializeEntryInfo(IArchive& rArc, bool MetadataOnly)
 
         if (rArc.IsReader())
         {
+            mCachedUppercaseName = mName.ToUpper();
             mpDirectory = mpStore->GetVirtualDirectory(Dir, true);
             mpDirectory->AddChild("", this);
-            mCachedUppercaseName = mName.ToUpper();
         }
     }
 }
 
+void CResourceEntry::SerializeDependencies(IArchive& rArc)
+{
+    rArc << SerialParameter("Dependencies", mpDependencies);
+}
+
+void CResourceEntry::SetDependencies(CDependencyTree *pDependencies)
+{
+    // Takes ownership of the tree
+    ASSERT(pDependencies);
+
+    if (mpDependencies)
+        delete mpDependencies;
+
+    mpDependencies = pDependencies;
+    mpStore->SetCacheDirty();
+    mpStore->DependencyIndex()->UpdateEntry(this);
+}
+
 void CResourceEntry::UpdateDependencies()
 {
     if (mpDependencies)
@@ -192,11 +256,13 @@ void CResourceEntry::UpdateDependencies()
     {
         errorf("Unable to update cached dependencies; failed to load resource");
         mpDependencies = new CDependencyTree();
+        mpStore->DependencyIndex()->UpdateEntry(this);
         return;
     }
 
     mpDependencies = mpResource->BuildDependencyTree();
     mpStore->SetCacheDirty();
+    mpStore->DependencyIndex()->UpdateEntry(this);
 
     if (!WasLoaded)
         mpStore->DestroyUnreferencedResources();
@@ -288,6 +354,9 @@ bool CResourceEntry::Save(bool SkipCacheSave /*= false*/, bool FlagForRecook /*=
     // In the future this might not be desired behavior 100% of the time.
     bool ShouldCollectGarbage = false;
 
+    // Background loads may be reading the files we're about to overwrite
+    mpStore->AsyncLoader()->CancelAll();
+
     // Save raw resource
     if (mpTypeInfo->CanBeSerialized())
     {
@@ -344,11 +413,12 @@ bool CResourceEntry::Save(bool SkipCacheSave /*= false*/, bool FlagForRecook /*=
     // Flag dirty any packages that contain this resource.
     if (FlagForRecook)
     {
-        for (uint32 iPkg = 0; iPkg < mpStore->Project()->NumPackages(); iPkg++)
-        {
-            CPackage *pPkg = mpStore->Project()->PackageByIndex(iPkg);
+        std::vector<CPackage*> Packages;
+        mpStore->DependencyIndex()->FindPackagesContaining(ID(), Packages);
 
-            if (!pPkg->NeedsRecook() && pPkg->ContainsAsset(ID()))
+        for (CPackage *pPkg : Packages)
+        {
+            if (!pPkg->NeedsRecook())
                 pPkg->MarkDirty();
         }
     }
@@ -361,6 +431,7 @@ bool CResourceEntry::Save(bool SkipCacheSave /*= false*/, bool FlagForRecook /*=
 
 bool CResourceEntry::Cook()
 {
+    mpStore->AsyncLoader()->CancelAll();
     Load();
     if (!mpResource) return false;
 
@@ -368,18 +439,23 @@ bool CResourceEntry::Cook()
     TString Dir = Path.GetFileDirectory();
     FileUtil::MakeDirectory(Dir);
 
-    // Attempt to open output cooked file
-    CFileOutStream File(Path, EEndian::BigEndian);
-    if (!File.IsValid())
-    {
-        errorf("Failed to open cooked file for writing: %s", *Path);
-        return false;
-    }
-
-    bool Success = CResourceCooker::CookResource(this, File);
+    // Cook into memory first; some cookers read from the existing cooked file while cooking,
+    // and this way a failed cook doesn't leave a truncated file behind
+    CVectorOutStream CookedData(EEndian::BigEndian);
+    bool Success = CResourceCooker::CookResource(this, CookedData);
 
     if (Success)
     {
+        // Attempt to open output cooked file
+        CFileOutStream File(Path, EEndian::BigEndian);
+        if (!File.IsValid())
+        {
+            errorf("Failed to open cooked file for writing: %s", *Path);
+            return false;
+        }
+
+        File.WriteBytes(CookedData.Data(), CookedData.Size());
+
         ClearFlag(EResEntryFlag::NeedsRecook);
         SetFlag(EResEntryFlag::HasBeenModified);
         SaveMetadata();
@@ -388,11 +464,40 @@ bool CResourceEntry::Cook()
     return Success;
 }
 
+CResourceLoadHandle CResourceEntry::LoadAsync()
+{
+    // Loads on a thread with an active load context are already off the main thread
+    CResourceLoadContext *pContext = CResourceLoadContext::Current();
+
+    if (pContext && pContext->Store() == mpStore)
+        return CResourceLoadHandle(this, nullptr);
+
+    return mpStore->AsyncLoader()->Load(this);
+}
+
 CResource* CResourceEntry::Load()
 {
+    // Loads on a thread with an active load context are owned by the context, not by the entry
+    CResourceLoadContext *pContext = CResourceLoadContext::Current();
+
+    if (pContext && pContext->Store() == mpStore)
+        return pContext->LoadResource(this);
+
     // If the asset is already loaded then just return it immediately
     if (mpResource) return mpResource;
 
+    // Loading it would modify this entry's store and swap gpResourceStore, which other threads
+    // are reading while a load context is active
+    if (pContext)
+    {
+        errorf("Can't load %s inside a load context for a different store", *CookedAssetPath(true));
+        return nullptr;
+    }
+
+    // If it was loaded in the background, pick up the result
+    if (mpStore->AsyncLoader()->FinishLoad(this))
+        return mpResource;
+
     // Always try to load raw version as the raw version contains extra editor-only data.
     // If there is no raw version (which will be the case for resource types that don't
     // support serialization yet) then load the cooked version as a backup.
@@ -404,6 +509,7 @@ CResource* CResourceEntry::Load()
         {
             // Set gpResourceStore to ensure the correct resource store is accessed by loader functions
             CResourceStore *pOldStore = gpResourceStore;
+            CancelOtherStoreAsyncLoads(pOldStore, mpStore);
             gpResourceStore = mpStore;
 
             CXMLReader Reader(RawAssetPath());
@@ -456,6 +562,7 @@ CResource* CResourceEntry::LoadCooked(IInputStream& rInput)
 
     // Set gpResourceStore to ensure the correct resource store is accessed by loader functions
     CResourceStore *pOldStore = gpResourceStore;
+    CancelOtherStoreAsyncLoads(pOldStore, mpStore);
     gpResourceStore = mpStore;
 
     mpResource = CResourceFactory::LoadCookedResource(this, rInput);
@@ -503,6 +610,9 @@ bool CResourceEntry::MoveAndRename(const TString& rkDir, const TString& rkName,
 
     if (!CanMoveTo(rkDir, rkName)) return false;
 
+    // Background loads look up files by path, so they must not run while the paths change
+    mpStore->AsyncLoader()->CancelAll();
+
     // Store old paths
     CVirtualDirectory *pOldDir = mpDirectory;
     TString OldName = mName;
@@ -525,8 +635,16 @@ bool CResourceEntry::MoveAndRename(const TString& rkDir, const TString& rkName,
     // Check if we can legally move to this spot
     ASSERT(pNewDir->FindChildResource(rkName, ResourceType()) == nullptr); // this check should be guaranteed to pass due to CanMoveTo() having already checked it
 
+    // Directories index their resources by name, so take this entry out of its old directory before renaming it
+    if (pOldDir != nullptr)
+    {
+        bool RemoveSuccess = pOldDir->RemoveChildResource(this);
+        ASSERT(RemoveSuccess == true); // this shouldn't be able to fail
+    }
+
     mpDirectory = pNewDir;
     mName = rkName;
+    mCachedUppercaseName = rkName.ToUpper();
     TString NewCookedPath = CookedAssetPath();
     TString NewRawPath = RawAssetPath();
     TString NewMetaPath = MetadataFilePath();
@@ -598,11 +716,10 @@ bool CResourceEntry::MoveAndRename(const TString& rkDir, const TString& rkName,
     // If we succeeded, finish the move
     if (FSMoveSuccess)
     {
+        mpDirectory->AddChild("", this);
+
         if (mpDirectory != pOldDir && pOldDir != nullptr)
         {
-            FSMoveSuccess = pOldDir->RemoveChildResource(this);
-            ASSERT(FSMoveSuccess == true); // this shouldn't be able to fail
-            mpDirectory->AddChild("", this);
             SetFlagEnabled(EResEntryFlag::AutoResDir, IsAutoGenDir);
         }
 
@@ -612,7 +729,6 @@ bool CResourceEntry::MoveAndRename(const TString& rkDir, const TString& rkName,
         }
 
         mpStore->SetCacheDirty();
-        mCachedUppercaseName = rkName.ToUpper();
         SaveMetadata();
         return true;
     }
@@ -623,6 +739,10 @@ bool CResourceEntry::MoveAndRename(const TString& rkDir, const TString& rkName,
         errorf("MOVE FAILED: %s", *MoveFailReason);
         mpDirectory = pOldDir;
         mName = OldName;
+        mCachedUppercaseName = OldName.ToUpper();
+
+        if (pOldDir != nullptr)
+            pOldDir->AddChild("", this);
 
         if (!DirAlreadyExisted)
         {
@@ -658,6 +778,7 @@ void CResourceEntry::MarkDeleted(bool InDeleted)
     // un-does the deletion.
     if (IsMarkedForDeletion() != InDeleted)
     {
+        mpStore->AsyncLoader()->CancelAll();
         SetFlagEnabled(EResEntryFlag::MarkedForDeletion, InDeleted);
 
         // Restore old name/directory if un-deleting
@@ -692,10 +813,9 @@ void CResourceEntry::MarkDeleted(bool InDeleted)
             // means it is not safe to access later. Separating the name and the path with
             // the '|' character is safe because this character is not allowed in filenames
             // (which is enforced in FileUtil::IsValidName()).
-            mName = mName + "|" + mpDirectory->FullPath();
-
-            // Remove from parent directory.
+            // Remove from parent directory first; it looks the entry up by its current name.
             mpDirectory->RemoveChildResource(this);
+            mName = mName + "|" + mpDirectory->FullPath();
             mpDirectory = nullptr;
 
             // Move any resource files out of the project into a temporary folder.
@@ -735,6 +855,7 @@ void CResourceEntry::MarkDeleted(bool InDeleted)
         }
 
         mpStore->SetCacheDirty();
+        mpStore->DependencyIndex()->UpdateEntry(this);
         debugf("%s FOR DELETION: [%s] %s", InDeleted ? "MARKED" : "UNMARKED", *ID().ToString(), *CookedPath.GetFileName());
     }
 }
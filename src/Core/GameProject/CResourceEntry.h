@@ -1,6 +1,7 @@
 #ifndef CRESOURCEENTRY_H
 #define CRESOURCEENTRY_H
 
+#include "CAsyncResourceLoader.h"
 #include "CResourceStore.h"
 #include "CVirtualDirectory.h"
 #include "Core/Resource/CResTypeInfo.h"
@@ -27,6 +28,8 @@ DECLARE_FLAGS(EResEntryFlag, FResEntryFlags)
 
 class CResourceEntry
 {
+    friend class CAsyncResourceLoader;
+
     CResource *mpResource;
     CResTypeInfo *mpTypeInfo;
     CResourceStore *mpStore;
@@ -48,13 +51,22 @@ public:
                                              const TString& rkDir, const TString& rkName,
                                              EResourceType Type, bool ExistingResource = false);
     static CResourceEntry* BuildFromArchive(CResourceStore *pStore, IArchive& rArc);
+    static CResourceEntry* BuildFromDatabaseCache(CResourceStore *pStore, const CAssetID& rkID, CResTypeInfo *pTypeInfo,
+                                                  FResEntryFlags Flags, const TString& rkName, const TString& rkUppercaseName,
+                                                  CVirtualDirectory *pDirectory);
     static CResourceEntry* BuildFromDirectory(CResourceStore *pStore, CResTypeInfo *pTypeInfo,
                                               const TString& rkDirPath, const TString& rkName);
     ~CResourceEntry();
 
+    // Entries are allocated out of a slab allocator, since projects have tens of thousands of them
+    static void* operator new(size_t Size);
+    static void operator delete(void *pData);
+
     bool LoadMetadata();
     bool SaveMetadata(bool ForceSave = false);
     void SerializeEntryInfo(IArchive& rArc, bool MetadataOnly);
+    void SerializeDependencies(IArchive& rArc);
+    void SetDependencies(CDependencyTree *pDependencies);
     void UpdateDependencies();
 
     bool HasRawVersion() const;
@@ -71,6 +83,7 @@ public:
     bool Save(bool SkipCacheSave = false, bool FlagForRecook = true);
     bool Cook();
     CResource* Load();
+    CResourceLoadHandle LoadAsync();
     CResource* LoadCooked(IInputStream& rInput);
     bool Unload();
     bool CanMoveTo(const TString& rkDir, const TString& rkName);
@@ -102,6 +115,7 @@ public:
     inline CResourceStore* ResourceStore() const    { return mpStore; }
     inline CDependencyTree* Dependencies() const    { return mpDependencies; }
     inline CAssetID ID() const                      { return mID; }
+    inline FResEntryFlags Flags() const             { return mFlags; }
     inline CVirtualDirectory* Directory() const     { return mpDirectory; }
     inline TString DirectoryPath() const            { return mpDirectory->FullPath(); }
     inline TString Name() const                     { return mName; }
@@ -3,20 +3,35 @@
 
 #include <Core/GameProject/CResourceEntry.h>
 #include <Core/GameProject/CResourceStore.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
 
 class CResourceIterator
 {
 protected:
     const CResourceStore *mpkStore;
-    std::map<CAssetID, CResourceEntry*>::const_iterator mIter;
+    std::shared_ptr< const std::vector<uint64> > mpkKeys;
+    uint32 mKeyIdx;
     CResourceEntry *mpCurEntry;
 
 public:
     CResourceIterator(const CResourceStore *pkStore = gpResourceStore)
         : mpkStore(pkStore)
+        , mKeyIdx(0)
         , mpCurEntry(nullptr)
     {
-        mIter = mpkStore->mResourceEntries.begin();
+        // The entry map is unordered, but things like the database cache, export order and generated asset names
+        // depend on iteration order, so iterate in asset ID order. The IDs are gathered up front and looked up as
+        // we go, so entries that get deleted in the meantime are skipped.
+        std::vector<uint64> Keys;
+        Keys.reserve(pkStore->mResourceEntries.Size());
+
+        for (auto It = pkStore->mResourceEntries.begin(); It != pkStore->mResourceEntries.end(); It++)
+            Keys.push_back(It.Key());
+
+        std::sort(Keys.begin(), Keys.end());
+        mpkKeys = std::make_shared< const std::vector<uint64> >(std::move(Keys));
         Next();
     }
 
@@ -24,12 +39,10 @@ public:
     {
         do
         {
-            if (mIter != mpkStore->mResourceEntries.end())
-            {
-                mpCurEntry = mIter->second;
-                mIter++;
-            }
-            else mpCurEntry = nullptr;
+            mpCurEntry = nullptr;
+
+            while (!mpCurEntry && mKeyIdx < mpkKeys->size())
+                mpCurEntry = mpkStore->mResourceEntries.Find((*mpkKeys)[mKeyIdx++], nullptr);
         }
         while (mpCurEntry && mpCurEntry->IsMarkedForDeletion());
 
@@ -0,0 +1,155 @@
+#include "CResourceLoadContext.h"
+#include "CResourceEntry.h"
+#include "CResourceStore.h"
+#include "Core/Resource/CResource.h"
+#include "Core/Resource/Factory/CResourceFactory.h"
+#include "Core/Resource/Script/NGameList.h"
+#include <Common/FileIO.h>
+#include <Common/Log.h>
+#include <Common/Serialization/CXMLReader.h>
+
+static thread_local CResourceLoadContext *gpCurrentLoadContext = nullptr;
+
+CResourceLoadContext::CResourceLoadContext(CResourceStore *pStore)
+    : mpStore(pStore)
+    , mpPrevContext(gpCurrentLoadContext)
+{
+    ASSERT(mpStore);
+    gpCurrentLoadContext = this;
+}
+
+CResourceLoadContext::~CResourceLoadContext()
+{
+    ASSERT(gpCurrentLoadContext == this);
+    gpCurrentLoadContext = mpPrevContext;
+
+    DeleteUnreferencedResources(mLoadOrder);
+
+    if (!mLoadOrder.empty())
+        warnf("Resource load context leaked %d resources with circular references", (uint32) mLoadOrder.size());
+}
+
+CResource* CResourceLoadContext::LoadResource(CResourceEntry *pEntry)
+{
+    ASSERT(pEntry->ResourceStore() == mpStore);
+
+    CResource *pRes = mResources.Find(pEntry->ID(), nullptr);
+    if (pRes) return pRes;
+
+    // Same load order as CResourceEntry::Load; raw version first, cooked version as a backup.
+    if (pEntry->HasRawVersion())
+    {
+        pRes = CResourceFactory::CreateResource(pEntry);
+
+        if (pRes)
+        {
+            CXMLReader Reader(pEntry->RawAssetPath());
+
+            if (!Reader.IsValid())
+            {
+                errorf("Failed to load raw resource; falling back on cooked. Raw path: %s", *pEntry->RawAssetPath());
+                delete pRes;
+                pRes = nullptr;
+            }
+            else
+            {
+                // Add before serializing so references back to this resource resolve to it
+                AddResource(pRes);
+                pRes->Serialize(Reader);
+                return pRes;
+            }
+        }
+    }
+
+    if (pEntry->HasCookedVersion())
+    {
+        CFileInStream File(pEntry->CookedAssetPath(), EEndian::BigEndian);
+
+        if (!File.IsValid())
+        {
+            errorf("Failed to open cooked resource: %s", *pEntry->CookedAssetPath(true));
+            return nullptr;
+        }
+
+        pRes = CResourceFactory::LoadCookedResource(pEntry, File);
+        if (pRes) AddResource(pRes);
+        return pRes;
+    }
+
+    errorf("Couldn't locate resource: %s", *pEntry->CookedAssetPath(true));
+    return nullptr;
+}
+
+std::vector<CResource*> CResourceLoadContext::ReleaseResources()
+{
+    // Hands everything loaded so far over to the caller, in load order. The context forgets about
+    // the resources, so the caller is responsible for deleting them.
+    std::vector<CResource*> Resources;
+    Resources.swap(mLoadOrder);
+    mResources.Clear();
+    return Resources;
+}
+
+void CResourceLoadContext::AddResource(CResource *pRes)
+{
+    mResources.Insert(pRes->ID(), pRes);
+    mLoadOrder.push_back(pRes);
+}
+
+// ************ STATIC ************
+void CResourceLoadContext::PrepareStore(CResourceStore *pStore)
+{
+    // Must be called on the thread that owns the stores, before any contexts for the store are
+    // created on worker threads. Loads whatever loaders would otherwise lazily initialize or load
+    // into other stores; the game template, and the display assets it loads from gpEditorStore.
+    ASSERT(!gpCurrentLoadContext);
+    CGameTemplate *pGame = NGameList::GetGameTemplate(pStore->Game());
+
+    if (pGame)
+        pGame->PreloadEditorAssets();
+}
+
+CResourceLoadContext* CResourceLoadContext::Current()
+{
+    return gpCurrentLoadContext;
+}
+
+bool CResourceLoadContext::IsActive(const CResourceStore *pkStore)
+{
+    for (CResourceLoadContext *pContext = gpCurrentLoadContext; pContext; pContext = pContext->mpPrevContext)
+    {
+        if (pContext->mpStore == pkStore)
+            return true;
+    }
+
+    return false;
+}
+
+uint32 CResourceLoadContext::DeleteUnreferencedResources(std::vector<CResource*>& rResources)
+{
+    // Resources can hold references to each other, so only delete unreferenced ones on each pass,
+    // the same way CResourceStore::DestroyUnreferencedResources does.
+    uint32 NumDeleted = 0;
+    uint32 NumDeletedThisPass;
+
+    do
+    {
+        NumDeletedThisPass = 0;
+
+        for (uint32 ResIdx = rResources.size(); ResIdx-- > 0;)
+        {
+            CResource *pRes = rResources[ResIdx];
+
+            if (!pRes->IsReferenced())
+            {
+                delete pRes;
+                rResources.erase(rResources.begin() + ResIdx);
+                NumDeletedThisPass++;
+            }
+        }
+
+        NumDeleted += NumDeletedThisPass;
+    } while (NumDeletedThisPass > 0);
+
+    return NumDeleted;
+}
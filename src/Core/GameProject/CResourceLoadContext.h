@@ -0,0 +1,53 @@
+#ifndef CRESOURCELOADCONTEXT_H
+#define CRESOURCELOADCONTEXT_H
+
+#include "TAssetMap.h"
+#include <vector>
+
+class CResource;
+class CResourceEntry;
+class CResourceStore;
+
+/**
+ * Private scope for loading resources from a store on a worker thread.
+ * While a context is active on a thread, every CResourceEntry::Load() for the context's store
+ * on that thread goes through the context instead: the resource is loaded into the context,
+ * it isn't attached to its entry or tracked by the store, and gpResourceStore is never swapped.
+ * Everything the context loaded is deleted when the context is destroyed.
+ *
+ * This allows any number of threads to load resources from the same store at once, provided
+ * nothing modifies the store in the meantime, gpResourceStore already points to it, and
+ * PrepareStore() was called for it beforehand. Resources from other stores can't be loaded
+ * inside a context; only ones that are already loaded can be used.
+ */
+class CResourceLoadContext
+{
+    CResourceStore *mpStore;
+    CResourceLoadContext *mpPrevContext;
+    TAssetMap<CResource*> mResources;
+    std::vector<CResource*> mLoadOrder;
+
+public:
+    explicit CResourceLoadContext(CResourceStore *pStore);
+    ~CResourceLoadContext();
+
+    CResource* LoadResource(CResourceEntry *pEntry);
+    std::vector<CResource*> ReleaseResources();
+
+    CResourceLoadContext(const CResourceLoadContext&) = delete;
+    CResourceLoadContext& operator=(const CResourceLoadContext&) = delete;
+
+    static void PrepareStore(CResourceStore *pStore);
+    static CResourceLoadContext* Current();
+    static bool IsActive(const CResourceStore *pkStore);
+    static uint32 DeleteUnreferencedResources(std::vector<CResource*>& rResources);
+
+    // Accessors
+    inline CResourceStore* Store() const        { return mpStore; }
+    inline uint32 NumLoadedResources() const    { return mLoadOrder.size(); }
+
+protected:
+    void AddResource(CResource *pRes);
+};
+
+#endif // CRESOURCELOADCONTEXT_H
@@ -1,15 +1,25 @@
 #include "CResourceStore.h"
+#include "CAsyncResourceLoader.h"
+#include "CDependencyIndex.h"
+#include "CDependencyTree.h"
 #include "CGameExporter.h"
 #include "CGameProject.h"
 #include "CResourceIterator.h"
+#include "CResourceLoadContext.h"
+#include "Core/CMappedFile.h"
+#include "Core/CWorkerPool.h"
 #include "Core/IUIRelay.h"
 #include "Core/Resource/CResource.h"
 #include <Common/Macros.h>
+#include <Common/FileIO.h>
 #include <Common/FileUtil.h>
 #include <Common/Log.h>
 #include <Common/Serialization/Binary.h>
 #include <Common/Serialization/XML.h>
 #include <tinyxml2.h>
+#include <functional>
+#include <string>
+#include <unordered_map>
 
 using namespace tinyxml2;
 CResourceStore *gpResourceStore = nullptr;
@@ -20,6 +30,8 @@ CResourceStore::CResourceStore(const TString& rkDatabasePath)
     : mpProj(nullptr)
     , mGame(EGame::Prime)
     , mDatabaseCacheDirty(false)
+    , mpAsyncLoader(std::make_unique<CAsyncResourceLoader>(this))
+    , mpDependencyIndex(std::make_unique<CDependencyIndex>(this))
 {
     mpDatabaseRoot = new CVirtualDirectory(this);
     mDatabasePath = FileUtil::MakeAbsolute(rkDatabasePath.GetFileDirectory());
@@ -32,6 +44,8 @@ CResourceStore::CResourceStore(CGameProject *pProject)
     , mGame(EGame::Invalid)
     , mpDatabaseRoot(nullptr)
     , mDatabaseCacheDirty(false)
+    , mpAsyncLoader(std::make_unique<CAsyncResourceLoader>(this))
+    , mpDependencyIndex(std::make_unique<CDependencyIndex>(this))
 {
     SetProject(pProject);
 }
@@ -42,7 +56,7 @@ CResourceStore::~CResourceStore()
     DestroyUnreferencedResources();
 
     for (auto It = mResourceEntries.begin(); It != mResourceEntries.end(); It++)
-        delete It->second;
+        delete It.Value();
 }
 
 void RecursiveGetListOfEmptyDirectories(CVirtualDirectory *pDir, TStringList& rOutList)
@@ -65,7 +79,7 @@ bool CResourceStore::SerializeDatabaseCache(IArchive& rArc)
     if (rArc.ParamBegin("Resources", 0))
     {
         // Serialize resources
-        uint32 ResourceCount = mResourceEntries.size();
+        uint32 ResourceCount = mResourceEntries.Size();
 
         if (rArc.IsWriter())
         {
@@ -73,7 +87,7 @@ bool CResourceStore::SerializeDatabaseCache(IArchive& rArc)
             // We can't use CResourceIterator because it skips MarkedForDeletion resources.
             for (auto Iter = mResourceEntries.begin(); Iter != mResourceEntries.end(); Iter++)
             {
-                CResourceEntry* pEntry = Iter->second;
+                CResourceEntry* pEntry = Iter.Value();
 
                 if (pEntry->IsMarkedForDeletion())
                 {
@@ -86,13 +100,15 @@ bool CResourceStore::SerializeDatabaseCache(IArchive& rArc)
 
         if (rArc.IsReader())
         {
+            mResourceEntries.Reserve(ResourceCount);
+
             for (uint32 ResIdx = 0; ResIdx < ResourceCount; ResIdx++)
             {
                 if (rArc.ParamBegin("Resource", 0))
                 {
                     CResourceEntry *pEntry = CResourceEntry::BuildFromArchive(this, rArc);
                     ASSERT( FindEntry(pEntry->ID()) == nullptr );
-                    mResourceEntries[pEntry->ID()] = pEntry;
+                    mResourceEntries.Insert(pEntry->ID(), pEntry);
                     rArc.ParamEnd();
                 }
             }
@@ -137,6 +153,50 @@ bool CResourceStore::SerializeDatabaseCache(IArchive& rArc)
     return true;
 }
 
+// Flat database cache layout (EDatabaseVersion::FlatLayout). Everything is stored in native byte order
+// so the tables can be used directly out of a memory mapping of the file. Table offsets are relative to
+// the start of the file, string offsets are relative to the start of the string pool, and dependency
+// offsets are relative to the start of the dependency data.
+const uint32 kFlatDatabaseMagic = FOURCC('PDBC');
+const uint32 kFlatDatabaseAlignment = 8;
+const uint32 kEmptyDirectoryFlag = 0x1;
+
+struct SDatabaseCacheHeader
+{
+    uint32 Magic;
+    uint32 Version;
+    uint32 Game;
+    uint32 NumEntries;
+    uint32 NumDirectories;
+    uint32 EntryTableOffset;
+    uint32 DirectoryTableOffset;
+    uint32 StringPoolOffset;
+    uint32 StringPoolSize;
+    uint32 DependencyDataOffset;
+    uint32 DependencyDataSize;
+};
+
+struct SDatabaseCacheEntry
+{
+    uint64 ID;
+    uint32 IDLength;
+    uint32 Type;
+    uint32 Flags;
+    uint32 NameOffset;
+    uint32 UppercaseNameOffset;
+    uint32 DirectoryIndex;
+    uint32 DependencyOffset;
+    uint32 DependencySize;
+};
+
+// Directories are stored parents-first, with subdirectories in sorted order. Index 0 is the root.
+struct SDatabaseCacheDirectory
+{
+    uint32 NameOffset;
+    uint32 ParentIndex;
+    uint32 Flags;
+};
+
 bool CResourceStore::LoadDatabaseCache()
 {
     ASSERT(!mDatabasePath.IsEmpty());
@@ -145,27 +205,161 @@ bool CResourceStore::LoadDatabaseCache()
     if (!mpDatabaseRoot)
         mpDatabaseRoot = new CVirtualDirectory(this);
 
-    // Load the resource database
-    CBasicBinaryReader Reader(Path, FOURCC('CACH'));
+    mpDependencyIndex->Clear();
 
-    if (!Reader.IsValid() || !SerializeDatabaseCache(Reader))
+    // Use the flat layout if the cache has been saved in it; otherwise fall back to the original
+    // archive format, and flag the cache dirty so it's migrated the next time the store is saved.
+    CMappedFile MappedCache(Path);
+
+    if (MappedCache.IsValid() && MappedCache.Size() >= sizeof(uint32) &&
+        *reinterpret_cast<const uint32*>(MappedCache.Data()) == kFlatDatabaseMagic)
     {
-        if (gpUIRelay->AskYesNoQuestion("Error", "Failed to load the resource database. Attempt to build from the directory? (This may take a while.)"))
-        {
-            if (!BuildFromDirectory(true))
-                return false;
-        }
-        else return false;
+        if (LoadFlatDatabaseCache(MappedCache))
+            return true;
     }
     else
     {
-        // Database is successfully loaded at this point
-        if (mpProj)
+        MappedCache.Close();
+
+        // Load the resource database
+        CBasicBinaryReader Reader(Path, FOURCC('CACH'));
+
+        if (Reader.IsValid() && SerializeDatabaseCache(Reader))
         {
-            ASSERT(mpProj->Game() == Reader.Game());
+            // Database is successfully loaded at this point
+            if (mpProj)
+            {
+                ASSERT(mpProj->Game() == Reader.Game());
+            }
+
+            mGame = Reader.Game();
+            mDatabaseCacheDirty = true;
+            return true;
         }
+    }
+
+    if (gpUIRelay->AskYesNoQuestion("Error", "Failed to load the resource database. Attempt to build from the directory? (This may take a while.)"))
+    {
+        if (!BuildFromDirectory(true))
+            return false;
+    }
+    else return false;
+
+    return true;
+}
+
+bool CResourceStore::LoadFlatDatabaseCache(const CMappedFile& rkFile)
+{
+    const uint8 *pkData = rkFile.Data();
+    const uint64 FileSize = rkFile.Size();
+
+    if (FileSize < sizeof(SDatabaseCacheHeader))
+        return false;
+
+    const SDatabaseCacheHeader& rkHeader = *reinterpret_cast<const SDatabaseCacheHeader*>(pkData);
+
+    if (rkHeader.Version != (uint32) EDatabaseVersion::FlatLayout)
+    {
+        errorf("%s: Unsupported database cache version: %d", *rkFile.Path(), rkHeader.Version);
+        return false;
+    }
+
+    // Validate everything up front, so we never end up with a partially loaded database
+    auto IsTableValid = [FileSize](uint64 Offset, uint64 Count, uint64 ElementSize) -> bool
+    {
+        return (Offset % kFlatDatabaseAlignment) == 0 && Offset + (Count * ElementSize) <= FileSize;
+    };
+
+    if (!IsTableValid(rkHeader.EntryTableOffset, rkHeader.NumEntries, sizeof(SDatabaseCacheEntry)) ||
+        !IsTableValid(rkHeader.DirectoryTableOffset, rkHeader.NumDirectories, sizeof(SDatabaseCacheDirectory)) ||
+        !IsTableValid(rkHeader.StringPoolOffset, rkHeader.StringPoolSize, 1) ||
+        !IsTableValid(rkHeader.DependencyDataOffset, rkHeader.DependencyDataSize, 1) ||
+        rkHeader.NumDirectories == 0 || rkHeader.StringPoolSize == 0)
+    {
+        errorf("%s: Database cache is truncated or corrupt", *rkFile.Path());
+        return false;
+    }
+
+    const SDatabaseCacheEntry *pkEntries = reinterpret_cast<const SDatabaseCacheEntry*>(pkData + rkHeader.EntryTableOffset);
+    const SDatabaseCacheDirectory *pkDirectories = reinterpret_cast<const SDatabaseCacheDirectory*>(pkData + rkHeader.DirectoryTableOffset);
+    const char *pkStrings = reinterpret_cast<const char*>(pkData + rkHeader.StringPoolOffset);
+
+    // Since the pool ends with a terminator, every in-bounds string offset is a valid string
+    bool Valid = (pkStrings[rkHeader.StringPoolSize - 1] == 0 && pkDirectories[0].ParentIndex == (uint32) -1);
+
+    for (uint32 DirIdx = 1; DirIdx < rkHeader.NumDirectories && Valid; DirIdx++)
+    {
+        const SDatabaseCacheDirectory& rkDir = pkDirectories[DirIdx];
+        Valid = (rkDir.ParentIndex < DirIdx && rkDir.NameOffset < rkHeader.StringPoolSize);
+    }
+
+    for (uint32 EntryIdx = 0; EntryIdx < rkHeader.NumEntries && Valid; EntryIdx++)
+    {
+        const SDatabaseCacheEntry& rkEntry = pkEntries[EntryIdx];
+        Valid = (rkEntry.NameOffset < rkHeader.StringPoolSize &&
+                 rkEntry.UppercaseNameOffset < rkHeader.StringPoolSize &&
+                 rkEntry.DirectoryIndex < rkHeader.NumDirectories &&
+                 (uint64) rkEntry.DependencyOffset + rkEntry.DependencySize <= rkHeader.DependencyDataSize &&
+                 CResTypeInfo::FindTypeInfo((EResourceType) rkEntry.Type) != nullptr);
+    }
+
+    if (!Valid)
+    {
+        errorf("%s: Database cache is truncated or corrupt", *rkFile.Path());
+        return false;
+    }
+
+    EGame Game = (EGame) rkHeader.Game;
+
+    if (mpProj)
+    {
+        ASSERT(mpProj->Game() == Game);
+    }
+
+    mGame = Game;
+
+    // Build the directory tree. Empty directories that no longer exist in the filesystem are skipped;
+    // since directories containing resources are never flagged empty, no entry can reference a skipped one.
+    std::vector<CVirtualDirectory*> Directories(rkHeader.NumDirectories, nullptr);
+    Directories[0] = mpDatabaseRoot;
+
+    for (uint32 DirIdx = 1; DirIdx < rkHeader.NumDirectories; DirIdx++)
+    {
+        const SDatabaseCacheDirectory& rkDir = pkDirectories[DirIdx];
+        CVirtualDirectory *pParent = Directories[rkDir.ParentIndex];
+        if (!pParent) continue;
+
+        TString Name = &pkStrings[rkDir.NameOffset];
 
-        mGame = Reader.Game();
+        if ((rkDir.Flags & kEmptyDirectoryFlag) && !FileUtil::Exists(pParent->AbsolutePath() + Name))
+            continue;
+
+        CVirtualDirectory *pDir = new CVirtualDirectory(pParent, Name, this);
+        pParent->AddSortedChild(pDir);
+        Directories[DirIdx] = pDir;
+    }
+
+    // Create entries
+    CMemoryInStream DependencyData(pkData + rkHeader.DependencyDataOffset, rkHeader.DependencyDataSize, EEndian::SystemEndian);
+    CBasicBinaryReader DependencyReader(&DependencyData, CSerialVersion(IArchive::skCurrentArchiveVersion, 0, mGame));
+    mResourceEntries.Reserve(rkHeader.NumEntries);
+
+    for (uint32 EntryIdx = 0; EntryIdx < rkHeader.NumEntries; EntryIdx++)
+    {
+        const SDatabaseCacheEntry& rkEntry = pkEntries[EntryIdx];
+        CVirtualDirectory *pDir = Directories[rkEntry.DirectoryIndex];
+        ASSERT(pDir != nullptr);
+
+        CAssetID ID(rkEntry.ID, (EIDLength) rkEntry.IDLength);
+        CResourceEntry *pEntry = CResourceEntry::BuildFromDatabaseCache(this, ID, CResTypeInfo::FindTypeInfo((EResourceType) rkEntry.Type),
+                                                                        FResEntryFlags(rkEntry.Flags), &pkStrings[rkEntry.NameOffset],
+                                                                        &pkStrings[rkEntry.UppercaseNameOffset], pDir);
+
+        DependencyData.Seek(rkEntry.DependencyOffset, SEEK_SET);
+        pEntry->SerializeDependencies(DependencyReader);
+
+        ASSERT( FindEntry(ID) == nullptr );
+        mResourceEntries.Insert(ID, pEntry);
     }
 
     return true;
@@ -176,12 +370,96 @@ bool CResourceStore::SaveDatabaseCache()
     TString Path = DatabasePath();
     debugf("Saving database cache...");
 
-    CBasicBinaryWriter Writer(Path, FOURCC('CACH'), 0, mGame);
+    // Intern all names into a single string pool
+    std::vector<char> StringPool;
+    std::unordered_map<std::string, uint32> StringOffsets;
+
+    auto InternString = [&StringPool, &StringOffsets](const TString& rkString) -> uint32
+    {
+        auto Find = StringOffsets.find(*rkString);
+        if (Find != StringOffsets.end()) return Find->second;
 
-    if (!Writer.IsValid())
+        uint32 Offset = StringPool.size();
+        StringPool.insert(StringPool.end(), *rkString, *rkString + rkString.Size() + 1);
+        StringOffsets[*rkString] = Offset;
+        return Offset;
+    };
+
+    // Build the directory table
+    std::vector<SDatabaseCacheDirectory> Directories;
+    std::unordered_map<CVirtualDirectory*, uint32> DirectoryIndices;
+
+    std::function<void(CVirtualDirectory*, uint32)> AddDirectory = [&](CVirtualDirectory *pDir, uint32 ParentIdx)
+    {
+        uint32 DirIdx = Directories.size();
+        DirectoryIndices[pDir] = DirIdx;
+        Directories.push_back( SDatabaseCacheDirectory {
+            InternString(pDir->Name()), ParentIdx, (pDir->IsEmpty(false) ? kEmptyDirectoryFlag : 0)
+        } );
+
+        for (uint32 SubIdx = 0; SubIdx < pDir->NumSubdirectories(); SubIdx++)
+            AddDirectory(pDir->SubdirectoryByIndex(SubIdx), DirIdx);
+    };
+    AddDirectory(mpDatabaseRoot, -1);
+
+    // Build the entry table and dependency data.
+    // CResourceIterator skips MarkedForDeletion resources, so deleted resources aren't included.
+    std::vector<SDatabaseCacheEntry> Entries;
+    Entries.reserve(mResourceEntries.Size());
+
+    std::vector<char> DependencyData;
+    CVectorOutStream DependencyStream(&DependencyData, EEndian::SystemEndian);
+    CBasicBinaryWriter DependencyWriter(&DependencyStream, CSerialVersion(IArchive::skCurrentArchiveVersion, 0, mGame));
+
+    for (CResourceIterator It(this); It; ++It)
+    {
+        auto DirFind = DirectoryIndices.find(It->Directory());
+        ASSERT(DirFind != DirectoryIndices.end());
+
+        SDatabaseCacheEntry Entry;
+        Entry.ID = It->ID().ToLongLong();
+        Entry.IDLength = (uint32) It->ID().Length();
+        Entry.Type = (uint32) It->ResourceType();
+        Entry.Flags = It->Flags().ToInt32();
+        Entry.NameOffset = InternString(It->Name());
+        Entry.UppercaseNameOffset = InternString(It->UppercaseName());
+        Entry.DirectoryIndex = DirFind->second;
+        Entry.DependencyOffset = DependencyStream.Size();
+        It->SerializeDependencies(DependencyWriter);
+        Entry.DependencySize = DependencyStream.Size() - Entry.DependencyOffset;
+        Entries.push_back(Entry);
+    }
+
+    // Lay out the file
+    SDatabaseCacheHeader Header;
+    Header.Magic = kFlatDatabaseMagic;
+    Header.Version = (uint32) EDatabaseVersion::FlatLayout;
+    Header.Game = (uint32) mGame;
+    Header.NumEntries = Entries.size();
+    Header.NumDirectories = Directories.size();
+    Header.EntryTableOffset = ALIGN(sizeof(SDatabaseCacheHeader), kFlatDatabaseAlignment);
+    Header.DirectoryTableOffset = ALIGN(Header.EntryTableOffset + Entries.size() * sizeof(SDatabaseCacheEntry), kFlatDatabaseAlignment);
+    Header.StringPoolOffset = ALIGN(Header.DirectoryTableOffset + Directories.size() * sizeof(SDatabaseCacheDirectory), kFlatDatabaseAlignment);
+    Header.StringPoolSize = StringPool.size();
+    Header.DependencyDataOffset = ALIGN(Header.StringPoolOffset + Header.StringPoolSize, kFlatDatabaseAlignment);
+    Header.DependencyDataSize = DependencyData.size();
+
+    CFileOutStream File(Path, EEndian::SystemEndian);
+
+    if (!File.IsValid())
         return false;
 
-    SerializeDatabaseCache(Writer);
+    File.WriteBytes(&Header, sizeof(SDatabaseCacheHeader));
+    File.WriteToBoundary(kFlatDatabaseAlignment, 0);
+    File.WriteBytes(Entries.data(), Entries.size() * sizeof(SDatabaseCacheEntry));
+    File.WriteToBoundary(kFlatDatabaseAlignment, 0);
+    File.WriteBytes(Directories.data(), Directories.size() * sizeof(SDatabaseCacheDirectory));
+    File.WriteToBoundary(kFlatDatabaseAlignment, 0);
+    File.WriteBytes(StringPool.data(), StringPool.size());
+    File.WriteToBoundary(kFlatDatabaseAlignment, 0);
+    File.WriteBytes(DependencyData.data(), DependencyData.size());
+    ASSERT(File.Tell() == Header.DependencyDataOffset + Header.DependencyDataSize);
+
     mDatabaseCacheDirty = false;
     return true;
 }
@@ -218,19 +496,21 @@ void CResourceStore::SetProject(CGameProject *pProj)
 
 void CResourceStore::CloseProject()
 {
+    mpAsyncLoader->CancelAll();
+
     // Destroy unreferenced resources first. (This is necessary to avoid invalid memory accesses when
     // various TResPtrs are destroyed. There might be a cleaner solution than this.)
     DestroyUnreferencedResources();
 
     // There should be no loaded resources!!!
     // If there are, that means something didn't clean up resource references properly on project close!!!
-    if (!mLoadedResources.empty())
+    if (!mLoadedResources.IsEmpty())
     {
-        warnf("%d resources still loaded on project close:", mLoadedResources.size());
+        warnf("%d resources still loaded on project close:", mLoadedResources.Size());
 
         for (auto Iter = mLoadedResources.begin(); Iter != mLoadedResources.end(); Iter++)
         {
-            CResourceEntry *pEntry = Iter->second;
+            CResourceEntry *pEntry = Iter.Value();
             warnf("\t%s.%s", *pEntry->Name(), *pEntry->CookedExtension().ToString());
         }
 
@@ -238,13 +518,11 @@ void CResourceStore::CloseProject()
     }
 
     // Delete all entries from old project
-    auto It = mResourceEntries.begin();
+    for (auto It = mResourceEntries.begin(); It != mResourceEntries.end(); It++)
+        delete It.Value();
 
-    while (It != mResourceEntries.end())
-    {
-        delete It->second;
-        It = mResourceEntries.erase(It);
-    }
+    mResourceEntries.Clear();
+    mpDependencyIndex->Clear();
 
     // Clear deleted files from previous runs
     TString DeletedPath = DeletedResourcePath();
@@ -304,15 +582,10 @@ CResourceEntry* CResourceStore::FindEntry(const CAssetID& rkID) const
 {
     if (rkID.IsValid())
     {
-        auto Found = mResourceEntries.find(rkID);
-
-        if (Found != mResourceEntries.end())
-        {
-            CResourceEntry* pEntry = Found->second;
+        CResourceEntry* pEntry = mResourceEntries.Find(rkID);
 
-            if (!pEntry->IsMarkedForDeletion())
-                return pEntry;
-        }
+        if (pEntry && !pEntry->IsMarkedForDeletion())
+            return pEntry;
     }
 
     return nullptr;
@@ -337,20 +610,22 @@ bool CResourceStore::AreAllEntriesValid() const
 void CResourceStore::ClearDatabase()
 {
     // THIS OPERATION REQUIRES THAT ALL RESOURCES ARE UNREFERENCED
+    mpAsyncLoader->CancelAll();
     DestroyUnreferencedResources();
 
-    if (!mLoadedResources.empty())
+    if (!mLoadedResources.IsEmpty())
     {
         debugf("ERROR: Resources still loaded:");
         for (auto Iter = mLoadedResources.begin(); Iter != mLoadedResources.end(); Iter++)
-            debugf("\t[%s] %s", *Iter->first.ToString(), *Iter->second->CookedAssetPath(true));
+            debugf("\t[%s] %s", *Iter.Value()->ID().ToString(), *Iter.Value()->CookedAssetPath(true));
         ASSERT(false);
     }
 
     // Clear out existing resource entries and directories
     for (auto Iter = mResourceEntries.begin(); Iter != mResourceEntries.end(); Iter++)
-        delete Iter->second;
-    mResourceEntries.clear();
+        delete Iter.Value();
+    mResourceEntries.Clear();
+    mpDependencyIndex->Clear();
 
     delete mpDatabaseRoot;
     mpDatabaseRoot = new CVirtualDirectory(this);
@@ -360,13 +635,16 @@ void CResourceStore::ClearDatabase()
 
 bool CResourceStore::BuildFromDirectory(bool ShouldGenerateCacheFile)
 {
-    ASSERT(mResourceEntries.empty());
+    ASSERT(mResourceEntries.IsEmpty());
 
     // Get list of resources
     TString ResDir = ResourcesDir();
     TStringList ResourceList;
     FileUtil::GetDirectoryContents(ResDir, ResourceList);
 
+    // Create entries and directories. Metadata is loaded afterwards on the worker pool.
+    std::vector<CResourceEntry*> NewEntries;
+
     for (auto Iter = ResourceList.begin(); Iter != ResourceList.end(); Iter++)
     {
         TString Path = *Iter;
@@ -391,24 +669,44 @@ bool CResourceStore::BuildFromDirectory(bool ShouldGenerateCacheFile)
             }
 
             // Create resource entry
-            CResourceEntry *pEntry = CResourceEntry::BuildFromDirectory(this, pTypeInfo, DirPath, ResName);
-
-            // Validate the entry
-            CAssetID ID = pEntry->ID();
-            ASSERT( mResourceEntries.find(ID) == mResourceEntries.end() );
-            ASSERT( ID.Length() == CAssetID::GameIDLength(mGame) );
-
-            mResourceEntries[ID] = pEntry;
+            NewEntries.push_back( CResourceEntry::BuildFromDirectory(this, pTypeInfo, DirPath, ResName) );
         }
 
         else if (FileUtil::IsDirectory(Path))
             CreateVirtualDirectory(RelPath);
     }
 
+    // Load metadata. Each job only touches its own entry, so this is safe to run in parallel.
+    CWorkerPool Pool;
+
+    Pool.ParallelFor(NewEntries.size(), [&NewEntries](uint EntryIdx)
+    {
+        CResourceEntry *pEntry = NewEntries[EntryIdx];
+
+        // Make sure we're valid, then load the remaining data from the metadata file
+        ASSERT(pEntry->HasCookedVersion() || pEntry->HasRawVersion());
+        bool Success = pEntry->LoadMetadata();
+        ASSERT(Success);
+    });
+
+    // Register entries in directory listing order, so the result doesn't depend on thread timing
+    mResourceEntries.Reserve(NewEntries.size());
+
+    for (CResourceEntry *pEntry : NewEntries)
+    {
+        // Validate the entry
+        CAssetID ID = pEntry->ID();
+        ASSERT( !mResourceEntries.Contains(ID) );
+        ASSERT( ID.Length() == CAssetID::GameIDLength(mGame) );
+
+        mResourceEntries.Insert(ID, pEntry);
+    }
+
     // Generate new cache file
     if (ShouldGenerateCacheFile)
     {
-        // Make sure gpResourceStore points to this store
+        // Make sure gpResourceStore points to this store. Loaders on the worker threads resolve dependencies
+        // through it, so it must not change until all jobs are finished.
         CResourceStore *pOldStore = gpResourceStore;
         gpResourceStore = this;
 
@@ -416,9 +714,43 @@ bool CResourceStore::BuildFromDirectory(bool ShouldGenerateCacheFile)
         if (mpProj)
             mpProj->AudioManager()->LoadAssets();
 
-        // Update dependencies
+        // Make sure nothing that loaders lazily initialize gets initialized from several threads at once,
+        // that editor display assets are already loaded (workers can't load them into gpEditorStore), and
+        // that nothing unreferenced is left for a worker's DestroyUnreferencedResources call to unload.
+        CResourceLoadContext::PrepareStore(this);
+        DestroyUnreferencedResources();
+
+        // Update dependencies. Every job loads its resource into its own load context and only generates the
+        // dependency tree; the trees are then assigned to their entries on this thread, in a fixed order.
+        std::vector<CResourceEntry*> Entries;
+        Entries.reserve(mResourceEntries.Size());
+
         for (CResourceIterator It(this); It; ++It)
-            It->UpdateDependencies();
+            Entries.push_back(*It);
+
+        std::vector<CDependencyTree*> Dependencies(Entries.size(), nullptr);
+
+        Pool.ParallelFor(Entries.size(), [this, &Entries, &Dependencies](uint EntryIdx)
+        {
+            CResourceEntry *pEntry = Entries[EntryIdx];
+
+            if (pEntry->TypeInfo()->CanHaveDependencies())
+            {
+                CResourceLoadContext Context(this);
+                CResource *pRes = pEntry->Load();
+
+                if (pRes)
+                    Dependencies[EntryIdx] = pRes->BuildDependencyTree();
+                else
+                    errorf("Unable to update cached dependencies; failed to load resource");
+            }
+        });
+
+        for (uint32 EntryIdx = 0; EntryIdx < Entries.size(); EntryIdx++)
+        {
+            CDependencyTree *pTree = Dependencies[EntryIdx];
+            Entries[EntryIdx]->SetDependencies(pTree ? pTree : new CDependencyTree());
+        }
 
         // Update database file
         mDatabaseCacheDirty = true;
@@ -457,8 +789,10 @@ CResourceEntry* CResourceStore::CreateNewResource(const CAssetID& rkID, EResourc
         // Validate directory
         if (IsValidResourcePath(rkDir, rkName))
         {
+            mpAsyncLoader->CancelAll();
             pEntry = CResourceEntry::CreateNewResource(this, rkID, rkDir, rkName, Type, ExistingResource);
-            mResourceEntries[rkID] = pEntry;
+            mResourceEntries.Insert(rkID, pEntry);
+            mpDependencyIndex->UpdateEntry(pEntry);
             mDatabaseCacheDirty = true;
 
             if (pEntry->IsLoaded())
@@ -552,12 +886,17 @@ CResource* CResourceStore::LoadResource(const TString& rkPath)
 void CResourceStore::TrackLoadedResource(CResourceEntry *pEntry)
 {
     ASSERT(pEntry->IsLoaded());
-    ASSERT(mLoadedResources.find(pEntry->ID()) == mLoadedResources.end());
-    mLoadedResources[pEntry->ID()] = pEntry;
+    ASSERT(!mLoadedResources.Contains(pEntry->ID()));
+    mLoadedResources.Insert(pEntry->ID(), pEntry);
 }
 
 void CResourceStore::DestroyUnreferencedResources()
 {
+    // Resources loaded through a load context are owned by the context, and the store must not be
+    // modified while contexts are active, so there's nothing to do here.
+    if (CResourceLoadContext::IsActive(this))
+        return;
+
     // This can be updated to avoid the do-while loop when reference lookup is implemented.
     uint32 NumDeleted;
 
@@ -568,21 +907,25 @@ void CResourceStore::DestroyUnreferencedResources()
 
         while (It != mLoadedResources.end())
         {
-            CResourceEntry *pEntry = It->second;
+            CResourceEntry *pEntry = It.Value();
 
             if (!pEntry->Resource()->IsReferenced() && pEntry->Unload())
             {
-                It = mLoadedResources.erase(It);
+                It = mLoadedResources.Erase(It);
                 NumDeleted++;
             }
 
             else It++;
         }
+
+        // Resources from background loads that couldn't be attached to their entries
+        NumDeleted += mpAsyncLoader->DestroyUnreferencedOrphans();
     } while (NumDeleted > 0);
 }
 
 bool CResourceStore::DeleteResourceEntry(CResourceEntry *pEntry)
 {
+    mpAsyncLoader->CancelAll();
     CAssetID ID = pEntry->ID();
 
     if (pEntry->IsLoaded())
@@ -590,17 +933,16 @@ bool CResourceStore::DeleteResourceEntry(CResourceEntry *pEntry)
         if (!pEntry->Unload())
             return false;
 
-        auto It = mLoadedResources.find(ID);
-        ASSERT(It != mLoadedResources.end());
-        mLoadedResources.erase(It);
+        bool WasTracked = mLoadedResources.Erase(ID);
+        ASSERT(WasTracked);
     }
 
     if (pEntry->Directory())
         pEntry->Directory()->RemoveChildResource(pEntry);
 
-    auto It = mResourceEntries.find(ID);
-    ASSERT(It != mResourceEntries.end());
-    mResourceEntries.erase(It);
+    bool WasRegistered = mResourceEntries.Erase(ID);
+    ASSERT(WasRegistered);
+    mpDependencyIndex->RemoveEntry(ID);
 
     delete pEntry;
     return true;
@@ -2,21 +2,27 @@
 #define CRESOURCESTORE_H
 
 #include "CVirtualDirectory.h"
+#include "TAssetMap.h"
 #include "Core/Resource/EResType.h"
 #include <Common/CAssetID.h>
 #include <Common/CFourCC.h>
 #include <Common/FileUtil.h>
 #include <Common/TString.h>
 #include <map>
+#include <memory>
 #include <set>
 
+class CAsyncResourceLoader;
+class CDependencyIndex;
 class CGameExporter;
 class CGameProject;
+class CMappedFile;
 class CResource;
 
 enum class EDatabaseVersion
 {
     Initial,
+    FlatLayout,     // Native-endian flat tables that can be loaded straight out of a memory mapping
     // Add new versions before this line
 
     Max,
@@ -30,9 +36,11 @@ class CResourceStore
     CGameProject *mpProj;
     EGame mGame;
     CVirtualDirectory *mpDatabaseRoot;
-    std::map<CAssetID, CResourceEntry*> mResourceEntries;
-    std::map<CAssetID, CResourceEntry*> mLoadedResources;
+    TAssetMap<CResourceEntry*> mResourceEntries;
+    TAssetMap<CResourceEntry*> mLoadedResources;
     bool mDatabaseCacheDirty;
+    std::unique_ptr<CAsyncResourceLoader> mpAsyncLoader;
+    std::unique_ptr<CDependencyIndex> mpDependencyIndex;
 
     // Directory paths
     TString mDatabasePath;
@@ -83,12 +91,17 @@ public:
     inline TString ResourcesDir() const             { return IsEditorStore() ? DatabaseRootPath() : DatabaseRootPath() + "Resources/"; }
     inline TString DatabasePath() const             { return DatabaseRootPath() + "ResourceDatabaseCache.bin"; }
     inline CVirtualDirectory* RootDirectory() const { return mpDatabaseRoot; }
-    inline uint32 NumTotalResources() const         { return mResourceEntries.size(); }
-    inline uint32 NumLoadedResources() const        { return mLoadedResources.size(); }
+    inline uint32 NumTotalResources() const         { return mResourceEntries.Size(); }
+    inline uint32 NumLoadedResources() const        { return mLoadedResources.Size(); }
     inline bool IsCacheDirty() const                { return mDatabaseCacheDirty; }
+    inline CAsyncResourceLoader* AsyncLoader() const { return mpAsyncLoader.get(); }
+    inline CDependencyIndex* DependencyIndex() const { return mpDependencyIndex.get(); }
 
     inline void SetCacheDirty()                     { mDatabaseCacheDirty = true; }
     inline bool IsEditorStore() const               { return mpProj == nullptr; }
+
+protected:
+    bool LoadFlatDatabaseCache(const CMappedFile& rkFile);
 };
 
 extern CResourceStore *gpResourceStore;
@@ -90,25 +90,21 @@ CVirtualDirectory* CVirtualDirectory::FindChildDirectory(const TString& rkName,
 {
     uint32 SlashIdx = rkName.IndexOf("\\/");
     TString DirName = (SlashIdx == -1 ? rkName : rkName.SubString(0, SlashIdx));
+    CVirtualDirectory *pChild = FindSubdirectory(DirName);
 
-    for (uint32 iSub = 0; iSub < mSubdirectories.size(); iSub++)
+    if (pChild)
     {
-        CVirtualDirectory *pChild = mSubdirectories[iSub];
+        if (SlashIdx == -1)
+            return pChild;
 
-        if (pChild->Name().CaseInsensitiveCompare(DirName))
+        else
         {
-            if (SlashIdx == -1)
-                return pChild;
+            TString Remaining = rkName.SubString(SlashIdx + 1, rkName.Size() - SlashIdx);
 
+            if (Remaining.IsEmpty())
+                return pChild;
             else
-            {
-                TString Remaining = rkName.SubString(SlashIdx + 1, rkName.Size() - SlashIdx);
-
-                if (Remaining.IsEmpty())
-                    return pChild;
-                else
-                    return pChild->FindChildDirectory(Remaining, AllowCreate);
-            }
+                return pChild->FindChildDirectory(Remaining, AllowCreate);
         }
     }
 
@@ -148,13 +144,8 @@ CResourceEntry* CVirtualDirectory::FindChildResource(const TString& rkPath)
 
 CResourceEntry* CVirtualDirectory::FindChildResource(const TString& rkName, EResourceType Type)
 {
-    for (uint32 iRes = 0; iRes < mResources.size(); iRes++)
-    {
-        if (rkName.CaseInsensitiveCompare(mResources[iRes]->Name()) && mResources[iRes]->ResourceType() == Type)
-            return mResources[iRes];
-    }
-
-    return nullptr;
+    auto It = mResourceIndex.find( SResourceKey { rkName.ToUpper(), Type } );
+    return (It != mResourceIndex.end() ? It->second : nullptr);
 }
 
 bool CVirtualDirectory::AddChild(const TString &rkPath, CResourceEntry *pEntry)
@@ -163,7 +154,7 @@ bool CVirtualDirectory::AddChild(const TString &rkPath, CResourceEntry *pEntry)
     {
         if (pEntry)
         {
-            mResources.push_back(pEntry);
+            InsertResource(pEntry);
             return true;
         }
         else
@@ -177,16 +168,7 @@ bool CVirtualDirectory::AddChild(const TString &rkPath, CResourceEntry *pEntry)
         TString Remaining = (SlashIdx == -1 ? "" : rkPath.SubString(SlashIdx + 1, rkPath.Size() - SlashIdx));
 
         // Check if this subdirectory already exists
-        CVirtualDirectory *pSubdir = nullptr;
-
-        for (uint32 iSub = 0; iSub < mSubdirectories.size(); iSub++)
-        {
-            if (mSubdirectories[iSub]->Name() == DirName)
-            {
-                pSubdir = mSubdirectories[iSub];
-                break;
-            }
-        }
+        CVirtualDirectory *pSubdir = FindSubdirectory(DirName);
 
         if (!pSubdir)
         {
@@ -199,7 +181,7 @@ bool CVirtualDirectory::AddChild(const TString &rkPath, CResourceEntry *pEntry)
                 return false;
             }
 
-            mSubdirectories.push_back(pSubdir);
+            InsertSubdirectory(pSubdir);
             SortSubdirectories();
 
             // As an optimization, don't recurse here. We've already verified the full path is valid, so we don't need to do it again.
@@ -216,11 +198,11 @@ bool CVirtualDirectory::AddChild(const TString &rkPath, CResourceEntry *pEntry)
                     return false;
                 }
 
-                pSubdir->Parent()->mSubdirectories.push_back(pSubdir);
+                pSubdir->Parent()->InsertSubdirectory(pSubdir);
             }
 
             if (pEntry)
-                pSubdir->mResources.push_back(pEntry);
+                pSubdir->InsertResource(pEntry);
 
             return true;
         }
@@ -241,14 +223,22 @@ bool CVirtualDirectory::AddChild(const TString &rkPath, CResourceEntry *pEntry)
 bool CVirtualDirectory::AddChild(CVirtualDirectory *pDir)
 {
     if (pDir->Parent() != this) return false;
-    if (FindChildDirectory(pDir->Name(), false) != nullptr) return false;
+    if (FindSubdirectory(pDir->Name()) != nullptr) return false;
 
-    mSubdirectories.push_back(pDir);
+    InsertSubdirectory(pDir);
     SortSubdirectories();
 
     return true;
 }
 
+void CVirtualDirectory::AddSortedChild(CVirtualDirectory *pDir)
+{
+    // Used when loading the database cache. Subdirectories are stored in sorted order there,
+    // so we can skip the conflict check and re-sort that AddChild does.
+    ASSERT(pDir->Parent() == this);
+    InsertSubdirectory(pDir);
+}
+
 bool CVirtualDirectory::RemoveChildDirectory(CVirtualDirectory *pSubdir)
 {
     for (auto It = mSubdirectories.begin(); It != mSubdirectories.end(); It++)
@@ -256,6 +246,12 @@ bool CVirtualDirectory::RemoveChildDirectory(CVirtualDirectory *pSubdir)
         if (*It == pSubdir)
         {
             mSubdirectories.erase(It);
+
+            auto IndexIt = mSubdirectoryIndex.find(pSubdir->Name().ToUpper());
+
+            if (IndexIt != mSubdirectoryIndex.end() && IndexIt->second == pSubdir)
+                mSubdirectoryIndex.erase(IndexIt);
+
             return true;
         }
     }
@@ -270,6 +266,20 @@ bool CVirtualDirectory::RemoveChildResource(CResourceEntry *pEntry)
         if (*It == pEntry)
         {
             mResources.erase(It);
+
+            // Entries are indexed under their cached uppercase name, so renames need to remove the entry before updating it
+            auto Range = mResourceIndex.equal_range( SResourceKey { pEntry->UppercaseName(), pEntry->ResourceType() } );
+
+            for (auto IndexIt = Range.first; IndexIt != Range.second; IndexIt++)
+            {
+                if (IndexIt->second == pEntry)
+                {
+                    mResourceIndex.erase(IndexIt);
+                    return true;
+                }
+            }
+
+            errorf("Resource %s was missing from the directory index", *pEntry->Name());
             return true;
         }
     }
@@ -297,7 +307,9 @@ bool CVirtualDirectory::Rename(const TString& rkNewName)
 
             if (FileUtil::MoveDirectory(AbsPath, NewPath))
             {
+                mpParent->mSubdirectoryIndex.erase(mName.ToUpper());
                 mName = rkNewName;
+                mpParent->mSubdirectoryIndex[mName.ToUpper()] = this;
                 mpStore->SetCacheDirty();
                 mpParent->SortSubdirectories();
                 return true;
@@ -397,6 +409,24 @@ bool CVirtualDirectory::SetParent(CVirtualDirectory *pParent)
     }
 }
 
+void CVirtualDirectory::InsertSubdirectory(CVirtualDirectory *pSubdir)
+{
+    mSubdirectories.push_back(pSubdir);
+    mSubdirectoryIndex.emplace(pSubdir->Name().ToUpper(), pSubdir);
+}
+
+void CVirtualDirectory::InsertResource(CResourceEntry *pEntry)
+{
+    mResources.push_back(pEntry);
+    mResourceIndex.emplace( SResourceKey { pEntry->UppercaseName(), pEntry->ResourceType() }, pEntry );
+}
+
+CVirtualDirectory* CVirtualDirectory::FindSubdirectory(const TString& rkName) const
+{
+    auto It = mSubdirectoryIndex.find(rkName.ToUpper());
+    return (It != mSubdirectoryIndex.end() ? It->second : nullptr);
+}
+
 // ************ STATIC ************
 bool CVirtualDirectory::IsValidDirectoryName(const TString& rkName)
 {
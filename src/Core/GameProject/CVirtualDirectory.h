@@ -5,6 +5,7 @@
 #include "Core/Resource/EResType.h"
 #include <Common/Macros.h>
 #include <Common/TString.h>
+#include <unordered_map>
 #include <vector>
 
 class CResourceEntry;
@@ -12,12 +13,49 @@ class CResourceStore;
 
 class CVirtualDirectory
 {
+    /** Key for resource lookups; names are stored uppercase so lookups are case-insensitive */
+    struct SResourceKey
+    {
+        TString UpperName;
+        EResourceType Type;
+
+        inline bool operator==(const SResourceKey& rkOther) const
+        {
+            return Type == rkOther.Type && UpperName == rkOther.UpperName;
+        }
+    };
+
+    struct SResourceKeyHash
+    {
+        inline size_t operator()(const SResourceKey& rkKey) const
+        {
+            return std::hash<uint64>()( ((uint64) rkKey.Type << 32) | rkKey.UpperName.Hash32() );
+        }
+    };
+
+    struct SNameHash
+    {
+        inline size_t operator()(const TString& rkUpperName) const
+        {
+            return std::hash<uint32>()( rkUpperName.Hash32() );
+        }
+    };
+
     CVirtualDirectory *mpParent;
     CResourceStore *mpStore;
     TString mName;
     std::vector<CVirtualDirectory*> mSubdirectories;
     std::vector<CResourceEntry*> mResources;
 
+    // Lookup indices for the child lists above, keyed by uppercase name.
+    // Resources use a multimap since nothing stops a broken database from containing duplicates.
+    std::unordered_map<TString, CVirtualDirectory*, SNameHash> mSubdirectoryIndex;
+    std::unordered_multimap<SResourceKey, CResourceEntry*, SResourceKeyHash> mResourceIndex;
+
+    void InsertSubdirectory(CVirtualDirectory *pSubdir);
+    void InsertResource(CResourceEntry *pEntry);
+    CVirtualDirectory* FindSubdirectory(const TString& rkName) const;
+
 public:
     CVirtualDirectory(CResourceStore *pStore);
     CVirtualDirectory(const TString& rkName, CResourceStore *pStore);
@@ -35,6 +73,7 @@ public:
     CResourceEntry* FindChildResource(const TString& rkName, EResourceType Type);
     bool AddChild(const TString& rkPath, CResourceEntry *pEntry);
     bool AddChild(CVirtualDirectory *pDir);
+    void AddSortedChild(CVirtualDirectory *pDir);
     bool RemoveChildDirectory(CVirtualDirectory *pSubdir);
     bool RemoveChildResource(CResourceEntry *pEntry);
     void SortSubdirectories();
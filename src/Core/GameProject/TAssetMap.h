@@ -0,0 +1,240 @@
+#ifndef TASSETMAP_H
+#define TASSETMAP_H
+
+#include <Common/BasicTypes.h>
+#include <Common/CAssetID.h>
+#include <Common/Macros.h>
+#include <Common/Math/MathUtil.h>
+#include <vector>
+
+/**
+ * Open-addressing hash map keyed on the integral value of an asset ID.
+ * This is used in place of std::map for lookups that are hit very frequently
+ * (e.g. resource entry lookups); all slots are stored in one contiguous array
+ * with linear probing, so a lookup usually only touches a single cache line.
+ *
+ * Erased slots are left as tombstones, so erasing during iteration is safe.
+ * Inserting during iteration is not, as inserts can trigger a rehash.
+ * Iteration order is unspecified; CResourceIterator sorts by ID where order matters.
+ */
+template<typename ValueType>
+class TAssetMap
+{
+    enum class ESlotState : uint8
+    {
+        Empty,
+        Occupied,
+        Erased
+    };
+
+    struct SSlot
+    {
+        uint64 Key;
+        ValueType Value;
+        ESlotState State;
+    };
+
+    std::vector<SSlot> mSlots;
+    uint32 mSize;
+    uint32 mNumErased;
+
+    static const uint32 skMinCapacity = 64;
+
+    static inline uint64 HashKey(uint64 Key)
+    {
+        // splitmix64 finalizer; asset IDs are often sequential, so they need to be mixed
+        Key ^= Key >> 30;
+        Key *= 0xBF58476D1CE4E5B9ULL;
+        Key ^= Key >> 27;
+        Key *= 0x94D049BB133111EBULL;
+        Key ^= Key >> 31;
+        return Key;
+    }
+
+    uint32 FindSlot(uint64 Key) const
+    {
+        if (mSlots.empty()) return -1;
+
+        uint32 Mask = mSlots.size() - 1;
+        uint32 SlotIdx = (uint32) HashKey(Key) & Mask;
+
+        while (mSlots[SlotIdx].State != ESlotState::Empty)
+        {
+            if (mSlots[SlotIdx].State == ESlotState::Occupied && mSlots[SlotIdx].Key == Key)
+                return SlotIdx;
+
+            SlotIdx = (SlotIdx + 1) & Mask;
+        }
+
+        return -1;
+    }
+
+    void Rehash(uint32 NewCapacity)
+    {
+        std::vector<SSlot> OldSlots( NewCapacity, SSlot { 0, ValueType(), ESlotState::Empty } );
+        OldSlots.swap(mSlots);
+        mSize = 0;
+        mNumErased = 0;
+
+        for (const SSlot& rkSlot : OldSlots)
+        {
+            if (rkSlot.State == ESlotState::Occupied)
+                Insert(rkSlot.Key, rkSlot.Value);
+        }
+    }
+
+public:
+    class CIterator
+    {
+        friend class TAssetMap;
+        const TAssetMap *mpkMap;
+        uint32 mSlotIdx;
+
+        CIterator(const TAssetMap *pkMap, uint32 SlotIdx)
+            : mpkMap(pkMap), mSlotIdx(SlotIdx)
+        {
+            SkipUnoccupied();
+        }
+
+        void SkipUnoccupied()
+        {
+            while (mSlotIdx < mpkMap->mSlots.size() && mpkMap->mSlots[mSlotIdx].State != ESlotState::Occupied)
+                mSlotIdx++;
+        }
+
+    public:
+        inline uint64 Key() const               { return mpkMap->mSlots[mSlotIdx].Key; }
+        inline ValueType Value() const          { return mpkMap->mSlots[mSlotIdx].Value; }
+
+        inline bool operator==(const CIterator& rkOther) const  { return mSlotIdx == rkOther.mSlotIdx; }
+        inline bool operator!=(const CIterator& rkOther) const  { return mSlotIdx != rkOther.mSlotIdx; }
+
+        inline CIterator& operator++()
+        {
+            mSlotIdx++;
+            SkipUnoccupied();
+            return *this;
+        }
+
+        inline CIterator operator++(int)
+        {
+            CIterator Copy = *this;
+            ++(*this);
+            return Copy;
+        }
+    };
+
+    TAssetMap()
+        : mSize(0)
+        , mNumErased(0)
+    {}
+
+    ValueType Find(const CAssetID& rkID, ValueType Default = ValueType()) const
+    {
+        return Find(rkID.ToLongLong(), Default);
+    }
+
+    ValueType Find(uint64 Key, ValueType Default = ValueType()) const
+    {
+        uint32 SlotIdx = FindSlot(Key);
+        return (SlotIdx == (uint32) -1 ? Default : mSlots[SlotIdx].Value);
+    }
+
+    inline bool Contains(const CAssetID& rkID) const
+    {
+        return FindSlot(rkID.ToLongLong()) != (uint32) -1;
+    }
+
+    void Insert(const CAssetID& rkID, ValueType Value)
+    {
+        Insert(rkID.ToLongLong(), Value);
+    }
+
+    void Insert(uint64 Key, ValueType Value)
+    {
+        // Keep the load factor (including erased slots) under 75%
+        if ((mSize + mNumErased + 1) * 4 > mSlots.size() * 3)
+        {
+            uint32 NewCapacity = Math::Max<uint32>(mSlots.size(), skMinCapacity);
+
+            while ((mSize + 1) * 2 > NewCapacity)
+                NewCapacity *= 2;
+
+            Rehash(NewCapacity);
+        }
+
+        uint32 Mask = mSlots.size() - 1;
+        uint32 SlotIdx = (uint32) HashKey(Key) & Mask;
+        uint32 InsertIdx = -1;
+
+        while (mSlots[SlotIdx].State != ESlotState::Empty)
+        {
+            if (mSlots[SlotIdx].State == ESlotState::Occupied && mSlots[SlotIdx].Key == Key)
+            {
+                mSlots[SlotIdx].Value = Value;
+                return;
+            }
+
+            if (mSlots[SlotIdx].State == ESlotState::Erased && InsertIdx == (uint32) -1)
+                InsertIdx = SlotIdx;
+
+            SlotIdx = (SlotIdx + 1) & Mask;
+        }
+
+        if (InsertIdx == (uint32) -1)
+            InsertIdx = SlotIdx;
+        else
+            mNumErased--;
+
+        mSlots[InsertIdx] = SSlot { Key, Value, ESlotState::Occupied };
+        mSize++;
+    }
+
+    bool Erase(const CAssetID& rkID)
+    {
+        uint32 SlotIdx = FindSlot(rkID.ToLongLong());
+        if (SlotIdx == (uint32) -1) return false;
+
+        mSlots[SlotIdx].Value = ValueType();
+        mSlots[SlotIdx].State = ESlotState::Erased;
+        mSize--;
+        mNumErased++;
+        return true;
+    }
+
+    CIterator Erase(CIterator Iter)
+    {
+        ASSERT(Iter.mpkMap == this && mSlots[Iter.mSlotIdx].State == ESlotState::Occupied);
+        mSlots[Iter.mSlotIdx].Value = ValueType();
+        mSlots[Iter.mSlotIdx].State = ESlotState::Erased;
+        mSize--;
+        mNumErased++;
+        return ++Iter;
+    }
+
+    void Clear()
+    {
+        mSlots.clear();
+        mSize = 0;
+        mNumErased = 0;
+    }
+
+    void Reserve(uint32 NumElements)
+    {
+        uint32 NewCapacity = skMinCapacity;
+
+        while (NumElements * 2 > NewCapacity)
+            NewCapacity *= 2;
+
+        if (NewCapacity > mSlots.size())
+            Rehash(NewCapacity);
+    }
+
+    // Accessors
+    inline CIterator begin() const  { return CIterator(this, 0); }
+    inline CIterator end() const    { return CIterator(this, mSlots.size()); }
+    inline uint32 Size() const      { return mSize; }
+    inline bool IsEmpty() const     { return mSize == 0; }
+};
+
+#endif // TASSETMAP_H
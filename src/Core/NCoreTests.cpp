@@ -1,9 +1,27 @@
 #include "NCoreTests.h"
 #include "IUIRelay.h"
+#include "Core/CompressionUtil.h"
+#include "Core/CRayCollisionTester.h"
 #include "Core/GameProject/CGameProject.h"
 #include "Core/GameProject/CResourceEntry.h"
 #include "Core/GameProject/CResourceIterator.h"
+#include "Core/GameProject/CResourceLoadContext.h"
+#include "Core/GameProject/DependencyListBuilders.h"
+#include "Core/Render/CBoneTransformData.h"
+#include "Core/Resource/Animation/CAnimation.h"
+#include "Core/Resource/Animation/CAnimSet.h"
+#include "Core/Resource/Area/CGameArea.h"
 #include "Core/Resource/Cooker/CResourceCooker.h"
+#include "Core/Resource/Factory/CTextureDecoder.h"
+#include "Core/Resource/Model/CModel.h"
+#include "Core/Resource/Script/CScriptLayer.h"
+#include "Core/Scene/CScene.h"
+#include "Core/Scene/CSceneIterator.h"
+#include <Common/CTimer.h>
+#include <Common/Math/MathUtil.h>
+#include <algorithm>
+#include <map>
+#include <random>
 
 namespace NCoreTests
 {
@@ -67,10 +85,532 @@ bool RunTests(int argc, char* argv[])
         return true;
     }
 
+    else if( ParseToken("BenchmarkResourceLookup", argc, argv) )
+    {
+        const char* pkIterations = ParseParameter("-iterations", argc, argv);
+        uint NumIterations = (pkIterations ? TString(pkIterations).ToInt32(10) : 100);
+
+        // Time the project open, since the entry map is populated when the resource database is loaded
+        double OpenStart = CTimer::GlobalTime();
+        bool Opened = gpUIRelay->OpenProject(ParseParameter("-project", argc, argv));
+        double OpenTime = CTimer::GlobalTime() - OpenStart;
+
+        if( Opened )
+        {
+            debugf( "Project opened in %f seconds", OpenTime );
+            BenchmarkResourceLookup(NumIterations);
+        }
+        return true;
+    }
+
+    else if( ParseToken("BenchmarkTextureDecode", argc, argv) )
+    {
+        const char* pkIterations = ParseParameter("-iterations", argc, argv);
+        uint NumIterations = (pkIterations ? TString(pkIterations).ToInt32(10) : 10);
+
+        if( gpUIRelay->OpenProject(ParseParameter("-project", argc, argv)) )
+        {
+            BenchmarkTextureDecode(NumIterations);
+        }
+        return true;
+    }
+
+    else if( ParseToken("BenchmarkPoseEvaluation", argc, argv) )
+    {
+        const char* pkIterations = ParseParameter("-iterations", argc, argv);
+        uint NumIterations = (pkIterations ? TString(pkIterations).ToInt32(10) : 100);
+
+        if( gpUIRelay->OpenProject(ParseParameter("-project", argc, argv)) )
+        {
+            BenchmarkPoseEvaluation(NumIterations);
+        }
+        return true;
+    }
+
+    else if( ParseToken("ReportAreaMemory", argc, argv) )
+    {
+        if( gpUIRelay->OpenProject(ParseParameter("-project", argc, argv)) )
+        {
+            ReportAreaMemory();
+        }
+        return true;
+    }
+
+    else if( ParseToken("ReportAnimationMemory", argc, argv) )
+    {
+        if( gpUIRelay->OpenProject(ParseParameter("-project", argc, argv)) )
+        {
+            ReportAnimationMemory();
+        }
+        return true;
+    }
+
+    else if( ParseToken("BenchmarkCompression", argc, argv) )
+    {
+        if( gpUIRelay->OpenProject(ParseParameter("-project", argc, argv)) )
+        {
+            BenchmarkCompression();
+        }
+        return true;
+    }
+
+    else if( ParseToken("BenchmarkScenePicking", argc, argv) )
+    {
+        // Builds its own scene, so no project is needed
+        const char* pkPicks = ParseParameter("-picks", argc, argv);
+        uint NumPicks = (pkPicks ? TString(pkPicks).ToInt32(10) : 10000);
+        BenchmarkScenePicking(NumPicks);
+        return true;
+    }
+
+    else if( ParseToken("BenchmarkSurfaceRayCast", argc, argv) )
+    {
+        const char* pkRays = ParseParameter("-rays", argc, argv);
+        uint NumRays = (pkRays ? TString(pkRays).ToInt32(10) : 100);
+
+        if( gpUIRelay->OpenProject(ParseParameter("-project", argc, argv)) )
+        {
+            BenchmarkSurfaceRayCast(NumRays);
+        }
+        return true;
+    }
+
+    else if( ParseToken("BenchmarkAreaSetup", argc, argv) )
+    {
+        const char* pkInstances = ParseParameter("-instances", argc, argv);
+        uint MaxInstances = (pkInstances ? TString(pkInstances).ToInt32(10) : 8000);
+
+        if( gpUIRelay->OpenProject(ParseParameter("-project", argc, argv)) )
+        {
+            BenchmarkAreaSetup(MaxInstances);
+        }
+        return true;
+    }
+
     // No test being run.
     return false;
 }
 
+/** Compare resource entry lookup performance of the resource store against std::map */
+bool BenchmarkResourceLookup(uint NumIterations)
+{
+    CResourceStore* pStore = gpResourceStore;
+
+    if (!pStore || !pStore->Project())
+    {
+        errorf("Resource lookup benchmark failed; no project loaded");
+        return false;
+    }
+
+    // Gather every asset ID in the project and shuffle them so lookups don't happen in storage order
+    std::vector<CAssetID> IDs;
+    IDs.reserve( pStore->NumTotalResources() );
+
+    for (CResourceIterator It(pStore); It; ++It)
+        IDs.push_back( It->ID() );
+
+    std::shuffle( IDs.begin(), IDs.end(), std::mt19937(0) );
+
+    // Build a std::map (the old storage) and a TAssetMap from the same entries
+    double Start = CTimer::GlobalTime();
+    std::map<CAssetID, CResourceEntry*> EntryMap;
+
+    for( const CAssetID& rkID : IDs )
+        EntryMap[rkID] = pStore->FindEntry(rkID);
+
+    double MapBuildTime = CTimer::GlobalTime() - Start;
+    Start = CTimer::GlobalTime();
+    TAssetMap<CResourceEntry*> EntryIndex;
+
+    for( const CAssetID& rkID : IDs )
+        EntryIndex.Insert( rkID, pStore->FindEntry(rkID) );
+
+    double IndexBuildTime = CTimer::GlobalTime() - Start;
+
+    // Time lookups. The checksum keeps the compiler from optimizing the lookups away.
+    uint64 MapChecksum = 0, IndexChecksum = 0, StoreChecksum = 0;
+    Start = CTimer::GlobalTime();
+
+    for( uint Iter = 0; Iter < NumIterations; Iter++ )
+        for( const CAssetID& rkID : IDs )
+            MapChecksum += (uint64) EntryMap.find(rkID)->second;
+
+    double MapLookupTime = CTimer::GlobalTime() - Start;
+    Start = CTimer::GlobalTime();
+
+    for( uint Iter = 0; Iter < NumIterations; Iter++ )
+        for( const CAssetID& rkID : IDs )
+            IndexChecksum += (uint64) EntryIndex.Find(rkID);
+
+    double IndexLookupTime = CTimer::GlobalTime() - Start;
+    Start = CTimer::GlobalTime();
+
+    for( uint Iter = 0; Iter < NumIterations; Iter++ )
+        for( const CAssetID& rkID : IDs )
+            StoreChecksum += (uint64) pStore->FindEntry(rkID);
+
+    double StoreLookupTime = CTimer::GlobalTime() - Start;
+
+    // Print results
+    double NumLookups = (double) IDs.size() * NumIterations;
+    debugf( "%d entries, %d lookups per container", (uint32) IDs.size(), (uint) NumLookups );
+    debugf( "std::map:   built in %f ms, %f million lookups/sec", MapBuildTime * 1000.0, NumLookups / MapLookupTime / 1000000.0 );
+    debugf( "TAssetMap:  built in %f ms, %f million lookups/sec", IndexBuildTime * 1000.0, NumLookups / IndexLookupTime / 1000000.0 );
+    debugf( "FindEntry:  %f million lookups/sec", NumLookups / StoreLookupTime / 1000000.0 );
+
+    bool Success = (MapChecksum == IndexChecksum && IndexChecksum == StoreChecksum);
+    debugf( "Benchmark %s", Success ? "SUCCEEDED" : "FAILED; lookup results don't match" );
+    return Success;
+}
+
+/** Compare the block texture decoder against the original per-pixel decoder on every texture in the project */
+bool BenchmarkTextureDecode(uint NumIterations)
+{
+    CResourceStore* pStore = gpResourceStore;
+    CGameProject* pProject = (pStore ? pStore->Project() : nullptr);
+
+    if (!pProject)
+    {
+        errorf("Texture decode benchmark failed; no project loaded");
+        return false;
+    }
+
+    // Load every cooked texture into memory up front so file IO isn't part of the timing
+    TString ResourcesDir = pProject->ResourcesDir(false);
+    std::vector< std::vector<uint8> > Textures;
+    uint64 TotalSize = 0;
+
+    for (CResourceIterator It(pStore); It; ++It)
+    {
+        if (It->ResourceType() != EResourceType::Texture || !It->HasCookedVersion())
+            continue;
+
+        CFileInStream FileStream(ResourcesDir / It->CookedAssetPath(true), EEndian::BigEndian);
+
+        if (!FileStream.IsValid())
+            continue;
+
+        std::vector<uint8> Data( FileStream.Size() );
+        FileStream.ReadBytes(Data.data(), Data.size());
+        TotalSize += Data.size();
+        Textures.push_back( std::move(Data) );
+    }
+
+    // Time both decoders over the whole corpus
+    auto TimeDecode = [&Textures, NumIterations](CTexture* (*pLoadFunc)(IInputStream&, CResourceEntry*)) -> double
+    {
+        double Start = CTimer::GlobalTime();
+
+        for( uint Iter = 0; Iter < NumIterations; Iter++ )
+        {
+            for( const std::vector<uint8>& rkData : Textures )
+            {
+                CMemoryInStream Stream(rkData.data(), rkData.size(), EEndian::BigEndian);
+                delete pLoadFunc(Stream, nullptr);
+            }
+        }
+
+        return CTimer::GlobalTime() - Start;
+    };
+
+    double ReferenceTime = TimeDecode(&CTextureDecoder::LoadTXTRReference);
+    double BlockTime = TimeDecode(&CTextureDecoder::LoadTXTR);
+
+    // Verify the two decoders produce identical image data
+    uint NumMismatches = 0;
+
+    for( const std::vector<uint8>& rkData : Textures )
+    {
+        CMemoryInStream ReferenceStream(rkData.data(), rkData.size(), EEndian::BigEndian);
+        CMemoryInStream BlockStream(rkData.data(), rkData.size(), EEndian::BigEndian);
+        CTexture* pReference = CTextureDecoder::LoadTXTRReference(ReferenceStream, nullptr);
+        CTexture* pBlock = CTextureDecoder::LoadTXTR(BlockStream, nullptr);
+
+        if( pReference->ImageDataSize() != pBlock->ImageDataSize() ||
+            memcmp(pReference->ImageData(), pBlock->ImageData(), pBlock->ImageDataSize()) != 0 )
+        {
+            NumMismatches++;
+        }
+
+        delete pReference;
+        delete pBlock;
+    }
+
+    // Print results
+    double TotalMB = (double) TotalSize * NumIterations / (1024.0 * 1024.0);
+    debugf( "%d textures, %f MB of cooked data", (uint32) Textures.size(), (double) TotalSize / (1024.0 * 1024.0) );
+    debugf( "Reference decode: %f seconds, %f MB/s", ReferenceTime, TotalMB / ReferenceTime );
+    debugf( "Block decode:     %f seconds, %f MB/s", BlockTime, TotalMB / BlockTime );
+
+    bool Success = (NumMismatches == 0);
+
+    if (Success)
+        debugf( "Benchmark SUCCEEDED" );
+    else
+        debugf( "Benchmark FAILED; %d textures decoded differently", NumMismatches );
+
+    return Success;
+}
+
+/** Compare skeletal pose evaluation throughput of the pose evaluator against per-bone evaluation */
+bool BenchmarkPoseEvaluation(uint NumIterations)
+{
+    CResourceStore* pStore = gpResourceStore;
+
+    if (!pStore)
+    {
+        errorf("Pose evaluation benchmark failed; no project loaded");
+        return false;
+    }
+
+    const uint kNumSamples = 16;
+    uint64 NumBonesEvaluated = 0;
+    double PerBoneTime = 0.0;
+    double PoseTime = 0.0;
+    float MaxError = 0.f;
+    uint NumPoses = 0;
+
+    for (CResourceIterator It(pStore); It; ++It)
+    {
+        if (It->ResourceType() != EResourceType::AnimSet || !It->HasCookedVersion())
+            continue;
+
+        CResourceLoadContext Context(pStore);
+        CAnimSet* pSet = (CAnimSet*) It->Load();
+        if (!pSet) continue;
+
+        for (uint32 CharIdx = 0; CharIdx < pSet->NumCharacters(); CharIdx++)
+        {
+            CSkeleton* pSkel = pSet->Character(CharIdx)->pSkeleton;
+            if (!pSkel || !pSkel->RootBone()) continue;
+
+            CBoneTransformData PerBoneData(pSkel);
+            CBoneTransformData PoseData(pSkel);
+
+            for (uint32 AnimIdx = 0; AnimIdx < pSet->NumAnimations(); AnimIdx++)
+            {
+                CAnimation* pAnim = pSet->FindAnimationAsset(AnimIdx);
+                if (!pAnim || pAnim->NumKeys() < 2) continue;
+
+                // Time both paths over the same set of sample times across the animation
+                double Start = CTimer::GlobalTime();
+
+                for (uint Iter = 0; Iter < NumIterations; Iter++)
+                    for (uint Sample = 0; Sample < kNumSamples; Sample++)
+                        pSkel->UpdateTransformPerBone(PerBoneData, pAnim, pAnim->Duration() * Sample / kNumSamples, false);
+
+                double Mid = CTimer::GlobalTime();
+
+                for (uint Iter = 0; Iter < NumIterations; Iter++)
+                    for (uint Sample = 0; Sample < kNumSamples; Sample++)
+                        pSkel->UpdateTransform(PoseData, pAnim, pAnim->Duration() * Sample / kNumSamples, false);
+
+                double End = CTimer::GlobalTime();
+                PerBoneTime += Mid - Start;
+                PoseTime += End - Mid;
+                NumBonesEvaluated += (uint64) pSkel->NumFlatBones() * NumIterations * kNumSamples;
+                NumPoses += NumIterations * kNumSamples;
+
+                // Compare the last pose; transform a point by every bone matrix and measure the difference
+                for (uint32 BoneIdx = 0; BoneIdx < pSkel->NumFlatBones(); BoneIdx++)
+                {
+                    uint32 BoneID = pSkel->FlatBone(BoneIdx)->ID();
+                    CVector3f A = PerBoneData[BoneID] * CVector3f::skOne;
+                    CVector3f B = PoseData[BoneID] * CVector3f::skOne;
+                    MaxError = Math::Max(MaxError, Math::Max(fabsf(A.X - B.X), Math::Max(fabsf(A.Y - B.Y), fabsf(A.Z - B.Z))));
+                }
+            }
+        }
+    }
+
+    // Print results
+    debugf( "%d poses, %f bones per pose", NumPoses, NumPoses ? (double) NumBonesEvaluated / NumPoses : 0.0 );
+    debugf( "Per-bone evaluation: %f seconds, %f bones/s", PerBoneTime, NumBonesEvaluated / PerBoneTime );
+    debugf( "Pose evaluator:      %f seconds, %f bones/s", PoseTime, NumBonesEvaluated / PoseTime );
+    debugf( "Max difference: %f", MaxError );
+
+    bool Success = (MaxError < 0.001f);
+    debugf( "Benchmark %s", Success ? "SUCCEEDED" : "FAILED; the pose evaluator doesn't match per-bone evaluation" );
+    return Success;
+}
+
+/** Report how many bytes of section data each area keeps in memory after it's loaded */
+bool ReportAreaMemory()
+{
+    CResourceStore* pStore = gpResourceStore;
+
+    if (!pStore)
+    {
+        errorf("Area memory report failed; no project loaded");
+        return false;
+    }
+
+    // Script objects look up display assets in the editor store, which can't be loaded into from inside a context
+    CResourceLoadContext::PrepareStore(pStore);
+
+    uint64 TotalSectionBytes = 0;
+    uint64 TotalRetainedBytes = 0;
+    uint NumAreas = 0;
+
+    for (CResourceIterator It(pStore); It; ++It)
+    {
+        if (It->ResourceType() != EResourceType::Area || !It->HasCookedVersion())
+            continue;
+
+        // Load each area on its own so only one is in memory at a time
+        CResourceLoadContext Context(pStore);
+        CGameArea* pArea = (CGameArea*) It->Load();
+        if (!pArea) continue;
+
+        uint SectionBytes = pArea->TotalSectionBytes();
+        uint RetainedBytes = pArea->RetainedSectionBytes();
+        debugf( "%s: %d sections, %d bytes of section data, %d bytes retained", *It->Name(), pArea->NumSections(), SectionBytes, RetainedBytes );
+
+        TotalSectionBytes += SectionBytes;
+        TotalRetainedBytes += RetainedBytes;
+        NumAreas++;
+    }
+
+    debugf( "%d areas: %f MB of section data, %f MB retained", NumAreas,
+            (double) TotalSectionBytes / (1024.0 * 1024.0), (double) TotalRetainedBytes / (1024.0 * 1024.0) );
+    return true;
+}
+
+/** Report how much memory animation keys take compared to storing every key at full precision */
+bool ReportAnimationMemory()
+{
+    CResourceStore* pStore = gpResourceStore;
+
+    if (!pStore)
+    {
+        errorf("Animation memory report failed; no project loaded");
+        return false;
+    }
+
+    // Load every animation, the same as browsing through every character in the character editor
+    uint64 TotalCookedSize = 0;
+    uint64 TotalKeyDataSize = 0;
+    uint64 TotalExpandedSize = 0;
+    uint NumAnims = 0;
+
+    for (CResourceIterator It(pStore); It; ++It)
+    {
+        if (It->ResourceType() != EResourceType::Animation || !It->HasCookedVersion())
+            continue;
+
+        CResourceLoadContext Context(pStore);
+        CAnimation* pAnim = (CAnimation*) It->Load();
+        if (!pAnim) continue;
+
+        TotalCookedSize += It->Size();
+        TotalKeyDataSize += pAnim->KeyDataSize();
+        TotalExpandedSize += pAnim->ExpandedKeyDataSize();
+        NumAnims++;
+    }
+
+    debugf( "%d animations, %f MB cooked", NumAnims, (double) TotalCookedSize / (1024.0 * 1024.0) );
+    debugf( "Key data resident: %f MB", (double) TotalKeyDataSize / (1024.0 * 1024.0) );
+    debugf( "Key data if fully expanded: %f MB", (double) TotalExpandedSize / (1024.0 * 1024.0) );
+    return true;
+}
+
+/** Report the compression ratio and time of each cook compression level on the project's paks */
+bool BenchmarkCompression()
+{
+    CResourceStore* pStore = gpResourceStore;
+    CGameProject* pProject = (pStore ? pStore->Project() : nullptr);
+
+    if (!pProject)
+    {
+        errorf("Compression benchmark failed; no project loaded");
+        return false;
+    }
+
+    EGame Game = pProject->Game();
+    bool UseZlib = (Game <= EGame::EchoesDemo || Game == EGame::DKCReturns);
+    const ECompressionLevel kLevels[] = { ECompressionLevel::Fast, ECompressionLevel::Balanced, ECompressionLevel::Max };
+    const uint kNumLevels = sizeof(kLevels) / sizeof(kLevels[0]);
+
+    uint64 TotalUncompressed = 0;
+    uint64 TotalCompressed[kNumLevels] = {};
+    double TotalTime[kNumLevels] = {};
+    bool Success = true;
+
+    for (uint32 PkgIdx = 0; PkgIdx < pProject->NumPackages(); PkgIdx++)
+    {
+        CPackage* pPackage = pProject->PackageByIndex(PkgIdx);
+
+        // Load each asset's cooked data up front so file IO isn't part of the timing
+        CPackageDependencyListBuilder Builder(pPackage);
+        std::list<CAssetID> AssetList;
+        Builder.BuildDependencyList(false, AssetList);
+
+        std::vector< std::vector<uint8> > Assets;
+        uint64 PackageSize = 0;
+
+        for (const CAssetID& rkID : AssetList)
+        {
+            CResourceEntry* pEntry = pStore->FindEntry(rkID);
+            if (!pEntry || !pEntry->HasCookedVersion()) continue;
+
+            CFileInStream FileStream(pEntry->CookedAssetPath(), EEndian::BigEndian);
+            if (!FileStream.IsValid()) continue;
+
+            std::vector<uint8> Data( FileStream.Size() );
+            FileStream.ReadBytes(Data.data(), Data.size());
+            PackageSize += Data.size();
+            Assets.push_back( std::move(Data) );
+        }
+
+        // Compress every asset at each level, the same way CPackage::Cook does
+        debugf( "%s.pak: %d assets, %f MB", *pPackage->Name(), (uint32) Assets.size(), (double) PackageSize / (1024.0 * 1024.0) );
+        TotalUncompressed += PackageSize;
+
+        for (uint LevelIdx = 0; LevelIdx < kNumLevels; LevelIdx++)
+        {
+            ECompressionLevel Level = kLevels[LevelIdx];
+            std::vector<uint8> CompressedData;
+            uint64 PackageCompressed = 0;
+            double Start = CTimer::GlobalTime();
+
+            for (std::vector<uint8>& rData : Assets)
+            {
+                CompressedData.resize(rData.size() * 2);
+                uint32 CompressedSize = 0;
+                bool Compressed;
+
+                if (UseZlib)
+                    Compressed = CompressionUtil::CompressZlib(rData.data(), rData.size(), CompressedData.data(), CompressedData.size(), CompressedSize, Level);
+                else
+                    Compressed = CompressionUtil::CompressLZOSegmented(rData.data(), rData.size(), CompressedData.data(), CompressedSize, false, Level);
+
+                Success &= Compressed;
+                PackageCompressed += (Compressed ? CompressedSize : rData.size());
+            }
+
+            double Time = CTimer::GlobalTime() - Start;
+            TotalCompressed[LevelIdx] += PackageCompressed;
+            TotalTime[LevelIdx] += Time;
+
+            debugf( "  %-8s ratio %f, %f seconds", TEnumReflection<ECompressionLevel>::ConvertValueToString(Level),
+                    PackageSize ? (double) PackageCompressed / PackageSize : 1.0, Time );
+        }
+    }
+
+    // Print totals
+    debugf( "All paks: %f MB (%s)", (double) TotalUncompressed / (1024.0 * 1024.0), UseZlib ? "zlib" : "LZO" );
+
+    for (uint LevelIdx = 0; LevelIdx < kNumLevels; LevelIdx++)
+    {
+        double MB = (double) TotalUncompressed / (1024.0 * 1024.0);
+        debugf( "  %-8s ratio %f, %f seconds, %f MB/s", TEnumReflection<ECompressionLevel>::ConvertValueToString(kLevels[LevelIdx]),
+                TotalUncompressed ? (double) TotalCompressed[LevelIdx] / TotalUncompressed : 1.0, TotalTime[LevelIdx], MB / TotalTime[LevelIdx] );
+    }
+
+    debugf( "Benchmark %s", Success ? "SUCCEEDED" : "FAILED; compression errors occurred" );
+    return Success;
+}
+
 /** Validate all cooker output for the given resource type matches the original asset data */
 bool ValidateCooker(EResourceType ResourceType, bool DumpInvalidFileContents)
 {
@@ -204,4 +744,335 @@ bool ValidateCooker(EResourceType ResourceType, bool DumpInvalidFileContents)
     return TestSuccess;
 }
 
+/** Compare scene ray cast throughput of the scene BVH against testing every node */
+bool BenchmarkScenePicking(uint NumPicks)
+{
+    if (NumPicks == 0)
+    {
+        errorf("Scene picking benchmark failed; the number of picks must be at least 1");
+        return false;
+    }
+
+    // Scatter a large number of light nodes around an empty area; their billboards are simple to ray test
+    // without any resources loaded, so the timing is dominated by the number of nodes that get tested.
+    const uint kNumLights = 50000;
+    const float kAreaExtent = 1000.f;
+
+    std::mt19937 Random(0x5CE4E);
+    std::uniform_real_distribution<float> PositionDist(-kAreaExtent, kAreaExtent);
+    std::uniform_real_distribution<float> DirectionDist(-1.f, 1.f);
+
+    std::vector<CLight*> Lights;
+    Lights.reserve(kNumLights);
+
+    for (uint LightIdx = 0; LightIdx < kNumLights; LightIdx++)
+    {
+        CVector3f Position(PositionDist(Random), PositionDist(Random), PositionDist(Random));
+        Lights.push_back( CLight::BuildLocalAmbient(Position, CColor::skWhite) );
+    }
+
+    std::vector<CRay> Rays;
+    Rays.reserve(NumPicks);
+
+    for (uint PickIdx = 0; PickIdx < NumPicks; PickIdx++)
+    {
+        CVector3f Origin(PositionDist(Random), PositionDist(Random), PositionDist(Random));
+        CVector3f Direction(DirectionDist(Random), DirectionDist(Random), DirectionDist(Random));
+        Rays.push_back( CRay(Origin, Direction.Normalized()) );
+    }
+
+    uint NumMismatches = 0;
+    uint TotalHits = 0;
+    double BruteForceTime = 0.0;
+    double TreeTime = 0.0;
+    double BuildTime = 0.0;
+    uint TreeHeight = 0;
+
+    // The area has to outlive the scene
+    CGameArea Area(nullptr);
+    {
+        CScene Scene;
+        Scene.SetActiveArea(nullptr, &Area);
+
+        for (uint LightIdx = 0; LightIdx < kNumLights; LightIdx++)
+            Scene.CreateLightNode(Lights[LightIdx]);
+
+        SViewInfo ViewInfo;
+        ViewInfo.pScene = &Scene;
+        ViewInfo.pRenderer = nullptr;
+        ViewInfo.pCamera = nullptr;
+        ViewInfo.GameMode = false;
+        ViewInfo.ShowFlags = EShowFlag::Lights;
+
+        // The tree is built on the first query
+        double BuildStart = CTimer::GlobalTime();
+        {
+            CRayCollisionTester Tester(Rays[0]);
+            Scene.RayAABoxIntersectTest(Tester, ViewInfo);
+        }
+        BuildTime = CTimer::GlobalTime() - BuildStart;
+        TreeHeight = Scene.NodeTree().Height();
+
+        std::vector<uint> BruteForceHits(NumPicks);
+        double BruteForceStart = CTimer::GlobalTime();
+
+        for (uint PickIdx = 0; PickIdx < NumPicks; PickIdx++)
+        {
+            CRayCollisionTester Tester(Rays[PickIdx]);
+
+            for (CSceneIterator It(&Scene, ENodeType::Light, false); It; ++It)
+                It->RayAABoxIntersectTest(Tester, ViewInfo);
+
+            BruteForceHits[PickIdx] = Tester.NumBoxIntersections();
+        }
+
+        BruteForceTime = CTimer::GlobalTime() - BruteForceStart;
+        double TreeStart = CTimer::GlobalTime();
+
+        for (uint PickIdx = 0; PickIdx < NumPicks; PickIdx++)
+        {
+            CRayCollisionTester Tester(Rays[PickIdx]);
+            Scene.RayAABoxIntersectTest(Tester, ViewInfo);
+
+            if (Tester.NumBoxIntersections() != BruteForceHits[PickIdx])
+                NumMismatches++;
+
+            TotalHits += Tester.NumBoxIntersections();
+        }
+
+        TreeTime = CTimer::GlobalTime() - TreeStart;
+    }
+
+    for (CLight* pLight : Lights)
+        delete pLight;
+
+    // Print results
+    debugf( "%d light nodes, %d picks, %f hits per pick", kNumLights, NumPicks, (double) TotalHits / NumPicks );
+    debugf( "BVH built in %f seconds, height %d", BuildTime, TreeHeight );
+    debugf( "Brute force: %f seconds, %f picks/s", BruteForceTime, BruteForceTime > 0.0 ? NumPicks / BruteForceTime : 0.0 );
+    debugf( "Scene BVH:   %f seconds, %f picks/s", TreeTime, TreeTime > 0.0 ? NumPicks / TreeTime : 0.0 );
+
+    bool Success = (NumMismatches == 0);
+
+    if (Success)
+        debugf( "Benchmark SUCCEEDED" );
+    else
+        debugf( "Benchmark FAILED; %d picks found different nodes", NumMismatches );
+
+    return Success;
+}
+
+/** Compare surface ray test throughput of the surface ray tree against testing every triangle */
+bool BenchmarkSurfaceRayCast(uint NumRays)
+{
+    CResourceStore* pStore = gpResourceStore;
+
+    if (!pStore)
+    {
+        errorf("Surface ray cast benchmark failed; no project loaded");
+        return false;
+    }
+
+    if (NumRays == 0)
+    {
+        errorf("Surface ray cast benchmark failed; the number of rays must be at least 1");
+        return false;
+    }
+
+    std::mt19937 Random(0x5A7CA57);
+    std::uniform_real_distribution<float> UnitDist(-1.f, 1.f);
+
+    uint64 NumTests = 0;
+    uint64 NumHits = 0;
+    uint64 NumTriangles = 0;
+    uint NumMismatches = 0;
+    uint NumSurfaces = 0;
+    double ReferenceTime = 0.0;
+    double TreeTime = 0.0;
+    double BuildTime = 0.0;
+
+    for (CResourceIterator It(pStore); It; ++It)
+    {
+        if (It->ResourceType() != EResourceType::Model || !It->HasCookedVersion())
+            continue;
+
+        CResourceLoadContext Context(pStore);
+        CModel* pModel = (CModel*) It->Load();
+        if (!pModel) continue;
+
+        for (uint32 SurfIdx = 0; SurfIdx < pModel->GetSurfaceCount(); SurfIdx++)
+        {
+            SSurface* pSurf = pModel->GetSurface(SurfIdx);
+            if (pSurf->TriangleCount == 0) continue;
+
+            // Aim rays from a sphere around the surface at random points within its bounds
+            CVector3f Center = pSurf->AABox.Center();
+            CVector3f HalfSize = pSurf->AABox.Size() * 0.5f;
+            float Radius = Math::Max(HalfSize.Magnitude() * 2.f, 1.f);
+            std::vector<CRay> Rays;
+            Rays.reserve(NumRays);
+
+            for (uint RayIdx = 0; RayIdx < NumRays; RayIdx++)
+            {
+                CVector3f Offset = CVector3f(UnitDist(Random), UnitDist(Random), UnitDist(Random)).Normalized() * Radius;
+                CVector3f Target = Center + CVector3f(HalfSize.X * UnitDist(Random), HalfSize.Y * UnitDist(Random), HalfSize.Z * UnitDist(Random));
+                Rays.push_back( CRay(Center + Offset, (Target - Center - Offset).Normalized()) );
+            }
+
+            // Build the tree up front so it isn't part of the ray test timing
+            double BuildStart = CTimer::GlobalTime();
+            pSurf->pRayTree.reset();
+            pSurf->IntersectsRay(Rays[0]);
+            BuildTime += CTimer::GlobalTime() - BuildStart;
+
+            std::vector< std::pair<bool,float> > ReferenceResults(NumRays);
+            double Start = CTimer::GlobalTime();
+
+            for (uint RayIdx = 0; RayIdx < NumRays; RayIdx++)
+                ReferenceResults[RayIdx] = pSurf->IntersectsRayReference(Rays[RayIdx], (RayIdx & 1) != 0);
+
+            double Mid = CTimer::GlobalTime();
+            std::vector< std::pair<bool,float> > TreeResults(NumRays);
+
+            for (uint RayIdx = 0; RayIdx < NumRays; RayIdx++)
+                TreeResults[RayIdx] = pSurf->IntersectsRay(Rays[RayIdx], (RayIdx & 1) != 0);
+
+            double End = CTimer::GlobalTime();
+            ReferenceTime += Mid - Start;
+            TreeTime += End - Mid;
+
+            for (uint RayIdx = 0; RayIdx < NumRays; RayIdx++)
+            {
+                const std::pair<bool,float>& rkRef = ReferenceResults[RayIdx];
+                const std::pair<bool,float>& rkTree = TreeResults[RayIdx];
+
+                if (rkRef.first != rkTree.first || (rkRef.first && fabsf(rkRef.second - rkTree.second) > 0.001f * Math::Max(rkRef.second, 1.f)))
+                    NumMismatches++;
+
+                if (rkRef.first)
+                    NumHits++;
+            }
+
+            NumTests += NumRays;
+            NumTriangles += pSurf->TriangleCount;
+            NumSurfaces++;
+        }
+    }
+
+    // Print results
+    debugf( "%d surfaces, %f triangles per surface, %d ray tests, %f%% hit", NumSurfaces, NumSurfaces ? (double) NumTriangles / NumSurfaces : 0.0,
+            (uint) NumTests, NumTests ? 100.0 * NumHits / NumTests : 0.0 );
+    debugf( "Ray trees built in %f seconds", BuildTime );
+    debugf( "Per-triangle test: %f seconds, %f rays/s", ReferenceTime, ReferenceTime > 0.0 ? NumTests / ReferenceTime : 0.0 );
+    debugf( "Surface ray tree:  %f seconds, %f rays/s", TreeTime, TreeTime > 0.0 ? NumTests / TreeTime : 0.0 );
+    debugf( "%d mismatched results", NumMismatches );
+
+    if (NumSurfaces == 0)
+    {
+        errorf("Surface ray cast benchmark failed; no model surfaces with triangles");
+        return false;
+    }
+
+    // Rays that graze a triangle edge can round differently between the two paths, so allow a handful
+    bool Success = (NumMismatches <= NumTests / 10000);
+    debugf( "Benchmark %s", Success ? "SUCCEEDED" : "FAILED; the surface ray tree doesn't match the per-triangle test" );
+    return Success;
+}
+
+/** Report how long scene setup takes for an area as it's padded out to more and more script instances */
+bool BenchmarkAreaSetup(uint MaxInstances)
+{
+    CResourceStore* pStore = gpResourceStore;
+
+    if (!pStore)
+    {
+        errorf("Area setup benchmark failed; no project loaded");
+        return false;
+    }
+
+    // Script objects look up display assets in the editor store, which can't be loaded into from inside a context
+    CResourceLoadContext::PrepareStore(pStore);
+
+    // Everything is loaded into a private context, so the instances spawned here are thrown away with it
+    CResourceLoadContext Context(pStore);
+    CGameArea* pArea = nullptr;
+
+    for (CResourceIterator It(pStore); It; ++It)
+    {
+        if (It->ResourceType() != EResourceType::Area || !It->HasCookedVersion())
+            continue;
+
+        pArea = (CGameArea*) It->Load();
+
+        if (pArea && pArea->NumScriptLayers() > 0 && pArea->TotalInstanceCount() > 0)
+        {
+            debugf( "Using area %s with %d instances", *It->Name(), pArea->TotalInstanceCount() );
+            break;
+        }
+
+        pArea = nullptr;
+    }
+
+    if (!pArea)
+    {
+        errorf("Area setup benchmark failed; no areas with script instances");
+        return false;
+    }
+
+    // New instances copy the templates of the area's existing ones, scattered around the area's bounds
+    std::vector<CScriptTemplate*> Templates;
+
+    for (uint32 LayerIdx = 0; LayerIdx < pArea->NumScriptLayers(); LayerIdx++)
+    {
+        CScriptLayer* pLayer = pArea->ScriptLayer(LayerIdx);
+
+        for (uint32 InstIdx = 0; InstIdx < pLayer->NumInstances(); InstIdx++)
+            Templates.push_back( pLayer->InstanceByIndex(InstIdx)->Template() );
+    }
+
+    std::mt19937 Random(0xA5E7);
+    std::uniform_real_distribution<float> UnitDist(0.f, 1.f);
+    CAABox Bounds = pArea->AABox();
+    CScriptLayer* pSpawnLayer = pArea->ScriptLayer(0);
+
+    // Double the instance count each step; the time per node should stay about the same
+    uint NumInstances = std::max<uint>(pArea->TotalInstanceCount(), MaxInstances / 8);
+    double FirstTimePerNode = 0.0;
+    double LastTimePerNode = 0.0;
+
+    while (true)
+    {
+        while (pArea->TotalInstanceCount() < NumInstances)
+        {
+            CVector3f Size = Bounds.Size();
+            CVector3f Position = Bounds.Min() + CVector3f(Size.X * UnitDist(Random), Size.Y * UnitDist(Random), Size.Z * UnitDist(Random));
+            CScriptTemplate* pTemplate = Templates[ Random() % Templates.size() ];
+
+            if (!pArea->SpawnInstance(pTemplate, pSpawnLayer, Position))
+                break;
+        }
+
+        CScene Scene;
+        double Start = CTimer::GlobalTime();
+        Scene.SetActiveArea(nullptr, pArea);
+        double Time = CTimer::GlobalTime() - Start;
+
+        double TimePerNode = Time / std::max(CSceneNode::NumNodes(), 1);
+        debugf( "%d instances, %d nodes: %f seconds, %f microseconds per node", pArea->TotalInstanceCount(), CSceneNode::NumNodes(), Time, TimePerNode * 1000000.0 );
+
+        if (FirstTimePerNode == 0.0) FirstTimePerNode = TimePerNode;
+        LastTimePerNode = TimePerNode;
+
+        if (NumInstances >= MaxInstances || pArea->TotalInstanceCount() < NumInstances)
+            break;
+
+        NumInstances = std::min<uint>(NumInstances * 2, MaxInstances);
+    }
+
+    // Allow plenty of slack for cache effects; quadratic setup would be off by the number of doublings
+    bool Success = (LastTimePerNode <= FirstTimePerNode * 3.0);
+    debugf( "Benchmark %s", Success ? "SUCCEEDED" : "FAILED; scene setup time grows faster than the instance count" );
+    return Success;
+}
+
 } // end namespace NCoreTests
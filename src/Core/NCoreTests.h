@@ -13,6 +13,33 @@ bool RunTests(int argc, char *argv[]);
 /** Validate all cooker output for the given resource type matches the original asset data */
 bool ValidateCooker(EResourceType ResourceType, bool DumpInvalidFileContents);
 
+/** Compare resource entry lookup performance of the resource store against std::map */
+bool BenchmarkResourceLookup(uint NumIterations);
+
+/** Compare texture decode throughput of the block decoder against the original per-pixel decoder */
+bool BenchmarkTextureDecode(uint NumIterations);
+
+/** Compare skeletal pose evaluation throughput of the pose evaluator against per-bone evaluation */
+bool BenchmarkPoseEvaluation(uint NumIterations);
+
+/** Report how many bytes of section data each area keeps in memory after it's loaded */
+bool ReportAreaMemory();
+
+/** Report how much memory animation keys take compared to storing every key at full precision */
+bool ReportAnimationMemory();
+
+/** Report the compression ratio and time of each cook compression level on the project's paks */
+bool BenchmarkCompression();
+
+/** Compare scene ray cast throughput of the scene BVH against testing every node */
+bool BenchmarkScenePicking(uint NumPicks);
+
+/** Compare surface ray test throughput of the surface ray tree against testing every triangle */
+bool BenchmarkSurfaceRayCast(uint NumRays);
+
+/** Report how long scene setup takes for an area as it's padded out to more and more script instances */
+bool BenchmarkAreaSetup(uint MaxInstances);
+
 }
 
 #endif // NCORETESTS_H
@@ -7,6 +7,10 @@ CAnimation::CAnimation(CResourceEntry *pEntry /*= 0*/)
     , mDuration(0.f)
     , mTickInterval(0.0333333f)
     , mNumKeys(0)
+    , mRotationMultiplier(0.f)
+    , mTranslationMultiplier(1.f)
+    , mScaleMultiplier(1.f)
+    , mIsCompressed(false)
 {
     for (uint32 iBone = 0; iBone < 100; iBone++)
     {
@@ -25,43 +29,136 @@ CDependencyTree* CAnimation::BuildDependencyTree() const
 
 void CAnimation::EvaluateTransform(float Time, uint32 BoneID, CVector3f *pOutTranslation, CQuaternion *pOutRotation, CVector3f *pOutScale) const
 {
-    const bool kInterpolate = true;
     if (!pOutTranslation && !pOutRotation && !pOutScale) return;
-    if (mDuration == 0.f) return;
 
-    if (Time >= mDuration) Time = mDuration;
-    if (Time >= FLT_EPSILON) Time -= FLT_EPSILON;
-    float t = fmodf(Time, mTickInterval) / mTickInterval;
-    uint32 LowKey = (uint32) (Time / mTickInterval);
-    if (LowKey == (mNumKeys - 1)) LowKey = mNumKeys - 2;
+    uint32 LowKey;
+    float t;
+    if (!FindKeys(Time, LowKey, t)) return;
 
     uint8 ScaleChannel = mBoneInfo[BoneID].ScaleChannelIdx;
     uint8 RotChannel = mBoneInfo[BoneID].RotationChannelIdx;
     uint8 TransChannel = mBoneInfo[BoneID].TranslationChannelIdx;
 
     if (ScaleChannel != 0xFF && pOutScale)
-    {
-        const CVector3f& rkLow = mScaleChannels[ScaleChannel][LowKey];
-        const CVector3f& rkHigh = mScaleChannels[ScaleChannel][LowKey + 1];
-        *pOutScale = (kInterpolate ? Math::Lerp<CVector3f>(rkLow, rkHigh, t) : rkLow);
-    }
+        *pOutScale = Math::Lerp<CVector3f>(ScaleKey(ScaleChannel, LowKey), ScaleKey(ScaleChannel, LowKey + 1), t);
 
     if (RotChannel != 0xFF && pOutRotation)
-    {
-        const CQuaternion& rkLow = mRotationChannels[RotChannel][LowKey];
-        const CQuaternion& rkHigh = mRotationChannels[RotChannel][LowKey + 1];
-        *pOutRotation = (kInterpolate ? rkLow.Slerp(rkHigh, t) : rkLow);
-    }
+        *pOutRotation = RotationKey(RotChannel, LowKey).Slerp(RotationKey(RotChannel, LowKey + 1), t);
 
     if (TransChannel != 0xFF && pOutTranslation)
-    {
-        const CVector3f& rkLow = mTranslationChannels[TransChannel][LowKey];
-        const CVector3f& rkHigh = mTranslationChannels[TransChannel][LowKey + 1];
-        *pOutTranslation = (kInterpolate ? Math::Lerp<CVector3f>(rkLow, rkHigh, t) : rkLow);
-    }
+        *pOutTranslation = Math::Lerp<CVector3f>(TranslationKey(TransChannel, LowKey), TranslationKey(TransChannel, LowKey + 1), t);
+}
+
+bool CAnimation::FindKeys(float Time, uint32& rOutLowKey, float& rOutBlend) const
+{
+    // Finds the pair of keys to blend between at the given time; the high key is always rOutLowKey + 1
+    if (mDuration == 0.f) return false;
+
+    if (Time >= mDuration) Time = mDuration;
+    if (Time >= FLT_EPSILON) Time -= FLT_EPSILON;
+    rOutBlend = fmodf(Time, mTickInterval) / mTickInterval;
+    rOutLowKey = (uint32) (Time / mTickInterval);
+    if (rOutLowKey == (mNumKeys - 1)) rOutLowKey = mNumKeys - 2;
+    return true;
 }
 
 bool CAnimation::HasTranslation(uint32 BoneID) const
 {
     return (mBoneInfo[BoneID].TranslationChannelIdx != 0xFF);
 }
+
+uint32 CAnimation::KeyDataSize() const
+{
+    uint32 Size = (mStoredKeys.size() + mKeyToStoredKey.size()) * sizeof(uint16);
+
+    for (const SQuantizedChannel& rkChan : mQuantizedChannels)
+        Size += (rkChan.Rotation.size() + rkChan.Translation.size() + rkChan.Scale.size()) * sizeof(int16);
+
+    for (const TScaleChannel& rkChan : mScaleChannels)              Size += rkChan.size() * sizeof(CVector3f);
+    for (const TRotationChannel& rkChan : mRotationChannels)        Size += rkChan.size() * sizeof(CQuaternion);
+    for (const TTranslationChannel& rkChan : mTranslationChannels)  Size += rkChan.size() * sizeof(CVector3f);
+    return Size;
+}
+
+uint32 CAnimation::ExpandedKeyDataSize() const
+{
+    // Size of the key data if every key of every channel was stored at full precision
+    if (!mIsCompressed)
+        return KeyDataSize();
+
+    uint32 Size = 0;
+
+    for (const SQuantizedChannel& rkChan : mQuantizedChannels)
+    {
+        if (!rkChan.Rotation.empty())       Size += mNumKeys * sizeof(CQuaternion);
+        if (!rkChan.Translation.empty())    Size += mNumKeys * sizeof(CVector3f);
+        if (!rkChan.Scale.empty())          Size += mNumKeys * sizeof(CVector3f);
+    }
+
+    return Size;
+}
+
+// ************ KEYS ************
+CQuaternion CAnimation::DequantizeRotation(const SQuantizedChannel& rkChannel, uint32 StoredKey) const
+{
+    const int16 *pkValues = &rkChannel.Rotation[StoredKey * 4];
+    CQuaternion Out;
+    Out.X = sinf(pkValues[0] * mRotationMultiplier);
+    Out.Y = sinf(pkValues[1] * mRotationMultiplier);
+    Out.Z = sinf(pkValues[2] * mRotationMultiplier);
+    Out.W = Math::Sqrt( fmax(1.f - ((Out.X * Out.X) + (Out.Y * Out.Y) + (Out.Z * Out.Z)), 0.f) );
+    if (pkValues[3]) Out.W = -Out.W;
+    return Out;
+}
+
+CVector3f CAnimation::DequantizeVector(const std::vector<int16>& rkValues, float Multiplier, uint32 StoredKey) const
+{
+    const int16 *pkValues = &rkValues[StoredKey * 3];
+    return CVector3f(pkValues[0], pkValues[1], pkValues[2]) * Multiplier;
+}
+
+CQuaternion CAnimation::RotationKey(uint32 Channel, uint32 Key) const
+{
+    if (!mIsCompressed) return mRotationChannels[Channel][Key];
+
+    const SQuantizedChannel& rkChan = mQuantizedChannels[Channel];
+    uint32 Stored = mKeyToStoredKey[Key];
+    CQuaternion Left = DequantizeRotation(rkChan, Stored);
+    if (mStoredKeys[Stored] == Key) return Left;
+
+    // Dropped key; interpolate between the stored keys on either side
+    uint32 First = mStoredKeys[Stored];
+    uint32 Last = mStoredKeys[Stored + 1];
+    CQuaternion Right = DequantizeRotation(rkChan, Stored + 1);
+    return Left.Slerp(Right, (float) (Key - First) / (float) (Last - First));
+}
+
+CVector3f CAnimation::TranslationKey(uint32 Channel, uint32 Key) const
+{
+    if (!mIsCompressed) return mTranslationChannels[Channel][Key];
+
+    const std::vector<int16>& rkValues = mQuantizedChannels[Channel].Translation;
+    uint32 Stored = mKeyToStoredKey[Key];
+    CVector3f Left = DequantizeVector(rkValues, mTranslationMultiplier, Stored);
+    if (mStoredKeys[Stored] == Key) return Left;
+
+    uint32 First = mStoredKeys[Stored];
+    uint32 Last = mStoredKeys[Stored + 1];
+    CVector3f Right = DequantizeVector(rkValues, mTranslationMultiplier, Stored + 1);
+    return Math::Lerp<CVector3f>(Left, Right, (float) (Key - First) / (float) (Last - First));
+}
+
+CVector3f CAnimation::ScaleKey(uint32 Channel, uint32 Key) const
+{
+    if (!mIsCompressed) return mScaleChannels[Channel][Key];
+
+    const std::vector<int16>& rkValues = mQuantizedChannels[Channel].Scale;
+    uint32 Stored = mKeyToStoredKey[Key];
+    CVector3f Left = DequantizeVector(rkValues, mScaleMultiplier, Stored);
+    if (mStoredKeys[Stored] == Key) return Left;
+
+    uint32 First = mStoredKeys[Stored];
+    uint32 Last = mStoredKeys[Stored + 1];
+    CVector3f Right = DequantizeVector(rkValues, mScaleMultiplier, Stored + 1);
+    return Math::Lerp<CVector3f>(Left, Right, (float) (Key - First) / (float) (Last - First));
+}
@@ -21,10 +21,28 @@ class CAnimation : public CResource
     float mTickInterval;
     uint32 mNumKeys;
 
+    // Uncompressed ANIMs keep a full precision value for every key
     std::vector<TScaleChannel> mScaleChannels;
     std::vector<TRotationChannel> mRotationChannels;
     std::vector<TTranslationChannel> mTranslationChannels;
 
+    // Compressed ANIMs keep the quantized values from the file and only dequantize the keys needed
+    // to evaluate a pose. Keys that were dropped from the file aren't stored; they're interpolated
+    // from the stored keys on either side when they're evaluated.
+    struct SQuantizedChannel
+    {
+        std::vector<int16> Rotation;    // X, Y, Z, W sign for each stored key
+        std::vector<int16> Translation; // X, Y, Z for each stored key
+        std::vector<int16> Scale;       // X, Y, Z for each stored key
+    };
+    std::vector<SQuantizedChannel> mQuantizedChannels;
+    std::vector<uint16> mStoredKeys;        // Key index of each stored key
+    std::vector<uint16> mKeyToStoredKey;    // For each key, the last stored key at or before it
+    float mRotationMultiplier;
+    float mTranslationMultiplier;
+    float mScaleMultiplier;
+    bool mIsCompressed;
+
     struct SBoneChannelInfo
     {
         uint8 ScaleChannelIdx;
@@ -35,16 +53,32 @@ class CAnimation : public CResource
 
     TResPtr<CAnimEventData> mpEventData;
 
+    CQuaternion DequantizeRotation(const SQuantizedChannel& rkChannel, uint32 StoredKey) const;
+    CVector3f DequantizeVector(const std::vector<int16>& rkValues, float Multiplier, uint32 StoredKey) const;
+
 public:
     CAnimation(CResourceEntry *pEntry = 0);
     CDependencyTree* BuildDependencyTree() const;
     void EvaluateTransform(float Time, uint32 BoneID, CVector3f *pOutTranslation, CQuaternion *pOutRotation, CVector3f *pOutScale) const;
+    bool FindKeys(float Time, uint32& rOutLowKey, float& rOutBlend) const;
     bool HasTranslation(uint32 BoneID) const;
 
+    // Key access by channel index; see the channel accessors below
+    CQuaternion RotationKey(uint32 Channel, uint32 Key) const;
+    CVector3f TranslationKey(uint32 Channel, uint32 Key) const;
+    CVector3f ScaleKey(uint32 Channel, uint32 Key) const;
+    uint32 KeyDataSize() const;
+    uint32 ExpandedKeyDataSize() const;
+
     inline float Duration() const               { return mDuration; }
     inline uint32 NumKeys() const               { return mNumKeys; }
     inline float TickInterval() const           { return mTickInterval; }
     inline CAnimEventData* EventData() const    { return mpEventData; }
+
+    // Channel index of each bone, or 0xFF if the bone isn't animated on that channel
+    inline uint8 ScaleChannel(uint32 BoneID) const          { return mBoneInfo[BoneID].ScaleChannelIdx; }
+    inline uint8 RotationChannel(uint32 BoneID) const       { return mBoneInfo[BoneID].RotationChannelIdx; }
+    inline uint8 TranslationChannel(uint32 BoneID) const    { return mBoneInfo[BoneID].TranslationChannelIdx; }
 };
 
 #endif // CANIMATION_H
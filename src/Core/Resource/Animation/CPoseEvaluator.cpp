@@ -0,0 +1,261 @@
+#include "CPoseEvaluator.h"
+#include "CAnimation.h"
+#include "Core/Render/CBoneTransformData.h"
+#include <cmath>
+
+// SSE is part of the x86-64 baseline, so the blend loops can use it without any runtime checks
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define POSE_EVALUATOR_SSE 1
+#include <xmmintrin.h>
+#else
+#define POSE_EVALUATOR_SSE 0
+#endif
+
+void CPoseEvaluator::SChannels::Resize(uint32 Size)
+{
+    X.resize(Size);
+    Y.resize(Size);
+    Z.resize(Size);
+    W.resize(Size);
+}
+
+void CPoseEvaluator::SChannels::Store(uint32 Index, const CVector3f& rkVec)
+{
+    X[Index] = rkVec.X;
+    Y[Index] = rkVec.Y;
+    Z[Index] = rkVec.Z;
+}
+
+void CPoseEvaluator::SChannels::Store(uint32 Index, const CQuaternion& rkQuat)
+{
+    X[Index] = rkQuat.X;
+    Y[Index] = rkQuat.Y;
+    Z[Index] = rkQuat.Z;
+    W[Index] = rkQuat.W;
+}
+
+CPoseEvaluator::CPoseEvaluator()
+    : mNumBones(0)
+    , mPaddedNumBones(0)
+{
+}
+
+void CPoseEvaluator::Resize(uint32 NumBones)
+{
+    mNumBones = NumBones;
+    mPaddedNumBones = (NumBones + 3) & ~3;
+
+    if (mLowTranslation.X.size() < mPaddedNumBones)
+    {
+        mLowTranslation.Resize(mPaddedNumBones);
+        mHighTranslation.Resize(mPaddedNumBones);
+        mLowRotation.Resize(mPaddedNumBones);
+        mHighRotation.Resize(mPaddedNumBones);
+        mLowScale.Resize(mPaddedNumBones);
+        mHighScale.Resize(mPaddedNumBones);
+        mRotationDots.resize(mPaddedNumBones);
+        mLowWeights.resize(mPaddedNumBones);
+        mHighWeights.resize(mPaddedNumBones);
+    }
+
+    mWorldTransforms.resize(NumBones);
+}
+
+float CPoseEvaluator::SampleKeys(const CSkeleton *pkSkel, const CAnimation *pkAnim, float Time)
+{
+    // Find the key pair once for the whole pose
+    uint32 LowKey = 0;
+    float Blend = 0.f;
+    bool Animated = (pkAnim && pkAnim->FindKeys(Time, LowKey, Blend));
+
+    for (uint32 iBone = 0; iBone < mPaddedNumBones; iBone++)
+    {
+        // Bones without a channel keep their bind pose; padding bones are just left at identity
+        const CBone *pkBone = (iBone < mNumBones ? pkSkel->FlatBone(iBone) : nullptr);
+        CVector3f BindTranslation = (pkBone ? pkBone->LocalPosition() : CVector3f::skZero);
+        mLowTranslation.Store(iBone, BindTranslation);
+        mHighTranslation.Store(iBone, BindTranslation);
+        mLowRotation.Store(iBone, CQuaternion::skIdentity);
+        mHighRotation.Store(iBone, CQuaternion::skIdentity);
+        mLowScale.Store(iBone, CVector3f::skOne);
+        mHighScale.Store(iBone, CVector3f::skOne);
+
+        if (!Animated || !pkBone)
+            continue;
+
+        uint32 BoneID = pkBone->ID();
+        uint8 TransChannel = pkAnim->TranslationChannel(BoneID);
+        uint8 RotChannel = pkAnim->RotationChannel(BoneID);
+        uint8 ScaleChannel = pkAnim->ScaleChannel(BoneID);
+
+        if (TransChannel != 0xFF)
+        {
+            mLowTranslation.Store(iBone, pkAnim->TranslationKey(TransChannel, LowKey));
+            mHighTranslation.Store(iBone, pkAnim->TranslationKey(TransChannel, LowKey + 1));
+        }
+
+        if (RotChannel != 0xFF)
+        {
+            mLowRotation.Store(iBone, pkAnim->RotationKey(RotChannel, LowKey));
+            mHighRotation.Store(iBone, pkAnim->RotationKey(RotChannel, LowKey + 1));
+        }
+
+        if (ScaleChannel != 0xFF)
+        {
+            mLowScale.Store(iBone, pkAnim->ScaleKey(ScaleChannel, LowKey));
+            mHighScale.Store(iBone, pkAnim->ScaleKey(ScaleChannel, LowKey + 1));
+        }
+    }
+
+    return Blend;
+}
+
+void CPoseEvaluator::BlendVectors(SChannels& rLow, const SChannels& rkHigh, float Blend)
+{
+    // Lerp every bone; the result is written back into the low channels
+    float *pComponents[3] = { rLow.X.data(), rLow.Y.data(), rLow.Z.data() };
+    const float *pkHighComponents[3] = { rkHigh.X.data(), rkHigh.Y.data(), rkHigh.Z.data() };
+
+    for (uint32 iComp = 0; iComp < 3; iComp++)
+    {
+        float *pLow = pComponents[iComp];
+        const float *pkHigh = pkHighComponents[iComp];
+
+#if POSE_EVALUATOR_SSE
+        __m128 T = _mm_set1_ps(Blend);
+
+        for (uint32 iBone = 0; iBone < mPaddedNumBones; iBone += 4)
+        {
+            __m128 Low = _mm_loadu_ps(pLow + iBone);
+            __m128 High = _mm_loadu_ps(pkHigh + iBone);
+            _mm_storeu_ps(pLow + iBone, _mm_add_ps(Low, _mm_mul_ps(_mm_sub_ps(High, Low), T)));
+        }
+#else
+        for (uint32 iBone = 0; iBone < mPaddedNumBones; iBone++)
+            pLow[iBone] += (pkHigh[iBone] - pLow[iBone]) * Blend;
+#endif
+    }
+}
+
+void CPoseEvaluator::BlendRotations(float Blend)
+{
+    SChannels& rLow = mLowRotation;
+    const SChannels& rkHigh = mHighRotation;
+
+    // Dot product of each key pair
+#if POSE_EVALUATOR_SSE
+    for (uint32 iBone = 0; iBone < mPaddedNumBones; iBone += 4)
+    {
+        __m128 Dot = _mm_mul_ps(_mm_loadu_ps(&rLow.X[iBone]), _mm_loadu_ps(&rkHigh.X[iBone]));
+        Dot = _mm_add_ps(Dot, _mm_mul_ps(_mm_loadu_ps(&rLow.Y[iBone]), _mm_loadu_ps(&rkHigh.Y[iBone])));
+        Dot = _mm_add_ps(Dot, _mm_mul_ps(_mm_loadu_ps(&rLow.Z[iBone]), _mm_loadu_ps(&rkHigh.Z[iBone])));
+        Dot = _mm_add_ps(Dot, _mm_mul_ps(_mm_loadu_ps(&rLow.W[iBone]), _mm_loadu_ps(&rkHigh.W[iBone])));
+        _mm_storeu_ps(&mRotationDots[iBone], Dot);
+    }
+#else
+    for (uint32 iBone = 0; iBone < mPaddedNumBones; iBone++)
+    {
+        mRotationDots[iBone] = (rLow.X[iBone] * rkHigh.X[iBone]) + (rLow.Y[iBone] * rkHigh.Y[iBone]) +
+                               (rLow.Z[iBone] * rkHigh.Z[iBone]) + (rLow.W[iBone] * rkHigh.W[iBone]);
+    }
+#endif
+
+    // Slerp weights. These need trig functions per bone, so they're calculated one bone at a time.
+    for (uint32 iBone = 0; iBone < mPaddedNumBones; iBone++)
+    {
+        float CosHalfTheta = mRotationDots[iBone];
+
+        if (fabsf(CosHalfTheta) >= 1.f)
+        {
+            mLowWeights[iBone] = 1.f;
+            mHighWeights[iBone] = 0.f;
+            continue;
+        }
+
+        float SinHalfTheta = sqrtf(1.f - (CosHalfTheta * CosHalfTheta));
+
+        // Nearly identical rotations; a plain lerp is accurate and avoids dividing by ~0
+        if (SinHalfTheta < 0.001f)
+        {
+            mLowWeights[iBone] = 1.f - Blend;
+            mHighWeights[iBone] = Blend;
+        }
+        else
+        {
+            float HalfTheta = acosf(CosHalfTheta);
+            mLowWeights[iBone] = sinf((1.f - Blend) * HalfTheta) / SinHalfTheta;
+            mHighWeights[iBone] = sinf(Blend * HalfTheta) / SinHalfTheta;
+        }
+    }
+
+    // Blend every bone with its weights
+    float *pComponents[4] = { rLow.X.data(), rLow.Y.data(), rLow.Z.data(), rLow.W.data() };
+    const float *pkHighComponents[4] = { rkHigh.X.data(), rkHigh.Y.data(), rkHigh.Z.data(), rkHigh.W.data() };
+
+    for (uint32 iComp = 0; iComp < 4; iComp++)
+    {
+        float *pLow = pComponents[iComp];
+        const float *pkHigh = pkHighComponents[iComp];
+
+#if POSE_EVALUATOR_SSE
+        for (uint32 iBone = 0; iBone < mPaddedNumBones; iBone += 4)
+        {
+            __m128 Low = _mm_mul_ps(_mm_loadu_ps(pLow + iBone), _mm_loadu_ps(&mLowWeights[iBone]));
+            __m128 High = _mm_mul_ps(_mm_loadu_ps(pkHigh + iBone), _mm_loadu_ps(&mHighWeights[iBone]));
+            _mm_storeu_ps(pLow + iBone, _mm_add_ps(Low, High));
+        }
+#else
+        for (uint32 iBone = 0; iBone < mPaddedNumBones; iBone++)
+            pLow[iBone] = (pLow[iBone] * mLowWeights[iBone]) + (pkHigh[iBone] * mHighWeights[iBone]);
+#endif
+    }
+}
+
+void CPoseEvaluator::ApplyHierarchy(const CSkeleton *pkSkel, bool AnchorRoot, CBoneTransformData& rOut)
+{
+    // Parents always come before their children in the flat order, so their transforms are ready by the time we need them
+    const SBoneTransformInfo kRootParent;
+
+    for (uint32 iBone = 0; iBone < mNumBones; iBone++)
+    {
+        const CBone *pkBone = pkSkel->FlatBone(iBone);
+        int32 ParentIdx = pkSkel->FlatParentIndex(iBone);
+        const SBoneTransformInfo& rkParent = (ParentIdx >= 0 ? mWorldTransforms[ParentIdx] : kRootParent);
+
+        CVector3f Position(mLowTranslation.X[iBone], mLowTranslation.Y[iBone], mLowTranslation.Z[iBone]);
+        CQuaternion Rotation;
+        Rotation.X = mLowRotation.X[iBone];
+        Rotation.Y = mLowRotation.Y[iBone];
+        Rotation.Z = mLowRotation.Z[iBone];
+        Rotation.W = mLowRotation.W[iBone];
+
+        if (AnchorRoot && pkBone->IsRoot())
+            Position = CVector3f::skZero;
+
+        // Apply parent transform
+        SBoneTransformInfo& rInfo = mWorldTransforms[iBone];
+        rInfo.Position = rkParent.Position + (rkParent.Rotation * (rkParent.Scale * Position));
+        rInfo.Rotation = rkParent.Rotation * Rotation;
+        rInfo.Scale = CVector3f(mLowScale.X[iBone], mLowScale.Y[iBone], mLowScale.Z[iBone]);
+
+        // Calculate transform
+        CTransform4f& rTransform = rOut[pkBone->ID()];
+        rTransform.SetIdentity();
+        rTransform.Scale(rInfo.Scale);
+        rTransform.Rotate(rInfo.Rotation);
+        rTransform.Translate(rInfo.Position);
+        rTransform *= pkBone->InverseBindMatrix();
+    }
+}
+
+void CPoseEvaluator::Evaluate(const CSkeleton *pkSkel, const CAnimation *pkAnim, float Time, bool AnchorRoot, CBoneTransformData& rOut)
+{
+    Resize(pkSkel->NumFlatBones());
+    float Blend = SampleKeys(pkSkel, pkAnim, Time);
+
+    // Every bone blends between its keys by the same factor
+    BlendVectors(mLowTranslation, mHighTranslation, Blend);
+    BlendRotations(Blend);
+    BlendVectors(mLowScale, mHighScale, Blend);
+    ApplyHierarchy(pkSkel, AnchorRoot, rOut);
+}
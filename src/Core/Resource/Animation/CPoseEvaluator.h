@@ -0,0 +1,51 @@
+#ifndef CPOSEEVALUATOR_H
+#define CPOSEEVALUATOR_H
+
+#include "CSkeleton.h"
+#include <Common/BasicTypes.h>
+#include <vector>
+
+class CAnimation;
+class CBoneTransformData;
+
+/**
+ * Evaluates an animation for every bone of a skeleton at once. The key pair and blend factor
+ * are looked up once per pose instead of once per bone, bone channels are kept as structure-of-arrays
+ * so the whole pose can be blended with SIMD, and the hierarchy is applied with a flat loop over
+ * the skeleton's parent indices instead of recursing through the bones.
+ *
+ * Produces the same transforms as CBone::UpdateTransform. The evaluator only holds scratch buffers,
+ * so a single evaluator can be reused for any number of skeletons.
+ */
+class CPoseEvaluator
+{
+    // One array per component; sized to a multiple of 4 bones so the SIMD loops don't need a scalar tail
+    struct SChannels
+    {
+        std::vector<float> X, Y, Z, W;
+        void Resize(uint32 Size);
+        void Store(uint32 Index, const CVector3f& rkVec);
+        void Store(uint32 Index, const CQuaternion& rkQuat);
+    };
+
+    uint32 mNumBones;
+    uint32 mPaddedNumBones;
+    SChannels mLowTranslation, mHighTranslation;
+    SChannels mLowRotation, mHighRotation;
+    SChannels mLowScale, mHighScale;
+    std::vector<float> mRotationDots;
+    std::vector<float> mLowWeights, mHighWeights;
+    std::vector<SBoneTransformInfo> mWorldTransforms;
+
+    void Resize(uint32 NumBones);
+    float SampleKeys(const CSkeleton *pkSkel, const CAnimation *pkAnim, float Time);
+    void BlendVectors(SChannels& rLow, const SChannels& rkHigh, float Blend);
+    void BlendRotations(float Blend);
+    void ApplyHierarchy(const CSkeleton *pkSkel, bool AnchorRoot, CBoneTransformData& rOut);
+
+public:
+    CPoseEvaluator();
+    void Evaluate(const CSkeleton *pkSkel, const CAnimation *pkAnim, float Time, bool AnchorRoot, CBoneTransformData& rOut);
+};
+
+#endif // CPOSEEVALUATOR_H
@@ -1,4 +1,5 @@
 #include "CSkeleton.h"
+#include "CPoseEvaluator.h"
 #include "Core/Render/CBoneTransformData.h"
 #include "Core/Render/CDrawUtil.h"
 #include "Core/Render/CGraphics.h"
@@ -109,9 +110,44 @@ uint32 CSkeleton::MaxBoneID() const
     return ID;
 }
 
+void CSkeleton::BuildFlatHierarchy()
+{
+    mFlatBones.clear();
+    mFlatParentIndices.clear();
+    if (!mpRootBone) return;
+
+    std::vector<std::pair<CBone*, int32>> Stack;
+    Stack.emplace_back(mpRootBone, -1);
+
+    while (!Stack.empty())
+    {
+        CBone *pBone = Stack.back().first;
+        int32 ParentIdx = Stack.back().second;
+        Stack.pop_back();
+
+        int32 BoneIdx = mFlatBones.size();
+        mFlatBones.push_back(pBone);
+        mFlatParentIndices.push_back(ParentIdx);
+
+        // Push in reverse so children come out in the same order CBone::UpdateTransform visits them
+        for (uint32 iChild = pBone->NumChildren(); iChild-- > 0;)
+            Stack.emplace_back(pBone->ChildByIndex(iChild), BoneIdx);
+    }
+}
+
 void CSkeleton::UpdateTransform(CBoneTransformData& rData, CAnimation *pAnim, float Time, bool AnchorRoot)
 {
     ASSERT(rData.NumTrackedBones() >= MaxBoneID());
+
+    // The evaluator only holds scratch buffers, so each thread can share one between every skeleton
+    static thread_local CPoseEvaluator Evaluator;
+    Evaluator.Evaluate(this, pAnim, Time, AnchorRoot, rData);
+}
+
+void CSkeleton::UpdateTransformPerBone(CBoneTransformData& rData, CAnimation *pAnim, float Time, bool AnchorRoot)
+{
+    // Evaluates the animation one bone at a time; kept for comparison against the pose evaluator
+    ASSERT(rData.NumTrackedBones() >= MaxBoneID());
     mpRootBone->UpdateTransform(rData, SBoneTransformInfo(), pAnim, Time, AnchorRoot);
 }
 
@@ -30,12 +30,20 @@ class CSkeleton : public CResource
     CBone *mpRootBone;
     std::vector<CBone*> mBones;
 
+    // Bones reachable from the root in depth-first order, so every bone comes after its parent,
+    // and the index of each bone's parent in that order (-1 for the root). Used for pose evaluation.
+    std::vector<CBone*> mFlatBones;
+    std::vector<int32> mFlatParentIndices;
+
     static const float skSphereRadius;
 
+    void BuildFlatHierarchy();
+
 public:
     CSkeleton(CResourceEntry *pEntry = 0);
     ~CSkeleton();
     void UpdateTransform(CBoneTransformData& rData, CAnimation *pAnim, float Time, bool AnchorRoot);
+    void UpdateTransformPerBone(CBoneTransformData& rData, CAnimation *pAnim, float Time, bool AnchorRoot);
     CBone* BoneByID(uint32 BoneID) const;
     CBone* BoneByName(const TString& rkBoneName) const;
     uint32 MaxBoneID() const;
@@ -43,8 +51,11 @@ public:
     void Draw(FRenderOptions Options, const CBoneTransformData *pkData);
     std::pair<int32,float> RayIntersect(const CRay& rkRay, const CBoneTransformData& rkData);
 
-    inline uint32 NumBones() const  { return mBones.size(); }
-    inline CBone* RootBone() const  { return mpRootBone; }
+    inline uint32 NumBones() const                          { return mBones.size(); }
+    inline CBone* RootBone() const                          { return mpRootBone; }
+    inline uint32 NumFlatBones() const                      { return mFlatBones.size(); }
+    inline CBone* FlatBone(uint32 Index) const              { return mFlatBones[Index]; }
+    inline int32 FlatParentIndex(uint32 Index) const        { return mFlatParentIndices[Index]; }
 };
 
 class CBone
@@ -80,6 +91,7 @@ public:
     inline CVector3f LocalPosition() const              { return mLocalPosition; }
     inline CQuaternion Rotation() const                 { return mRotation; }
     inline CQuaternion LocalRotation() const            { return mLocalRotation; }
+    inline const CTransform4f& InverseBindMatrix() const { return mInvBind; }
     inline TString Name() const                         { return mName; }
     inline bool IsSelected() const                      { return mSelected; }
 
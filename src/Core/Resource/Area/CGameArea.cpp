@@ -1,6 +1,9 @@
 #include "CGameArea.h"
 #include "Core/Resource/Script/CScriptLayer.h"
 #include "Core/Render/CRenderer.h"
+#include "Core/Resource/Factory/CAreaLoader.h"
+#include <Common/FileIO.h>
+#include <Common/Log.h>
 
 CGameArea::CGameArea(CResourceEntry *pEntry /*= 0*/)
     : CResource(pEntry)
@@ -62,6 +65,19 @@ CDependencyTree* CGameArea::BuildDependencyTree() const
     return pTree;
 }
 
+void CGameArea::OnBackgroundLoadAttached()
+{
+    // Script objects created on a worker thread skip registering with their templates; do that now
+    for (CScriptLayer *pLayer : mScriptLayers)
+    {
+        for (uint32 InstIdx = 0; InstIdx < pLayer->NumInstances(); InstIdx++)
+        {
+            CScriptObject *pInst = pLayer->InstanceByIndex(InstIdx);
+            pInst->Template()->AddObject(pInst);
+        }
+    }
+}
+
 void CGameArea::AddWorldModel(CModel *pModel)
 {
     mWorldModels.push_back(pModel);
@@ -259,3 +275,57 @@ void CGameArea::ClearExtraDependencies()
         Entry()->UpdateDependencies();
     }
 }
+
+bool CGameArea::LoadSectionData()
+{
+    if (mSectionDataBuffers.size() == mSectionSizes.size())
+        return true;
+
+    // Read the sections back from the cooked file this area was loaded from
+    ASSERT(Entry() != nullptr);
+    CFileInStream MREA(Entry()->CookedAssetPath(), EEndian::BigEndian);
+
+    if (!MREA.IsValid())
+    {
+        errorf("Failed to open cooked area to read section data: %s", *Entry()->CookedAssetPath(true));
+        return false;
+    }
+
+    std::vector<std::vector<uint8>> Sections;
+
+    if (!CAreaLoader::LoadSectionData(MREA, Sections) || Sections.size() != mSectionSizes.size())
+    {
+        errorf("%s: Failed to read area section data", *Entry()->CookedAssetPath(true));
+        return false;
+    }
+
+    mSectionDataBuffers = std::move(Sections);
+    return true;
+}
+
+void CGameArea::ReleaseSectionData()
+{
+    // Areas without an entry have nowhere to reload their section data from, so they keep it
+    if (Entry())
+        std::vector<std::vector<uint8>>().swap(mSectionDataBuffers);
+}
+
+uint32 CGameArea::TotalSectionBytes() const
+{
+    uint32 Total = 0;
+
+    for (uint32 SecIdx = 0; SecIdx < mSectionSizes.size(); SecIdx++)
+        Total += mSectionSizes[SecIdx];
+
+    return Total;
+}
+
+uint32 CGameArea::RetainedSectionBytes() const
+{
+    uint32 Total = 0;
+
+    for (uint32 SecIdx = 0; SecIdx < mSectionDataBuffers.size(); SecIdx++)
+        Total += mSectionDataBuffers[SecIdx].capacity();
+
+    return Total;
+}
@@ -31,7 +31,10 @@ class CGameArea : public CResource
     CTransform4f mTransform;
     CAABox mAABox;
 
-    // Data saved from the original file to help on recook
+    // Data saved from the original file to help on recook. Section data isn't kept in memory once the
+    // area is loaded; only the section sizes are. The cooker calls LoadSectionData() to read the sections
+    // back from the cooked file for as long as it needs them.
+    std::vector<uint32> mSectionSizes;
     std::vector<std::vector<uint8>> mSectionDataBuffers;
     uint32 mOriginalWorldMeshCount;
     bool mUsesCompression;
@@ -68,6 +71,7 @@ public:
     CGameArea(CResourceEntry *pEntry = 0);
     ~CGameArea();
     CDependencyTree* BuildDependencyTree() const;
+    void OnBackgroundLoadAttached();
 
     void AddWorldModel(CModel *pModel);
     void MergeTerrain();
@@ -84,9 +88,14 @@ public:
     void AddInstanceToArea(CScriptObject *pInstance);
     void DeleteInstance(CScriptObject *pInstance);
     void ClearExtraDependencies();
+    bool LoadSectionData();
+    void ReleaseSectionData();
+    uint32 TotalSectionBytes() const;
+    uint32 RetainedSectionBytes() const;
 
     // Inline Accessors
     inline uint32 WorldIndex() const                                    { return mWorldIndex; }
+    inline uint32 NumSections() const                                   { return mSectionSizes.size(); }
     inline CTransform4f Transform() const                               { return mTransform; }
     inline CMaterialSet* Materials() const                              { return mpMaterialSet; }
     inline uint32 NumWorldModels() const                                { return mWorldModels.size(); }
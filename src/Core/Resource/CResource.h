@@ -10,6 +10,7 @@
 #include <Common/CFourCC.h>
 #include <Common/TString.h>
 #include <Common/Serialization/IArchive.h>
+#include <atomic>
 
 // This macro creates functions that allow us to easily identify this resource type.
 // Must be included on every CResource subclass.
@@ -32,7 +33,7 @@ class CResource
     DECLARE_RESOURCE_TYPE(Resource)
 
     CResourceEntry *mpEntry;
-    int mRefCount;
+    std::atomic<int> mRefCount; // Resources that are shared between stores (e.g. editor assets) are referenced from worker threads
 
 public:
     CResource(CResourceEntry *pEntry = 0)
@@ -44,6 +45,7 @@ public:
     virtual CDependencyTree* BuildDependencyTree() const    { return new CDependencyTree(); }
     virtual void Serialize(IArchive& /*rArc*/)              {}
     virtual void InitializeNewResource()                    {}
+    virtual void OnBackgroundLoadAttached()                 {} // Called on the main thread when a resource loaded on a worker thread is attached to its entry
     
     inline CResourceEntry* Entry() const    { return mpEntry; }
     inline CResTypeInfo* TypeInfo() const   { return mpEntry->TypeInfo(); }
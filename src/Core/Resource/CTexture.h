@@ -47,6 +47,8 @@ public:
     uint32 Height() const                   { return (uint32) mHeight; }
     uint32 NumMipMaps() const               { return mNumMipMaps; }
     GLuint TextureID() const                { return mTextureID; }
+    const uint8* ImageData() const          { return mpImgDataBuffer; }
+    uint32 ImageDataSize() const            { return mImgDataSize; }
 
     inline void SetMultisamplingEnabled(bool Enable)
     {
@@ -1,6 +1,8 @@
 #include "CAreaCooker.h"
 #include "CScriptCooker.h"
 #include "Core/CompressionUtil.h"
+#include "Core/CWorkerPool.h"
+#include "Core/GameProject/CGameProject.h"
 #include "Core/GameProject/DependencyListBuilders.h"
 #include <Common/Log.h>
 
@@ -21,6 +23,11 @@ CAreaCooker::CAreaCooker()
     , mEGMCSecNum(-1)
     , mDepsSecNum(-1)
     , mModulesSecNum(-1)
+    , mCompressionLevel(ECompressionLevel::Max)
+{
+}
+
+CAreaCooker::~CAreaCooker()
 {
 }
 
@@ -99,7 +106,7 @@ void CAreaCooker::WritePrimeHeader(IOutputStream& rOut)
     mpArea->mTransform.Write(rOut);
     rOut.WriteLong(mpArea->mOriginalWorldMeshCount);
     if (mVersion >= EGame::Echoes) rOut.WriteLong(mpArea->mScriptLayers.size());
-    rOut.WriteLong(mpArea->mSectionDataBuffers.size());
+    rOut.WriteLong(mpArea->mSectionSizes.size());
 
     rOut.WriteLong(mGeometrySecNum);
     rOut.WriteLong(mSCLYSecNum);
@@ -139,7 +146,7 @@ void CAreaCooker::WriteCorruptionHeader(IOutputStream& rOut)
     mpArea->mTransform.Write(rOut);
     rOut.WriteLong(mpArea->mOriginalWorldMeshCount);
     rOut.WriteLong(mpArea->mScriptLayers.size());
-    rOut.WriteLong(mpArea->mSectionDataBuffers.size());
+    rOut.WriteLong(mpArea->mSectionSizes.size());
     rOut.WriteLong(mCompressedBlocks.size());
     rOut.WriteLong(mpArea->mSectionNumbers.size());
     rOut.WriteToBoundary(32, 0);
@@ -358,7 +365,11 @@ void CAreaCooker::FinishBlock()
 
     if (EnableCompression)
     {
-        bool Success = CompressionUtil::CompressSegmentedData((uint8*) mCompressedData.Data(), mCompressedData.Size(), CompressedBuf.data(), CompressedSize, UseZlib, true);
+        if (!mpCompressionPool)
+            mpCompressionPool = std::make_unique<CWorkerPool>();
+
+        bool Success = CompressionUtil::CompressSegmentedData((uint8*) mCompressedData.Data(), mCompressedData.Size(), CompressedBuf.data(), CompressedSize, UseZlib, true,
+                                                              mCompressionLevel, mpCompressionPool.get());
         uint32 PadBytes = (32 - (CompressedSize % 32)) & 0x1F;
         WriteCompressedData = Success && (CompressedSize + PadBytes < (uint32) mCompressedData.Size());
     }
@@ -389,10 +400,23 @@ void CAreaCooker::FinishBlock()
 
 // ************ STATIC ************
 bool CAreaCooker::CookMREA(CGameArea *pArea, IOutputStream& rOut)
+{
+    // Use the project's cook compression level if the area belongs to one
+    CGameProject *pProj = (pArea->Entry() ? pArea->Entry()->Project() : nullptr);
+    ECompressionLevel Level = (pProj ? pProj->CookCompressionLevel() : ECompressionLevel::Max);
+    return CookMREA(pArea, rOut, Level);
+}
+
+bool CAreaCooker::CookMREA(CGameArea *pArea, IOutputStream& rOut, ECompressionLevel Level)
 {
     CAreaCooker Cooker;
     Cooker.mpArea = pArea;
     Cooker.mVersion = pArea->Game();
+    Cooker.mCompressionLevel = Level;
+
+    // Section data isn't kept in memory after the area is loaded, so read it back in while we're cooking
+    if (!pArea->LoadSectionData())
+        return false;
 
     if (Cooker.mVersion <= EGame::Echoes)
         Cooker.DetermineSectionNumbersPrime();
@@ -420,7 +444,7 @@ bool CAreaCooker::CookMREA(CGameArea *pArea, IOutputStream& rOut)
 
     // Write post-SCLY data sections
     uint32 PostSCLY = (Cooker.mVersion <= EGame::Prime ? Cooker.mSCLYSecNum + 1 : Cooker.mSCGNSecNum + 1);
-    for (uint32 iSec = PostSCLY; iSec < pArea->mSectionDataBuffers.size(); iSec++)
+    for (uint32 iSec = PostSCLY; iSec < pArea->mSectionSizes.size(); iSec++)
     {
         if (iSec == Cooker.mModulesSecNum)
             Cooker.WriteModules(Cooker.mSectionData);
@@ -432,6 +456,7 @@ bool CAreaCooker::CookMREA(CGameArea *pArea, IOutputStream& rOut)
         }
     }
 
+    pArea->ReleaseSectionData();
     Cooker.FinishBlock();
 
     // Write to actual file
@@ -2,9 +2,13 @@
 #define CAREACOOKER_H
 
 #include "CSectionMgrOut.h"
+#include "Core/CompressionUtil.h"
 #include "Core/Resource/Area/CGameArea.h"
 #include <Common/EGame.h>
 #include <Common/FileIO.h>
+#include <memory>
+
+class CWorkerPool;
 
 class CAreaCooker
 {
@@ -45,7 +49,12 @@ class CAreaCooker
 
     std::vector<SCompressedBlock> mCompressedBlocks;
 
+    // Created on the first compressed block; compresses the segments of each block in parallel
+    std::unique_ptr<CWorkerPool> mpCompressionPool;
+    ECompressionLevel mCompressionLevel;
+
     CAreaCooker();
+    ~CAreaCooker();
     void DetermineSectionNumbersPrime();
     void DetermineSectionNumbersCorruption();
 
@@ -70,6 +79,7 @@ class CAreaCooker
 
 public:
     static bool CookMREA(CGameArea *pArea, IOutputStream& rOut);
+    static bool CookMREA(CGameArea *pArea, IOutputStream& rOut, ECompressionLevel Level);
     static uint32 GetMREAVersion(EGame Version);
 };
 
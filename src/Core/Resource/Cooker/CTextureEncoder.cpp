@@ -1,14 +1,470 @@
 #include "CTextureEncoder.h"
+#include "Core/CWorkerPool.h"
 #include <Common/Log.h>
+#include <Common/Math/MathUtil.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <memory>
 
+// Block dimensions in pixels for each GX texture format
+static const uint32 gskBlockWidth[] = {
+    8, 8, 8, 4, 8, 8, 4, 4, 4, 4, 8
+};
+
+static const uint32 gskBlockHeight[] = {
+    8, 4, 4, 4, 8, 4, 4, 4, 4, 4, 8
+};
+
+// CMPR mips with fewer blocks than this are compressed on the calling thread
+static const uint32 gskMinParallelCMPRBlocks = 64;
+
+// ************ PIXEL UTILITY ************
+static inline uint32 ChannelA(uint32 Pixel)     { return (Pixel >> 24) & 0xFF; }
+static inline uint32 ChannelR(uint32 Pixel)     { return (Pixel >> 16) & 0xFF; }
+static inline uint32 ChannelG(uint32 Pixel)     { return (Pixel >>  8) & 0xFF; }
+static inline uint32 ChannelB(uint32 Pixel)     { return (Pixel >>  0) & 0xFF; }
+
+static inline uint32 MakeARGB(uint32 A, uint32 R, uint32 G, uint32 B)
+{
+    return (A << 24) | (R << 16) | (G << 8) | B;
+}
+
+static inline uint32 QuantizeChannel(uint32 Value, uint32 MaxValue)
+{
+    return (Value * MaxValue + 127) / 255;
+}
+
+static inline uint32 Expand5(uint32 In) { return (In << 3) | (In >> 2); }
+static inline uint32 Expand6(uint32 In) { return (In << 2) | (In >> 4); }
+static inline uint32 Expand4(uint32 In) { return (In << 4) | In; }
+static inline uint32 Expand3(uint32 In) { return (In << 5) | (In << 2) | (In >> 1); }
+
+static inline uint16 EncodeRGB565(uint32 R, uint32 G, uint32 B)
+{
+    return (uint16) ((QuantizeChannel(R, 31) << 11) | (QuantizeChannel(G, 63) << 5) | QuantizeChannel(B, 31));
+}
+
+static inline uint32 DecodeRGB565(uint16 Color)
+{
+    return MakeARGB(0xFF, Expand5((Color >> 11) & 0x1F), Expand6((Color >> 5) & 0x3F), Expand5(Color & 0x1F));
+}
+
+static inline uint16 EncodeRGB5A3(uint32 Pixel)
+{
+    // Fully opaque pixels get 5 bits per color channel; anything else needs the 4-bit color + 3-bit alpha mode
+    uint32 A = ChannelA(Pixel);
+
+    if (QuantizeChannel(A, 7) == 7)
+    {
+        return (uint16) (0x8000 | (QuantizeChannel(ChannelR(Pixel), 31) << 10) |
+                                  (QuantizeChannel(ChannelG(Pixel), 31) << 5) |
+                                  (QuantizeChannel(ChannelB(Pixel), 31)));
+    }
+    else
+    {
+        return (uint16) ((QuantizeChannel(A, 7) << 12) |
+                         (QuantizeChannel(ChannelR(Pixel), 15) << 8) |
+                         (QuantizeChannel(ChannelG(Pixel), 15) << 4) |
+                         (QuantizeChannel(ChannelB(Pixel), 15)));
+    }
+}
+
+static inline uint32 DecodeRGB5A3(uint16 Color)
+{
+    if (Color & 0x8000)
+        return MakeARGB(0xFF, Expand5((Color >> 10) & 0x1F), Expand5((Color >> 5) & 0x1F), Expand5(Color & 0x1F));
+    else
+        return MakeARGB(Expand3((Color >> 12) & 0x7), Expand4((Color >> 8) & 0xF), Expand4((Color >> 4) & 0xF), Expand4(Color & 0xF));
+}
+
+static inline uint32 PixelLuminance(uint32 Pixel)
+{
+    // Rec. 601 weights in 8-bit fixed point
+    return (ChannelR(Pixel) * 77 + ChannelG(Pixel) * 150 + ChannelB(Pixel) * 29 + 128) >> 8;
+}
+
+static inline uint32 ColorDistance(uint32 A, uint32 B)
+{
+    int DA = (int) ChannelA(A) - (int) ChannelA(B);
+    int DR = (int) ChannelR(A) - (int) ChannelR(B);
+    int DG = (int) ChannelG(A) - (int) ChannelG(B);
+    int DB = (int) ChannelB(A) - (int) ChannelB(B);
+    return (uint32) (DA*DA + DR*DR + DG*DG + DB*DB);
+}
+
+static inline void WriteBE16(uint8 *pDst, uint16 Value)
+{
+    pDst[0] = (uint8) (Value >> 8);
+    pDst[1] = (uint8) (Value & 0xFF);
+}
+
+// Fetch a pixel, clamping to the edge of the image so partial blocks are padded with edge pixels
+static inline uint32 FetchPixel(const std::vector<uint32>& rkPixels, uint32 Width, uint32 Height, uint32 X, uint32 Y)
+{
+    return rkPixels[ (Math::Min(Y, Height - 1) * Width) + Math::Min(X, Width - 1) ];
+}
+
+// ************ CMPR ************
+// Decoded 565 palette for one CMPR sub-block; interpolation matches CTextureDecoder
+static void BuildCMPRPalette(uint16 Color0, uint16 Color1, uint32 Palette[4])
+{
+    Palette[0] = DecodeRGB565(Color0);
+    Palette[1] = DecodeRGB565(Color1);
+
+    if (Color0 > Color1)
+    {
+        Palette[2] = MakeARGB(0xFF, (ChannelR(Palette[0]) * 2 + ChannelR(Palette[1])) / 3,
+                                    (ChannelG(Palette[0]) * 2 + ChannelG(Palette[1])) / 3,
+                                    (ChannelB(Palette[0]) * 2 + ChannelB(Palette[1])) / 3);
+        Palette[3] = MakeARGB(0xFF, (ChannelR(Palette[0]) + ChannelR(Palette[1]) * 2) / 3,
+                                    (ChannelG(Palette[0]) + ChannelG(Palette[1]) * 2) / 3,
+                                    (ChannelB(Palette[0]) + ChannelB(Palette[1]) * 2) / 3);
+    }
+    else
+    {
+        Palette[2] = MakeARGB(0xFF, (ChannelR(Palette[0]) + ChannelR(Palette[1])) / 2,
+                                    (ChannelG(Palette[0]) + ChannelG(Palette[1])) / 2,
+                                    (ChannelB(Palette[0]) + ChannelB(Palette[1])) / 2);
+        Palette[3] = 0;
+    }
+}
+
+// Assigns each pixel to its closest palette entry and returns the total squared error
+static uint32 AssignCMPRIndices(const uint32 Pixels[16], uint16 Color0, uint16 Color1, uint8 Indices[16])
+{
+    uint32 Palette[4];
+    BuildCMPRPalette(Color0, Color1, Palette);
+
+    bool ThreeColor = (Color0 <= Color1);
+    uint32 NumColors = (ThreeColor ? 3 : 4);
+    uint32 TotalError = 0;
+
+    for (uint32 iPix = 0; iPix < 16; iPix++)
+    {
+        if (ChannelA(Pixels[iPix]) < 128)
+        {
+            // Only the three color mode has a transparent index; the caller never picks four color mode for these
+            Indices[iPix] = 3;
+            continue;
+        }
+
+        uint32 Opaque = Pixels[iPix] | 0xFF000000;
+        uint32 BestError = UINT32_MAX;
+
+        for (uint32 iCol = 0; iCol < NumColors; iCol++)
+        {
+            uint32 Error = ColorDistance(Opaque, Palette[iCol]);
+
+            if (Error < BestError)
+            {
+                BestError = Error;
+                Indices[iPix] = (uint8) iCol;
+            }
+        }
+
+        TotalError += BestError;
+    }
+
+    return TotalError;
+}
+
+// Least squares fit of both endpoints to the current index assignment. Returns false if the system is degenerate.
+static bool RefineCMPREndpoints(const uint32 Pixels[16], const uint8 Indices[16], bool ThreeColor, float Endpoints[2][3])
+{
+    static const float skWeights4[4] = { 1.f, 0.f, 2.f / 3.f, 1.f / 3.f };
+    static const float skWeights3[4] = { 1.f, 0.f, 0.5f, 0.f };
+    const float *pkWeights = (ThreeColor ? skWeights3 : skWeights4);
+
+    float AA = 0.f, AB = 0.f, BB = 0.f;
+    float AX[3] = { 0.f, 0.f, 0.f }, BX[3] = { 0.f, 0.f, 0.f };
+
+    for (uint32 iPix = 0; iPix < 16; iPix++)
+    {
+        if (ChannelA(Pixels[iPix]) < 128) continue;
+
+        float A = pkWeights[Indices[iPix]];
+        float B = 1.f - A;
+        float Channels[3] = { (float) ChannelR(Pixels[iPix]), (float) ChannelG(Pixels[iPix]), (float) ChannelB(Pixels[iPix]) };
+
+        AA += A * A;
+        AB += A * B;
+        BB += B * B;
+
+        for (uint32 iChan = 0; iChan < 3; iChan++)
+        {
+            AX[iChan] += A * Channels[iChan];
+            BX[iChan] += B * Channels[iChan];
+        }
+    }
+
+    float Det = (AA * BB) - (AB * AB);
+    if (fabsf(Det) < 1e-6f) return false;
+
+    float InvDet = 1.f / Det;
+
+    for (uint32 iChan = 0; iChan < 3; iChan++)
+    {
+        Endpoints[0][iChan] = Math::Clamp(0.f, 255.f, ((AX[iChan] * BB) - (BX[iChan] * AB)) * InvDet);
+        Endpoints[1][iChan] = Math::Clamp(0.f, 255.f, ((BX[iChan] * AA) - (AX[iChan] * AB)) * InvDet);
+    }
+
+    return true;
+}
+
+static inline uint16 EndpointTo565(const float Endpoint[3])
+{
+    return EncodeRGB565((uint32) (Endpoint[0] + 0.5f), (uint32) (Endpoint[1] + 0.5f), (uint32) (Endpoint[2] + 0.5f));
+}
+
+// Picks endpoints for one 4x4 sub-block
+static void FindCMPREndpoints(const uint32 Pixels[16], ETextureEncodeQuality Quality, float Endpoints[2][3])
+{
+    float Colors[16][3];
+    uint32 NumColors = 0;
+
+    for (uint32 iPix = 0; iPix < 16; iPix++)
+    {
+        if (ChannelA(Pixels[iPix]) < 128) continue;
+        Colors[NumColors][0] = (float) ChannelR(Pixels[iPix]);
+        Colors[NumColors][1] = (float) ChannelG(Pixels[iPix]);
+        Colors[NumColors][2] = (float) ChannelB(Pixels[iPix]);
+        NumColors++;
+    }
+
+    if (NumColors == 0)
+    {
+        for (uint32 iChan = 0; iChan < 3; iChan++)
+            Endpoints[0][iChan] = Endpoints[1][iChan] = 0.f;
+        return;
+    }
+
+    if (Quality == ETextureEncodeQuality::Fast)
+    {
+        // Bounding box diagonal, inset slightly to reduce the error of the extremes
+        for (uint32 iChan = 0; iChan < 3; iChan++)
+        {
+            float Min = 255.f, Max = 0.f;
+
+            for (uint32 iCol = 0; iCol < NumColors; iCol++)
+            {
+                Min = Math::Min(Min, Colors[iCol][iChan]);
+                Max = Math::Max(Max, Colors[iCol][iChan]);
+            }
+
+            float Inset = (Max - Min) / 16.f;
+            Endpoints[0][iChan] = Max - Inset;
+            Endpoints[1][iChan] = Min + Inset;
+        }
+        return;
+    }
+
+    // Principal axis of the colors, found by power iteration on the covariance matrix
+    float Mean[3] = { 0.f, 0.f, 0.f };
+
+    for (uint32 iCol = 0; iCol < NumColors; iCol++)
+        for (uint32 iChan = 0; iChan < 3; iChan++)
+            Mean[iChan] += Colors[iCol][iChan];
+
+    for (uint32 iChan = 0; iChan < 3; iChan++)
+        Mean[iChan] /= (float) NumColors;
+
+    float Cov[6] = { 0.f, 0.f, 0.f, 0.f, 0.f, 0.f }; // RR RG RB GG GB BB
+
+    for (uint32 iCol = 0; iCol < NumColors; iCol++)
+    {
+        float R = Colors[iCol][0] - Mean[0];
+        float G = Colors[iCol][1] - Mean[1];
+        float B = Colors[iCol][2] - Mean[2];
+        Cov[0] += R*R; Cov[1] += R*G; Cov[2] += R*B;
+        Cov[3] += G*G; Cov[4] += G*B; Cov[5] += B*B;
+    }
+
+    float Axis[3] = { 1.f, 1.f, 1.f };
+
+    for (uint32 iIter = 0; iIter < 8; iIter++)
+    {
+        float X = (Cov[0] * Axis[0]) + (Cov[1] * Axis[1]) + (Cov[2] * Axis[2]);
+        float Y = (Cov[1] * Axis[0]) + (Cov[3] * Axis[1]) + (Cov[4] * Axis[2]);
+        float Z = (Cov[2] * Axis[0]) + (Cov[4] * Axis[1]) + (Cov[5] * Axis[2]);
+        float Len = Math::Max(fabsf(X), Math::Max(fabsf(Y), fabsf(Z)));
+        if (Len < 1e-6f) break;
+
+        Axis[0] = X / Len;
+        Axis[1] = Y / Len;
+        Axis[2] = Z / Len;
+    }
+
+    // Endpoints are the extreme projections onto the axis
+    float MinDot = FLT_MAX, MaxDot = -FLT_MAX;
+    uint32 MinIdx = 0, MaxIdx = 0;
+
+    for (uint32 iCol = 0; iCol < NumColors; iCol++)
+    {
+        float Dot = (Colors[iCol][0] * Axis[0]) + (Colors[iCol][1] * Axis[1]) + (Colors[iCol][2] * Axis[2]);
+        if (Dot < MinDot) { MinDot = Dot; MinIdx = iCol; }
+        if (Dot > MaxDot) { MaxDot = Dot; MaxIdx = iCol; }
+    }
+
+    for (uint32 iChan = 0; iChan < 3; iChan++)
+    {
+        Endpoints[0][iChan] = Colors[MaxIdx][iChan];
+        Endpoints[1][iChan] = Colors[MinIdx][iChan];
+    }
+}
+
+// Orders the endpoints for the requested block mode
+static inline void OrderCMPREndpoints(uint16& rColor0, uint16& rColor1, bool ThreeColor)
+{
+    if ((ThreeColor && rColor0 > rColor1) || (!ThreeColor && rColor0 < rColor1))
+        std::swap(rColor0, rColor1);
+}
+
+// Encodes one 4x4 sub-block into 8 bytes of CMPR data
+static void EncodeSubBlockCMPR(const uint32 Pixels[16], ETextureEncodeQuality Quality, uint8 *pOut)
+{
+    bool HasTransparency = false;
+
+    for (uint32 iPix = 0; iPix < 16; iPix++)
+    {
+        if (ChannelA(Pixels[iPix]) < 128)
+        {
+            HasTransparency = true;
+            break;
+        }
+    }
+
+    float Endpoints[2][3];
+    FindCMPREndpoints(Pixels, Quality, Endpoints);
+
+    uint32 NumRefinePasses = (Quality == ETextureEncodeQuality::Fast ? 0 : Quality == ETextureEncodeQuality::Normal ? 1 : 4);
+
+    // Blocks with transparency have to use the three color mode. Opaque blocks normally use four colors,
+    // but at high quality both modes are tried, since three colors can fit some blocks better after rounding.
+    bool TryModes[2] = { !HasTransparency, HasTransparency || Quality == ETextureEncodeQuality::High };
+    uint16 BestColors[2] = { 0, 0 };
+    uint8 BestIndices[16];
+    uint32 BestError = UINT32_MAX;
+
+    for (uint32 iMode = 0; iMode < 2; iMode++)
+    {
+        if (!TryModes[iMode]) continue;
+        bool ThreeColor = (iMode == 1);
+
+        uint16 Color0 = EndpointTo565(Endpoints[0]);
+        uint16 Color1 = EndpointTo565(Endpoints[1]);
+        OrderCMPREndpoints(Color0, Color1, ThreeColor);
+
+        uint8 Indices[16];
+        uint32 Error = AssignCMPRIndices(Pixels, Color0, Color1, Indices);
+
+        for (uint32 iPass = 0; iPass < NumRefinePasses; iPass++)
+        {
+            float Refined[2][3];
+            if (!RefineCMPREndpoints(Pixels, Indices, ThreeColor, Refined)) break;
+
+            uint16 NewColor0 = EndpointTo565(Refined[0]);
+            uint16 NewColor1 = EndpointTo565(Refined[1]);
+            OrderCMPREndpoints(NewColor0, NewColor1, ThreeColor);
+
+            uint8 NewIndices[16];
+            uint32 NewError = AssignCMPRIndices(Pixels, NewColor0, NewColor1, NewIndices);
+            if (NewError >= Error) break;
+
+            Color0 = NewColor0;
+            Color1 = NewColor1;
+            Error = NewError;
+            memcpy(Indices, NewIndices, sizeof(Indices));
+        }
+
+        if (Error < BestError)
+        {
+            BestError = Error;
+            BestColors[0] = Color0;
+            BestColors[1] = Color1;
+            memcpy(BestIndices, Indices, sizeof(BestIndices));
+        }
+    }
+
+    // Four color mode requires Color0 > Color1; if they're equal every pixel uses index 0 anyway
+    if (!HasTransparency && BestColors[0] == BestColors[1])
+        memset(BestIndices, 0, sizeof(BestIndices));
+
+    WriteBE16(pOut + 0, BestColors[0]);
+    WriteBE16(pOut + 2, BestColors[1]);
+
+    for (uint32 iRow = 0; iRow < 4; iRow++)
+    {
+        const uint8 *pkRow = &BestIndices[iRow * 4];
+        pOut[4 + iRow] = (uint8) ((pkRow[0] << 6) | (pkRow[1] << 4) | (pkRow[2] << 2) | pkRow[3]);
+    }
+}
+
+// ************ CTextureEncoder ************
 CTextureEncoder::CTextureEncoder()
     : mpTexture(nullptr)
+    , mPaletteFormat(EGXPaletteFormat::RGB565)
+    , mQuality(ETextureEncodeQuality::Normal)
+    , mGenerateMipmaps(true)
 {
 }
 
 void CTextureEncoder::WriteTXTR(IOutputStream& rTXTR)
 {
-    // Only DXT1->CMPR supported at the moment
+    if (mSourceFormat == ETexelFormat::DXT1)
+    {
+        WriteCMPRFromDXT1(rTXTR);
+        return;
+    }
+
+    if (mOutputFormat == ETexelFormat::GX_C4 || mOutputFormat == ETexelFormat::GX_C8)
+        GeneratePalette();
+
+    rTXTR.WriteLong((uint) mOutputFormat);
+    rTXTR.WriteShort((uint16) mMipLevels[0].Width);
+    rTXTR.WriteShort((uint16) mMipLevels[0].Height);
+    rTXTR.WriteLong(mMipLevels.size());
+
+    if (!mPalette.empty())
+    {
+        rTXTR.WriteLong((uint) mPaletteFormat);
+        rTXTR.WriteShort(1);
+        rTXTR.WriteShort((uint16) mPalette.size());
+
+        for (uint16 Color : mPalette)
+            rTXTR.WriteShort(Color);
+    }
+
+    std::vector<uint8> MipData;
+
+    // One pool is shared by every mip level; it's only worth starting if the top level is encoded in parallel
+    std::unique_ptr<CWorkerPool> pPool;
+    uint32 NumTopBlocks = ((mMipLevels[0].Width + 7) / 8) * ((mMipLevels[0].Height + 7) / 8);
+
+    if (mOutputFormat == ETexelFormat::GX_CMPR && NumTopBlocks >= gskMinParallelCMPRBlocks)
+        pPool = std::make_unique<CWorkerPool>();
+
+    for (const SMipLevel& rkMip : mMipLevels)
+    {
+        MipData.clear();
+
+        switch (mOutputFormat)
+        {
+        case ETexelFormat::GX_CMPR:     EncodeMipCMPR(rkMip, MipData, pPool.get()); break;
+        case ETexelFormat::GX_RGB5A3:   EncodeMipRGB5A3(rkMip, MipData);            break;
+        case ETexelFormat::GX_I8:       EncodeMipI8(rkMip, MipData);                break;
+        case ETexelFormat::GX_C4:
+        case ETexelFormat::GX_C8:       EncodeMipIndexed(rkMip, MipData);           break;
+        default:                                                                    break;
+        }
+
+        rTXTR.WriteBytes(MipData.data(), MipData.size());
+    }
+}
+
+void CTextureEncoder::WriteCMPRFromDXT1(IOutputStream& rTXTR)
+{
     rTXTR.WriteLong((uint) mOutputFormat);
     rTXTR.WriteShort(mpTexture->mWidth);
     rTXTR.WriteShort(mpTexture->mHeight);
@@ -42,7 +498,28 @@ void CTextureEncoder::WriteTXTR(IOutputStream& rTXTR)
 
 void CTextureEncoder::DetermineBestOutputFormat()
 {
-    // todo
+    // Greyscale opaque images go to I8. Otherwise, CMPR if the alpha channel is 1-bit, or RGB5A3 if it isn't.
+    const uint32 *pkPixels = reinterpret_cast<const uint32*>(mpTexture->mpImgDataBuffer);
+    uint32 NumPixels = mpTexture->Width() * mpTexture->Height();
+    bool IsGreyscale = true;
+    bool HasAlpha = false;
+    bool HasPartialAlpha = false;
+
+    for (uint32 iPix = 0; iPix < NumPixels; iPix++)
+    {
+        uint32 Pixel = pkPixels[iPix];
+        uint32 A = ChannelA(Pixel);
+        if (A != 0xFF) HasAlpha = true;
+        if (A != 0xFF && A != 0x00) HasPartialAlpha = true;
+        if (ChannelR(Pixel) != ChannelG(Pixel) || ChannelG(Pixel) != ChannelB(Pixel)) IsGreyscale = false;
+    }
+
+    if (IsGreyscale && !HasAlpha)
+        mOutputFormat = ETexelFormat::GX_I8;
+    else if (HasPartialAlpha)
+        mOutputFormat = ETexelFormat::GX_RGB5A3;
+    else
+        mOutputFormat = ETexelFormat::GX_CMPR;
 }
 
 void CTextureEncoder::ReadSubBlockCMPR(IInputStream& rSource, IOutputStream& rDest)
@@ -58,26 +535,396 @@ void CTextureEncoder::ReadSubBlockCMPR(IInputStream& rSource, IOutputStream& rDe
     }
 }
 
+// ************ RGBA8 ENCODE ************
+void CTextureEncoder::GenerateMipLevels()
+{
+    // The top level comes from the texture; any mipmaps the source texture has are ignored and regenerated
+    SMipLevel Top;
+    Top.Width = mpTexture->Width();
+    Top.Height = mpTexture->Height();
+    Top.Pixels.resize(Top.Width * Top.Height);
+    memcpy(Top.Pixels.data(), mpTexture->mpImgDataBuffer, Top.Pixels.size() * sizeof(uint32));
+    mMipLevels.push_back( std::move(Top) );
+
+    if (!mGenerateMipmaps) return;
+
+    // Stop once a level would be smaller than a single block, so no level needs block padding
+    uint32 BlockW = gskBlockWidth[(int) mOutputFormat];
+    uint32 BlockH = gskBlockHeight[(int) mOutputFormat];
+
+    while (mMipLevels.back().Width / 2 >= BlockW && mMipLevels.back().Height / 2 >= BlockH)
+    {
+        const SMipLevel& rkPrev = mMipLevels.back();
+        SMipLevel Mip;
+        Mip.Width = rkPrev.Width / 2;
+        Mip.Height = rkPrev.Height / 2;
+        Mip.Pixels.resize(Mip.Width * Mip.Height);
+
+        // 2x2 box filter
+        for (uint32 Y = 0; Y < Mip.Height; Y++)
+        {
+            for (uint32 X = 0; X < Mip.Width; X++)
+            {
+                uint32 Samples[4] = {
+                    rkPrev.Pixels[ ((Y*2 + 0) * rkPrev.Width) + (X*2 + 0) ],
+                    rkPrev.Pixels[ ((Y*2 + 0) * rkPrev.Width) + (X*2 + 1) ],
+                    rkPrev.Pixels[ ((Y*2 + 1) * rkPrev.Width) + (X*2 + 0) ],
+                    rkPrev.Pixels[ ((Y*2 + 1) * rkPrev.Width) + (X*2 + 1) ]
+                };
+
+                uint32 A = 0, R = 0, G = 0, B = 0;
+
+                for (uint32 Sample : Samples)
+                {
+                    A += ChannelA(Sample);
+                    R += ChannelR(Sample);
+                    G += ChannelG(Sample);
+                    B += ChannelB(Sample);
+                }
+
+                Mip.Pixels[(Y * Mip.Width) + X] = MakeARGB((A + 2) / 4, (R + 2) / 4, (G + 2) / 4, (B + 2) / 4);
+            }
+        }
+
+        mMipLevels.push_back( std::move(Mip) );
+    }
+}
+
+void CTextureEncoder::GeneratePalette()
+{
+    // Median cut on the top level, followed by k-means refinement passes depending on the quality level.
+    // The palette is stored as RGB5A3 if the image has any transparency, otherwise as RGB565.
+    uint32 NumEntries = (mOutputFormat == ETexelFormat::GX_C4 ? 16 : 256);
+    const std::vector<uint32>& rkPixels = mMipLevels[0].Pixels;
+
+    std::vector<uint32> Colors = rkPixels;
+    std::sort(Colors.begin(), Colors.end());
+    Colors.erase( std::unique(Colors.begin(), Colors.end()), Colors.end() );
+
+    bool HasAlpha = false;
+
+    for (uint32 Color : Colors)
+    {
+        if (ChannelA(Color) != 0xFF)
+        {
+            HasAlpha = true;
+            break;
+        }
+    }
+
+    mPaletteFormat = (HasAlpha ? EGXPaletteFormat::RGB5A3 : EGXPaletteFormat::RGB565);
+
+    // Each box is a range in Colors, along with the channel it has the largest range in
+    struct SBox { uint32 Start, End, Shift, Range; };
+
+    auto MakeBox = [&Colors](uint32 Start, uint32 End) -> SBox
+    {
+        SBox Box { Start, End, 0, 0 };
+
+        for (uint32 Shift = 0; Shift < 32; Shift += 8)
+        {
+            uint32 Min = 0xFF, Max = 0;
+
+            for (uint32 iCol = Start; iCol < End; iCol++)
+            {
+                uint32 Value = (Colors[iCol] >> Shift) & 0xFF;
+                Min = Math::Min(Min, Value);
+                Max = Math::Max(Max, Value);
+            }
+
+            if (End > Start && Max - Min > Box.Range)
+            {
+                Box.Range = Max - Min;
+                Box.Shift = Shift;
+            }
+        }
+
+        return Box;
+    };
+
+    std::vector<SBox> Boxes;
+    Boxes.push_back( MakeBox(0, Colors.size()) );
+
+    while (Boxes.size() < NumEntries)
+    {
+        // Split the box with the largest channel range at its median
+        uint32 BestBox = -1, BestRange = 0;
+
+        for (uint32 iBox = 0; iBox < Boxes.size(); iBox++)
+        {
+            if (Boxes[iBox].End - Boxes[iBox].Start >= 2 && Boxes[iBox].Range > BestRange)
+            {
+                BestRange = Boxes[iBox].Range;
+                BestBox = iBox;
+            }
+        }
+
+        if (BestBox == (uint32) -1) break;
+
+        SBox Box = Boxes[BestBox];
+        uint32 Shift = Box.Shift;
+        std::sort(Colors.begin() + Box.Start, Colors.begin() + Box.End, [Shift](uint32 A, uint32 B) {
+            return ((A >> Shift) & 0xFF) < ((B >> Shift) & 0xFF);
+        });
+
+        uint32 Median = (Box.Start + Box.End) / 2;
+        Boxes[BestBox] = MakeBox(Box.Start, Median);
+        Boxes.push_back( MakeBox(Median, Box.End) );
+    }
+
+    // Average each box into a palette entry
+    std::vector<uint32> Palette;
+
+    for (const SBox& rkBox : Boxes)
+    {
+        uint32 Count = rkBox.End - rkBox.Start;
+        if (Count == 0) continue;
+
+        uint32 Sums[4] = { 0, 0, 0, 0 };
+
+        for (uint32 iCol = rkBox.Start; iCol < rkBox.End; iCol++)
+            for (uint32 iChan = 0; iChan < 4; iChan++)
+                Sums[iChan] += (Colors[iCol] >> (iChan * 8)) & 0xFF;
+
+        uint32 Color = 0;
+        for (uint32 iChan = 0; iChan < 4; iChan++)
+            Color |= ((Sums[iChan] + Count / 2) / Count) << (iChan * 8);
+
+        Palette.push_back(Color);
+    }
+
+    // K-means refinement over every pixel
+    uint32 NumPasses = (mQuality == ETextureEncodeQuality::Fast ? 0 : mQuality == ETextureEncodeQuality::Normal ? 1 : 4);
+
+    for (uint32 iPass = 0; iPass < NumPasses; iPass++)
+    {
+        std::vector<uint64> Sums(Palette.size() * 4, 0);
+        std::vector<uint32> Counts(Palette.size(), 0);
+
+        for (uint32 Pixel : rkPixels)
+        {
+            uint32 BestIdx = 0, BestError = UINT32_MAX;
+
+            for (uint32 iEntry = 0; iEntry < Palette.size(); iEntry++)
+            {
+                uint32 Error = ColorDistance(Pixel, Palette[iEntry]);
+                if (Error < BestError) { BestError = Error; BestIdx = iEntry; }
+            }
+
+            for (uint32 iChan = 0; iChan < 4; iChan++)
+                Sums[BestIdx * 4 + iChan] += (Pixel >> (iChan * 8)) & 0xFF;
+            Counts[BestIdx]++;
+        }
+
+        for (uint32 iEntry = 0; iEntry < Palette.size(); iEntry++)
+        {
+            if (Counts[iEntry] == 0) continue;
+            uint32 Color = 0;
+
+            for (uint32 iChan = 0; iChan < 4; iChan++)
+                Color |= (uint32) ((Sums[iEntry * 4 + iChan] + Counts[iEntry] / 2) / Counts[iEntry]) << (iChan * 8);
+
+            Palette[iEntry] = Color;
+        }
+    }
+
+    // Quantize; unused entries are left black
+    mPalette.assign(NumEntries, 0);
+
+    for (uint32 iEntry = 0; iEntry < Palette.size(); iEntry++)
+    {
+        uint32 Color = Palette[iEntry];
+
+        if (mPaletteFormat == EGXPaletteFormat::RGB5A3)
+            mPalette[iEntry] = EncodeRGB5A3(Color);
+        else
+            mPalette[iEntry] = EncodeRGB565(ChannelR(Color), ChannelG(Color), ChannelB(Color));
+    }
+}
+
+void CTextureEncoder::EncodeMipCMPR(const SMipLevel& rkMip, std::vector<uint8>& rOut, CWorkerPool *pPool)
+{
+    // 8x8 blocks of four 4x4 sub-blocks, 32 bytes per block. Each block is independent, so they're compressed in parallel.
+    uint32 BlocksX = (rkMip.Width + 7) / 8;
+    uint32 BlocksY = (rkMip.Height + 7) / 8;
+    uint32 NumBlocks = BlocksX * BlocksY;
+    rOut.resize(NumBlocks * 32);
+
+    ETextureEncodeQuality Quality = mQuality;
+
+    auto EncodeBlock = [&rkMip, &rOut, BlocksX, Quality](uint BlockIdx)
+    {
+        uint32 BaseX = (BlockIdx % BlocksX) * 8;
+        uint32 BaseY = (BlockIdx / BlocksX) * 8;
+        uint8 *pOut = &rOut[BlockIdx * 32];
+
+        for (uint32 iSub = 0; iSub < 4; iSub++)
+        {
+            uint32 SubX = BaseX + ((iSub % 2) * 4);
+            uint32 SubY = BaseY + ((iSub / 2) * 4);
+            uint32 Pixels[16];
+
+            for (uint32 iPix = 0; iPix < 16; iPix++)
+                Pixels[iPix] = FetchPixel(rkMip.Pixels, rkMip.Width, rkMip.Height, SubX + (iPix % 4), SubY + (iPix / 4));
+
+            EncodeSubBlockCMPR(Pixels, Quality, pOut + (iSub * 8));
+        }
+    };
+
+    if (!pPool || NumBlocks < gskMinParallelCMPRBlocks)
+    {
+        for (uint32 iBlock = 0; iBlock < NumBlocks; iBlock++)
+            EncodeBlock(iBlock);
+    }
+    else
+        pPool->ParallelFor(NumBlocks, EncodeBlock);
+}
+
+void CTextureEncoder::EncodeMipRGB5A3(const SMipLevel& rkMip, std::vector<uint8>& rOut)
+{
+    // 4x4 blocks, 2 bytes per pixel
+    uint32 BlocksX = (rkMip.Width + 3) / 4;
+    uint32 BlocksY = (rkMip.Height + 3) / 4;
+    rOut.resize(BlocksX * BlocksY * 32);
+    uint8 *pOut = rOut.data();
+
+    for (uint32 iBlockY = 0; iBlockY < BlocksY; iBlockY++)
+        for (uint32 iBlockX = 0; iBlockX < BlocksX; iBlockX++)
+            for (uint32 iPix = 0; iPix < 16; iPix++)
+            {
+                uint32 Pixel = FetchPixel(rkMip.Pixels, rkMip.Width, rkMip.Height, (iBlockX * 4) + (iPix % 4), (iBlockY * 4) + (iPix / 4));
+                WriteBE16(pOut, EncodeRGB5A3(Pixel));
+                pOut += 2;
+            }
+}
+
+void CTextureEncoder::EncodeMipI8(const SMipLevel& rkMip, std::vector<uint8>& rOut)
+{
+    // 8x4 blocks, 1 byte per pixel
+    uint32 BlocksX = (rkMip.Width + 7) / 8;
+    uint32 BlocksY = (rkMip.Height + 3) / 4;
+    rOut.resize(BlocksX * BlocksY * 32);
+    uint8 *pOut = rOut.data();
+
+    for (uint32 iBlockY = 0; iBlockY < BlocksY; iBlockY++)
+        for (uint32 iBlockX = 0; iBlockX < BlocksX; iBlockX++)
+            for (uint32 iPix = 0; iPix < 32; iPix++)
+            {
+                uint32 Pixel = FetchPixel(rkMip.Pixels, rkMip.Width, rkMip.Height, (iBlockX * 8) + (iPix % 8), (iBlockY * 4) + (iPix / 8));
+                *pOut++ = (uint8) PixelLuminance(Pixel);
+            }
+}
+
+void CTextureEncoder::EncodeMipIndexed(const SMipLevel& rkMip, std::vector<uint8>& rOut)
+{
+    // C4 is 8x8 blocks with two pixels per byte (high nibble first); C8 is 8x4 blocks with one pixel per byte
+    bool IsC4 = (mOutputFormat == ETexelFormat::GX_C4);
+    uint32 BlockH = (IsC4 ? 8 : 4);
+    uint32 BlocksX = (rkMip.Width + 7) / 8;
+    uint32 BlocksY = (rkMip.Height + BlockH - 1) / BlockH;
+    rOut.assign(BlocksX * BlocksY * 32, 0);
+
+    // Decode the palette once so the nearest entry search compares against what the game will actually display
+    std::vector<uint32> Decoded(mPalette.size());
+
+    for (uint32 iEntry = 0; iEntry < mPalette.size(); iEntry++)
+        Decoded[iEntry] = (mPaletteFormat == EGXPaletteFormat::RGB5A3 ? DecodeRGB5A3(mPalette[iEntry]) : DecodeRGB565(mPalette[iEntry]));
+
+    uint32 OutIdx = 0;
+
+    for (uint32 iBlockY = 0; iBlockY < BlocksY; iBlockY++)
+        for (uint32 iBlockX = 0; iBlockX < BlocksX; iBlockX++)
+            for (uint32 iPix = 0; iPix < 8 * BlockH; iPix++)
+            {
+                uint32 Pixel = FetchPixel(rkMip.Pixels, rkMip.Width, rkMip.Height, (iBlockX * 8) + (iPix % 8), (iBlockY * BlockH) + (iPix / 8));
+                if (mPaletteFormat == EGXPaletteFormat::RGB565) Pixel |= 0xFF000000;
+
+                uint32 BestIdx = 0, BestError = UINT32_MAX;
+
+                for (uint32 iEntry = 0; iEntry < Decoded.size(); iEntry++)
+                {
+                    uint32 Error = ColorDistance(Pixel, Decoded[iEntry]);
+                    if (Error < BestError) { BestError = Error; BestIdx = iEntry; }
+                }
+
+                if (IsC4)
+                {
+                    rOut[OutIdx / 2] |= (uint8) ((OutIdx % 2 == 0) ? (BestIdx << 4) : BestIdx);
+                    OutIdx++;
+                }
+                else
+                    rOut[OutIdx++] = (uint8) BestIdx;
+            }
+}
+
 // ************ STATIC ************
 void CTextureEncoder::EncodeTXTR(IOutputStream& rTXTR, CTexture *pTex)
 {
-    if (pTex->mTexelFormat != ETexelFormat::DXT1)
+    if (pTex->mTexelFormat == ETexelFormat::DXT1)
+    {
+        EncodeTXTR(rTXTR, pTex, ETexelFormat::GX_CMPR);
+        return;
+    }
+
+    if (pTex->mTexelFormat != ETexelFormat::RGBA8)
     {
-        errorf("Unsupported texel format for decoding");
+        errorf("Unsupported texel format for encoding");
         return;
     }
 
     CTextureEncoder Encoder;
     Encoder.mpTexture = pTex;
-    Encoder.mSourceFormat = ETexelFormat::DXT1;
-    Encoder.mOutputFormat = ETexelFormat::GX_CMPR;
+    Encoder.mSourceFormat = ETexelFormat::RGBA8;
+    Encoder.DetermineBestOutputFormat();
+    Encoder.GenerateMipLevels();
     Encoder.WriteTXTR(rTXTR);
 }
 
-void CTextureEncoder::EncodeTXTR(IOutputStream& rTXTR, CTexture *pTex, ETexelFormat /*OutputFormat*/)
+void CTextureEncoder::EncodeTXTR(IOutputStream& rTXTR, CTexture *pTex, ETexelFormat OutputFormat,
+                                 ETextureEncodeQuality Quality /*= ETextureEncodeQuality::Normal*/, bool GenerateMipmaps /*= true*/)
 {
-    // todo: support for encoding a specific format
-    EncodeTXTR(rTXTR, pTex);
+    CTextureEncoder Encoder;
+    Encoder.mpTexture = pTex;
+    Encoder.mSourceFormat = pTex->mTexelFormat;
+    Encoder.mOutputFormat = OutputFormat;
+    Encoder.mQuality = Quality;
+    Encoder.mGenerateMipmaps = GenerateMipmaps;
+
+    if (pTex->mTexelFormat == ETexelFormat::DXT1)
+    {
+        // DXT1 is converted directly, so the existing mipmaps are used as they are
+        if (OutputFormat != ETexelFormat::GX_CMPR)
+        {
+            errorf("DXT1 textures can only be encoded to CMPR");
+            return;
+        }
+
+        Encoder.WriteTXTR(rTXTR);
+        return;
+    }
+
+    if (pTex->mTexelFormat != ETexelFormat::RGBA8)
+    {
+        errorf("Unsupported texel format for encoding");
+        return;
+    }
+
+    switch (OutputFormat)
+    {
+    case ETexelFormat::GX_CMPR:
+    case ETexelFormat::GX_RGB5A3:
+    case ETexelFormat::GX_I8:
+    case ETexelFormat::GX_C4:
+    case ETexelFormat::GX_C8:
+        break;
+
+    default:
+        errorf("Unsupported output format for texture encoding: %d", (int) OutputFormat);
+        return;
+    }
+
+    Encoder.GenerateMipLevels();
+    Encoder.WriteTXTR(rTXTR);
 }
 
 ETexelFormat CTextureEncoder::GetGXFormat(ETexelFormat Format)
@@ -3,23 +3,56 @@
 
 #include "Core/Resource/CTexture.h"
 #include "Core/Resource/TResPtr.h"
+#include <vector>
 
-// Class contains basic functionality right now - only supports directly converting DXT1 to CMPR
-// More advanced functions (including actual encoding!) coming later
+class CWorkerPool;
+
+// Speed/quality tradeoff for lossy formats (CMPR and palettes)
+enum class ETextureEncodeQuality
+{
+    Fast,   // Bounding box endpoints; fastest
+    Normal, // Principal axis endpoints with one refinement pass
+    High    // Principal axis endpoints with several refinement passes, tries every CMPR block mode
+};
+
+// Encodes textures to TXTR. DXT1 textures are converted directly to CMPR; RGBA8 textures
+// can be encoded to CMPR, RGB5A3, I8, C4 or C8, with mipmaps generated from the top level.
 class CTextureEncoder
 {
     TResPtr<CTexture> mpTexture;
     ETexelFormat mSourceFormat;
     ETexelFormat mOutputFormat;
+    EGXPaletteFormat mPaletteFormat;
+    ETextureEncodeQuality mQuality;
+    bool mGenerateMipmaps;
+
+    // Source image for each mip level, as 32-bit ARGB (the same layout as the RGBA8 texel format)
+    struct SMipLevel
+    {
+        uint32 Width, Height;
+        std::vector<uint32> Pixels;
+    };
+    std::vector<SMipLevel> mMipLevels;
+    std::vector<uint16> mPalette;
 
     CTextureEncoder();
     void WriteTXTR(IOutputStream& rTXTR);
+    void WriteCMPRFromDXT1(IOutputStream& rTXTR);
     void DetermineBestOutputFormat();
     void ReadSubBlockCMPR(IInputStream& rSource, IOutputStream& rDest);
 
+    // RGBA8 encode
+    void GenerateMipLevels();
+    void GeneratePalette();
+    void EncodeMipCMPR(const SMipLevel& rkMip, std::vector<uint8>& rOut, CWorkerPool *pPool);
+    void EncodeMipRGB5A3(const SMipLevel& rkMip, std::vector<uint8>& rOut);
+    void EncodeMipI8(const SMipLevel& rkMip, std::vector<uint8>& rOut);
+    void EncodeMipIndexed(const SMipLevel& rkMip, std::vector<uint8>& rOut);
+
 public:
     static void EncodeTXTR(IOutputStream& rTXTR, CTexture *pTex);
-    static void EncodeTXTR(IOutputStream& rTXTR, CTexture *pTex, ETexelFormat OutputFormat);
+    static void EncodeTXTR(IOutputStream& rTXTR, CTexture *pTex, ETexelFormat OutputFormat,
+                           ETextureEncodeQuality Quality = ETextureEncodeQuality::Normal, bool GenerateMipmaps = true);
     static ETexelFormat GetGXFormat(ETexelFormat Format);
     static ETexelFormat GetFormat(ETexelFormat Format);
 };
@@ -243,9 +243,7 @@ void CAnimationLoader::ReadCompressedANIM()
 
     // Read bone channel descriptors
     mCompressedChannels.resize(NumBoneChannels);
-    mpAnim->mScaleChannels.resize(NumBoneChannels);
-    mpAnim->mRotationChannels.resize(NumBoneChannels);
-    mpAnim->mTranslationChannels.resize(NumBoneChannels);
+    mpAnim->mQuantizedChannels.resize(NumBoneChannels);
 
     for (uint32 iChan = 0; iChan < NumBoneChannels; iChan++)
     {
@@ -310,50 +308,81 @@ void CAnimationLoader::ReadCompressedANIM()
 void CAnimationLoader::ReadCompressedAnimationData()
 {
     CBitStreamInWrapper BitStream(mpInput);
+    uint32 NumKeys = mpAnim->mNumKeys;
+    ASSERT(NumKeys > 0 && NumKeys <= 0x10000);
+
+    mpAnim->mIsCompressed = true;
+    mpAnim->mRotationMultiplier = Math::skHalfPi / (float) mRotationDivisor;
+    mpAnim->mTranslationMultiplier = mTranslationMultiplier;
+    if (mGame >= EGame::EchoesDemo) mpAnim->mScaleMultiplier = mScaleMultiplier;
+
+    // Work out which keys are stored. Dropped keys are interpolated from the stored keys on either
+    // side at evaluation time, except for dropped keys at the end of the animation, which have nothing
+    // to interpolate towards; those are stored as a copy of the previous key.
+    uint32 LastPresentKey = 0;
+
+    for (uint32 iKey = 1; iKey < NumKeys; iKey++)
+    {
+        if (mKeyFlags[iKey])
+            LastPresentKey = iKey;
+    }
+
+    std::vector<bool> KeyStored(NumKeys);
+    mpAnim->mKeyToStoredKey.resize(NumKeys);
+
+    for (uint32 iKey = 0; iKey < NumKeys; iKey++)
+    {
+        KeyStored[iKey] = (iKey == 0 || mKeyFlags[iKey] || iKey > LastPresentKey);
+
+        if (KeyStored[iKey])
+            mpAnim->mStoredKeys.push_back((uint16) iKey);
+
+        mpAnim->mKeyToStoredKey[iKey] = (uint16) (mpAnim->mStoredKeys.size() - 1);
+    }
+
+    uint32 NumStoredKeys = mpAnim->mStoredKeys.size();
 
     // Initialize
     for (uint32 iChan = 0; iChan < mCompressedChannels.size(); iChan++)
     {
         SCompressedChannel& rChan = mCompressedChannels[iChan];
+        CAnimation::SQuantizedChannel& rOutChan = mpAnim->mQuantizedChannels[iChan];
 
         // Set initial rotation/translation/scale
         if (rChan.NumRotationKeys > 0)
         {
-            mpAnim->mRotationChannels[iChan].reserve(rChan.NumRotationKeys + 1);
-            CQuaternion Rotation = DequantizeRotation(false, rChan.Rotation[0], rChan.Rotation[1], rChan.Rotation[2]);
-            mpAnim->mRotationChannels[iChan].push_back(Rotation);
+            rOutChan.Rotation.reserve(NumStoredKeys * 4);
+            rOutChan.Rotation.insert(rOutChan.Rotation.end(), { rChan.Rotation[0], rChan.Rotation[1], rChan.Rotation[2], 0 });
         }
 
         if (rChan.NumTranslationKeys > 0)
         {
-            mpAnim->mTranslationChannels[iChan].reserve(rChan.NumTranslationKeys + 1);
-            CVector3f Translate = CVector3f(rChan.Translation[0], rChan.Translation[1], rChan.Translation[2]) * mTranslationMultiplier;
-            mpAnim->mTranslationChannels[iChan].push_back(Translate);
+            rOutChan.Translation.reserve(NumStoredKeys * 3);
+            rOutChan.Translation.insert(rOutChan.Translation.end(), { rChan.Translation[0], rChan.Translation[1], rChan.Translation[2] });
         }
 
         if (rChan.NumScaleKeys > 0)
         {
-            mpAnim->mScaleChannels[iChan].reserve(rChan.NumScaleKeys + 1);
-            CVector3f Scale = CVector3f(rChan.Scale[0], rChan.Scale[1], rChan.Scale[2]) * mScaleMultiplier;
-            mpAnim->mScaleChannels[iChan].push_back(Scale);
+            rOutChan.Scale.reserve(NumStoredKeys * 3);
+            rOutChan.Scale.insert(rOutChan.Scale.end(), { rChan.Scale[0], rChan.Scale[1], rChan.Scale[2] });
         }
     }
 
     // Read keys
-    for (uint32 iKey = 0; iKey < mpAnim->mNumKeys - 1; iKey++)
+    for (uint32 iKey = 1; iKey < NumKeys; iKey++)
     {
-        bool KeyPresent = mKeyFlags[iKey+1];
+        bool KeyPresent = mKeyFlags[iKey];
 
         for (uint32 iChan = 0; iChan < mCompressedChannels.size(); iChan++)
         {
             SCompressedChannel& rChan = mCompressedChannels[iChan];
+            CAnimation::SQuantizedChannel& rOutChan = mpAnim->mQuantizedChannels[iChan];
 
             // Read rotation
             if (rChan.NumRotationKeys > 0)
             {
-                // Note if KeyPresent is false, this isn't the correct value of WSign.
-                // However, we're going to recreate this key later via interpolation, so it doesn't matter what value we use here.
-                bool WSign = (KeyPresent ? BitStream.ReadBit() : false);
+                // Copies of dropped keys at the end of the animation always have a positive W
+                int16 WSign = (KeyPresent ? (int16) BitStream.ReadBit() : 0);
 
                 if (KeyPresent)
                 {
@@ -362,8 +391,8 @@ void CAnimationLoader::ReadCompressedAnimationData()
                     rChan.Rotation[2] += (int16) BitStream.ReadBits(rChan.RotationBits[2]);
                 }
 
-                CQuaternion Rotation = DequantizeRotation(WSign, rChan.Rotation[0], rChan.Rotation[1], rChan.Rotation[2]);
-                mpAnim->mRotationChannels[iChan].push_back(Rotation);
+                if (KeyStored[iKey])
+                    rOutChan.Rotation.insert(rOutChan.Rotation.end(), { rChan.Rotation[0], rChan.Rotation[1], rChan.Rotation[2], WSign });
             }
 
             // Read translation
@@ -376,8 +405,8 @@ void CAnimationLoader::ReadCompressedAnimationData()
                     rChan.Translation[2] += (int16) BitStream.ReadBits(rChan.TranslationBits[2]);
                 }
 
-                CVector3f Translate = CVector3f(rChan.Translation[0], rChan.Translation[1], rChan.Translation[2]) * mTranslationMultiplier;
-                mpAnim->mTranslationChannels[iChan].push_back(Translate);
+                if (KeyStored[iKey])
+                    rOutChan.Translation.insert(rOutChan.Translation.end(), { rChan.Translation[0], rChan.Translation[1], rChan.Translation[2] });
             }
 
             // Read scale
@@ -390,76 +419,11 @@ void CAnimationLoader::ReadCompressedAnimationData()
                     rChan.Scale[2] += (int16) BitStream.ReadBits(rChan.ScaleBits[2]);
                 }
 
-                CVector3f Scale = CVector3f(rChan.Scale[0], rChan.Scale[1], rChan.Scale[2]) * mScaleMultiplier;
-                mpAnim->mScaleChannels[iChan].push_back(Scale);
+                if (KeyStored[iKey])
+                    rOutChan.Scale.insert(rOutChan.Scale.end(), { rChan.Scale[0], rChan.Scale[1], rChan.Scale[2] });
             }
         }
     }
-
-    // Fill in missing keys
-    uint32 NumMissedKeys = 0;
-
-    for (uint32 iKey = 0; iKey < mpAnim->mNumKeys; iKey++)
-    {
-        if (!mKeyFlags[iKey])
-            NumMissedKeys++;
-
-        else if (NumMissedKeys > 0)
-        {
-            uint32 FirstIndex = iKey - NumMissedKeys - 1;
-            uint32 LastIndex = iKey;
-            uint32 RelLastIndex = LastIndex - FirstIndex;
-
-            for (uint32 iMissed = 0; iMissed < NumMissedKeys; iMissed++)
-            {
-                uint32 KeyIndex = FirstIndex + iMissed + 1;
-                uint32 RelKeyIndex = (KeyIndex - FirstIndex);
-                float Interp = (float) RelKeyIndex / (float) RelLastIndex;
-
-                for (uint32 iChan = 0; iChan < mCompressedChannels.size(); iChan++)
-                {
-                    bool HasTranslationKeys = mCompressedChannels[iChan].NumTranslationKeys > 0;
-                    bool HasRotationKeys = mCompressedChannels[iChan].NumRotationKeys > 0;
-                    bool HasScaleKeys = mCompressedChannels[iChan].NumScaleKeys > 0;
-
-                    if (HasRotationKeys)
-                    {
-                        CQuaternion Left = mpAnim->mRotationChannels[iChan][FirstIndex];
-                        CQuaternion Right = mpAnim->mRotationChannels[iChan][LastIndex];
-                        mpAnim->mRotationChannels[iChan][KeyIndex] = Left.Slerp(Right, Interp);
-                    }
-
-                    if (HasTranslationKeys)
-                    {
-                        CVector3f Left = mpAnim->mTranslationChannels[iChan][FirstIndex];
-                        CVector3f Right = mpAnim->mTranslationChannels[iChan][LastIndex];
-                        mpAnim->mTranslationChannels[iChan][KeyIndex] = Math::Lerp<CVector3f>(Left, Right, Interp);
-                    }
-
-                    if (HasScaleKeys)
-                    {
-                        CVector3f Left = mpAnim->mScaleChannels[iChan][FirstIndex];
-                        CVector3f Right = mpAnim->mScaleChannels[iChan][LastIndex];
-                        mpAnim->mScaleChannels[iChan][KeyIndex] = Math::Lerp<CVector3f>(Left, Right, Interp);
-                    }
-                }
-            }
-
-            NumMissedKeys = 0;
-        }
-    }
-}
-
-CQuaternion CAnimationLoader::DequantizeRotation(bool Sign, int16 X, int16 Y, int16 Z)
-{
-    CQuaternion Out;
-    float Multiplier = Math::skHalfPi / (float) mRotationDivisor;
-    Out.X = sinf(X * Multiplier);
-    Out.Y = sinf(Y * Multiplier);
-    Out.Z = sinf(Z * Multiplier);
-    Out.W = Math::Sqrt( fmax(1.f - ((Out.X * Out.X) + (Out.Y * Out.Y) + (Out.Z * Out.Z)), 0.f) );
-    if (Sign) Out.W = -Out.W;
-    return Out;
 }
 
 // ************ STATIC ************
@@ -38,7 +38,6 @@ class CAnimationLoader
     void ReadUncompressedANIM();
     void ReadCompressedANIM();
     void ReadCompressedAnimationData();
-    CQuaternion DequantizeRotation(bool Sign, int16 X, int16 Y, int16 Z);
 
 public:
     static CAnimation* LoadANIM(IInputStream& rANIM, CResourceEntry *pEntry);
@@ -4,15 +4,20 @@
 #include "CMaterialLoader.h"
 #include "CScriptLoader.h"
 #include "Core/CompressionUtil.h"
+#include "Core/CWorkerPool.h"
+#include "Core/GameProject/CResourceLoadContext.h"
 #include <Common/Log.h>
 
 #include <Common/CFourCC.h>
+#include <Common/Math/MathUtil.h>
 
+#include <atomic>
 #include <iostream>
 
 CAreaLoader::CAreaLoader()
     : mpMREA(nullptr)
     , mHasDecompressedBuffer(false)
+    , mKeepSectionData(true)
     , mGeometryBlockNum(-1)
     , mScriptLayerBlockNum(-1)
     , mCollisionBlockNum(-1)
@@ -564,10 +569,20 @@ void CAreaLoader::Decompress()
     // It should be called at the beginning of the first compressed cluster.
     if (mVersion < EGame::Echoes) return;
 
-    // Decompress clusters
+    // Read clusters. Uncompressed clusters are copied straight into the buffer; compressed
+    // clusters are read into one buffer and decompressed into their slice of the output afterwards.
     mpDecmpBuffer = new uint8[mTotalDecmpSize];
     uint32 Offset = 0;
 
+    struct SClusterJob
+    {
+        uint32 SrcOffset;
+        uint32 DstOffset;
+        uint32 ClusterIdx;
+    };
+    std::vector<SClusterJob> Jobs;
+    std::vector<uint8> CompressedBuf;
+
     for (uint32 iClust = 0; iClust < mClusters.size(); iClust++)
     {
         SCompressedCluster *pClust = &mClusters[iClust];
@@ -576,7 +591,6 @@ void CAreaLoader::Decompress()
         if (mClusters[iClust].CompressedSize == 0)
         {
             mpMREA->ReadBytes(mpDecmpBuffer + Offset, pClust->DecompressedSize);
-            Offset += pClust->DecompressedSize;
         }
 
         else
@@ -585,16 +599,44 @@ void CAreaLoader::Decompress()
             if (StartOffset != 32)
                 mpMREA->Seek(StartOffset, SEEK_CUR);
 
-            std::vector<uint8> CompressedBuf(mClusters[iClust].CompressedSize);
-            mpMREA->ReadBytes(CompressedBuf.data(), CompressedBuf.size());
+            uint32 SrcOffset = CompressedBuf.size();
+            CompressedBuf.resize(SrcOffset + pClust->CompressedSize);
+            mpMREA->ReadBytes(CompressedBuf.data() + SrcOffset, pClust->CompressedSize);
+            Jobs.push_back( SClusterJob { SrcOffset, Offset, iClust } );
+        }
+
+        Offset += pClust->DecompressedSize;
+    }
 
-            bool Success = CompressionUtil::DecompressSegmentedData(CompressedBuf.data(), CompressedBuf.size(), mpDecmpBuffer + Offset, pClust->DecompressedSize);
-            if (!Success)
-                throw "Failed to decompress MREA!";
+    // Decompress clusters. Each cluster writes to its own slice of the buffer, so they can run in parallel.
+    std::atomic<bool> Success(true);
 
-            Offset += pClust->DecompressedSize;
+    auto DecompressCluster = [&](uint JobIdx)
+    {
+        const SClusterJob& rkJob = Jobs[JobIdx];
+        const SCompressedCluster& rkClust = mClusters[rkJob.ClusterIdx];
+
+        if (!CompressionUtil::DecompressSegmentedData(CompressedBuf.data() + rkJob.SrcOffset, rkClust.CompressedSize,
+                                                      mpDecmpBuffer + rkJob.DstOffset, rkClust.DecompressedSize))
+        {
+            Success = false;
         }
+    };
+
+    // Areas loaded through a load context are already being loaded on a worker thread, so don't start more threads for those.
+    if (Jobs.size() > 1 && !CResourceLoadContext::Current())
+    {
+        CWorkerPool Pool( Math::Min<uint>(Jobs.size(), CWorkerPool::DefaultThreadCount()) );
+        Pool.ParallelFor(Jobs.size(), DecompressCluster);
     }
+    else
+    {
+        for (uint32 JobIdx = 0; JobIdx < Jobs.size(); JobIdx++)
+            DecompressCluster(JobIdx);
+    }
+
+    if (!Success)
+        throw "Failed to decompress MREA!";
 
     TString Source = mpMREA->GetSourceString();
     mpMREA = new CMemoryInStream(mpDecmpBuffer, mTotalDecmpSize, EEndian::BigEndian);
@@ -605,14 +647,24 @@ void CAreaLoader::Decompress()
 
 void CAreaLoader::LoadSectionDataBuffers()
 {
-   mpArea->mSectionDataBuffers.resize(mpSectionMgr->NumSections());
+   mpArea->mSectionSizes.resize(mpSectionMgr->NumSections());
    mpSectionMgr->ToSection(0);
 
+   // Section data is only copied out if the area can't read it back from its cooked file later
+   if (mKeepSectionData)
+       mpArea->mSectionDataBuffers.resize(mpSectionMgr->NumSections());
+
    for (uint32 iSec = 0; iSec < mpSectionMgr->NumSections(); iSec++)
    {
        uint32 Size = mpSectionMgr->CurrentSectionSize();
-       mpArea->mSectionDataBuffers[iSec].resize(Size);
-       mpMREA->ReadBytes(mpArea->mSectionDataBuffers[iSec].data(), mpArea->mSectionDataBuffers[iSec].size());
+       mpArea->mSectionSizes[iSec] = Size;
+
+       if (mKeepSectionData)
+       {
+           mpArea->mSectionDataBuffers[iSec].resize(Size);
+           mpMREA->ReadBytes(mpArea->mSectionDataBuffers[iSec].data(), mpArea->mSectionDataBuffers[iSec].size());
+       }
+
        mpSectionMgr->ToNextSection();
    }
 }
@@ -745,6 +797,7 @@ CGameArea* CAreaLoader::LoadMREA(IInputStream& MREA, CResourceEntry *pEntry)
     uint32 Version = MREA.ReadLong();
     Loader.mVersion = GetFormatVersion(Version);
     Loader.mpMREA = &MREA;
+    Loader.mKeepSectionData = (pEntry == nullptr);
 
     switch (Loader.mVersion)
     {
@@ -814,6 +867,43 @@ CGameArea* CAreaLoader::LoadMREA(IInputStream& MREA, CResourceEntry *pEntry)
     return Loader.mpArea;
 }
 
+bool CAreaLoader::LoadSectionData(IInputStream& rMREA, std::vector<std::vector<uint8>>& rOut)
+{
+    // Reads the header and section data of an MREA without parsing any of the sections
+    if (!rMREA.IsValid() || rMREA.ReadLong() != 0xdeadbeef)
+        return false;
+
+    CAreaLoader Loader;
+    Loader.mVersion = GetFormatVersion(rMREA.ReadLong());
+    Loader.mpMREA = &rMREA;
+    Loader.mpArea = new CGameArea();
+
+    switch (Loader.mVersion)
+    {
+        case EGame::PrimeDemo:
+        case EGame::Prime:
+            Loader.ReadHeaderPrime();
+            break;
+        case EGame::EchoesDemo:
+        case EGame::Echoes:
+            Loader.ReadHeaderEchoes();
+            break;
+        case EGame::CorruptionProto:
+        case EGame::Corruption:
+        case EGame::DKCReturns:
+            Loader.ReadHeaderCorruption();
+            break;
+        default:
+            Loader.mpArea.Delete();
+            return false;
+    }
+
+    rOut = std::move(Loader.mpArea->mSectionDataBuffers);
+    delete Loader.mpSectionMgr;
+    Loader.mpArea.Delete();
+    return true;
+}
+
 EGame CAreaLoader::GetFormatVersion(uint32 Version)
 {
     switch (Version)
@@ -26,6 +26,7 @@ class CAreaLoader
     // Compression
     uint8 *mpDecmpBuffer;
     bool mHasDecompressedBuffer;
+    bool mKeepSectionData;
     std::vector<SCompressedCluster> mClusters;
     uint32 mTotalDecmpSize;
 
@@ -82,6 +83,7 @@ class CAreaLoader
 
 public:
     static CGameArea* LoadMREA(IInputStream& rMREA, CResourceEntry *pEntry);
+    static bool LoadSectionData(IInputStream& rMREA, std::vector<std::vector<uint8>>& rOut);
     static EGame GetFormatVersion(uint32 Version);
 };
 
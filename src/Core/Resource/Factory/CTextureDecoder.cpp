@@ -1,6 +1,15 @@
 #include "CTextureDecoder.h"
 #include <Common/Log.h>
 #include <Common/CColor.h>
+#include <cstring>
+
+// SSE2 is part of the x86-64 baseline, so the block decoders can use it without any runtime checks
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXTURE_DECODE_SSE2 1
+#include <emmintrin.h>
+#else
+#define TEXTURE_DECODE_SSE2 0
+#endif
 
 // A cleanup is warranted at some point. Trying to support both partial + full decode ended up really messy.
 
@@ -100,6 +109,15 @@ CTexture* CTextureDecoder::LoadTXTR(IInputStream& rTXTR, CResourceEntry *pEntry)
     return Decoder.CreateTexture();
 }
 
+CTexture* CTextureDecoder::LoadTXTRReference(IInputStream& rTXTR, CResourceEntry *pEntry)
+{
+    CTextureDecoder Decoder;
+    Decoder.mpEntry = pEntry;
+    Decoder.ReadTXTR(rTXTR);
+    Decoder.PartialDecodeGXTextureReference(rTXTR);
+    return Decoder.CreateTexture();
+}
+
 CTexture* CTextureDecoder::DoFullDecode(IInputStream& rTXTR, CResourceEntry *pEntry)
 {
     CTextureDecoder Decoder;
@@ -201,9 +219,709 @@ void CTextureDecoder::ReadDDS(IInputStream& rDDS)
     rDDS.Seek(ImageDataStart, SEEK_SET);
 }
 
+// ************ BLOCK DECODE ************
+// Block decoders work on raw image data in memory instead of going through streams. Each call decodes one
+// whole GX block (for CMPR, one 8x8 block made of four sub-blocks) to the output image, so the texel format
+// only needs to be dispatched once per texture rather than once per pixel.
+struct SBlockDecodeParams
+{
+    uint32 DstPitch;            // Size of one output row in bytes
+    uint32 DstPixelStride;      // Size of one output pixel in bytes
+    const uint32 *pkPalette;    // Palette converted to output pixels, for C4/C8
+};
+typedef void (*FBlockDecodeFunc)(const uint8 *pkSrc, uint8 *pDst, const SBlockDecodeParams& rkParams);
+
+// Size of one block of source data for each GX texture format
+static const uint32 gskSourceBlockSize[] = {
+    32, 32, 32, 32, 32, 32, 32, 32, 32, 64, 32
+};
+
+// Extra space allocated past the end of decode buffers. Partial C4 decodes write each pair of pixels
+// as two 32-bit values regardless of pixel stride, so the last pair can spill past the end of the image.
+static const uint32 gskDecodeBufferPadding = 8;
+
+static inline uint16 ReadBE16(const uint8 *pkSrc)
+{
+    return (uint16) ((pkSrc[0] << 8) | pkSrc[1]);
+}
+
+static inline void StoreNative16(uint8 *pDst, uint16 Value)
+{
+    memcpy(pDst, &Value, sizeof(uint16));
+}
+
+static inline void StoreNative32(uint8 *pDst, uint32 Value)
+{
+    memcpy(pDst, &Value, sizeof(uint32));
+}
+
+static inline uint32 MakeARGB(uint32 A, uint32 R, uint32 G, uint32 B)
+{
+    return (A << 24) | (R << 16) | (G << 8) | B;
+}
+
+static std::vector<uint8> ReadImageData(IInputStream& rTXTR)
+{
+    uint32 ImageStart = rTXTR.Tell();
+    rTXTR.Seek(0x0, SEEK_END);
+    uint32 ImageSize = rTXTR.Tell() - ImageStart;
+    rTXTR.Seek(ImageStart, SEEK_SET);
+
+    std::vector<uint8> Data(ImageSize);
+    rTXTR.ReadBytes(Data.data(), Data.size());
+    return Data;
+}
+
+#if TEXTURE_DECODE_SSE2
+static inline __m128i ByteSwap16(__m128i Value)
+{
+    return _mm_or_si128( _mm_slli_epi16(Value, 8), _mm_srli_epi16(Value, 8) );
+}
+
+static inline __m128i ExtendNibbles(__m128i Nibbles)
+{
+    // Each byte must be in [0, 15], so the shift can't carry into the neighboring byte
+    return _mm_or_si128( Nibbles, _mm_slli_epi16(Nibbles, 4) );
+}
+
+static inline __m128i Select(__m128i Mask, __m128i IfSet, __m128i IfClear)
+{
+    return _mm_or_si128( _mm_and_si128(Mask, IfSet), _mm_andnot_si128(Mask, IfClear) );
+}
+#endif
+
+// ************ BLOCK DECODE (PARTIAL) ************
+// These produce the same output as the ReadPixel functions used by the reference decode.
+static void PartialDecodeBlockI4(const uint8 *pkSrc, uint8 *pDst, const SBlockDecodeParams& rkParams)
+{
+    // 8x8 block; each source byte holds two pixels, each output pixel is two bytes
+#if TEXTURE_DECODE_SSE2
+    const __m128i kLowNibble = _mm_set1_epi8(0xF);
+
+    for (uint32 Half = 0; Half < 2; Half++)
+    {
+        __m128i Src = _mm_loadu_si128( (const __m128i*) (pkSrc + (Half * 16)) );
+        __m128i High = ExtendNibbles( _mm_and_si128(_mm_srli_epi16(Src, 4), kLowNibble) );
+        __m128i Low = ExtendNibbles( _mm_and_si128(Src, kLowNibble) );
+        __m128i Pairs01 = _mm_unpacklo_epi8(High, Low);
+        __m128i Pairs23 = _mm_unpackhi_epi8(High, Low);
+
+        uint8 *pRow = pDst + (Half * 4 * rkParams.DstPitch);
+        _mm_storeu_si128( (__m128i*) (pRow),                            _mm_unpacklo_epi8(Pairs01, Pairs01) );
+        _mm_storeu_si128( (__m128i*) (pRow + rkParams.DstPitch),        _mm_unpackhi_epi8(Pairs01, Pairs01) );
+        _mm_storeu_si128( (__m128i*) (pRow + rkParams.DstPitch * 2),    _mm_unpacklo_epi8(Pairs23, Pairs23) );
+        _mm_storeu_si128( (__m128i*) (pRow + rkParams.DstPitch * 3),    _mm_unpackhi_epi8(Pairs23, Pairs23) );
+    }
+#else
+    for (uint32 Row = 0; Row < 8; Row++)
+    {
+        uint8 *pRow = pDst + (Row * rkParams.DstPitch);
+
+        for (uint32 ByteIdx = 0; ByteIdx < 4; ByteIdx++)
+        {
+            uint8 Byte = *pkSrc++;
+            uint8 High = CTextureDecoder::Extend4to8(Byte >> 4);
+            uint8 Low = CTextureDecoder::Extend4to8(Byte);
+            pRow[0] = High;
+            pRow[1] = High;
+            pRow[2] = Low;
+            pRow[3] = Low;
+            pRow += 4;
+        }
+    }
+#endif
+}
+
+static void PartialDecodeBlockI8(const uint8 *pkSrc, uint8 *pDst, const SBlockDecodeParams& rkParams)
+{
+    // 8x4 block; each pixel is written twice
+#if TEXTURE_DECODE_SSE2
+    for (uint32 Half = 0; Half < 2; Half++)
+    {
+        __m128i Src = _mm_loadu_si128( (const __m128i*) (pkSrc + (Half * 16)) );
+        uint8 *pRow = pDst + (Half * 2 * rkParams.DstPitch);
+        _mm_storeu_si128( (__m128i*) (pRow),                        _mm_unpacklo_epi8(Src, Src) );
+        _mm_storeu_si128( (__m128i*) (pRow + rkParams.DstPitch),    _mm_unpackhi_epi8(Src, Src) );
+    }
+#else
+    for (uint32 Row = 0; Row < 4; Row++)
+    {
+        uint8 *pRow = pDst + (Row * rkParams.DstPitch);
+
+        for (uint32 Col = 0; Col < 8; Col++)
+        {
+            pRow[0] = *pkSrc;
+            pRow[1] = *pkSrc++;
+            pRow += 2;
+        }
+    }
+#endif
+}
+
+static void PartialDecodeBlockIA4(const uint8 *pkSrc, uint8 *pDst, const SBlockDecodeParams& rkParams)
+{
+    // 8x4 block; output is a native-endian short with luminance in the high byte and alpha in the low byte
+#if TEXTURE_DECODE_SSE2
+    const __m128i kLowNibble = _mm_set1_epi8(0xF);
+
+    for (uint32 Half = 0; Half < 2; Half++)
+    {
+        __m128i Src = _mm_loadu_si128( (const __m128i*) (pkSrc + (Half * 16)) );
+        __m128i Alpha = ExtendNibbles( _mm_and_si128(_mm_srli_epi16(Src, 4), kLowNibble) );
+        __m128i Lum = ExtendNibbles( _mm_and_si128(Src, kLowNibble) );
+
+        uint8 *pRow = pDst + (Half * 2 * rkParams.DstPitch);
+        _mm_storeu_si128( (__m128i*) (pRow),                        _mm_unpacklo_epi8(Alpha, Lum) );
+        _mm_storeu_si128( (__m128i*) (pRow + rkParams.DstPitch),    _mm_unpackhi_epi8(Alpha, Lum) );
+    }
+#else
+    for (uint32 Row = 0; Row < 4; Row++)
+    {
+        uint8 *pRow = pDst + (Row * rkParams.DstPitch);
+
+        for (uint32 Col = 0; Col < 8; Col++)
+        {
+            uint8 Byte = *pkSrc++;
+            uint8 Alpha = CTextureDecoder::Extend4to8(Byte >> 4);
+            uint8 Lum = CTextureDecoder::Extend4to8(Byte);
+            StoreNative16(pRow, (uint16) ((Lum << 8) | Alpha));
+            pRow += 2;
+        }
+    }
+#endif
+}
+
+static void PartialDecodeBlockSwap16(const uint8 *pkSrc, uint8 *pDst, const SBlockDecodeParams& rkParams)
+{
+    // 4x4 block of big-endian shorts that are used as-is (IA8 and RGB565)
+#if TEXTURE_DECODE_SSE2
+    for (uint32 Half = 0; Half < 2; Half++)
+    {
+        __m128i Src = ByteSwap16( _mm_loadu_si128( (const __m128i*) (pkSrc + (Half * 16)) ) );
+        uint8 *pRow = pDst + (Half * 2 * rkParams.DstPitch);
+        _mm_storel_epi64( (__m128i*) (pRow),                        Src );
+        _mm_storel_epi64( (__m128i*) (pRow + rkParams.DstPitch),    _mm_srli_si128(Src, 8) );
+    }
+#else
+    for (uint32 Row = 0; Row < 4; Row++)
+    {
+        uint8 *pRow = pDst + (Row * rkParams.DstPitch);
+
+        for (uint32 Col = 0; Col < 4; Col++)
+        {
+            StoreNative16(pRow, ReadBE16(pkSrc));
+            pkSrc += 2;
+            pRow += 2;
+        }
+    }
+#endif
+}
+
+static inline uint32 PartialDecodePixelRGB5A3(uint16 Pixel)
+{
+    uint8 R, G, B, A;
+
+    if (Pixel & 0x8000) // RGB5
+    {
+        B = CTextureDecoder::Extend5to8(Pixel >> 10);
+        G = CTextureDecoder::Extend5to8(Pixel >>  5);
+        R = CTextureDecoder::Extend5to8(Pixel >>  0);
+        A = 255;
+    }
+
+    else // RGB4A3
+    {
+        A = CTextureDecoder::Extend3to8(Pixel >> 12);
+        B = CTextureDecoder::Extend4to8(Pixel >>  8);
+        G = CTextureDecoder::Extend4to8(Pixel >>  4);
+        R = CTextureDecoder::Extend4to8(Pixel >>  0);
+    }
+
+    return MakeARGB(A, R, G, B);
+}
+
+static void PartialDecodeBlockRGB5A3(const uint8 *pkSrc, uint8 *pDst, const SBlockDecodeParams& rkParams)
+{
+    // 4x4 block; converted to 32-bit
+#if TEXTURE_DECODE_SSE2
+    const __m128i k3Bits = _mm_set1_epi16(0x7);
+    const __m128i k4Bits = _mm_set1_epi16(0xF);
+    const __m128i k5Bits = _mm_set1_epi16(0x1F);
+    const __m128i kOpaque = _mm_set1_epi16(0xFF);
+
+    for (uint32 Half = 0; Half < 2; Half++)
+    {
+        __m128i Src = ByteSwap16( _mm_loadu_si128( (const __m128i*) (pkSrc + (Half * 16)) ) );
+        __m128i IsRGB5 = _mm_srai_epi16(Src, 15);
+
+        // RGB5
+        __m128i R5 = _mm_and_si128(Src, k5Bits);
+        __m128i G5 = _mm_and_si128(_mm_srli_epi16(Src, 5), k5Bits);
+        __m128i B5 = _mm_and_si128(_mm_srli_epi16(Src, 10), k5Bits);
+        R5 = _mm_or_si128( _mm_slli_epi16(R5, 3), _mm_srli_epi16(R5, 2) );
+        G5 = _mm_or_si128( _mm_slli_epi16(G5, 3), _mm_srli_epi16(G5, 2) );
+        B5 = _mm_or_si128( _mm_slli_epi16(B5, 3), _mm_srli_epi16(B5, 2) );
+
+        // RGB4A3
+        __m128i R4 = _mm_and_si128(Src, k4Bits);
+        __m128i G4 = _mm_and_si128(_mm_srli_epi16(Src, 4), k4Bits);
+        __m128i B4 = _mm_and_si128(_mm_srli_epi16(Src, 8), k4Bits);
+        __m128i A3 = _mm_and_si128(_mm_srli_epi16(Src, 12), k3Bits);
+        R4 = _mm_or_si128( _mm_slli_epi16(R4, 4), R4 );
+        G4 = _mm_or_si128( _mm_slli_epi16(G4, 4), G4 );
+        B4 = _mm_or_si128( _mm_slli_epi16(B4, 4), B4 );
+        A3 = _mm_or_si128( _mm_or_si128(_mm_slli_epi16(A3, 5), _mm_slli_epi16(A3, 2)), _mm_srli_epi16(A3, 1) );
+
+        __m128i R = Select(IsRGB5, R5, R4);
+        __m128i G = Select(IsRGB5, G5, G4);
+        __m128i B = Select(IsRGB5, B5, B4);
+        __m128i A = Select(IsRGB5, kOpaque, A3);
+
+        // Interleave into (A << 24) | (R << 16) | (G << 8) | B
+        __m128i GB = _mm_or_si128( B, _mm_slli_epi16(G, 8) );
+        __m128i AR = _mm_or_si128( R, _mm_slli_epi16(A, 8) );
+
+        uint8 *pRow = pDst + (Half * 2 * rkParams.DstPitch);
+        _mm_storeu_si128( (__m128i*) (pRow),                        _mm_unpacklo_epi16(GB, AR) );
+        _mm_storeu_si128( (__m128i*) (pRow + rkParams.DstPitch),    _mm_unpackhi_epi16(GB, AR) );
+    }
+#else
+    for (uint32 Row = 0; Row < 4; Row++)
+    {
+        uint8 *pRow = pDst + (Row * rkParams.DstPitch);
+
+        for (uint32 Col = 0; Col < 4; Col++)
+        {
+            StoreNative32(pRow, PartialDecodePixelRGB5A3( ReadBE16(pkSrc) ));
+            pkSrc += 2;
+            pRow += 4;
+        }
+    }
+#endif
+}
+
+static void PartialDecodeBlockRGBA8(const uint8 *pkSrc, uint8 *pDst, const SBlockDecodeParams& rkParams)
+{
+    // 4x4 block stored as 32 bytes of AR pairs followed by 32 bytes of GB pairs
+#if TEXTURE_DECODE_SSE2
+    for (uint32 Half = 0; Half < 2; Half++)
+    {
+        __m128i AR = ByteSwap16( _mm_loadu_si128( (const __m128i*) (pkSrc + (Half * 16)) ) );
+        __m128i GB = ByteSwap16( _mm_loadu_si128( (const __m128i*) (pkSrc + 32 + (Half * 16)) ) );
+
+        uint8 *pRow = pDst + (Half * 2 * rkParams.DstPitch);
+        _mm_storeu_si128( (__m128i*) (pRow),                        _mm_unpacklo_epi16(GB, AR) );
+        _mm_storeu_si128( (__m128i*) (pRow + rkParams.DstPitch),    _mm_unpackhi_epi16(GB, AR) );
+    }
+#else
+    for (uint32 PixelIdx = 0; PixelIdx < 16; PixelIdx++)
+    {
+        uint32 AR = ReadBE16(pkSrc + (PixelIdx * 2));
+        uint32 GB = ReadBE16(pkSrc + 32 + (PixelIdx * 2));
+        uint8 *pPixel = pDst + ((PixelIdx / 4) * rkParams.DstPitch) + ((PixelIdx % 4) * 4);
+        StoreNative32(pPixel, (AR << 16) | GB);
+    }
+#endif
+}
+
+static void PartialDecodeBlockCMPR(const uint8 *pkSrc, uint8 *pDst, const SBlockDecodeParams& rkParams)
+{
+    // Four 4x4 sub-blocks, each of which is treated as a single 8-byte pixel in a 2x2 block.
+    // Colors are byteswapped and the index bit pairs in each byte are reversed, to match DXT1.
+    for (uint32 SubBlockIdx = 0; SubBlockIdx < 4; SubBlockIdx++)
+    {
+        uint8 *pSubBlock = pDst + ((SubBlockIdx / 2) * rkParams.DstPitch) + ((SubBlockIdx % 2) * 8);
+        StoreNative16(pSubBlock + 0, ReadBE16(pkSrc + 0));
+        StoreNative16(pSubBlock + 2, ReadBE16(pkSrc + 2));
+
+        uint32 Indices;
+        memcpy(&Indices, pkSrc + 4, sizeof(uint32));
+        Indices = ((Indices & 0x03030303) << 6) | ((Indices & 0x0C0C0C0C) << 2) |
+                  ((Indices & 0x30303030) >> 2) | ((Indices & 0xC0C0C0C0) >> 6);
+        memcpy(pSubBlock + 4, &Indices, sizeof(uint32));
+
+        pkSrc += 8;
+    }
+}
+
+static void PartialDecodeBlockC4(const uint8 *pkSrc, uint8 *pDst, const SBlockDecodeParams& rkParams)
+{
+    // 8x8 block. See ReadPixelsC4; each pair of pixels is written as two 32-bit values at the position of
+    // the first pixel, so with a 16-bit pixel stride, pairs overlap. Pairs are written in the same order as
+    // the reference decode so the result is identical.
+    for (uint32 Row = 0; Row < 8; Row++)
+    {
+        uint8 *pPair = pDst + (Row * rkParams.DstPitch);
+
+        for (uint32 ByteIdx = 0; ByteIdx < 4; ByteIdx++)
+        {
+            uint8 Byte = *pkSrc++;
+            StoreNative32(pPair + 0, rkParams.pkPalette[Byte >> 4]);
+            StoreNative32(pPair + 4, rkParams.pkPalette[Byte & 0xF]);
+            pPair += rkParams.DstPixelStride * 2;
+        }
+    }
+}
+
+static void PartialDecodeBlockC8(const uint8 *pkSrc, uint8 *pDst, const SBlockDecodeParams& rkParams)
+{
+    // 8x4 block; palette entries are either 16-bit or 32-bit depending on the palette format
+    for (uint32 Row = 0; Row < 4; Row++)
+    {
+        uint8 *pRow = pDst + (Row * rkParams.DstPitch);
+
+        if (rkParams.DstPixelStride == 4)
+        {
+            for (uint32 Col = 0; Col < 8; Col++)
+                StoreNative32(pRow + (Col * 4), rkParams.pkPalette[*pkSrc++]);
+        }
+        else
+        {
+            for (uint32 Col = 0; Col < 8; Col++)
+                StoreNative16(pRow + (Col * 2), (uint16) rkParams.pkPalette[*pkSrc++]);
+        }
+    }
+}
+
+// ************ BLOCK DECODE (FULL) ************
+// These decode to 32-bit ARGB, the same layout as CColor::ToLongARGB().
+static inline uint32 FullDecodePixelIA8(uint16 Pixel)
+{
+    uint32 Lum = Pixel & 0xFF;
+    return MakeARGB(Pixel >> 8, Lum, Lum, Lum);
+}
+
+static inline uint32 FullDecodePixelRGB565(uint16 Pixel)
+{
+    return MakeARGB( 0xFF,
+                     CTextureDecoder::Extend5to8( (uint8) (Pixel >> 11) ),
+                     CTextureDecoder::Extend6to8( (uint8) (Pixel >> 5) ),
+                     CTextureDecoder::Extend5to8( (uint8) Pixel ) );
+}
+
+static inline uint32 FullDecodePixelRGB5A3(uint16 Pixel)
+{
+    if (Pixel & 0x8000) // RGB5
+    {
+        return MakeARGB( 0xFF,
+                         CTextureDecoder::Extend5to8( (uint8) (Pixel >> 10) ),
+                         CTextureDecoder::Extend5to8( (uint8) (Pixel >> 5) ),
+                         CTextureDecoder::Extend5to8( (uint8) Pixel ) );
+    }
+    else // RGB4A3
+    {
+        return MakeARGB( CTextureDecoder::Extend3to8( (uint8) (Pixel >> 12) ),
+                         CTextureDecoder::Extend4to8( (uint8) (Pixel >> 8) ),
+                         CTextureDecoder::Extend4to8( (uint8) (Pixel >> 4) ),
+                         CTextureDecoder::Extend4to8( (uint8) Pixel ) );
+    }
+}
+
+static void FullDecodeBlockI4(const uint8 *pkSrc, uint8 *pDst, const SBlockDecodeParams& rkParams)
+{
+    for (uint32 Row = 0; Row < 8; Row++)
+    {
+        uint8 *pRow = pDst + (Row * rkParams.DstPitch);
+
+        for (uint32 ByteIdx = 0; ByteIdx < 4; ByteIdx++)
+        {
+            uint8 Byte = *pkSrc++;
+            uint32 High = CTextureDecoder::Extend4to8(Byte >> 4);
+            uint32 Low = CTextureDecoder::Extend4to8(Byte);
+            StoreNative32(pRow + 0, MakeARGB(0xFF, High, High, High));
+            StoreNative32(pRow + 4, MakeARGB(0xFF, Low, Low, Low));
+            pRow += 8;
+        }
+    }
+}
+
+static void FullDecodeBlockI8(const uint8 *pkSrc, uint8 *pDst, const SBlockDecodeParams& rkParams)
+{
+    for (uint32 Row = 0; Row < 4; Row++)
+    {
+        uint8 *pRow = pDst + (Row * rkParams.DstPitch);
+
+        for (uint32 Col = 0; Col < 8; Col++)
+        {
+            uint32 Lum = *pkSrc++;
+            StoreNative32(pRow + (Col * 4), MakeARGB(0xFF, Lum, Lum, Lum));
+        }
+    }
+}
+
+static void FullDecodeBlockIA4(const uint8 *pkSrc, uint8 *pDst, const SBlockDecodeParams& rkParams)
+{
+    for (uint32 Row = 0; Row < 4; Row++)
+    {
+        uint8 *pRow = pDst + (Row * rkParams.DstPitch);
+
+        for (uint32 Col = 0; Col < 8; Col++)
+        {
+            uint8 Byte = *pkSrc++;
+            uint32 Alpha = CTextureDecoder::Extend4to8(Byte >> 4);
+            uint32 Lum = CTextureDecoder::Extend4to8(Byte);
+            StoreNative32(pRow + (Col * 4), MakeARGB(Alpha, Lum, Lum, Lum));
+        }
+    }
+}
+
+template<uint32 (*DecodePixel)(uint16)>
+static void FullDecodeBlock16(const uint8 *pkSrc, uint8 *pDst, const SBlockDecodeParams& rkParams)
+{
+    // 4x4 block of big-endian 16-bit pixels
+    for (uint32 Row = 0; Row < 4; Row++)
+    {
+        uint8 *pRow = pDst + (Row * rkParams.DstPitch);
+
+        for (uint32 Col = 0; Col < 4; Col++)
+        {
+            StoreNative32(pRow + (Col * 4), DecodePixel( ReadBE16(pkSrc) ));
+            pkSrc += 2;
+        }
+    }
+}
+
+static void FullDecodeBlockRGBA8(const uint8 *pkSrc, uint8 *pDst, const SBlockDecodeParams& rkParams)
+{
+    for (uint32 PixelIdx = 0; PixelIdx < 16; PixelIdx++)
+    {
+        const uint8 *pkAR = pkSrc + (PixelIdx * 2);
+        const uint8 *pkGB = pkSrc + 32 + (PixelIdx * 2);
+        uint8 *pPixel = pDst + ((PixelIdx / 4) * rkParams.DstPitch) + ((PixelIdx % 4) * 4);
+        StoreNative32(pPixel, MakeARGB(pkAR[0], pkAR[1], pkGB[0], pkGB[1]));
+    }
+}
+
+static void FullDecodeBlockCMPR(const uint8 *pkSrc, uint8 *pDst, const SBlockDecodeParams& rkParams)
+{
+    // 8x8 block made of four 4x4 DXT1-like sub-blocks
+    for (uint32 SubBlockIdx = 0; SubBlockIdx < 4; SubBlockIdx++)
+    {
+        uint8 *pSubBlock = pDst + ((SubBlockIdx / 2) * 4 * rkParams.DstPitch) + ((SubBlockIdx % 2) * 16);
+        uint16 ColorA = ReadBE16(pkSrc + 0);
+        uint16 ColorB = ReadBE16(pkSrc + 2);
+
+        uint32 Palette[4];
+        Palette[0] = FullDecodePixelRGB565(ColorA);
+        Palette[1] = FullDecodePixelRGB565(ColorB);
+
+        if (ColorA > ColorB)
+        {
+            Palette[2] = 0xFF000000;
+            Palette[3] = 0xFF000000;
+
+            for (uint32 Shift = 0; Shift < 24; Shift += 8)
+            {
+                uint32 A = (Palette[0] >> Shift) & 0xFF;
+                uint32 B = (Palette[1] >> Shift) & 0xFF;
+                Palette[2] |= (((A * 2) + B) / 3) << Shift;
+                Palette[3] |= ((A + (B * 2)) / 3) << Shift;
+            }
+        }
+        else
+        {
+            Palette[2] = 0xFF000000;
+            Palette[3] = 0;
+
+            for (uint32 Shift = 0; Shift < 24; Shift += 8)
+            {
+                uint32 A = (Palette[0] >> Shift) & 0xFF;
+                uint32 B = (Palette[1] >> Shift) & 0xFF;
+                Palette[2] |= ((A + B) / 2) << Shift;
+            }
+        }
+
+        for (uint32 Row = 0; Row < 4; Row++)
+        {
+            uint8 Indices = pkSrc[4 + Row];
+            uint8 *pRow = pSubBlock + (Row * rkParams.DstPitch);
+
+            for (uint32 Col = 0; Col < 4; Col++)
+                StoreNative32(pRow + (Col * 4), Palette[(Indices >> (6 - (Col * 2))) & 0x3]);
+        }
+
+        pkSrc += 8;
+    }
+}
+
+static void FullDecodeBlockC4(const uint8 *pkSrc, uint8 *pDst, const SBlockDecodeParams& rkParams)
+{
+    for (uint32 Row = 0; Row < 8; Row++)
+    {
+        uint8 *pRow = pDst + (Row * rkParams.DstPitch);
+
+        for (uint32 ByteIdx = 0; ByteIdx < 4; ByteIdx++)
+        {
+            uint8 Byte = *pkSrc++;
+            StoreNative32(pRow + 0, rkParams.pkPalette[Byte >> 4]);
+            StoreNative32(pRow + 4, rkParams.pkPalette[Byte & 0xF]);
+            pRow += 8;
+        }
+    }
+}
+
+static void FullDecodeBlockC8(const uint8 *pkSrc, uint8 *pDst, const SBlockDecodeParams& rkParams)
+{
+    for (uint32 Row = 0; Row < 4; Row++)
+    {
+        uint8 *pRow = pDst + (Row * rkParams.DstPitch);
+
+        for (uint32 Col = 0; Col < 8; Col++)
+            StoreNative32(pRow + (Col * 4), rkParams.pkPalette[*pkSrc++]);
+    }
+}
+
 // ************ DECODE ************
-void CTextureDecoder::PartialDecodeGXTexture(IInputStream& TXTR)
+// Shared block loop for the partial and full GX decodes. Blocks are decoded in the same order they're
+// stored in, and the decode stops early if the image data ends partway through (see below).
+static void DecodeGXBlocks(const std::vector<uint8>& rkSrc, uint8 *pDst, uint32 DstSize,
+                           ETexelFormat Format, uint32 Width, uint32 Height, uint32 NumMipMaps,
+                           FBlockDecodeFunc pDecodeBlock, SBlockDecodeParams Params,
+                           uint32 DstRowsPerPixel, float MipBytesPerPixel)
 {
+    if (!pDecodeBlock) return;
+
+    uint32 MipW = Width, MipH = Height;
+    uint32 MipOffset = 0;
+    uint32 SrcOffset = 0;
+
+    uint32 BWidth = gskBlockWidth[(int) Format];
+    uint32 BHeight = gskBlockHeight[(int) Format];
+    uint32 SrcBlockSize = gskSourceBlockSize[(int) Format];
+
+    // With CMPR, we're using a little trick.
+    // CMPR stores pixels in 8x8 blocks, with four 4x4 subblocks.
+    // An easy way to convert it is to pretend each block is 2x2 and each subblock is one pixel.
+    // So to do that we need to calculate the "new" dimensions of the image, 1/4 the size of the original.
+    if (Format == ETexelFormat::GX_CMPR)
+    {
+        MipW /= 4;
+        MipH /= 4;
+    }
+
+    // The last block may be cut off; this is due to a mistake Retro made in their cooker for I8 textures
+    // where very small mipmaps are cut off early. This affects one texture that I know of - Echoes 3bb2c034.TXTR
+    // The cut-off block is decoded from a zero-padded copy and the decode stops after it.
+    uint8 PaddedBlock[64];
+
+    for (uint32 iMip = 0; iMip < NumMipMaps; iMip++)
+    {
+        if (MipW < BWidth) MipW = BWidth;
+        if (MipH < BHeight) MipH = BHeight;
+
+        Params.DstPitch = MipW * Params.DstPixelStride;
+        uint32 BlockDstSize = ((BHeight * DstRowsPerPixel) - 1) * Params.DstPitch + (BWidth * Params.DstPixelStride);
+
+        for (uint32 iBlockY = 0; iBlockY < MipH; iBlockY += BHeight)
+        {
+            for (uint32 iBlockX = 0; iBlockX < MipW; iBlockX += BWidth)
+            {
+                if (SrcOffset >= rkSrc.size())
+                    return;
+
+                uint32 DstOffset = MipOffset + (iBlockY * DstRowsPerPixel * Params.DstPitch) + (iBlockX * Params.DstPixelStride);
+                if (DstOffset + BlockDstSize > DstSize)
+                    return;
+
+                const uint8 *pkBlock = &rkSrc[SrcOffset];
+
+                if (SrcOffset + SrcBlockSize > rkSrc.size())
+                {
+                    uint32 Remaining = rkSrc.size() - SrcOffset;
+                    memset(PaddedBlock, 0, sizeof(PaddedBlock));
+                    memcpy(PaddedBlock, pkBlock, Remaining);
+                    pkBlock = PaddedBlock;
+                }
+
+                pDecodeBlock(pkBlock, pDst + DstOffset, Params);
+                SrcOffset += SrcBlockSize;
+            }
+        }
+
+        MipOffset += (uint32) (MipW * MipH * MipBytesPerPixel);
+        MipW /= 2;
+        MipH /= 2;
+    }
+}
+
+void CTextureDecoder::PartialDecodeGXTexture(IInputStream& rTXTR)
+{
+    // Decodes whole blocks straight from memory. Output matches PartialDecodeGXTextureReference.
+    std::vector<uint8> ImageData = ReadImageData(rTXTR);
+
+    mDataBufferSize = ImageData.size() * (gskOutputBpp[(int) mTexelFormat] / gskSourceBpp[(int) mTexelFormat]);
+    if ((mHasPalettes) && (mPaletteFormat == EGXPaletteFormat::RGB5A3)) mDataBufferSize *= 2;
+    mpDataBuffer = new uint8[mDataBufferSize + gskDecodeBufferPadding]();
+
+    SBlockDecodeParams Params;
+    Params.DstPitch = 0;
+    Params.DstPixelStride = gskOutputPixelStride[(int) mTexelFormat];
+    Params.pkPalette = nullptr;
+
+    if (mHasPalettes && (mPaletteFormat == EGXPaletteFormat::RGB5A3))
+        Params.DstPixelStride = 4;
+
+    // Choose the block decoder once for the whole texture
+    FBlockDecodeFunc pDecodeBlock = nullptr;
+    uint32 Palette[256];
+
+    switch (mTexelFormat)
+    {
+    case ETexelFormat::GX_I4:       pDecodeBlock = &PartialDecodeBlockI4;       break;
+    case ETexelFormat::GX_I8:       pDecodeBlock = &PartialDecodeBlockI8;       break;
+    case ETexelFormat::GX_IA4:      pDecodeBlock = &PartialDecodeBlockIA4;      break;
+    case ETexelFormat::GX_IA8:      pDecodeBlock = &PartialDecodeBlockSwap16;   break;
+    case ETexelFormat::GX_RGB565:   pDecodeBlock = &PartialDecodeBlockSwap16;   break;
+    case ETexelFormat::GX_RGB5A3:   pDecodeBlock = &PartialDecodeBlockRGB5A3;   break;
+    case ETexelFormat::GX_RGBA8:    pDecodeBlock = &PartialDecodeBlockRGBA8;    break;
+    case ETexelFormat::GX_CMPR:     pDecodeBlock = &PartialDecodeBlockCMPR;     break;
+
+    case ETexelFormat::GX_C4:
+        // Font texture workaround; see ReadPixelsC4. Each index bit maps to one channel.
+        for (uint32 iIdx = 0; iIdx < 16; iIdx++)
+        {
+            uint32 R = (iIdx & 0x8) ? 0xFF : 0x0;
+            uint32 G = (iIdx & 0x4) ? 0xFF : 0x0;
+            uint32 B = (iIdx & 0x2) ? 0xFF : 0x0;
+            uint32 A = (iIdx & 0x1) ? 0xFF : 0x0;
+            Palette[iIdx] = (R << 24) | (G << 16) | (B << 8) | A;
+        }
+
+        Params.pkPalette = Palette;
+        pDecodeBlock = &PartialDecodeBlockC4;
+        break;
+
+    case ETexelFormat::GX_C8:
+        for (uint32 iIdx = 0; iIdx < 256; iIdx++)
+        {
+            uint16 Entry = ReadBE16(&mPalettes[iIdx * 2]);
+            Palette[iIdx] = (mPaletteFormat == EGXPaletteFormat::RGB5A3 ? PartialDecodePixelRGB5A3(Entry) : Entry);
+        }
+
+        Params.pkPalette = Palette;
+
+        if (mPaletteFormat == EGXPaletteFormat::IA8 ||
+            mPaletteFormat == EGXPaletteFormat::RGB565 ||
+            mPaletteFormat == EGXPaletteFormat::RGB5A3)
+        {
+            pDecodeBlock = &PartialDecodeBlockC8;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    float MipBytesPerPixel = gskPixelsToBytes[(int) mTexelFormat];
+    if (mTexelFormat == ETexelFormat::GX_CMPR) MipBytesPerPixel *= 16; // Since we're pretending the image is 1/4 its actual size, we have to multiply the size by 16 to get the correct offset
+
+    DecodeGXBlocks(ImageData, mpDataBuffer, mDataBufferSize, mTexelFormat, mWidth, mHeight, mNumMipMaps,
+                   pDecodeBlock, Params, 1, MipBytesPerPixel);
+}
+
+void CTextureDecoder::PartialDecodeGXTextureReference(IInputStream& TXTR)
+{
+    // Original per-pixel stream decode. Kept as the reference for the block decoders; see NCoreTests::BenchmarkTextureDecode.
     // TODO: This function doesn't handle very small mipmaps correctly.
     // The format applies padding when the size of a mipmap is less than the block size for that format.
     // The decode needs to be adjusted to account for the padding and skip over it (since we don't have padding in OpenGL).
@@ -216,7 +934,7 @@ void CTextureDecoder::PartialDecodeGXTexture(IInputStream& TXTR)
 
     mDataBufferSize = ImageSize * (gskOutputBpp[(int) mTexelFormat] / gskSourceBpp[(int) mTexelFormat]);
     if ((mHasPalettes) && (mPaletteFormat == EGXPaletteFormat::RGB5A3)) mDataBufferSize *= 2;
-    mpDataBuffer = new uint8[mDataBufferSize];
+    mpDataBuffer = new uint8[mDataBufferSize + gskDecodeBufferPadding]();
 
     CMemoryOutStream Out(mpDataBuffer, mDataBufferSize, EEndian::SystemEndian);
 
@@ -299,87 +1017,63 @@ void CTextureDecoder::PartialDecodeGXTexture(IInputStream& TXTR)
 
 void CTextureDecoder::FullDecodeGXTexture(IInputStream& rTXTR)
 {
-    // Get image data size, create output buffer
-    uint32 ImageStart = rTXTR.Tell();
-    rTXTR.Seek(0x0, SEEK_END);
-    uint32 ImageSize = rTXTR.Tell() - ImageStart;
-    rTXTR.Seek(ImageStart, SEEK_SET);
+    std::vector<uint8> ImageData = ReadImageData(rTXTR);
 
-    mDataBufferSize = ImageSize * (32 / gskSourceBpp[(int) mTexelFormat]);
-    mpDataBuffer = new uint8[mDataBufferSize];
+    mDataBufferSize = ImageData.size() * (32 / gskSourceBpp[(int) mTexelFormat]);
+    mpDataBuffer = new uint8[mDataBufferSize]();
 
-    CMemoryOutStream Out(mpDataBuffer, mDataBufferSize, EEndian::SystemEndian);
+    SBlockDecodeParams Params;
+    Params.DstPitch = 0;
+    Params.DstPixelStride = 4;
+    Params.pkPalette = nullptr;
 
-    // Initializing more stuff before we start the mipmap loop
-    uint32 MipW = mWidth, MipH = mHeight;
-    uint32 MipOffset = 0;
-
-    uint32 BWidth = gskBlockWidth[(int) mTexelFormat];
-    uint32 BHeight = gskBlockHeight[(int) mTexelFormat];
+    FBlockDecodeFunc pDecodeBlock = nullptr;
+    uint32 DstRowsPerPixel = 1;
+    float MipBytesPerPixel = 4.f;
+    uint32 Palette[256];
 
-    // With CMPR, we're using a little trick.
-    // CMPR stores pixels in 8x8 blocks, with four 4x4 subblocks.
-    // An easy way to convert it is to pretend each block is 2x2 and each subblock is one pixel.
-    // So to do that we need to calculate the "new" dimensions of the image, 1/4 the size of the original.
-    if (mTexelFormat == ETexelFormat::GX_CMPR)
+    switch (mTexelFormat)
     {
-        MipW /= 4;
-        MipH /= 4;
-    }
+    case ETexelFormat::GX_I4:       pDecodeBlock = &FullDecodeBlockI4;                                break;
+    case ETexelFormat::GX_I8:       pDecodeBlock = &FullDecodeBlockI8;                                break;
+    case ETexelFormat::GX_IA4:      pDecodeBlock = &FullDecodeBlockIA4;                               break;
+    case ETexelFormat::GX_IA8:      pDecodeBlock = &FullDecodeBlock16<&FullDecodePixelIA8>;           break;
+    case ETexelFormat::GX_RGB565:   pDecodeBlock = &FullDecodeBlock16<&FullDecodePixelRGB565>;        break;
+    case ETexelFormat::GX_RGB5A3:   pDecodeBlock = &FullDecodeBlock16<&FullDecodePixelRGB5A3>;        break;
+    case ETexelFormat::GX_RGBA8:    pDecodeBlock = &FullDecodeBlockRGBA8;                             break;
+
+    case ETexelFormat::GX_CMPR:
+        // Each CMPR "pixel" is a 4x4 subblock; see DecodeGXBlocks
+        pDecodeBlock = &FullDecodeBlockCMPR;
+        Params.DstPixelStride = 16;
+        DstRowsPerPixel = 4;
+        MipBytesPerPixel = 64.f;
+        break;
 
-    for (uint32 iMip = 0; iMip < mNumMipMaps; iMip++)
+    case ETexelFormat::GX_C4:
+    case ETexelFormat::GX_C8:
     {
-        for (uint32 iBlockY = 0; iBlockY < MipH; iBlockY += BHeight)
-            for (uint32 iBlockX = 0; iBlockX < MipW; iBlockX += BWidth) {
-                for (uint32 iImgY = iBlockY; iImgY < iBlockY + BHeight; iImgY++) {
-                    for (uint32 iImgX = iBlockX; iImgX < iBlockX + BWidth; iImgX++)
-                    {
-                        uint32 DstPos = (mTexelFormat == ETexelFormat::GX_CMPR) ? ((iImgY * (MipW * 4)) + iImgX) * 16 : ((iImgY * MipW) + iImgX) * 4;
-                        Out.Seek(MipOffset + DstPos, SEEK_SET);
+        uint32 NumEntries = mPalettes.size() / 2;
+        uint32 (*pDecodeEntry)(uint16) = nullptr;
 
-                        // I4/C4/CMPR require reading more than one pixel at a time
-                        if (mTexelFormat == ETexelFormat::GX_I4)
-                        {
-                            uint8 Byte = rTXTR.ReadByte();
-                            Out.WriteLong( DecodePixelI4(Byte, 0).ToLongARGB() );
-                            Out.WriteLong( DecodePixelI4(Byte, 1).ToLongARGB() );
-                        }
-                        else if (mTexelFormat == ETexelFormat::GX_C4)
-                        {
-                            uint8 Byte = rTXTR.ReadByte();
-                            Out.WriteLong( DecodePixelC4(Byte, 0, mPaletteInput).ToLongARGB() );
-                            Out.WriteLong( DecodePixelC4(Byte, 1, mPaletteInput).ToLongARGB() );
-                        }
-                        else if (mTexelFormat == ETexelFormat::GX_CMPR) DecodeSubBlockCMPR(rTXTR, Out, (uint16) (MipW * 4));
-
-                        else
-                        {
-                            CColor Pixel;
-
-                            if (mTexelFormat == ETexelFormat::GX_I8)          Pixel = DecodePixelI8(rTXTR.ReadByte());
-                            else if (mTexelFormat == ETexelFormat::GX_IA4)    Pixel = DecodePixelIA4(rTXTR.ReadByte());
-                            else if (mTexelFormat == ETexelFormat::GX_IA8)    Pixel = DecodePixelIA8(rTXTR.ReadShort());
-                            else if (mTexelFormat == ETexelFormat::GX_C8)     Pixel = DecodePixelC8(rTXTR.ReadByte(), mPaletteInput);
-                            else if (mTexelFormat == ETexelFormat::GX_RGB565) Pixel = DecodePixelRGB565(rTXTR.ReadShort());
-                            else if (mTexelFormat == ETexelFormat::GX_RGB5A3) Pixel = DecodePixelRGB5A3(rTXTR.ReadShort());
-                            else if (mTexelFormat == ETexelFormat::GX_RGBA8)  Pixel = CColor(rTXTR, true);
-
-                            Out.WriteLong(Pixel.ToLongARGB());
-                        }
-                    }
-                }
-                if (mTexelFormat == ETexelFormat::GX_RGBA8) rTXTR.Seek(0x20, SEEK_CUR);
-            }
+        if (mPaletteFormat == EGXPaletteFormat::IA8)            pDecodeEntry = &FullDecodePixelIA8;
+        else if (mPaletteFormat == EGXPaletteFormat::RGB565)    pDecodeEntry = &FullDecodePixelRGB565;
+        else if (mPaletteFormat == EGXPaletteFormat::RGB5A3)    pDecodeEntry = &FullDecodePixelRGB5A3;
 
-        uint32 MipSize = MipW * MipH * 4;
-        if (mTexelFormat == ETexelFormat::GX_CMPR) MipSize *= 16;
+        for (uint32 iIdx = 0; iIdx < NumEntries; iIdx++)
+            Palette[iIdx] = (pDecodeEntry ? pDecodeEntry( ReadBE16(&mPalettes[iIdx * 2]) ) : 0);
 
-        MipOffset += MipSize;
-        MipW /= 2;
-        MipH /= 2;
-        if (MipW < BWidth) MipW = BWidth;
-        if (MipH < BHeight) MipH = BHeight;
+        Params.pkPalette = Palette;
+        pDecodeBlock = (mTexelFormat == ETexelFormat::GX_C4 ? &FullDecodeBlockC4 : &FullDecodeBlockC8);
+        break;
+    }
+
+    default:
+        break;
     }
+
+    DecodeGXBlocks(ImageData, mpDataBuffer, mDataBufferSize, mTexelFormat, mWidth, mHeight, mNumMipMaps,
+                   pDecodeBlock, Params, DstRowsPerPixel, MipBytesPerPixel);
 }
 
 void CTextureDecoder::DecodeDDS(IInputStream& rDDS)
@@ -627,53 +1321,6 @@ void CTextureDecoder::ReadSubBlockCMPR(IInputStream& rSrc, IOutputStream& rDst)
 }
 
 // ************ DECODE PIXELS (FULL DECODE TO RGBA8) ************
-CColor CTextureDecoder::DecodePixelI4(uint8 Byte, uint8 WhichPixel)
-{
-    if (WhichPixel == 1) Byte >>= 4;
-    uint8 Pixel = Extend4to8(Byte);
-    return CColor::Integral(Pixel, Pixel, Pixel);
-}
-
-CColor CTextureDecoder::DecodePixelI8(uint8 Byte)
-{
-    return CColor::Integral(Byte, Byte, Byte);
-}
-
-CColor CTextureDecoder::DecodePixelIA4(uint8 Byte)
-{
-    uint8 Alpha = Extend4to8(Byte >> 4);
-    uint8 Lum = Extend4to8(Byte);
-    return CColor::Integral(Lum, Lum, Lum, Alpha);
-}
-
-CColor CTextureDecoder::DecodePixelIA8(uint16 Short)
-{
-    uint8 Alpha = (Short >> 8) & 0xFF;
-    uint8 Lum = Short & 0xFF;
-    return CColor::Integral(Lum, Lum, Lum, Alpha);
-}
-
-CColor CTextureDecoder::DecodePixelC4(uint8 Byte, uint8 WhichPixel, IInputStream& rPaletteStream)
-{
-    if (WhichPixel == 1) Byte >>= 4;
-    Byte &= 0xF;
-
-    rPaletteStream.Seek(Byte * 2, SEEK_SET);
-    if (mPaletteFormat == EGXPaletteFormat::IA8)         return DecodePixelIA8(rPaletteStream.ReadShort());
-    else if (mPaletteFormat == EGXPaletteFormat::RGB565) return DecodePixelIA8(rPaletteStream.ReadShort());
-    else if (mPaletteFormat == EGXPaletteFormat::RGB5A3) return DecodePixelIA8(rPaletteStream.ReadShort());
-    else return CColor::skTransparentBlack;
-}
-
-CColor CTextureDecoder::DecodePixelC8(uint8 Byte, IInputStream& rPaletteStream)
-{
-    rPaletteStream.Seek(Byte * 2, SEEK_SET);
-    if (mPaletteFormat == EGXPaletteFormat::IA8)         return DecodePixelIA8(rPaletteStream.ReadShort());
-    else if (mPaletteFormat == EGXPaletteFormat::RGB565) return DecodePixelIA8(rPaletteStream.ReadShort());
-    else if (mPaletteFormat == EGXPaletteFormat::RGB5A3) return DecodePixelIA8(rPaletteStream.ReadShort());
-    else return CColor::skTransparentBlack;
-}
-
 CColor CTextureDecoder::DecodePixelRGB565(uint16 Short)
 {
     uint8 B = Extend5to8( (uint8) (Short >> 11) );
@@ -682,61 +1329,6 @@ CColor CTextureDecoder::DecodePixelRGB565(uint16 Short)
     return CColor::Integral(R, G, B, 0xFF);
 }
 
-CColor CTextureDecoder::DecodePixelRGB5A3(uint16 Short)
-{
-    if (Short & 0x8000) // RGB5
-    {
-        uint8 B = Extend5to8( (uint8) (Short >> 10));
-        uint8 G = Extend5to8( (uint8) (Short >> 5));
-        uint8 R = Extend5to8( (uint8) (Short) );
-        return CColor::Integral(R, G, B, 0xFF);
-    }
-
-    else // RGB4A3
-    {
-        uint8 A = Extend3to8( (uint8) (Short >> 12) );
-        uint8 B = Extend4to8( (uint8) (Short >> 8) );
-        uint8 G = Extend4to8( (uint8) (Short >> 4) );
-        uint8 R = Extend4to8( (uint8) (Short) );
-        return CColor::Integral(R, G, B, A);
-    }
-}
-
-void CTextureDecoder::DecodeSubBlockCMPR(IInputStream& rSrc, IOutputStream& rDst, uint16 Width)
-{
-    CColor Palettes[4];
-    uint16 PaletteA = rSrc.ReadShort();
-    uint16 PaletteB = rSrc.ReadShort();
-    Palettes[0] = DecodePixelRGB565(PaletteA);
-    Palettes[1] = DecodePixelRGB565(PaletteB);
-
-    if (PaletteA > PaletteB)
-    {
-        Palettes[2] = (Palettes[0] * 0.666666666f) + (Palettes[1] * 0.333333333f);
-        Palettes[3] = (Palettes[0] * 0.333333333f) + (Palettes[1] * 0.666666666f);
-    }
-    else
-    {
-        Palettes[2] = (Palettes[0] * 0.5f) + (Palettes[1] * 0.5f);
-        Palettes[3] = CColor::skTransparentBlack;
-    }
-
-    for (uint32 iBlockY = 0; iBlockY < 4; iBlockY++)
-    {
-        uint8 Byte = rSrc.ReadByte();
-
-        for (uint32 iBlockX = 0; iBlockX < 4; iBlockX++)
-        {
-            uint8 Shift = (uint8) (6 - (iBlockX * 2));
-            uint8 PaletteIndex = (Byte >> Shift) & 0x3;
-            CColor Pixel = Palettes[PaletteIndex];
-            rDst.WriteLong(Pixel.ToLongARGB());
-        }
-
-        rDst.Seek((Width - 4) * 4, SEEK_CUR);
-    }
-}
-
 void CTextureDecoder::DecodeBlockBC1(IInputStream& rSrc, IOutputStream& rDst, uint32 Width)
 {
     // Very similar to the CMPR subblock function, but unfortunately a slight
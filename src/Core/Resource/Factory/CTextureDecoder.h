@@ -44,6 +44,7 @@ class CTextureDecoder
 
     // Decode
     void PartialDecodeGXTexture(IInputStream& rTXTR);
+    void PartialDecodeGXTextureReference(IInputStream& rTXTR);
     void FullDecodeGXTexture(IInputStream& rTXTR);
     void DecodeDDS(IInputStream& rDDS);
 
@@ -60,16 +61,7 @@ class CTextureDecoder
     void ReadSubBlockCMPR(IInputStream& rSrc, IOutputStream& rDst);
 
     // Decode Pixels (convert to RGBA8)
-    CColor DecodePixelI4(uint8 Byte, uint8 WhichPixel);
-    CColor DecodePixelI8(uint8 Byte);
-    CColor DecodePixelIA4(uint8 Byte);
-    CColor DecodePixelIA8(uint16 Short);
-    CColor DecodePixelC4(uint8 Byte, uint8 WhichPixel, IInputStream& rPaletteStream);
-    CColor DecodePixelC8(uint8 Byte, IInputStream& rPaletteStream);
     CColor DecodePixelRGB565(uint16 Short);
-    CColor DecodePixelRGB5A3(uint16 Short);
-    CColor DecodePixelRGBA8(IInputStream& rSrc, IOutputStream& rDst);
-    void DecodeSubBlockCMPR(IInputStream& rSrc, IOutputStream& rDst, uint16 Width);
 
     void DecodeBlockBC1(IInputStream& rSrc, IOutputStream& rDst, uint32 Width);
     void DecodeBlockBC2(IInputStream& rSrc, IOutputStream& rDst, uint32 Width);
@@ -79,6 +71,7 @@ class CTextureDecoder
     // Static
 public:
     static CTexture* LoadTXTR(IInputStream& rTXTR, CResourceEntry *pEntry);
+    static CTexture* LoadTXTRReference(IInputStream& rTXTR, CResourceEntry *pEntry);
     static CTexture* LoadDDS(IInputStream& rDDS, CResourceEntry *pEntry);
     static CTexture* DoFullDecode(IInputStream& rTXTR, CResourceEntry *pEntry);
     static CTexture* DoFullDecode(CTexture *pTexture);
@@ -0,0 +1,380 @@
+#include "CSurfaceRayTree.h"
+#include "SSurface.h"
+#include <Common/Math/MathUtil.h>
+#include <algorithm>
+#include <limits>
+
+// SSE is part of the x86-64 baseline, so the triangle tests can use it without any runtime checks
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define SURFACE_RAY_TREE_SSE 1
+#include <xmmintrin.h>
+#else
+#define SURFACE_RAY_TREE_SSE 0
+#endif
+
+namespace
+{
+
+/** Triangles per leaf; two packets */
+const uint32 gkMaxLeafTriangles = 8;
+
+/** Same epsilon as Math::RayTriangleIntersection */
+const float gkEpsilon = 0.000001f;
+
+/** Ray/box slab test. Returns whether the ray enters the box before MaxDist, and where it enters. */
+inline bool RayHitsBox(const float *pkMin, const float *pkMax, const float *pkOrigin, const float *pkInvDir, float MaxDist, float& rOutEntry)
+{
+    float TMin = -std::numeric_limits<float>::infinity();
+    float TMax = std::numeric_limits<float>::infinity();
+
+    for (uint32 Axis = 0; Axis < 3; Axis++)
+    {
+        float T1 = (pkMin[Axis] - pkOrigin[Axis]) * pkInvDir[Axis];
+        float T2 = (pkMax[Axis] - pkOrigin[Axis]) * pkInvDir[Axis];
+        TMin = Math::Max(TMin, Math::Min(T1, T2));
+        TMax = Math::Min(TMax, Math::Max(T1, T2));
+    }
+
+    // Written so that NaNs (from a ray lying exactly on a box face) count as a hit rather than a miss
+    rOutEntry = TMin;
+    return !(TMax < 0.f || TMin > TMax || TMin > MaxDist);
+}
+
+}
+
+CSurfaceRayTree::CSurfaceRayTree(const SSurface& rkSurface)
+    : mNumTriangles(0)
+{
+    // Unpack every primitive into a flat triangle list, with the same winding the brute force test used
+    std::vector<STriangle> Triangles;
+    Triangles.reserve(rkSurface.TriangleCount);
+
+    for (const SSurface::SPrimitive& rkPrim : rkSurface.Primitives)
+    {
+        const std::vector<CVertex>& rkVerts = rkPrim.Vertices;
+        uint32 NumVerts = rkVerts.size();
+
+        if (rkPrim.Type == EPrimitiveType::Triangles || rkPrim.Type == EPrimitiveType::TriangleFan || rkPrim.Type == EPrimitiveType::TriangleStrip)
+        {
+            if (NumVerts < 3) continue;
+            uint32 NumTris = (rkPrim.Type == EPrimitiveType::Triangles ? NumVerts / 3 : NumVerts - 2);
+
+            for (uint32 TriIdx = 0; TriIdx < NumTris; TriIdx++)
+            {
+                STriangle Tri;
+
+                if (rkPrim.Type == EPrimitiveType::Triangles)
+                {
+                    Tri.Vertices[0] = rkVerts[TriIdx * 3].Position;
+                    Tri.Vertices[1] = rkVerts[TriIdx * 3 + 1].Position;
+                    Tri.Vertices[2] = rkVerts[TriIdx * 3 + 2].Position;
+                }
+
+                else if (rkPrim.Type == EPrimitiveType::TriangleFan)
+                {
+                    Tri.Vertices[0] = rkVerts[0].Position;
+                    Tri.Vertices[1] = rkVerts[TriIdx + 1].Position;
+                    Tri.Vertices[2] = rkVerts[TriIdx + 2].Position;
+                }
+
+                else if (TriIdx & 0x1)
+                {
+                    Tri.Vertices[0] = rkVerts[TriIdx + 2].Position;
+                    Tri.Vertices[1] = rkVerts[TriIdx + 1].Position;
+                    Tri.Vertices[2] = rkVerts[TriIdx].Position;
+                }
+
+                else
+                {
+                    Tri.Vertices[0] = rkVerts[TriIdx].Position;
+                    Tri.Vertices[1] = rkVerts[TriIdx + 1].Position;
+                    Tri.Vertices[2] = rkVerts[TriIdx + 2].Position;
+                }
+
+                CVector3f Centroid = (Tri.Vertices[0] + Tri.Vertices[1] + Tri.Vertices[2]) / 3.f;
+                Tri.Centroid[0] = Centroid.X;
+                Tri.Centroid[1] = Centroid.Y;
+                Tri.Centroid[2] = Centroid.Z;
+                Triangles.push_back(Tri);
+            }
+        }
+
+        else if (rkPrim.Type == EPrimitiveType::Lines || rkPrim.Type == EPrimitiveType::LineStrip)
+        {
+            if (NumVerts < 2) continue;
+            uint32 NumLines = (rkPrim.Type == EPrimitiveType::Lines ? NumVerts / 2 : NumVerts - 1);
+
+            for (uint32 LineIdx = 0; LineIdx < NumLines; LineIdx++)
+            {
+                uint32 Index = (rkPrim.Type == EPrimitiveType::Lines ? LineIdx * 2 : LineIdx);
+                mLineVertices.push_back(rkVerts[Index].Position);
+                mLineVertices.push_back(rkVerts[Index + 1].Position);
+            }
+        }
+    }
+
+    mNumTriangles = Triangles.size();
+
+    if (!Triangles.empty())
+    {
+        // Median splits leave 4-8 triangles in each leaf, so there are at most N/4 leaves
+        uint32 MaxLeaves = (mNumTriangles + 3) / 4;
+        mNodes.reserve(MaxLeaves * 2);
+        mPackets.reserve(MaxLeaves * 2);
+        BuildNode(Triangles, 0, mNumTriangles);
+    }
+}
+
+std::pair<bool,float> CSurfaceRayTree::IntersectsRay(const CRay& rkRay, bool AllowBackfaces, float LineThreshold) const
+{
+    bool Hit = false;
+    float HitDist = std::numeric_limits<float>::max();
+
+    if (!mNodes.empty())
+    {
+        CVector3f Origin = rkRay.Origin();
+        CVector3f Dir = rkRay.Direction();
+
+        // Division by zero gives infinity here, which the slab test handles correctly
+        float OriginArr[3] = { Origin.X, Origin.Y, Origin.Z };
+        float InvDir[3] = { 1.f / Dir.X, 1.f / Dir.Y, 1.f / Dir.Z };
+
+        // Median splits keep the depth well below this for any triangle count that fits in memory
+        uint32 Stack[64];
+        uint32 StackSize = 0;
+        float Entry;
+
+        if (RayHitsBox(mNodes[0].Min, mNodes[0].Max, OriginArr, InvDir, HitDist, Entry))
+            Stack[StackSize++] = 0;
+
+        while (StackSize > 0)
+        {
+            uint32 NodeIdx = Stack[--StackSize];
+            const SNode& rkNode = mNodes[NodeIdx];
+
+            // Parents are tested before they're pushed, but a closer hit may have been found since then
+            if (!RayHitsBox(rkNode.Min, rkNode.Max, OriginArr, InvDir, HitDist, Entry))
+                continue;
+
+            if (rkNode.NumPackets > 0)
+            {
+                for (uint32 PacketIdx = 0; PacketIdx < rkNode.NumPackets; PacketIdx++)
+                {
+                    if (TestPacket(mPackets[rkNode.Index + PacketIdx], Origin, Dir, AllowBackfaces, HitDist))
+                        Hit = true;
+                }
+            }
+
+            else
+            {
+                // Push the farther child first so the nearer one is visited first, and can cull the other one
+                uint32 ChildA = NodeIdx + 1;
+                uint32 ChildB = rkNode.Index;
+                float EntryA, EntryB;
+                bool HitA = RayHitsBox(mNodes[ChildA].Min, mNodes[ChildA].Max, OriginArr, InvDir, HitDist, EntryA);
+                bool HitB = RayHitsBox(mNodes[ChildB].Min, mNodes[ChildB].Max, OriginArr, InvDir, HitDist, EntryB);
+
+                if (HitA && HitB)
+                {
+                    bool AFirst = !(EntryB < EntryA);
+                    Stack[StackSize++] = (AFirst ? ChildB : ChildA);
+                    Stack[StackSize++] = (AFirst ? ChildA : ChildB);
+                }
+                else if (HitA)
+                    Stack[StackSize++] = ChildA;
+                else if (HitB)
+                    Stack[StackSize++] = ChildB;
+            }
+        }
+    }
+
+    // Lines are rare and only show up on small editor models, so they don't get a tree
+    for (uint32 VertIdx = 0; VertIdx + 1 < mLineVertices.size(); VertIdx += 2)
+    {
+        std::pair<bool,float> Result = Math::RayLineIntersection(rkRay, mLineVertices[VertIdx], mLineVertices[VertIdx + 1], LineThreshold);
+
+        if (Result.first && (!Hit || Result.second < HitDist))
+        {
+            Hit = true;
+            HitDist = Result.second;
+        }
+    }
+
+    return std::pair<bool,float>(Hit, HitDist);
+}
+
+// ************ PROTECTED ************
+uint32 CSurfaceRayTree::BuildNode(std::vector<STriangle>& rTriangles, uint32 Begin, uint32 End)
+{
+    uint32 NodeIdx = mNodes.size();
+    mNodes.emplace_back();
+
+    CAABox Bounds = CAABox::skInfinite;
+    CAABox CentroidBounds = CAABox::skInfinite;
+
+    for (uint32 TriIdx = Begin; TriIdx < End; TriIdx++)
+    {
+        const STriangle& rkTri = rTriangles[TriIdx];
+        Bounds.ExpandBounds(rkTri.Vertices[0]);
+        Bounds.ExpandBounds(rkTri.Vertices[1]);
+        Bounds.ExpandBounds(rkTri.Vertices[2]);
+        CentroidBounds.ExpandBounds(CVector3f(rkTri.Centroid[0], rkTri.Centroid[1], rkTri.Centroid[2]));
+    }
+
+    CVector3f Min = Bounds.Min(), Max = Bounds.Max();
+    SNode& rNode = mNodes[NodeIdx];
+    rNode.Min[0] = Min.X; rNode.Min[1] = Min.Y; rNode.Min[2] = Min.Z;
+    rNode.Max[0] = Max.X; rNode.Max[1] = Max.Y; rNode.Max[2] = Max.Z;
+
+    uint32 Count = End - Begin;
+
+    if (Count <= gkMaxLeafTriangles)
+    {
+        rNode.Index = mPackets.size();
+        rNode.NumPackets = (Count + 3) / 4;
+
+        for (uint32 TriIdx = Begin; TriIdx < End; TriIdx += 4)
+            AddPacket(&rTriangles[TriIdx], std::min<uint32>(4, End - TriIdx));
+
+        return NodeIdx;
+    }
+
+    // Split at the median centroid along the longest axis
+    CVector3f Extent = CentroidBounds.Size();
+    uint32 Axis = (Extent.X >= Extent.Y && Extent.X >= Extent.Z ? 0 : (Extent.Y >= Extent.Z ? 1 : 2));
+    uint32 Mid = Begin + (Count / 2);
+
+    std::nth_element(rTriangles.begin() + Begin, rTriangles.begin() + Mid, rTriangles.begin() + End,
+                     [Axis](const STriangle& rkLeft, const STriangle& rkRight) { return rkLeft.Centroid[Axis] < rkRight.Centroid[Axis]; });
+
+    // The first child is always built right after its parent; rNode may be invalidated by the recursion
+    BuildNode(rTriangles, Begin, Mid);
+    uint32 SecondChild = BuildNode(rTriangles, Mid, End);
+
+    mNodes[NodeIdx].Index = SecondChild;
+    mNodes[NodeIdx].NumPackets = 0;
+    return NodeIdx;
+}
+
+void CSurfaceRayTree::AddPacket(const STriangle *pkTriangles, uint32 NumTriangles)
+{
+    // Unused lanes are left as zero-area triangles, which the ray test always rejects
+    STrianglePacket Packet = {};
+
+    for (uint32 Lane = 0; Lane < NumTriangles; Lane++)
+    {
+        const STriangle& rkTri = pkTriangles[Lane];
+        CVector3f EdgeA = rkTri.Vertices[1] - rkTri.Vertices[0];
+        CVector3f EdgeB = rkTri.Vertices[2] - rkTri.Vertices[0];
+
+        Packet.VtxX[Lane] = rkTri.Vertices[0].X;
+        Packet.VtxY[Lane] = rkTri.Vertices[0].Y;
+        Packet.VtxZ[Lane] = rkTri.Vertices[0].Z;
+        Packet.EdgeAX[Lane] = EdgeA.X;
+        Packet.EdgeAY[Lane] = EdgeA.Y;
+        Packet.EdgeAZ[Lane] = EdgeA.Z;
+        Packet.EdgeBX[Lane] = EdgeB.X;
+        Packet.EdgeBY[Lane] = EdgeB.Y;
+        Packet.EdgeBZ[Lane] = EdgeB.Z;
+    }
+
+    mPackets.push_back(Packet);
+}
+
+bool CSurfaceRayTree::TestPacket(const STrianglePacket& rkPacket, const CVector3f& rkOrigin, const CVector3f& rkDir, bool AllowBackfaces, float& rBestDist)
+{
+    // Moller-Trumbore against four triangles at once; same math and rejection rules as Math::RayTriangleIntersection
+#if SURFACE_RAY_TREE_SSE
+    const __m128 kZero = _mm_setzero_ps();
+    const __m128 kOne = _mm_set1_ps(1.f);
+    const __m128 kEpsilon = _mm_set1_ps(gkEpsilon);
+
+    __m128 DirX = _mm_set1_ps(rkDir.X), DirY = _mm_set1_ps(rkDir.Y), DirZ = _mm_set1_ps(rkDir.Z);
+    __m128 EdgeAX = _mm_load_ps(rkPacket.EdgeAX), EdgeAY = _mm_load_ps(rkPacket.EdgeAY), EdgeAZ = _mm_load_ps(rkPacket.EdgeAZ);
+    __m128 EdgeBX = _mm_load_ps(rkPacket.EdgeBX), EdgeBY = _mm_load_ps(rkPacket.EdgeBY), EdgeBZ = _mm_load_ps(rkPacket.EdgeBZ);
+
+    // P = Dir x EdgeB
+    __m128 PX = _mm_sub_ps(_mm_mul_ps(DirY, EdgeBZ), _mm_mul_ps(DirZ, EdgeBY));
+    __m128 PY = _mm_sub_ps(_mm_mul_ps(DirZ, EdgeBX), _mm_mul_ps(DirX, EdgeBZ));
+    __m128 PZ = _mm_sub_ps(_mm_mul_ps(DirX, EdgeBY), _mm_mul_ps(DirY, EdgeBX));
+    __m128 Det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(EdgeAX, PX), _mm_mul_ps(EdgeAY, PY)), _mm_mul_ps(EdgeAZ, PZ));
+
+    // Near-zero determinants mean the ray is parallel to the triangle; negative ones mean it hits the back face
+    __m128 Mask = _mm_cmpge_ps(Det, kEpsilon);
+
+    if (AllowBackfaces)
+        Mask = _mm_or_ps(Mask, _mm_cmple_ps(Det, _mm_sub_ps(kZero, kEpsilon)));
+
+    if (_mm_movemask_ps(Mask) == 0)
+        return false;
+
+    __m128 InvDet = _mm_div_ps(kOne, Det);
+
+    // T = Origin - Vtx
+    __m128 TX = _mm_sub_ps(_mm_set1_ps(rkOrigin.X), _mm_load_ps(rkPacket.VtxX));
+    __m128 TY = _mm_sub_ps(_mm_set1_ps(rkOrigin.Y), _mm_load_ps(rkPacket.VtxY));
+    __m128 TZ = _mm_sub_ps(_mm_set1_ps(rkOrigin.Z), _mm_load_ps(rkPacket.VtxZ));
+
+    __m128 U = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(TX, PX), _mm_mul_ps(TY, PY)), _mm_mul_ps(TZ, PZ)), InvDet);
+    Mask = _mm_and_ps(Mask, _mm_and_ps(_mm_cmpge_ps(U, kZero), _mm_cmple_ps(U, kOne)));
+
+    // Q = T x EdgeA
+    __m128 QX = _mm_sub_ps(_mm_mul_ps(TY, EdgeAZ), _mm_mul_ps(TZ, EdgeAY));
+    __m128 QY = _mm_sub_ps(_mm_mul_ps(TZ, EdgeAX), _mm_mul_ps(TX, EdgeAZ));
+    __m128 QZ = _mm_sub_ps(_mm_mul_ps(TX, EdgeAY), _mm_mul_ps(TY, EdgeAX));
+
+    __m128 V = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(DirX, QX), _mm_mul_ps(DirY, QY)), _mm_mul_ps(DirZ, QZ)), InvDet);
+    Mask = _mm_and_ps(Mask, _mm_and_ps(_mm_cmpge_ps(V, kZero), _mm_cmple_ps(_mm_add_ps(U, V), kOne)));
+
+    __m128 Dist = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(EdgeBX, QX), _mm_mul_ps(EdgeBY, QY)), _mm_mul_ps(EdgeBZ, QZ)), InvDet);
+    Mask = _mm_and_ps(Mask, _mm_and_ps(_mm_cmpgt_ps(Dist, kEpsilon), _mm_cmplt_ps(Dist, _mm_set1_ps(rBestDist))));
+
+    int HitMask = _mm_movemask_ps(Mask);
+    if (HitMask == 0) return false;
+
+    alignas(16) float Dists[4];
+    _mm_store_ps(Dists, Dist);
+
+    for (uint32 Lane = 0; Lane < 4; Lane++)
+    {
+        if ((HitMask & (1 << Lane)) && Dists[Lane] < rBestDist)
+            rBestDist = Dists[Lane];
+    }
+
+    return true;
+
+#else
+    bool Hit = false;
+
+    for (uint32 Lane = 0; Lane < 4; Lane++)
+    {
+        CVector3f EdgeA(rkPacket.EdgeAX[Lane], rkPacket.EdgeAY[Lane], rkPacket.EdgeAZ[Lane]);
+        CVector3f EdgeB(rkPacket.EdgeBX[Lane], rkPacket.EdgeBY[Lane], rkPacket.EdgeBZ[Lane]);
+
+        CVector3f P = rkDir.Cross(EdgeB);
+        float Det = EdgeA.Dot(P);
+
+        if (!(Det >= gkEpsilon || (AllowBackfaces && Det <= -gkEpsilon)))
+            continue;
+
+        float InvDet = 1.f / Det;
+        CVector3f T = rkOrigin - CVector3f(rkPacket.VtxX[Lane], rkPacket.VtxY[Lane], rkPacket.VtxZ[Lane]);
+        float U = T.Dot(P) * InvDet;
+        if (U < 0.f || U > 1.f) continue;
+
+        CVector3f Q = T.Cross(EdgeA);
+        float V = rkDir.Dot(Q) * InvDet;
+        if (V < 0.f || U + V > 1.f) continue;
+
+        float Dist = EdgeB.Dot(Q) * InvDet;
+
+        if (Dist > gkEpsilon && Dist < rBestDist)
+        {
+            rBestDist = Dist;
+            Hit = true;
+        }
+    }
+
+    return Hit;
+#endif
+}
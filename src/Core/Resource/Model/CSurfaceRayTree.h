@@ -0,0 +1,66 @@
+#ifndef CSURFACERAYTREE_H
+#define CSURFACERAYTREE_H
+
+#include <Common/BasicTypes.h>
+#include <Common/Math/CRay.h>
+#include <Common/Math/CVector3f.h>
+#include <utility>
+#include <vector>
+
+struct SSurface;
+
+/**
+ * Ray test acceleration structure for a single surface. The surface's strips and fans are
+ * unpacked into a flat triangle list once, and the triangles are sorted into a bounding
+ * volume hierarchy so a ray test only visits the triangles near the ray.
+ *
+ * Triangles are stored four at a time as one vertex and two edges, with each component in
+ * its own array, so the ray test can check a whole group of four at once with SIMD. Each
+ * leaf holds up to two groups.
+ *
+ * Built from the surface's vertices as they are when it's constructed; it doesn't see any
+ * later changes to them.
+ */
+class CSurfaceRayTree
+{
+    struct alignas(16) STrianglePacket
+    {
+        float VtxX[4], VtxY[4], VtxZ[4];
+        float EdgeAX[4], EdgeAY[4], EdgeAZ[4];
+        float EdgeBX[4], EdgeBY[4], EdgeBZ[4];
+    };
+
+    struct SNode
+    {
+        float Min[3];
+        float Max[3];
+        uint32 Index;       // Leaves: first packet. Inner nodes: second child; the first child is always the next node.
+        uint32 NumPackets;  // 0 for inner nodes
+    };
+
+    struct STriangle
+    {
+        CVector3f Vertices[3];
+        float Centroid[3];
+    };
+
+    std::vector<SNode> mNodes;
+    std::vector<STrianglePacket> mPackets;
+    std::vector<CVector3f> mLineVertices; // Two per line
+    uint32 mNumTriangles;
+
+public:
+    explicit CSurfaceRayTree(const SSurface& rkSurface);
+    std::pair<bool,float> IntersectsRay(const CRay& rkRay, bool AllowBackfaces, float LineThreshold) const;
+
+    // Accessors
+    inline uint32 NumTriangles() const  { return mNumTriangles; }
+    inline uint32 NumNodes() const      { return mNodes.size(); }
+
+protected:
+    uint32 BuildNode(std::vector<STriangle>& rTriangles, uint32 Begin, uint32 End);
+    void AddPacket(const STriangle *pkTriangles, uint32 NumTriangles);
+    static bool TestPacket(const STrianglePacket& rkPacket, const CVector3f& rkOrigin, const CVector3f& rkDir, bool AllowBackfaces, float& rBestDist);
+};
+
+#endif // CSURFACERAYTREE_H
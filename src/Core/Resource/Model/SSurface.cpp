@@ -4,13 +4,21 @@
 #include <Common/Math/MathUtil.h>
 
 std::pair<bool,float> SSurface::IntersectsRay(const CRay& rkRay, bool AllowBackfaces, float LineThreshold)
+{
+    if (!pRayTree)
+        pRayTree.reset(new CSurfaceRayTree(*this));
+
+    return pRayTree->IntersectsRay(rkRay, AllowBackfaces, LineThreshold);
+}
+
+std::pair<bool,float> SSurface::IntersectsRayReference(const CRay& rkRay, bool AllowBackfaces, float LineThreshold) const
 {
     bool Hit = false;
     float HitDist;
 
     for (uint32 iPrim = 0; iPrim < Primitives.size(); iPrim++)
     {
-        SPrimitive *pPrim = &Primitives[iPrim];
+        const SPrimitive *pPrim = &Primitives[iPrim];
         uint32 NumVerts = pPrim->Vertices.size();
 
         // Triangles
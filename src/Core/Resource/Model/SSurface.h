@@ -1,6 +1,7 @@
 #ifndef SSURFACE_H
 #define SSURFACE_H
 
+#include "CSurfaceRayTree.h"
 #include "CVertex.h"
 #include "Core/Resource/CMaterialSet.h"
 #include "Core/OpenGL/GLCommon.h"
@@ -10,6 +11,7 @@
 #include <Common/Math/CRay.h>
 #include <Common/Math/CTransform4f.h>
 #include <Common/Math/CVector3f.h>
+#include <memory>
 #include <vector>
 
 // Should prolly be a class
@@ -30,6 +32,9 @@ struct SSurface
     };
     std::vector<SPrimitive> Primitives;
 
+    // Built on the first ray test
+    std::unique_ptr<CSurfaceRayTree> pRayTree;
+
     SSurface()
     {
         VertexCount = 0;
@@ -37,6 +42,9 @@ struct SSurface
     }
 
     std::pair<bool,float> IntersectsRay(const CRay& rkRay, bool AllowBackfaces = false, float LineThreshold = 0.02f);
+
+    /** Tests every primitive directly without the ray tree; kept to validate and benchmark the tree against */
+    std::pair<bool,float> IntersectsRayReference(const CRay& rkRay, bool AllowBackfaces = false, float LineThreshold = 0.02f) const;
 };
 
 #endif // SSURFACE_H
@@ -1,11 +1,13 @@
 #include "CGameTemplate.h"
 #include "NPropertyMap.h"
+#include "Core/GameProject/CResourceStore.h"
 #include "Core/Resource/Factory/CWorldLoader.h"
 #include <Common/Log.h>
 
 CGameTemplate::CGameTemplate()
     : mFullyLoaded(false)
     , mDirty(false)
+    , mEditorAssetsLoaded(false)
 {
 }
 
@@ -158,6 +160,20 @@ CScriptTemplate* CGameTemplate::TemplateByID(const CFourCC& ObjectID)
     return TemplateByID(ObjectID.ToLong());
 }
 
+/** Load the editor store display assets of every script template. See CScriptTemplate::PreloadEditorAssets */
+void CGameTemplate::PreloadEditorAssets()
+{
+    if (mEditorAssetsLoaded || !gpEditorStore) return;
+
+    for (auto Iter = mScriptTemplates.begin(); Iter != mScriptTemplates.end(); Iter++)
+    {
+        if (Iter->second.pTemplate)
+            Iter->second.pTemplate->PreloadEditorAssets();
+    }
+
+    mEditorAssetsLoaded = true;
+}
+
 CScriptTemplate* CGameTemplate::TemplateByIndex(uint32 Index)
 {
     auto it = mScriptTemplates.begin();
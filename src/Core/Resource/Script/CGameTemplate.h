@@ -71,6 +71,7 @@ class CGameTemplate
     TString mSourceFile;
     bool mFullyLoaded;
     bool mDirty;
+    bool mEditorAssetsLoaded;
 
     /** Template arrays */
     std::map<SObjId,  SScriptTemplatePath>    mScriptTemplates;
@@ -89,6 +90,7 @@ public:
     void Load(const TString& kFilePath);
     void Save();
     void SaveGameTemplates(bool ForceAll = false);
+    void PreloadEditorAssets();
 
     uint32 GameVersion(TString VersionName);
     CScriptTemplate* TemplateByID(uint32 ObjectID);
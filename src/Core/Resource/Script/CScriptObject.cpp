@@ -1,6 +1,7 @@
 #include "CScriptObject.h"
 #include "CScriptLayer.h"
 #include "CGameTemplate.h"
+#include "Core/GameProject/CResourceLoadContext.h"
 #include "Core/Resource/Animation/CAnimSet.h"
 
 CScriptObject::CScriptObject(uint32 InstanceID, CGameArea *pArea, CScriptLayer *pLayer, CScriptTemplate *pTemplate)
@@ -12,7 +13,9 @@ CScriptObject::CScriptObject(uint32 InstanceID, CGameArea *pArea, CScriptLayer *
     , mHasInGameModel(false)
     , mIsCheckingNearVisibleActivation(false)
 {
-    mpTemplate->AddObject(this);
+    // Objects loaded on a worker thread aren't visible to the rest of the editor until their area is attached to its entry
+    if (!CResourceLoadContext::Current())
+        mpTemplate->AddObject(this);
 
     // Init properties
     CStructProperty* pProperties = pTemplate->Properties();
@@ -264,6 +264,26 @@ CResource* CScriptTemplate::FindDisplayAsset(void* pPropertyData, uint32& rOutCh
     return nullptr;
 }
 
+/**
+ * Load the display assets that come from the editor store. FindDisplayAsset loads them from
+ * gpEditorStore no matter which store the object belongs to, and loading a resource into the
+ * editor store can't be done from a worker thread, so this needs to be called before objects
+ * are loaded on worker threads. The assets are kept loaded from then on.
+ */
+void CScriptTemplate::PreloadEditorAssets()
+{
+    if (!gpEditorStore || !mEditorAssets.empty()) return;
+
+    for (const SEditorAsset& rkAsset : mAssets)
+    {
+        if (rkAsset.AssetType == SEditorAsset::EAssetType::Collision || rkAsset.AssetSource != SEditorAsset::EAssetSource::File)
+            continue;
+
+        CResource *pRes = gpEditorStore->LoadResource(rkAsset.AssetLocation);
+        if (pRes) mEditorAssets.push_back(pRes);
+    }
+}
+
 CCollisionMeshGroup* CScriptTemplate::FindCollision(void* pPropertyData)
 {
     for (auto it = mAssets.begin(); it != mAssets.end(); it++)
@@ -309,11 +329,13 @@ const std::list<CScriptObject*>& CScriptTemplate::ObjectList() const
 
 void CScriptTemplate::AddObject(CScriptObject *pObject)
 {
+    std::lock_guard<std::mutex> Lock(mObjectListMutex);
     mObjectList.push_back(pObject);
 }
 
 void CScriptTemplate::RemoveObject(CScriptObject *pObject)
 {
+    std::lock_guard<std::mutex> Lock(mObjectListMutex);
     for (auto it = mObjectList.begin(); it != mObjectList.end(); it++)
     {
         if (*it == pObject)
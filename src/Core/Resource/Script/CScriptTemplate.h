@@ -8,6 +8,7 @@
 #include <Common/BasicTypes.h>
 #include <Common/CFourCC.h>
 #include <list>
+#include <mutex>
 #include <vector>
 
 class CGameTemplate;
@@ -79,6 +80,7 @@ private:
     std::unique_ptr<CStructProperty> mpProperties;
     std::vector<SEditorAsset> mAssets;
     std::vector<SAttachment> mAttachments;
+    std::vector< TResPtr<CResource> > mEditorAssets; // File display assets, kept loaded once preloaded
 
     ERotationType mRotationType;
     EScaleType mScaleType;
@@ -102,6 +104,7 @@ private:
 
     CGameTemplate* mpGame;
     std::list<CScriptObject*> mObjectList;
+    std::mutex mObjectListMutex; // Areas may be loaded on several threads at once
 
     CStringProperty* mpNameProperty;
     CVectorProperty* mpPositionProperty;
@@ -143,6 +146,7 @@ public:
     float VolumeScale(CScriptObject *pObj);
     CResource* FindDisplayAsset(void* pPropertyData, uint32& rOutCharIndex, uint32& rOutAnimIndex, bool& rOutIsInGame);
     CCollisionMeshGroup* FindCollision(void* pPropertyData);
+    void PreloadEditorAssets();
 
     // Accessors
     inline CGameTemplate* GameTemplate() const              { return mpGame; }
@@ -11,6 +11,16 @@ CCollisionNode::CCollisionNode(CScene *pScene, uint32 NodeID, CSceneNode *pParen
     SetName("Collision");
 }
 
+void* CCollisionNode::operator new(size_t Size)
+{
+    return AllocatePooled<CCollisionNode>(Size);
+}
+
+void CCollisionNode::operator delete(void *pData, size_t Size)
+{
+    FreePooled<CCollisionNode>(pData, Size);
+}
+
 ENodeType CCollisionNode::NodeType()
 {
     return ENodeType::Collision;
@@ -121,6 +131,15 @@ SRayIntersection CCollisionNode::RayNodeIntersectTest(const CRay& /*rkRay*/, uin
     return Result;
 }
 
+bool CCollisionNode::ExpandSceneBounds(CAABox& rBounds)
+{
+    // Nothing to draw without collision
+    if (!mpCollision)
+        return true;
+
+    return CSceneNode::ExpandSceneBounds(rBounds);
+}
+
 void CCollisionNode::SetCollision(CCollisionMeshGroup *pCollision)
 {
     mpCollision = pCollision;
@@ -138,4 +157,6 @@ void CCollisionNode::SetCollision(CCollisionMeshGroup *pCollision)
             mLocalAABox.ExpandBounds(pMesh->Bounds());
         }
     }
+
+    MarkSceneBoundsChanged();
 }
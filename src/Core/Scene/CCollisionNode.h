@@ -10,11 +10,14 @@ class CCollisionNode : public CSceneNode
 
 public:
     CCollisionNode(CScene *pScene, uint32 NodeID, CSceneNode *pParent = 0, CCollisionMeshGroup *pCollision = 0);
+    static void* operator new(size_t Size);
+    static void operator delete(void *pData, size_t Size);
     ENodeType NodeType();
     void AddToRenderer(CRenderer *pRenderer, const SViewInfo& rkViewInfo);
     void Draw(FRenderOptions Options, int ComponentIndex, ERenderCommand Command, const SViewInfo& rkViewInfo);
     void RayAABoxIntersectTest(CRayCollisionTester& rTester, const SViewInfo& rkViewInfo);
     SRayIntersection RayNodeIntersectTest(const CRay& rkRay, uint32 AssetID, const SViewInfo& rkViewInfo);
+    bool ExpandSceneBounds(CAABox& rBounds);
     void SetCollision(CCollisionMeshGroup *pCollision);
 };
 
@@ -0,0 +1,242 @@
+#include "CLightGrid.h"
+#include "Core/Resource/Area/CGameArea.h"
+#include <Common/Macros.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+
+/** Upper limit on the grid resolution along each axis, to keep the cell arrays small */
+const uint32 gkMaxCellsPerAxis = 32;
+
+inline bool IsFinite(const CVector3f& rkVec)
+{
+    return std::isfinite(rkVec.X) && std::isfinite(rkVec.Y) && std::isfinite(rkVec.Z);
+}
+
+}
+
+CLightGrid::CLightGrid()
+    : mQueryStamp(0)
+{
+}
+
+void CLightGrid::Build(CGameArea *pArea)
+{
+    Clear();
+    if (!pArea) return;
+
+    mLayers.resize(pArea->NumLightLayers());
+
+    for (uint32 iLyr = 0; iLyr < mLayers.size(); iLyr++)
+    {
+        SLayer& rLayer = mLayers[iLyr];
+        rLayer.NumLights = pArea->NumLights(iLyr);
+        rLayer.AmbientColor = CColor::skBlack;
+
+        for (uint32 iLight = 0; iLight < rLayer.NumLights; iLight++)
+        {
+            CLight *pLight = pArea->Light(iLyr, iLight);
+
+            // Same as CSceneNode::BuildLightList; if there's more than one ambient light, the last one wins
+            if (pLight->Type() == ELightType::LocalAmbient)
+                rLayer.AmbientColor = pLight->Color();
+            else
+                rLayer.Lights.push_back(pLight);
+        }
+
+        BuildLayer(rLayer);
+    }
+}
+
+void CLightGrid::Clear()
+{
+    mLayers.clear();
+    mQueryStamp = 0;
+}
+
+void CLightGrid::FindLights(uint32 LayerIndex, const CAABox& rkBounds, std::vector<CLight*>& rOut)
+{
+    ASSERT(LayerIndex < mLayers.size());
+    SLayer& rLayer = mLayers[LayerIndex];
+    if (rLayer.Lights.empty()) return;
+
+    // Reset the stamps on the rare occasion the counter wraps around, so old stamps can't match
+    if (++mQueryStamp == 0)
+    {
+        for (SLayer& rOther : mLayers)
+            std::fill(rOther.QueryStamps.begin(), rOther.QueryStamps.end(), 0);
+
+        mQueryStamp = 1;
+    }
+
+    for (uint32 LightIdx : rLayer.UnbinnedLights)
+        rOut.push_back(rLayer.Lights[LightIdx]);
+
+    uint32 Min[3], Max[3];
+    CellRange(rLayer, rkBounds.Min(), rkBounds.Max(), Min, Max);
+
+    for (uint32 Z = Min[2]; Z <= Max[2]; Z++)
+    {
+        for (uint32 Y = Min[1]; Y <= Max[1]; Y++)
+        {
+            for (uint32 X = Min[0]; X <= Max[0]; X++)
+            {
+                uint32 CellIdx = (Z * rLayer.Dims[1] + Y) * rLayer.Dims[0] + X;
+
+                for (uint32 iLight = rLayer.CellStarts[CellIdx]; iLight < rLayer.CellStarts[CellIdx + 1]; iLight++)
+                {
+                    uint32 LightIdx = rLayer.CellLights[iLight];
+
+                    if (rLayer.QueryStamps[LightIdx] != mQueryStamp)
+                    {
+                        rLayer.QueryStamps[LightIdx] = mQueryStamp;
+                        rOut.push_back(rLayer.Lights[LightIdx]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void CLightGrid::BuildLayer(SLayer& rLayer)
+{
+    uint32 NumLights = rLayer.Lights.size();
+    rLayer.QueryStamps.assign(NumLights, 0);
+    rLayer.GridMin[0] = rLayer.GridMin[1] = rLayer.GridMin[2] = 0.f;
+    rLayer.InvCellSize = 1.f;
+    rLayer.Dims[0] = rLayer.Dims[1] = rLayer.Dims[2] = 1;
+
+    // Lights that can't be binned go straight into the unbinned list; the grid covers the positions of the rest
+    std::vector<uint32> Binnable;
+    std::vector<float> Radii;
+    float GridMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float GridMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+    for (uint32 iLight = 0; iLight < NumLights; iLight++)
+    {
+        CLight *pLight = rLayer.Lights[iLight];
+        CVector3f Position = pLight->Position();
+        float Radius = pLight->GetRadius();
+
+        if (!IsFinite(Position) || !std::isfinite(Radius))
+        {
+            rLayer.UnbinnedLights.push_back(iLight);
+            continue;
+        }
+
+        Binnable.push_back(iLight);
+        Radii.push_back(Radius);
+
+        float Coords[3] = { Position.X, Position.Y, Position.Z };
+
+        for (uint32 iAxis = 0; iAxis < 3; iAxis++)
+        {
+            GridMin[iAxis] = std::min(GridMin[iAxis], Coords[iAxis]);
+            GridMax[iAxis] = std::max(GridMax[iAxis], Coords[iAxis]);
+        }
+    }
+
+    if (!Binnable.empty())
+    {
+        // Aim for about one light per cell, but don't make cells smaller than a typical light,
+        // or each light ends up in a lot of cells
+        float Extent[3];
+        float Volume = 1.f;
+
+        for (uint32 iAxis = 0; iAxis < 3; iAxis++)
+        {
+            Extent[iAxis] = GridMax[iAxis] - GridMin[iAxis];
+            Volume *= std::max(Extent[iAxis], 1.f);
+        }
+
+        std::nth_element(Radii.begin(), Radii.begin() + Radii.size() / 2, Radii.end());
+        float MedianRadius = Radii[Radii.size() / 2];
+        float CellSize = std::max(std::cbrt(Volume / Binnable.size()), MedianRadius);
+        CellSize = std::max(CellSize, 1.f);
+
+        for (uint32 iAxis = 0; iAxis < 3; iAxis++)
+        {
+            float NumCells = std::ceil(Extent[iAxis] / CellSize);
+            rLayer.Dims[iAxis] = (uint32) std::min(std::max(NumCells, 1.f), (float) gkMaxCellsPerAxis);
+        }
+
+        std::copy(GridMin, GridMin + 3, rLayer.GridMin);
+        rLayer.InvCellSize = 1.f / CellSize;
+    }
+
+    // Bin the lights; count them per cell first, so the cell lists can be packed into one array
+    uint32 NumCells = rLayer.Dims[0] * rLayer.Dims[1] * rLayer.Dims[2];
+    rLayer.CellStarts.assign(NumCells + 1, 0);
+
+    std::vector<uint32> Ranges(Binnable.size() * 6);
+    uint32 NumBinned = 0;
+
+    for (uint32 iBin = 0; iBin < Binnable.size(); iBin++)
+    {
+        uint32 LightIdx = Binnable[iBin];
+        CLight *pLight = rLayer.Lights[LightIdx];
+        CVector3f Extent(pLight->GetRadius());
+        uint32 *pMin = &Ranges[iBin * 6];
+        uint32 *pMax = pMin + 3;
+        CellRange(rLayer, pLight->Position() - Extent, pLight->Position() + Extent, pMin, pMax);
+
+        uint32 NumCovered = (pMax[0] - pMin[0] + 1) * (pMax[1] - pMin[1] + 1) * (pMax[2] - pMin[2] + 1);
+
+        if (NumCovered > NumCells / 2)
+        {
+            rLayer.UnbinnedLights.push_back(LightIdx);
+            Binnable[iBin] = -1;
+            continue;
+        }
+
+        for (uint32 Z = pMin[2]; Z <= pMax[2]; Z++)
+            for (uint32 Y = pMin[1]; Y <= pMax[1]; Y++)
+                for (uint32 X = pMin[0]; X <= pMax[0]; X++)
+                    rLayer.CellStarts[(Z * rLayer.Dims[1] + Y) * rLayer.Dims[0] + X + 1]++;
+
+        NumBinned += NumCovered;
+    }
+
+    for (uint32 iCell = 0; iCell < NumCells; iCell++)
+        rLayer.CellStarts[iCell + 1] += rLayer.CellStarts[iCell];
+
+    rLayer.CellLights.resize(NumBinned);
+    std::vector<uint32> CellFill(rLayer.CellStarts.begin(), rLayer.CellStarts.end() - 1);
+
+    for (uint32 iBin = 0; iBin < Binnable.size(); iBin++)
+    {
+        if (Binnable[iBin] == -1) continue;
+        const uint32 *pkMin = &Ranges[iBin * 6];
+        const uint32 *pkMax = pkMin + 3;
+
+        for (uint32 Z = pkMin[2]; Z <= pkMax[2]; Z++)
+            for (uint32 Y = pkMin[1]; Y <= pkMax[1]; Y++)
+                for (uint32 X = pkMin[0]; X <= pkMax[0]; X++)
+                    rLayer.CellLights[CellFill[(Z * rLayer.Dims[1] + Y) * rLayer.Dims[0] + X]++] = Binnable[iBin];
+    }
+
+    // Keep the unbinned lights in layer order
+    std::sort(rLayer.UnbinnedLights.begin(), rLayer.UnbinnedLights.end());
+}
+
+void CLightGrid::CellRange(const SLayer& rkLayer, const CVector3f& rkMin, const CVector3f& rkMax, uint32 *pOutMin, uint32 *pOutMax) const
+{
+    // Clamping to the edge cells (rather than rejecting anything outside the grid) keeps this monotonic,
+    // so any two overlapping boxes always end up with overlapping cell ranges
+    float Min[3] = { rkMin.X, rkMin.Y, rkMin.Z };
+    float Max[3] = { rkMax.X, rkMax.Y, rkMax.Z };
+
+    for (uint32 iAxis = 0; iAxis < 3; iAxis++)
+    {
+        float LastCell = (float) (rkLayer.Dims[iAxis] - 1);
+        float MinCell = std::floor((Min[iAxis] - rkLayer.GridMin[iAxis]) * rkLayer.InvCellSize);
+        float MaxCell = std::floor((Max[iAxis] - rkLayer.GridMin[iAxis]) * rkLayer.InvCellSize);
+
+        // Written so NaNs end up in the first cell instead of being cast to an integer
+        pOutMin[iAxis] = (uint32) (MinCell > 0.f ? std::min(MinCell, LastCell) : 0.f);
+        pOutMax[iAxis] = (uint32) (MaxCell > 0.f ? std::min(MaxCell, LastCell) : 0.f);
+    }
+}
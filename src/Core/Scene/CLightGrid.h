@@ -0,0 +1,64 @@
+#ifndef CLIGHTGRID_H
+#define CLIGHTGRID_H
+
+#include "Core/Resource/CLight.h"
+#include <Common/BasicTypes.h>
+#include <Common/CColor.h>
+#include <Common/Math/CAABox.h>
+#include <Common/Math/CVector3f.h>
+#include <vector>
+
+class CGameArea;
+
+/**
+ * Uniform grid over the light spheres of an area, used to find the lights that can reach a
+ * scene node without testing every light on its layer. Each light layer gets its own grid,
+ * sized to the spread of its light positions; a light is binned into every cell its sphere's
+ * bounding box overlaps, and the bounds of anything outside the grid are clamped to the edge
+ * cells, so a query only needs to visit the cells its box overlaps.
+ *
+ * Lights that would cover most of a grid anyway (such as directional lights, which have an
+ * effectively infinite radius) aren't binned and are returned by every query instead.
+ *
+ * Queries are conservative; callers still need to test the returned lights against the box.
+ * Built from the lights as they are at the time; it needs to be rebuilt when they change.
+ */
+class CLightGrid
+{
+    struct SLayer
+    {
+        std::vector<CLight*> Lights;            // Non-ambient lights, in layer order
+        std::vector<uint32> UnbinnedLights;
+        std::vector<uint32> CellStarts;         // One per cell plus one; each cell's lights are in CellLights[Start, NextStart)
+        std::vector<uint32> CellLights;
+        std::vector<uint32> QueryStamps;        // Per light; used to skip lights found in more than one cell
+        uint32 NumLights;                       // Including ambient lights
+        CColor AmbientColor;
+        float GridMin[3];
+        float InvCellSize;
+        uint32 Dims[3];
+    };
+
+    std::vector<SLayer> mLayers;
+    uint32 mQueryStamp;
+
+public:
+    CLightGrid();
+
+    void Build(CGameArea *pArea);
+    void Clear();
+
+    /** Append every non-ambient light on the layer whose sphere may intersect the box. */
+    void FindLights(uint32 LayerIndex, const CAABox& rkBounds, std::vector<CLight*>& rOut);
+
+    // Accessors
+    inline uint32 NumLayers() const                         { return mLayers.size(); }
+    inline uint32 NumLights(uint32 LayerIndex) const        { return (LayerIndex < mLayers.size() ? mLayers[LayerIndex].NumLights : 0); }
+    inline CColor AmbientColor(uint32 LayerIndex) const     { return mLayers[LayerIndex].AmbientColor; }
+
+protected:
+    void BuildLayer(SLayer& rLayer);
+    void CellRange(const SLayer& rkLayer, const CVector3f& rkMin, const CVector3f& rkMax, uint32 *pOutMin, uint32 *pOutMax) const;
+};
+
+#endif // CLIGHTGRID_H
@@ -1,4 +1,5 @@
 #include "CLightNode.h"
+#include "CScene.h"
 #include "Core/Render/CDrawUtil.h"
 #include "Core/Render/CGraphics.h"
 #include "Core/Render/CRenderer.h"
@@ -20,6 +21,16 @@ CLightNode::CLightNode(CScene *pScene, uint32 NodeID, CSceneNode *pParent, CLigh
     }
 }
 
+void* CLightNode::operator new(size_t Size)
+{
+    return AllocatePooled<CLightNode>(Size);
+}
+
+void CLightNode::operator delete(void *pData, size_t Size)
+{
+    FreePooled<CLightNode>(pData, Size);
+}
+
 ENodeType CLightNode::NodeType()
 {
     return ENodeType::Light;
@@ -125,6 +136,21 @@ SRayIntersection CLightNode::RayNodeIntersectTest(const CRay& rkRay, uint32 Asse
     return Out;
 }
 
+bool CLightNode::ExpandSceneBounds(CAABox& rBounds)
+{
+    // Selected lights draw their radius
+    if (IsSelected())
+        return false;
+
+    CVector2f BillScale = BillboardScale();
+    float ScaleXY = (BillScale.X > BillScale.Y ? BillScale.X : BillScale.Y);
+
+    rBounds.ExpandBounds(AABox());
+    rBounds.ExpandBounds(CAABox(mPosition + CVector3f(-ScaleXY, -ScaleXY, -BillScale.Y),
+                                mPosition + CVector3f( ScaleXY,  ScaleXY,  BillScale.Y)));
+    return true;
+}
+
 CStructRef CLightNode::GetProperties() const
 {
     return CStructRef(mpLight, mpLight->GetProperties());
@@ -136,6 +162,10 @@ void CLightNode::PropertyModified(IProperty* pProperty)
 
     if (pProperty->Name() == "Position")
         SetPosition( mpLight->Position() );
+
+    // Any light property can change which nodes the light reaches
+    if (mpScene)
+        mpScene->OnLightsChanged();
 }
 
 CLight* CLightNode::Light()
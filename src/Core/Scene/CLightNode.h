@@ -9,12 +9,15 @@ class CLightNode : public CSceneNode
     CLight *mpLight;
 public:
     CLightNode(CScene *pScene, uint32 NodeID, CSceneNode *pParent = 0, CLight *Light = 0);
+    static void* operator new(size_t Size);
+    static void operator delete(void *pData, size_t Size);
     ENodeType NodeType();
     void AddToRenderer(CRenderer *pRenderer, const SViewInfo& ViewInfo);
     void Draw(FRenderOptions Options, int ComponentIndex, ERenderCommand Command, const SViewInfo& ViewInfo);
     void DrawSelection();
     void RayAABoxIntersectTest(CRayCollisionTester& Tester, const SViewInfo& ViewInfo);
     SRayIntersection RayNodeIntersectTest(const CRay &Ray, uint32 AssetID, const SViewInfo& ViewInfo);
+    bool ExpandSceneBounds(CAABox& rBounds);
     CStructRef GetProperties() const;
     void PropertyModified(IProperty* pProperty);
     bool AllowsRotate() const { return false; }
@@ -15,6 +15,16 @@ CModelNode::CModelNode(CScene *pScene, uint32 NodeID, CSceneNode *pParent, CMode
     SetModel(pModel);
 }
 
+void* CModelNode::operator new(size_t Size)
+{
+    return AllocatePooled<CModelNode>(Size);
+}
+
+void CModelNode::operator delete(void *pData, size_t Size)
+{
+    FreePooled<CModelNode>(pData, Size);
+}
+
 ENodeType CModelNode::NodeType()
 {
     return ENodeType::Model;
@@ -154,6 +164,14 @@ SRayIntersection CModelNode::RayNodeIntersectTest(const CRay& rkRay, uint32 Asse
     return Out;
 }
 
+bool CModelNode::ExpandSceneBounds(CAABox& rBounds)
+{
+    if (!mpModel)
+        return true;
+
+    return CSceneNode::ExpandSceneBounds(rBounds);
+}
+
 CColor CModelNode::TintColor(const SViewInfo& /*rkViewInfo*/) const
 {
     return mTintColor;
@@ -17,6 +17,8 @@ class CModelNode : public CSceneNode
 public:
     explicit CModelNode(CScene *pScene, uint32 NodeID, CSceneNode *pParent = 0, CModel *pModel = 0);
 
+    static void* operator new(size_t Size);
+    static void operator delete(void *pData, size_t Size);
     virtual ENodeType NodeType();
     virtual void PostLoad();
     virtual void AddToRenderer(CRenderer *pRenderer, const SViewInfo& rkViewInfo);
@@ -24,6 +26,7 @@ public:
     virtual void DrawSelection();
     virtual void RayAABoxIntersectTest(CRayCollisionTester& Tester, const SViewInfo& rkViewInfo);
     virtual SRayIntersection RayNodeIntersectTest(const CRay &Ray, uint32 AssetID, const SViewInfo& rkViewInfo);
+    virtual bool ExpandSceneBounds(CAABox& rBounds);
     virtual CColor TintColor(const SViewInfo& rkViewInfo) const;
 
     // Setters
@@ -20,6 +20,8 @@ CScene::CScene()
     , mpArea(nullptr)
     , mpWorld(nullptr)
     , mpAreaRootNode(nullptr)
+    , mNextNodeID(0)
+    , mLightGridDirty(false)
 {
 }
 
@@ -34,7 +36,7 @@ bool CScene::IsNodeIDUsed(uint32 ID) const
     return (mNodeMap.find(ID) != mNodeMap.end());
 }
 
-uint32 CScene::CreateNodeID(uint32 SuggestedID /*= -1*/) const
+uint32 CScene::CreateNodeID(uint32 SuggestedID /*= -1*/)
 {
     if (SuggestedID != -1)
     {
@@ -44,12 +46,21 @@ uint32 CScene::CreateNodeID(uint32 SuggestedID /*= -1*/) const
             return SuggestedID;
     }
 
-    uint32 ID = 0;
+    // Reuse the IDs of deleted nodes first. Suggested IDs can take IDs from the free list or past
+    // mNextNodeID without removing them, so anything that's been taken since is skipped here.
+    while (!mFreeNodeIDs.empty())
+    {
+        uint32 ID = mFreeNodeIDs.back();
+        mFreeNodeIDs.pop_back();
+
+        if (!IsNodeIDUsed(ID))
+            return ID;
+    }
 
-    while (IsNodeIDUsed(ID))
-        ID++;
+    while (IsNodeIDUsed(mNextNodeID))
+        mNextNodeID++;
 
-    return ID;
+    return mNextNodeID++;
 }
 
 CModelNode* CScene::CreateModelNode(CModel *pModel, uint32 NodeID /*= -1*/)
@@ -60,6 +71,7 @@ CModelNode* CScene::CreateModelNode(CModel *pModel, uint32 NodeID /*= -1*/)
     CModelNode *pNode = new CModelNode(this, ID, mpAreaRootNode, pModel);
     mNodes[ENodeType::Model].push_back(pNode);
     mNodeMap[ID] = pNode;
+    pNode->_mTreeProxy = mNodeTree.Insert(pNode);
     mNumNodes++;
     return pNode;
 }
@@ -72,6 +84,7 @@ CStaticNode* CScene::CreateStaticNode(CStaticModel *pModel, uint32 NodeID /*= -1
     CStaticNode *pNode = new CStaticNode(this, ID, mpAreaRootNode, pModel);
     mNodes[ENodeType::Static].push_back(pNode);
     mNodeMap[ID] = pNode;
+    pNode->_mTreeProxy = mNodeTree.Insert(pNode);
     mNumNodes++;
     return pNode;
 }
@@ -84,6 +97,7 @@ CCollisionNode* CScene::CreateCollisionNode(CCollisionMeshGroup *pMesh, uint32 N
     CCollisionNode *pNode = new CCollisionNode(this, ID, mpAreaRootNode, pMesh);
     mNodes[ENodeType::Collision].push_back(pNode);
     mNodeMap[ID] = pNode;
+    pNode->_mTreeProxy = mNodeTree.Insert(pNode);
     mNumNodes++;
     return pNode;
 }
@@ -92,25 +106,8 @@ CScriptNode* CScene::CreateScriptNode(CScriptObject *pObj, uint32 NodeID /*= -1*
 {
     if (pObj == nullptr) return nullptr;
 
-    uint32 ID = CreateNodeID(NodeID);
-    uint32 InstanceID = pObj->InstanceID();
-
-    CScriptNode *pNode = new CScriptNode(this, ID, mpAreaRootNode, pObj);
-    mNodes[ENodeType::Script].push_back(pNode);
-    mNodeMap[ID] = pNode;
-    mScriptMap[InstanceID] = pNode;
-    pNode->BuildLightList(mpArea);
-
-    // AreaAttributes check
-    switch (pObj->ObjectTypeID())
-    {
-    case 0x4E:           // MP1 AreaAttributes ID
-    case FOURCC('REAA'): // MP2/MP3/DKCR AreaAttributes ID
-        mAreaAttributesObjects.emplace_back( CAreaAttributes(pObj) );
-        break;
-    }
-
-    mNumNodes++;
+    CScriptNode *pNode = AddScriptNode(pObj, NodeID);
+    pNode->BuildLightList(mLightGrid);
     return pNode;
 }
 
@@ -122,6 +119,7 @@ CLightNode* CScene::CreateLightNode(CLight *pLight, uint32 NodeID /*= -1*/)
     CLightNode *pNode = new CLightNode(this, ID, mpAreaRootNode, pLight);
     mNodes[ENodeType::Light].push_back(pNode);
     mNodeMap[ID] = pNode;
+    pNode->_mTreeProxy = mNodeTree.Insert(pNode);
     mNumNodes++;
     return pNode;
 }
@@ -141,7 +139,10 @@ void CScene::DeleteNode(CSceneNode *pNode)
 
     auto MapIt = mNodeMap.find(pNode->ID());
     if (MapIt != mNodeMap.end())
+    {
         mNodeMap.erase(MapIt);
+        mFreeNodeIDs.push_back(pNode->ID());
+    }
 
     if (Type == ENodeType::Script)
     {
@@ -167,6 +168,9 @@ void CScene::DeleteNode(CSceneNode *pNode)
         }
     }
 
+    mNodeTree.Remove(pNode->_mTreeProxy);
+    pNode->_mTreeProxy = -1;
+
     pNode->Unparent();
     delete pNode;
     mNumNodes--;
@@ -205,28 +209,38 @@ void CScene::SetActiveArea(CWorld *pWorld, CGameArea *pArea)
     CreateCollisionNode(mpArea->Collision());
 
     uint32 NumLayers = mpArea->NumScriptLayers();
+    uint32 NumInstances = mpArea->TotalInstanceCount();
+    mNodes[ENodeType::Script].reserve(NumInstances);
+    mNodeMap.reserve(mNodeMap.size() + NumInstances);
+    mScriptMap.reserve(NumInstances);
 
     for (uint32 iLyr = 0; iLyr < NumLayers; iLyr++)
     {
         CScriptLayer *pLayer = mpArea->ScriptLayer(iLyr);
         uint32 NumObjects = pLayer->NumInstances();
-        mNodes[ENodeType::Script].reserve(mNodes[ENodeType::Script].size() + NumObjects);
 
+        // Light lists depend on positions, which aren't final until every node exists; they're built below
         for (uint32 iObj = 0; iObj < NumObjects; iObj++)
         {
             CScriptObject *pObj = pLayer->InstanceByIndex(iObj);
-            CreateScriptNode(pObj);
+            AddScriptNode(pObj, -1);
         }
     }
 
     // Ensure script nodes have valid positions + build light lists
+    mLightGrid.Build(mpArea);
+    mLightGridDirty = false;
+
     for (CSceneIterator It(this, ENodeType::Script, true); It; ++It)
     {
         CScriptNode *pScript = static_cast<CScriptNode*>(*It);
         pScript->GeneratePosition();
-        pScript->BuildLightList(mpArea);
+        pScript->BuildLightList(mLightGrid);
     }
 
+    // Everything was just built from scratch
+    mDirtyLightListNodes.clear();
+
     uint32 NumLightLayers = mpArea->NumLightLayers();
     CGraphics::sAreaAmbientColor = CColor::skBlack;
 
@@ -264,10 +278,16 @@ void CScene::ClearScene()
         mpAreaRootNode = nullptr;
     }
 
+    mNodeTree.Clear();
+    mLightGrid.Clear();
+    mDirtyLightListNodes.clear();
+    mLightGridDirty = false;
     mNodes.clear();
     mAreaAttributesObjects.clear();
     mNodeMap.clear();
     mScriptMap.clear();
+    mFreeNodeIDs.clear();
+    mNextNodeID = 0;
     mNumNodes = 0;
 
     mpArea = nullptr;
@@ -280,14 +300,21 @@ void CScene::AddSceneToRenderer(CRenderer *pRenderer, const SViewInfo& rkViewInf
     if (!mRanPostLoad)
         PostLoad();
 
+    // Nodes need their current lights before they're drawn
+    UpdateLightLists();
+
     // Override show flags in game mode
     FShowFlags ShowFlags = (rkViewInfo.GameMode ? gkGameModeShowFlags : rkViewInfo.ShowFlags);
     FNodeFlags NodeFlags = NodeFlagsForShowFlags(ShowFlags);
 
-    for (CSceneIterator It(this, NodeFlags, false); It; ++It)
+    // Only nodes that might be on screen need to be added
+    mNodeQueryResults.clear();
+    mNodeTree.FrustumQuery(rkViewInfo.ViewFrustum, mNodeQueryResults);
+
+    for (CSceneNode *pNode : mNodeQueryResults)
     {
-        if (rkViewInfo.GameMode || It->IsVisible())
-            It->AddToRenderer(pRenderer, rkViewInfo);
+        if ((NodeFlags & pNode->NodeType()) && pNode->IsVisible())
+            pNode->AddToRenderer(pRenderer, rkViewInfo);
     }
 }
 
@@ -296,14 +323,76 @@ SRayIntersection CScene::SceneRayCast(const CRay& rkRay, const SViewInfo& rkView
     FShowFlags ShowFlags = (rkViewInfo.GameMode ? gkGameModeShowFlags : rkViewInfo.ShowFlags);
     FNodeFlags NodeFlags = NodeFlagsForShowFlags(ShowFlags);
     CRayCollisionTester Tester(rkRay);
+    RayAABoxIntersectTest(Tester, rkViewInfo);
+    return Tester.TestNodes(rkViewInfo);
+}
+
+void CScene::RayAABoxIntersectTest(CRayCollisionTester& rTester, const SViewInfo& rkViewInfo)
+{
+    FShowFlags ShowFlags = (rkViewInfo.GameMode ? gkGameModeShowFlags : rkViewInfo.ShowFlags);
+    FNodeFlags NodeFlags = NodeFlagsForShowFlags(ShowFlags);
 
-    for (CSceneIterator It(this, NodeFlags, false); It; ++It)
+    // Only nodes whose bounds the ray passes through can be hit
+    mNodeQueryResults.clear();
+    mNodeTree.RayQuery(rTester.Ray(), mNodeQueryResults);
+
+    for (CSceneNode *pNode : mNodeQueryResults)
     {
-        if (It->IsVisible())
-            It->RayAABoxIntersectTest(Tester, rkViewInfo);
+        if ((NodeFlags & pNode->NodeType()) && pNode->IsVisible())
+            pNode->RayAABoxIntersectTest(rTester, rkViewInfo);
     }
+}
 
-    return Tester.TestNodes(rkViewInfo);
+void CScene::OnNodeBoundsChanged(const CSceneNode *pkNode)
+{
+    OnNodeLightListChanged(pkNode);
+
+    // Child nodes are included in the bounds of the nearest ancestor that's in the tree
+    while (pkNode && pkNode->_mTreeProxy == -1)
+        pkNode = pkNode->mpParent;
+
+    if (pkNode)
+        mNodeTree.MarkDirty(pkNode->_mTreeProxy);
+}
+
+void CScene::OnNodeLightListChanged(const CSceneNode *pkNode)
+{
+    // Only nodes that have a light list need one rebuilt, and each only needs to be queued once
+    if (pkNode->_mLightListLayer == -1 || pkNode->_mLightListDirty)
+        return;
+
+    pkNode->_mLightListDirty = true;
+    mDirtyLightListNodes.push_back(pkNode->ID());
+}
+
+void CScene::OnLightsChanged()
+{
+    mLightGridDirty = true;
+}
+
+void CScene::UpdateLightLists()
+{
+    if (mLightGridDirty)
+    {
+        // Any node's lights may have changed, so every light list needs rebuilding
+        mLightGrid.Build(mpArea);
+        mLightGridDirty = false;
+
+        for (CSceneIterator It(this, ENodeType::Script, true); It; ++It)
+            It->BuildLightList(mLightGrid);
+    }
+
+    else
+    {
+        // IDs rather than pointers, in case nodes were deleted since they were queued
+        for (uint32 NodeID : mDirtyLightListNodes)
+        {
+            CSceneNode *pNode = NodeByID(NodeID);
+            if (pNode) pNode->UpdateLightList(mLightGrid);
+        }
+    }
+
+    mDirtyLightListNodes.clear();
 }
 
 CSceneNode* CScene::NodeByID(uint32 NodeID)
@@ -370,6 +459,32 @@ CGameArea* CScene::ActiveArea()
     return mpArea;
 }
 
+// ************ PROTECTED ************
+CScriptNode* CScene::AddScriptNode(CScriptObject *pObj, uint32 NodeID)
+{
+    // Same as CreateScriptNode, but leaves building the light list to the caller
+    uint32 ID = CreateNodeID(NodeID);
+    uint32 InstanceID = pObj->InstanceID();
+
+    CScriptNode *pNode = new CScriptNode(this, ID, mpAreaRootNode, pObj);
+    mNodes[ENodeType::Script].push_back(pNode);
+    mNodeMap[ID] = pNode;
+    pNode->_mTreeProxy = mNodeTree.Insert(pNode);
+    mScriptMap[InstanceID] = pNode;
+
+    // AreaAttributes check
+    switch (pObj->ObjectTypeID())
+    {
+    case 0x4E:           // MP1 AreaAttributes ID
+    case FOURCC('REAA'): // MP2/MP3/DKCR AreaAttributes ID
+        mAreaAttributesObjects.emplace_back( CAreaAttributes(pObj) );
+        break;
+    }
+
+    mNumNodes++;
+    return pNode;
+}
+
 // ************ STATIC ************
 FShowFlags CScene::ShowFlagsForNodeFlags(FNodeFlags NodeFlags)
 {
@@ -8,6 +8,8 @@
 #include "CScriptNode.h"
 #include "CStaticNode.h"
 #include "CCollisionNode.h"
+#include "CLightGrid.h"
+#include "CSceneBVH.h"
 #include "FShowFlags.h"
 #include "Core/Render/CRenderer.h"
 #include "Core/Render/SViewInfo.h"
@@ -42,6 +44,17 @@ class CScene
     // Node Management
     std::unordered_map<uint32, CSceneNode*> mNodeMap;
     std::unordered_map<uint32, CScriptNode*> mScriptMap;
+    std::vector<uint32> mFreeNodeIDs;
+    uint32 mNextNodeID;
+
+    // Culling
+    CSceneBVH mNodeTree;
+    std::vector<CSceneNode*> mNodeQueryResults;
+
+    // Lighting
+    CLightGrid mLightGrid;
+    std::vector<uint32> mDirtyLightListNodes;
+    bool mLightGridDirty;
 
 public:
     CScene();
@@ -49,7 +62,7 @@ public:
 
     // Scene Management
     bool IsNodeIDUsed(uint32 ID) const;
-    uint32 CreateNodeID(uint32 SuggestedID = -1) const;
+    uint32 CreateNodeID(uint32 SuggestedID = -1);
 
     CModelNode* CreateModelNode(CModel *pModel, uint32 NodeID = -1);
     CStaticNode* CreateStaticNode(CStaticModel *pModel, uint32 NodeID = -1);
@@ -62,6 +75,11 @@ public:
     void ClearScene();
     void AddSceneToRenderer(CRenderer *pRenderer, const SViewInfo& rkViewInfo);
     SRayIntersection SceneRayCast(const CRay& rkRay, const SViewInfo& rkViewInfo);
+    void RayAABoxIntersectTest(CRayCollisionTester& rTester, const SViewInfo& rkViewInfo);
+    void OnNodeBoundsChanged(const CSceneNode *pkNode);
+    void OnNodeLightListChanged(const CSceneNode *pkNode);
+    void OnLightsChanged();
+    void UpdateLightLists();
     CSceneNode* NodeByID(uint32 NodeID);
     CScriptNode* NodeForInstanceID(uint32 InstanceID);
     CScriptNode* NodeForInstance(CScriptObject *pObj);
@@ -69,6 +87,14 @@ public:
     CModel* ActiveSkybox();
     CGameArea* ActiveArea();
 
+    // Accessors
+    inline const CSceneBVH& NodeTree() const    { return mNodeTree; }
+    inline const CLightGrid& LightGrid() const  { return mLightGrid; }
+
+protected:
+    CScriptNode* AddScriptNode(CScriptObject *pObj, uint32 NodeID);
+
+public:
     // Static
     static FShowFlags ShowFlagsForNodeFlags(FNodeFlags NodeFlags);
     static FNodeFlags NodeFlagsForShowFlags(FShowFlags ShowFlags);
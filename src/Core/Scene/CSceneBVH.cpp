@@ -0,0 +1,473 @@
+#include "CSceneBVH.h"
+#include "CSceneNode.h"
+#include <Common/Macros.h>
+#include <Common/Math/MathUtil.h>
+#include <cmath>
+
+namespace
+{
+
+/** How far leaf bounds are enlarged past their node's bounds, so small moves don't need a reinsert */
+const float gkLeafMargin = 0.5f;
+
+inline CAABox Union(const CAABox& rkA, const CAABox& rkB)
+{
+    CAABox Out = rkA;
+    Out.ExpandBounds(rkB);
+    return Out;
+}
+
+inline float SurfaceArea(const CAABox& rkBox)
+{
+    CVector3f Size = rkBox.Size();
+    return 2.f * (Size.X * Size.Y + Size.Y * Size.Z + Size.Z * Size.X);
+}
+
+inline bool Contains(const CAABox& rkOuter, const CAABox& rkInner)
+{
+    CVector3f OuterMin = rkOuter.Min(), OuterMax = rkOuter.Max();
+    CVector3f InnerMin = rkInner.Min(), InnerMax = rkInner.Max();
+
+    return OuterMin.X <= InnerMin.X && OuterMin.Y <= InnerMin.Y && OuterMin.Z <= InnerMin.Z &&
+           OuterMax.X >= InnerMax.X && OuterMax.Y >= InnerMax.Y && OuterMax.Z >= InnerMax.Z;
+}
+
+inline bool IsValidBounds(const CAABox& rkBox)
+{
+    // Catches empty boxes (min > max), as well as infinite and NaN extents
+    CVector3f Min = rkBox.Min(), Max = rkBox.Max();
+
+    return std::isfinite(Min.X) && std::isfinite(Min.Y) && std::isfinite(Min.Z) &&
+           std::isfinite(Max.X) && std::isfinite(Max.Y) && std::isfinite(Max.Z) &&
+           Min.X <= Max.X && Min.Y <= Max.Y && Min.Z <= Max.Z;
+}
+
+/** Ray/box slab test with the ray's reciprocal direction precomputed; only the boolean result is needed to cull */
+inline bool RayHitsBox(const CVector3f& rkOrigin, const CVector3f& rkInvDir, const CAABox& rkBox)
+{
+    CVector3f Min = rkBox.Min(), Max = rkBox.Max();
+
+    float TX1 = (Min.X - rkOrigin.X) * rkInvDir.X, TX2 = (Max.X - rkOrigin.X) * rkInvDir.X;
+    float TY1 = (Min.Y - rkOrigin.Y) * rkInvDir.Y, TY2 = (Max.Y - rkOrigin.Y) * rkInvDir.Y;
+    float TZ1 = (Min.Z - rkOrigin.Z) * rkInvDir.Z, TZ2 = (Max.Z - rkOrigin.Z) * rkInvDir.Z;
+
+    float TMin = Math::Max(Math::Max(Math::Min(TX1, TX2), Math::Min(TY1, TY2)), Math::Min(TZ1, TZ2));
+    float TMax = Math::Min(Math::Min(Math::Max(TX1, TX2), Math::Max(TY1, TY2)), Math::Max(TZ1, TZ2));
+
+    return TMax >= 0.f && TMin <= TMax;
+}
+
+}
+
+CSceneBVH::CSceneBVH()
+    : mRoot(-1)
+    , mFreeList(-1)
+    , mNumLeaves(0)
+{
+}
+
+uint32 CSceneBVH::Insert(CSceneNode *pSceneNode)
+{
+    ASSERT(pSceneNode);
+
+    // The node is usually still being set up at this point, so its bounds are only calculated on the next update
+    uint32 LeafIdx = AllocateNode();
+    SNode& rLeaf = mNodes[LeafIdx];
+    rLeaf.pSceneNode = pSceneNode;
+    rLeaf.Height = 0;
+    rLeaf.State = ELeafState::Pending;
+    rLeaf.Dirty = true;
+
+    mDirtyLeaves.push_back(LeafIdx);
+    mNumLeaves++;
+    return LeafIdx;
+}
+
+void CSceneBVH::Remove(uint32 Proxy)
+{
+    ASSERT(Proxy < mNodes.size() && mNodes[Proxy].IsLeaf() && mNodes[Proxy].Height == 0);
+
+    if (mNodes[Proxy].Dirty)
+    {
+        for (auto Iter = mDirtyLeaves.begin(); Iter != mDirtyLeaves.end(); Iter++)
+        {
+            if (*Iter == Proxy)
+            {
+                mDirtyLeaves.erase(Iter);
+                break;
+            }
+        }
+    }
+
+    switch (mNodes[Proxy].State)
+    {
+    case ELeafState::InTree:    RemoveLeaf(Proxy);      break;
+    case ELeafState::Unbounded: RemoveUnbounded(Proxy); break;
+    default:                                            break;
+    }
+
+    FreeNode(Proxy);
+    mNumLeaves--;
+}
+
+void CSceneBVH::MarkDirty(uint32 Proxy)
+{
+    SNode& rLeaf = mNodes[Proxy];
+
+    if (!rLeaf.Dirty)
+    {
+        rLeaf.Dirty = true;
+        mDirtyLeaves.push_back(Proxy);
+    }
+}
+
+void CSceneBVH::Update()
+{
+    // Calculating a node's bounds can flag other leaves dirty, so don't hold on to an iterator
+    for (uint32 DirtyIdx = 0; DirtyIdx < mDirtyLeaves.size(); DirtyIdx++)
+    {
+        uint32 LeafIdx = mDirtyLeaves[DirtyIdx];
+        RefreshLeaf(LeafIdx);
+        mNodes[LeafIdx].Dirty = false;
+    }
+
+    mDirtyLeaves.clear();
+}
+
+void CSceneBVH::Clear()
+{
+    mNodes.clear();
+    mDirtyLeaves.clear();
+    mUnboundedLeaves.clear();
+    mRoot = -1;
+    mFreeList = -1;
+    mNumLeaves = 0;
+}
+
+void CSceneBVH::RayQuery(const CRay& rkRay, std::vector<CSceneNode*>& rOut)
+{
+    Update();
+
+    for (uint32 LeafIdx : mUnboundedLeaves)
+        rOut.push_back(mNodes[LeafIdx].pSceneNode);
+
+    if (mRoot == -1)
+        return;
+
+    // Division by zero gives infinity here, which the slab test handles correctly
+    CVector3f Origin = rkRay.Origin();
+    CVector3f Dir = rkRay.Direction();
+    CVector3f InvDir(1.f / Dir.X, 1.f / Dir.Y, 1.f / Dir.Z);
+
+    mTraversalStack.clear();
+    mTraversalStack.push_back(mRoot);
+
+    while (!mTraversalStack.empty())
+    {
+        const SNode& rkNode = mNodes[mTraversalStack.back()];
+        mTraversalStack.pop_back();
+
+        if (!RayHitsBox(Origin, InvDir, rkNode.Bounds))
+            continue;
+
+        if (rkNode.IsLeaf())
+            rOut.push_back(rkNode.pSceneNode);
+
+        else
+        {
+            mTraversalStack.push_back(rkNode.Children[0]);
+            mTraversalStack.push_back(rkNode.Children[1]);
+        }
+    }
+}
+
+void CSceneBVH::FrustumQuery(const CFrustumPlanes& rkFrustum, std::vector<CSceneNode*>& rOut)
+{
+    Update();
+
+    for (uint32 LeafIdx : mUnboundedLeaves)
+        rOut.push_back(mNodes[LeafIdx].pSceneNode);
+
+    if (mRoot == -1)
+        return;
+
+    mTraversalStack.clear();
+    mTraversalStack.push_back(mRoot);
+
+    while (!mTraversalStack.empty())
+    {
+        const SNode& rkNode = mNodes[mTraversalStack.back()];
+        mTraversalStack.pop_back();
+
+        if (!rkFrustum.BoxInFrustum(rkNode.Bounds))
+            continue;
+
+        if (rkNode.IsLeaf())
+            rOut.push_back(rkNode.pSceneNode);
+
+        else
+        {
+            mTraversalStack.push_back(rkNode.Children[0]);
+            mTraversalStack.push_back(rkNode.Children[1]);
+        }
+    }
+}
+
+// ************ PROTECTED ************
+uint32 CSceneBVH::AllocateNode()
+{
+    uint32 NodeIdx;
+
+    if (mFreeList != -1)
+    {
+        NodeIdx = mFreeList;
+        mFreeList = mNodes[NodeIdx].Parent;
+    }
+    else
+    {
+        NodeIdx = mNodes.size();
+        mNodes.emplace_back();
+    }
+
+    SNode& rNode = mNodes[NodeIdx];
+    rNode.Bounds = CAABox::skInfinite;
+    rNode.pSceneNode = nullptr;
+    rNode.Parent = -1;
+    rNode.Children[0] = -1;
+    rNode.Children[1] = -1;
+    rNode.Height = 0;
+    rNode.UnboundedIndex = -1;
+    rNode.State = ELeafState::Pending;
+    rNode.Dirty = false;
+    return NodeIdx;
+}
+
+void CSceneBVH::FreeNode(uint32 NodeIdx)
+{
+    SNode& rNode = mNodes[NodeIdx];
+    rNode.pSceneNode = nullptr;
+    rNode.Height = -1;
+    rNode.Parent = mFreeList;
+    mFreeList = NodeIdx;
+}
+
+void CSceneBVH::RefreshLeaf(uint32 LeafIdx)
+{
+    CAABox Bounds = CAABox::skInfinite;
+    bool IsBounded = mNodes[LeafIdx].pSceneNode->ExpandSceneBounds(Bounds) && IsValidBounds(Bounds);
+    SNode& rLeaf = mNodes[LeafIdx];
+
+    if (!IsBounded)
+    {
+        if (rLeaf.State == ELeafState::InTree)
+            RemoveLeaf(LeafIdx);
+
+        if (mNodes[LeafIdx].State != ELeafState::Unbounded)
+            AddUnbounded(LeafIdx);
+
+        return;
+    }
+
+    // Small moves stay within the enlarged bounds and don't need any changes to the tree
+    if (rLeaf.State == ELeafState::InTree)
+    {
+        if (Contains(rLeaf.Bounds, Bounds))
+            return;
+
+        RemoveLeaf(LeafIdx);
+    }
+
+    else if (rLeaf.State == ELeafState::Unbounded)
+        RemoveUnbounded(LeafIdx);
+
+    Bounds.ExpandBy(CVector3f(gkLeafMargin));
+    mNodes[LeafIdx].Bounds = Bounds;
+    InsertLeaf(LeafIdx);
+}
+
+void CSceneBVH::InsertLeaf(uint32 LeafIdx)
+{
+    mNodes[LeafIdx].State = ELeafState::InTree;
+
+    if (mRoot == -1)
+    {
+        mRoot = LeafIdx;
+        mNodes[LeafIdx].Parent = -1;
+        return;
+    }
+
+    // Find the best sibling, going down the side that increases the total surface area of the tree the least
+    CAABox LeafBounds = mNodes[LeafIdx].Bounds;
+    uint32 NodeIdx = mRoot;
+
+    while (!mNodes[NodeIdx].IsLeaf())
+    {
+        const SNode& rkNode = mNodes[NodeIdx];
+        float Area = SurfaceArea(rkNode.Bounds);
+        float CombinedArea = SurfaceArea(Union(rkNode.Bounds, LeafBounds));
+
+        // Cost of making a new parent for this node and the leaf, and the minimum cost of pushing the leaf further down
+        float Cost = 2.f * CombinedArea;
+        float InheritanceCost = 2.f * (CombinedArea - Area);
+        float ChildCosts[2];
+
+        for (uint32 ChildIdx = 0; ChildIdx < 2; ChildIdx++)
+        {
+            const SNode& rkChild = mNodes[rkNode.Children[ChildIdx]];
+            float NewArea = SurfaceArea(Union(rkChild.Bounds, LeafBounds));
+            ChildCosts[ChildIdx] = InheritanceCost + (rkChild.IsLeaf() ? NewArea : NewArea - SurfaceArea(rkChild.Bounds));
+        }
+
+        if (Cost < ChildCosts[0] && Cost < ChildCosts[1])
+            break;
+
+        NodeIdx = (ChildCosts[0] < ChildCosts[1] ? rkNode.Children[0] : rkNode.Children[1]);
+    }
+
+    // Create a new parent for the sibling and the leaf
+    uint32 SiblingIdx = NodeIdx;
+    uint32 OldParentIdx = mNodes[SiblingIdx].Parent;
+    uint32 NewParentIdx = AllocateNode();
+
+    SNode& rNewParent = mNodes[NewParentIdx];
+    rNewParent.Parent = OldParentIdx;
+    rNewParent.Bounds = Union(LeafBounds, mNodes[SiblingIdx].Bounds);
+    rNewParent.Height = mNodes[SiblingIdx].Height + 1;
+    rNewParent.Children[0] = SiblingIdx;
+    rNewParent.Children[1] = LeafIdx;
+
+    if (OldParentIdx != -1)
+        ReplaceChild(OldParentIdx, SiblingIdx, NewParentIdx);
+    else
+        mRoot = NewParentIdx;
+
+    mNodes[SiblingIdx].Parent = NewParentIdx;
+    mNodes[LeafIdx].Parent = NewParentIdx;
+
+    FixUpwards(NewParentIdx);
+}
+
+void CSceneBVH::RemoveLeaf(uint32 LeafIdx)
+{
+    mNodes[LeafIdx].State = ELeafState::Pending;
+
+    if (LeafIdx == mRoot)
+    {
+        mRoot = -1;
+        return;
+    }
+
+    // Replace the leaf's parent with its sibling
+    uint32 ParentIdx = mNodes[LeafIdx].Parent;
+    uint32 GrandParentIdx = mNodes[ParentIdx].Parent;
+    uint32 SiblingIdx = (mNodes[ParentIdx].Children[0] == LeafIdx ? mNodes[ParentIdx].Children[1] : mNodes[ParentIdx].Children[0]);
+
+    mNodes[SiblingIdx].Parent = GrandParentIdx;
+    mNodes[LeafIdx].Parent = -1;
+    FreeNode(ParentIdx);
+
+    if (GrandParentIdx != -1)
+    {
+        ReplaceChild(GrandParentIdx, ParentIdx, SiblingIdx);
+        FixUpwards(GrandParentIdx);
+    }
+    else
+        mRoot = SiblingIdx;
+}
+
+void CSceneBVH::AddUnbounded(uint32 LeafIdx)
+{
+    mNodes[LeafIdx].State = ELeafState::Unbounded;
+    mNodes[LeafIdx].UnboundedIndex = mUnboundedLeaves.size();
+    mUnboundedLeaves.push_back(LeafIdx);
+}
+
+void CSceneBVH::RemoveUnbounded(uint32 LeafIdx)
+{
+    uint32 ListIdx = mNodes[LeafIdx].UnboundedIndex;
+    uint32 LastIdx = mUnboundedLeaves.back();
+
+    mUnboundedLeaves[ListIdx] = LastIdx;
+    mNodes[LastIdx].UnboundedIndex = ListIdx;
+    mUnboundedLeaves.pop_back();
+
+    mNodes[LeafIdx].UnboundedIndex = -1;
+    mNodes[LeafIdx].State = ELeafState::Pending;
+}
+
+void CSceneBVH::FixUpwards(uint32 NodeIdx)
+{
+    while (NodeIdx != -1)
+    {
+        NodeIdx = Balance(NodeIdx);
+
+        SNode& rNode = mNodes[NodeIdx];
+        const SNode& rkChildA = mNodes[rNode.Children[0]];
+        const SNode& rkChildB = mNodes[rNode.Children[1]];
+        rNode.Height = 1 + Math::Max(rkChildA.Height, rkChildB.Height);
+        rNode.Bounds = Union(rkChildA.Bounds, rkChildB.Bounds);
+
+        NodeIdx = rNode.Parent;
+    }
+}
+
+uint32 CSceneBVH::Balance(uint32 NodeIdx)
+{
+    // If one child is more than one level taller than the other, rotate it up to take the node's place
+    SNode& rA = mNodes[NodeIdx];
+
+    if (rA.IsLeaf() || rA.Height < 2)
+        return NodeIdx;
+
+    uint32 IdxB = rA.Children[0];
+    uint32 IdxC = rA.Children[1];
+    int32 HeightDiff = mNodes[IdxC].Height - mNodes[IdxB].Height;
+
+    if (HeightDiff >= -1 && HeightDiff <= 1)
+        return NodeIdx;
+
+    // The taller child moves up. Its taller child stays with it, and the other one moves down to replace it under A.
+    uint32 TallSlot = (HeightDiff > 1 ? 1 : 0);
+    uint32 IdxUp = rA.Children[TallSlot];
+    uint32 IdxOther = rA.Children[1 - TallSlot];
+    SNode& rUp = mNodes[IdxUp];
+
+    uint32 IdxF = rUp.Children[0];
+    uint32 IdxG = rUp.Children[1];
+
+    rUp.Children[0] = NodeIdx;
+    rUp.Parent = rA.Parent;
+    rA.Parent = IdxUp;
+
+    if (rUp.Parent != -1)
+        ReplaceChild(rUp.Parent, NodeIdx, IdxUp);
+    else
+        mRoot = IdxUp;
+
+    uint32 IdxKeep = (mNodes[IdxF].Height > mNodes[IdxG].Height ? IdxF : IdxG);
+    uint32 IdxMove = (IdxKeep == IdxF ? IdxG : IdxF);
+
+    rUp.Children[1] = IdxKeep;
+    rA.Children[TallSlot] = IdxMove;
+    mNodes[IdxMove].Parent = NodeIdx;
+
+    rA.Bounds = Union(mNodes[IdxOther].Bounds, mNodes[IdxMove].Bounds);
+    rA.Height = 1 + Math::Max(mNodes[IdxOther].Height, mNodes[IdxMove].Height);
+    rUp.Bounds = Union(rA.Bounds, mNodes[IdxKeep].Bounds);
+    rUp.Height = 1 + Math::Max(rA.Height, mNodes[IdxKeep].Height);
+
+    return IdxUp;
+}
+
+void CSceneBVH::ReplaceChild(uint32 ParentIdx, uint32 OldChild, uint32 NewChild)
+{
+    SNode& rParent = mNodes[ParentIdx];
+
+    if (rParent.Children[0] == OldChild)
+        rParent.Children[0] = NewChild;
+    else
+    {
+        ASSERT(rParent.Children[1] == OldChild);
+        rParent.Children[1] = NewChild;
+    }
+}
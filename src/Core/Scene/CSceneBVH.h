@@ -0,0 +1,90 @@
+#ifndef CSCENEBVH_H
+#define CSCENEBVH_H
+
+#include <Common/BasicTypes.h>
+#include <Common/Math/CAABox.h>
+#include <Common/Math/CFrustumPlanes.h>
+#include <Common/Math/CRay.h>
+#include <vector>
+
+class CSceneNode;
+
+/**
+ * Dynamic bounding volume hierarchy over the nodes of a scene, used to narrow down ray casts
+ * and frustum culling to the nodes that can actually be hit or seen.
+ *
+ * Leaves store a slightly enlarged copy of their node's bounds, so nodes that move a little
+ * don't need to be reinserted. Nodes flag their leaf dirty when their bounds may have changed;
+ * dirty leaves are refitted at the start of the next query, and are only removed and reinserted
+ * if the new bounds no longer fit the enlarged ones. Inserts pick the sibling that grows the
+ * total surface area the least, and the tree is rebalanced with rotations on the way back up,
+ * so it stays shallow no matter what order nodes are added and moved in.
+ *
+ * Nodes that can't be bounded (see CSceneNode::ExpandSceneBounds) are kept in a separate list
+ * and returned by every query.
+ */
+class CSceneBVH
+{
+    enum class ELeafState
+    {
+        Pending,    // Not in the tree yet; inserted on the next update
+        InTree,
+        Unbounded   // In the unbounded list
+    };
+
+    struct SNode
+    {
+        CAABox Bounds;
+        CSceneNode *pSceneNode;     // Leaves only
+        uint32 Parent;              // Next free node for nodes on the free list
+        uint32 Children[2];         // -1 for leaves
+        int32 Height;               // 0 for leaves, -1 for free nodes
+        uint32 UnboundedIndex;      // Index in mUnboundedLeaves for unbounded leaves
+        ELeafState State;
+        bool Dirty;
+
+        inline bool IsLeaf() const  { return Children[0] == -1; }
+    };
+
+    std::vector<SNode> mNodes;
+    uint32 mRoot;
+    uint32 mFreeList;
+    uint32 mNumLeaves;
+    std::vector<uint32> mDirtyLeaves;
+    std::vector<uint32> mUnboundedLeaves;
+    std::vector<uint32> mTraversalStack;
+
+public:
+    CSceneBVH();
+
+    uint32 Insert(CSceneNode *pSceneNode);
+    void Remove(uint32 Proxy);
+    void MarkDirty(uint32 Proxy);
+    void Update();
+    void Clear();
+
+    /** Append every node whose bounds may intersect the ray */
+    void RayQuery(const CRay& rkRay, std::vector<CSceneNode*>& rOut);
+
+    /** Append every node whose bounds may be inside the frustum */
+    void FrustumQuery(const CFrustumPlanes& rkFrustum, std::vector<CSceneNode*>& rOut);
+
+    // Accessors
+    inline uint32 NumNodes() const              { return mNumLeaves; }
+    inline uint32 NumUnboundedNodes() const     { return mUnboundedLeaves.size(); }
+    inline uint32 Height() const                { return mRoot == -1 ? 0 : mNodes[mRoot].Height; }
+
+protected:
+    uint32 AllocateNode();
+    void FreeNode(uint32 NodeIdx);
+    void RefreshLeaf(uint32 LeafIdx);
+    void InsertLeaf(uint32 LeafIdx);
+    void RemoveLeaf(uint32 LeafIdx);
+    void AddUnbounded(uint32 LeafIdx);
+    void RemoveUnbounded(uint32 LeafIdx);
+    void FixUpwards(uint32 NodeIdx);
+    uint32 Balance(uint32 NodeIdx);
+    void ReplaceChild(uint32 ParentIdx, uint32 OldChild, uint32 NewChild);
+};
+
+#endif // CSCENEBVH_H
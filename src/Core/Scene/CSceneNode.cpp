@@ -1,4 +1,5 @@
 #include "CSceneNode.h"
+#include "CScene.h"
 #include "Core/GameProject/CResourceStore.h"
 #include "Core/Render/CRenderer.h"
 #include "Core/Render/CGraphics.h"
@@ -16,6 +17,9 @@ CSceneNode::CSceneNode(CScene *pScene, uint32 NodeID, CSceneNode *pParent)
     : mpScene(pScene)
     , mpParent(pParent)
     , _mID(NodeID)
+    , _mTreeProxy(-1)
+    , _mLightListDirty(false)
+    , _mLightListLayer(-1)
     , mPosition(CVector3f::skZero)
     , mRotation(CQuaternion::skIdentity)
     , mScale(CVector3f::skOne)
@@ -58,6 +62,17 @@ void CSceneNode::RayAABoxIntersectTest(CRayCollisionTester& rTester, const SView
         rTester.AddNode(this, -1, Result.second);
 }
 
+bool CSceneNode::ExpandSceneBounds(CAABox& rBounds)
+{
+    // Default implementation for virtual function.
+    // Selected nodes can draw things outside their bounds, so the scene can't cull them.
+    if (IsSelected())
+        return false;
+
+    rBounds.ExpandBounds(AABox());
+    return true;
+}
+
 bool CSceneNode::IsVisible() const
 {
     // Default implementation for virtual function
@@ -129,13 +144,19 @@ void CSceneNode::LoadModelMatrix()
     CGraphics::UpdateMVPBlock();
 }
 
-void CSceneNode::BuildLightList(CGameArea *pArea)
+void CSceneNode::BuildLightList(CLightGrid& rLightGrid)
 {
     mLightCount = 0;
     mAmbientColor = CColor::skBlack;
 
+    CAABox Bounds = AABox();
+    _mLightListDirty = false;
+    _mLightListBounds = Bounds;
+    _mLightListPosition = mPosition;
+    _mLightListLayer = mLightLayerIndex;
+
     uint32 Index = mLightLayerIndex;
-    if ((pArea->NumLightLayers() <= Index) || (pArea->NumLights(Index) == 0)) Index = 0;
+    if ((rLightGrid.NumLayers() <= Index) || (rLightGrid.NumLights(Index) == 0)) Index = 0;
 
     struct SLightEntry {
         CLight *pLight;
@@ -151,27 +172,27 @@ void CSceneNode::BuildLightList(CGameArea *pArea)
     std::vector<SLightEntry> LightEntries;
 
     // Default ambient color to white if there are no lights on the selected layer
-    uint32 NumLights = pArea->NumLights(Index);
-    if (NumLights == 0) mAmbientColor = CColor::skWhite;
-
-    for (uint32 iLight = 0; iLight < NumLights; iLight++)
+    if (rLightGrid.NumLights(Index) == 0)
     {
-        CLight* pLight = pArea->Light(Index, iLight);
+        mAmbientColor = CColor::skWhite;
+        return;
+    }
 
-        // Ambient lights should only be present one per layer; need to check how the game deals with multiple ambients
-        if (pLight->Type() == ELightType::LocalAmbient)
-            mAmbientColor = pLight->Color();
+    // Ambient lights should only be present one per layer; need to check how the game deals with multiple ambients
+    mAmbientColor = rLightGrid.AmbientColor(Index);
 
-        // Other lights will be used depending which are closest to the node
-        else
-        {
-            bool IsInRange = AABox().IntersectsSphere(pLight->Position(), pLight->GetRadius());
+    // Other lights will be used depending which are closest to the node; the grid narrows them down to the ones nearby
+    std::vector<CLight*> NearbyLights;
+    rLightGrid.FindLights(Index, Bounds, NearbyLights);
+
+    for (CLight *pLight : NearbyLights)
+    {
+        bool IsInRange = Bounds.IntersectsSphere(pLight->Position(), pLight->GetRadius());
 
-            if (IsInRange)
-            {
-                float Dist = mPosition.Distance(pLight->Position());
-                LightEntries.push_back(SLightEntry(pLight, Dist));
-            }
+        if (IsInRange)
+        {
+            float Dist = mPosition.Distance(pLight->Position());
+            LightEntries.push_back(SLightEntry(pLight, Dist));
         }
     }
 
@@ -183,6 +204,21 @@ void CSceneNode::BuildLightList(CGameArea *pArea)
         mLights[iLight] = LightEntries[iLight].pLight;
 }
 
+void CSceneNode::UpdateLightList(CLightGrid& rLightGrid)
+{
+    if (!_mLightListDirty) return;
+    _mLightListDirty = false;
+
+    // Nodes get flagged for plenty of things that don't move them (such as selection), so check that something changed
+    CAABox Bounds = AABox();
+
+    if (Bounds.Min() != _mLightListBounds.Min() || Bounds.Max() != _mLightListBounds.Max() ||
+        mPosition != _mLightListPosition || mLightLayerIndex != _mLightListLayer)
+    {
+        BuildLightList(rLightGrid);
+    }
+}
+
 void CSceneNode::LoadLights(const SViewInfo& rkViewInfo)
 {
     CGraphics::sNumLights = 0;
@@ -342,6 +378,19 @@ void CSceneNode::MarkTransformChanged() const
     }
 
     _mTransformDirty = true;
+    MarkSceneBoundsChanged();
+}
+
+void CSceneNode::MarkSceneBoundsChanged() const
+{
+    if (mpScene)
+        mpScene->OnNodeBoundsChanged(this);
+}
+
+void CSceneNode::MarkLightListChanged() const
+{
+    if (mpScene)
+        mpScene->OnNodeLightListChanged(this);
 }
 
 const CTransform4f& CSceneNode::Transform() const
@@ -1,6 +1,7 @@
 #ifndef CSCENENODE_H
 #define CSCENENODE_H
 
+#include "CLightGrid.h"
 #include "ENodeType.h"
 #include "Core/Render/EDepthGroup.h"
 #include "Core/Render/FRenderOptions.h"
@@ -8,6 +9,7 @@
 #include "Core/Resource/Area/CGameArea.h"
 #include "Core/Resource/CLight.h"
 #include "Core/CRayCollisionTester.h"
+#include "Core/TSlabAllocator.h"
 #include <Common/BasicTypes.h>
 #include <Common/Math/CAABox.h>
 #include <Common/Math/CQuaternion.h>
@@ -53,7 +55,7 @@ class CScene;
  *
  * I'm also not a fan of the reliance on raycasting for detecting mouse input from the
  * user; the raycasting code kinda works, but it tends to be very performance-intensive
- * (especially when we currently don't have any type of octree support for the scene) and
+ * (the scene BVH only narrows it down to the nodes whose bounds the ray passes through) and
  * requires a lot of specialized code for every type of primitive, which again gets duplicated
  * everywhere. Additionally this means you can't raycast against animated models because we do
  * all skinning on the GPU, and likewise if we had support for particles you wouldn't be able
@@ -68,6 +70,8 @@ class CScene;
  */
 class CSceneNode : public IRenderable
 {
+    friend class CScene;
+
 private:
     mutable CTransform4f _mCachedTransform;
     mutable CAABox _mCachedAABox;
@@ -78,6 +82,13 @@ private:
     bool _mInheritsScale;
 
     uint32 _mID;
+    uint32 _mTreeProxy;
+
+    // What the light list was last built for; the layer is -1 for nodes that don't have one
+    mutable bool _mLightListDirty;
+    CAABox _mLightListBounds;
+    CVector3f _mLightListPosition;
+    uint32 _mLightListLayer;
 
 protected:
     static uint32 smNumNodes;
@@ -118,6 +129,7 @@ public:
     virtual CColor WireframeColor() const;
     virtual CStructRef GetProperties() const { return CStructRef(); }
     virtual void PropertyModified(IProperty* pProperty) {}
+    virtual bool ExpandSceneBounds(CAABox& rBounds);
 
     void OnLoadFinished();
     void Unparent();
@@ -125,7 +137,8 @@ public:
     void DeleteChildren();
     void SetInheritance(bool InheritPos, bool InheritRot, bool InheritScale);
     void LoadModelMatrix();
-    void BuildLightList(CGameArea *pArea);
+    void BuildLightList(CLightGrid& rLightGrid);
+    void UpdateLightList(CLightGrid& rLightGrid);
     void LoadLights(const SViewInfo& rkViewInfo);
     void AddModelToRenderer(CRenderer *pRenderer, CModel *pModel, uint32 MatSet);
     void DrawModelParts(CModel *pModel, FRenderOptions Options, uint32 MatSet, ERenderCommand RenderCommand);
@@ -141,6 +154,8 @@ public:
     const CTransform4f& Transform() const;
 protected:
     void MarkTransformChanged() const;
+    void MarkSceneBoundsChanged() const;
+    void MarkLightListChanged() const;
     void ForceRecalculateTransform() const;
     virtual void CalculateTransform(CTransform4f& rOut) const;
 
@@ -173,14 +188,42 @@ public:
     void SetRotation(const CQuaternion& rkRotation) { mRotation = rkRotation; MarkTransformChanged(); }
     void SetRotation(const CVector3f& rkRotEuler)   { mRotation = CQuaternion::FromEuler(rkRotEuler); MarkTransformChanged(); }
     void SetScale(const CVector3f& rkScale)         { mScale = rkScale; MarkTransformChanged(); }
-    void SetLightLayerIndex(uint32 Index)           { mLightLayerIndex = Index; }
+    void SetLightLayerIndex(uint32 Index)           { mLightLayerIndex = Index; MarkLightListChanged(); }
     void SetMouseHovering(bool Hovering)            { mMouseHovering = Hovering; }
-    void SetSelected(bool Selected)                 { mSelected = Selected; }
+    void SetSelected(bool Selected)                 { mSelected = Selected; MarkSceneBoundsChanged(); }
     void SetVisible(bool Visible)                   { mVisible = Visible; }
 
     // Static
     inline static int NumNodes() { return smNumNodes; }
     static CColor skSelectionTint;
+
+protected:
+    /**
+     * Pooled storage for the node types the scene creates in bulk, for use in their operator new/delete.
+     * Subclasses of a pooled type don't fit in its blocks, so they fall back to the heap.
+     */
+    template<typename NodeType>
+    static void* AllocatePooled(size_t Size)
+    {
+        if (Size != sizeof(NodeType)) return ::operator new(Size);
+        return NodePool<NodeType>().Allocate();
+    }
+
+    template<typename NodeType>
+    static void FreePooled(void *pData, size_t Size)
+    {
+        if (Size != sizeof(NodeType)) ::operator delete(pData);
+        else NodePool<NodeType>().Free(pData);
+    }
+
+private:
+    template<typename NodeType>
+    static TSlabAllocator<NodeType>& NodePool()
+    {
+        // Intentionally never destroyed, so nodes that outlive static destruction can still be freed
+        static TSlabAllocator<NodeType> *spPool = new TSlabAllocator<NodeType>;
+        return *spPool;
+    }
 };
 
 #endif // CSCENENODE_H
@@ -117,6 +117,14 @@ void CScriptAttachNode::RayAABoxIntersectTest(CRayCollisionTester& rTester, cons
         rTester.AddNodeModel(this, pModel);
 }
 
+bool CScriptAttachNode::ExpandSceneBounds(CAABox& rBounds)
+{
+    if (!Model())
+        return true;
+
+    return CSceneNode::ExpandSceneBounds(rBounds);
+}
+
 SRayIntersection CScriptAttachNode::RayNodeIntersectTest(const CRay& rkRay, uint32 AssetID, const SViewInfo& rkViewInfo)
 {
     FRenderOptions Options = rkViewInfo.pRenderer->RenderOptions();
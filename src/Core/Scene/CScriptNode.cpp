@@ -79,6 +79,16 @@ CScriptNode::CScriptNode(CScene *pScene, uint32 NodeID, CSceneNode *pParent, CSc
     mpExtra = CScriptExtra::CreateExtra(this);
 }
 
+void* CScriptNode::operator new(size_t Size)
+{
+    return AllocatePooled<CScriptNode>(Size);
+}
+
+void CScriptNode::operator delete(void *pData, size_t Size)
+{
+    FreePooled<CScriptNode>(pData, Size);
+}
+
 ENodeType CScriptNode::NodeType()
 {
     return ENodeType::Script;
@@ -426,6 +436,40 @@ SRayIntersection CScriptNode::RayNodeIntersectTest(const CRay& rkRay, uint32 Ass
     return Out;
 }
 
+bool CScriptNode::ExpandSceneBounds(CAABox& rBounds)
+{
+    if (!mpInstance)
+        return true;
+
+    // Extras can draw and pick just about anything, and selected objects draw their links, so neither can be culled
+    if (mpExtra || IsSelected())
+        return false;
+
+    rBounds.ExpandBounds(AABox());
+
+    if (!UsesModel())
+    {
+        // Same box as the billboard ray test
+        CVector2f BillScale = BillboardScale();
+        float ScaleXY = (BillScale.X > BillScale.Y ? BillScale.X : BillScale.Y);
+
+        rBounds.ExpandBounds(CAABox(mPosition + CVector3f(-ScaleXY, -ScaleXY, -BillScale.Y),
+                                    mPosition + CVector3f( ScaleXY,  ScaleXY,  BillScale.Y)));
+    }
+
+    // Child nodes aren't in the scene BVH themselves, so they go in our bounds
+    if (!mpCollisionNode->ExpandSceneBounds(rBounds))
+        return false;
+
+    for (uint32 iAttach = 0; iAttach < mAttachments.size(); iAttach++)
+    {
+        if (!mAttachments[iAttach]->ExpandSceneBounds(rBounds))
+            return false;
+    }
+
+    return true;
+}
+
 bool CScriptNode::AllowsRotate() const
 {
     return (Template()->RotationType() == CScriptTemplate::ERotationType::RotationEnabled);
@@ -34,6 +34,8 @@ class CScriptNode : public CSceneNode
 
 public:
     CScriptNode(CScene *pScene, uint32 NodeID, CSceneNode *pParent = 0, CScriptObject *pObject = 0);
+    static void* operator new(size_t Size);
+    static void operator delete(void *pData, size_t Size);
     ENodeType NodeType();
     void PostLoad();
     void OnTransformed();
@@ -42,6 +44,7 @@ public:
     void DrawSelection();
     void RayAABoxIntersectTest(CRayCollisionTester& rTester, const SViewInfo& rkViewInfo);
     SRayIntersection RayNodeIntersectTest(const CRay& rkRay, uint32 AssetID, const SViewInfo& rkViewInfo);
+    bool ExpandSceneBounds(CAABox& rBounds);
     bool AllowsRotate() const;
     bool AllowsScale() const;
     bool IsVisible() const;
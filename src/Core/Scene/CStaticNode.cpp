@@ -13,6 +13,16 @@ CStaticNode::CStaticNode(CScene *pScene, uint32 NodeID, CSceneNode *pParent, CSt
     SetName("Static Node");
 }
 
+void* CStaticNode::operator new(size_t Size)
+{
+    return AllocatePooled<CStaticNode>(Size);
+}
+
+void CStaticNode::operator delete(void *pData, size_t Size)
+{
+    FreePooled<CStaticNode>(pData, Size);
+}
+
 ENodeType CStaticNode::NodeType()
 {
     return ENodeType::Static;
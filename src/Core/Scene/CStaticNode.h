@@ -10,6 +10,8 @@ class CStaticNode : public CSceneNode
 
 public:
     CStaticNode(CScene *pScene, uint32 NodeID, CSceneNode *pParent = 0, CStaticModel *pModel = 0);
+    static void* operator new(size_t Size);
+    static void operator delete(void *pData, size_t Size);
     ENodeType NodeType();
     void PostLoad();
     void AddToRenderer(CRenderer *pRenderer, const SViewInfo& rkViewInfo);
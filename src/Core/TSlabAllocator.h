@@ -0,0 +1,77 @@
+#ifndef TSLABALLOCATOR_H
+#define TSLABALLOCATOR_H
+
+#include <Common/BasicTypes.h>
+#include <mutex>
+#include <vector>
+
+/**
+ * Allocates fixed-size blocks for objects of type T out of large slabs. This is intended
+ * for classes that are allocated in large numbers and live for a long time (such as
+ * resource entries), to keep them close together in memory and to avoid per-object heap
+ * overhead. Freed blocks are reused, but slabs are only released when the allocator is
+ * destroyed. Allocation and free are thread-safe.
+ */
+template<typename T, uint kBlocksPerSlab = 256>
+class TSlabAllocator
+{
+    union UBlock
+    {
+        UBlock *pNext;
+        alignas(T) uint8 Data[sizeof(T)];
+    };
+
+    std::vector<UBlock*> mSlabs;
+    UBlock *mpFreeList;
+    std::mutex mMutex;
+
+public:
+    TSlabAllocator()
+        : mpFreeList(nullptr)
+    {}
+
+    ~TSlabAllocator()
+    {
+        for (UBlock *pSlab : mSlabs)
+            delete[] pSlab;
+    }
+
+    TSlabAllocator(const TSlabAllocator&) = delete;
+    TSlabAllocator& operator=(const TSlabAllocator&) = delete;
+
+    void* Allocate()
+    {
+        std::lock_guard<std::mutex> Lock(mMutex);
+
+        if (!mpFreeList)
+        {
+            UBlock *pSlab = new UBlock[kBlocksPerSlab];
+            mSlabs.push_back(pSlab);
+
+            // Link blocks in reverse so they're handed out in address order
+            for (uint BlockIdx = kBlocksPerSlab; BlockIdx-- > 0;)
+            {
+                pSlab[BlockIdx].pNext = mpFreeList;
+                mpFreeList = &pSlab[BlockIdx];
+            }
+        }
+
+        UBlock *pBlock = mpFreeList;
+        mpFreeList = pBlock->pNext;
+        return pBlock;
+    }
+
+    void Free(void *pData)
+    {
+        if (!pData) return;
+
+        std::lock_guard<std::mutex> Lock(mMutex);
+        UBlock *pBlock = static_cast<UBlock*>(pData);
+        pBlock->pNext = mpFreeList;
+        mpFreeList = pBlock;
+    }
+
+    inline uint32 NumSlabs() const  { return mSlabs.size(); }
+};
+
+#endif // TSLABALLOCATOR_H
@@ -15,6 +15,7 @@
 
 #include <Common/Macros.h>
 #include <Common/CTimer.h>
+#include <Core/GameProject/CAsyncResourceLoader.h>
 #include <Core/GameProject/CGameProject.h>
 
 #include <QFuture>
@@ -97,6 +98,12 @@ bool CEditorApplication::OpenProject(const QString& rkProjPath)
 
     CProgressDialog Dialog("Opening " + TO_QSTRING(Path.GetFileName()), true, true, mpWorldEditor);
     Dialog.DisallowCanceling();
+
+    // Loading the project swaps gpResourceStore on the loading thread, which cancels background loads for
+    // the current store. They can only be cancelled from this thread, so stop them here first.
+    if (gpResourceStore)
+        gpResourceStore->AsyncLoader()->CancelAll();
+
     QFuture<CGameProject*> Future = QtConcurrent::run(&CGameProject::LoadProject, Path, &Dialog);
     mpActiveProject = Dialog.WaitForResults(Future);
     Dialog.close();
@@ -236,6 +243,9 @@ bool CEditorApplication::CookPackageList(QList<CPackage*> PackageList)
     {
         CProgressDialog Dialog("Cooking package" + QString(PackageList.size() > 1  ? "s" : ""), false, true, mpWorldEditor);
 
+        // Background loads can only be cancelled from this thread, so stop them before handing the store over
+        mpActiveProject->ResourceStore()->AsyncLoader()->CancelAll();
+
         QFuture<void> Future = QtConcurrent::run([&]()
         {
             Dialog.SetNumTasks(PackageList.size());
@@ -288,6 +298,7 @@ bool CEditorApplication::RebuildResourceDatabase()
         Dialog.SetOneShotTask("Rebuilding resource database");
         Dialog.DisallowCanceling();
 
+        pProj->ResourceStore()->AsyncLoader()->CancelAll();
         QFuture<void> Future = QtConcurrent::run(pProj->ResourceStore(), &CResourceStore::RebuildFromDirectory);
         Dialog.WaitForResults(Future);
         Dialog.close();
@@ -5,6 +5,7 @@
 
 #include <Common/Macros.h>
 #include <Core/GameProject/CAssetNameMap.h>
+#include <Core/GameProject/CAsyncResourceLoader.h>
 #include <Core/GameProject/CGameExporter.h>
 #include <Core/GameProject/CGameInfo.h>
 #include <Core/Resource/Script/CGameTemplate.h>
@@ -456,6 +457,10 @@ void CExportGameDialog::Export()
     TString StrExportDir = TO_TSTRING(ExportDir);
     StrExportDir.EnsureEndsWith('/');
 
+    // The exporter points gpResourceStore at the new store, so background loads for the current one have to stop first
+    if (gpResourceStore)
+        gpResourceStore->AsyncLoader()->CancelAll();
+
     CProgressDialog Dialog("Creating new game project", false, true, parentWidget());
     QFuture<bool> Future = QtConcurrent::run(mpExporter, &CGameExporter::Export, mpDisc, StrExportDir, &NameMap, &GameInfo, &Dialog);
     mExportSuccess = Dialog.WaitForResults(Future);
@@ -7,6 +7,7 @@
 #include "UICommon.h"
 #include "Editor/ResourceBrowser/CResourceBrowser.h"
 #include <Common/Macros.h>
+#include <Core/CompressionUtil.h>
 #include <Core/GameProject/CGameExporter.h>
 #include <Core/GameProject/COpeningBanner.h>
 
@@ -26,6 +27,7 @@ CProjectSettingsDialog::CProjectSettingsDialog(QWidget *pParent)
     mpUI->setupUi(this);
 
     connect(mpUI->GameNameLineEdit, SIGNAL(editingFinished()), this, SLOT(GameNameChanged()));
+    connect(mpUI->CompressionLevelComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(CompressionLevelChanged(int)));
     connect(mpUI->CookPackageButton, SIGNAL(clicked()), this, SLOT(CookPackage()));
     connect(mpUI->CookAllDirtyPackagesButton, SIGNAL(clicked(bool)), this, SLOT(CookAllDirtyPackages()));
     connect(mpUI->BuildIsoButton, SIGNAL(clicked(bool)), this, SLOT(BuildISO()));
@@ -65,6 +67,16 @@ void CProjectSettingsDialog::ActiveProjectChanged(CGameProject *pProj)
         mpUI->BuildLineEdit->setText( QString("%1 (%2)").arg(BuildVer).arg( TO_QSTRING(BuildName) ) );
         mpUI->RegionLineEdit->setText( TO_QSTRING(RegionName) );
 
+        // Compression level. The combo box items are in the same order as ECompressionLevel.
+        bool LevelApplies = pProj->UsesZlibCompression() || CompressionUtil::LZOSupportsCompressionLevels();
+        mpUI->CompressionLevelComboBox->blockSignals(true);
+        mpUI->CompressionLevelComboBox->setCurrentIndex( (int) pProj->CookCompressionLevel() );
+        mpUI->CompressionLevelComboBox->blockSignals(false);
+        mpUI->CompressionLevelComboBox->setEnabled(LevelApplies);
+        mpUI->CompressionLevelComboBox->setToolTip(LevelApplies ?
+            "Compression effort used when cooking packages. Lower levels cook faster, but make larger paks." :
+            "This build compresses LZO with lzokay, which only has one compression level.");
+
         // Banner info
         COpeningBanner Banner(pProj);
         mpUI->GameNameLineEdit->setText( TO_QSTRING(Banner.EnglishGameName()) );
@@ -79,6 +91,7 @@ void CProjectSettingsDialog::ActiveProjectChanged(CGameProject *pProj)
         mpUI->BuildLineEdit->clear();
         mpUI->RegionLineEdit->clear();
         mpUI->GameNameLineEdit->clear();
+        mpUI->CompressionLevelComboBox->setEnabled(false);
         close();
     }
 
@@ -97,6 +110,15 @@ void CProjectSettingsDialog::GameNameChanged()
     }
 }
 
+void CProjectSettingsDialog::CompressionLevelChanged(int NewIndex)
+{
+    if (mpProject && NewIndex != -1)
+    {
+        mpProject->SetCookCompressionLevel( (ECompressionLevel) NewIndex );
+        mpProject->Save();
+    }
+}
+
 void CProjectSettingsDialog::SetupPackagesList()
 {
     mpUI->PackagesList->clear();
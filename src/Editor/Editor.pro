@@ -201,6 +201,8 @@ HEADERS += \
     CTweakEditor.h \
     Undo/CEditIntrinsicPropertyCommand.h \
     Undo/TSerializeUndoCommand.h \
+    Undo/CSnapshotDelta.h \
+    Undo/CUndoStack.h \
     StringEditor/CStringMimeData.h \
     ScanEditor/CScanEditor.h \
     Undo/ICreateDeleteResourceCommand.h \
@@ -279,6 +281,8 @@ SOURCES += \
     CPropertyNameValidator.cpp \
     CGeneratePropertyNamesDialog.cpp \
     Undo/IEditPropertyCommand.cpp \
+    Undo/CSnapshotDelta.cpp \
+    Undo/CUndoStack.cpp \
     StringEditor/CStringEditor.cpp \
     StringEditor/CStringListModel.cpp \
     IEditor.cpp \
@@ -54,7 +54,7 @@ bool IEditor::CheckUnsavedChanges()
 
         else if (Result == QMessageBox::No)
         {
-            mUndoStack.setIndex(0); // Revert all changes
+            mUndoStack.RevertToClean(); // Revert all changes
             OkToClear = true;
         }
 
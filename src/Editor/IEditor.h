@@ -7,6 +7,7 @@
 #include <QUndoStack>
 
 #include "CEditorApplication.h"
+#include "Undo/CUndoStack.h"
 
 /** Base class of all editor windows */
 class IEditor : public QMainWindow
@@ -15,7 +16,7 @@ class IEditor : public QMainWindow
 
 protected:
     // Undo stack
-    QUndoStack mUndoStack;
+    CUndoStack mUndoStack;
     QList<QAction*> mUndoActions;
 
 public:
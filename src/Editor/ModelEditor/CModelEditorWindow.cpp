@@ -793,8 +793,12 @@ void CModelEditorWindow::ConvertToTXTR()
     CTexture *pTex = CTextureDecoder::LoadDDS(InTextureFile, nullptr);
     TString OutName = TexFilename.GetFilePathWithoutExtension() + ".txtr";
 
-    if ((pTex->TexelFormat() != ETexelFormat::DXT1) || (pTex->NumMipMaps() > 1))
-        QMessageBox::warning(this, "Error", "Can't convert DDS to TXTR! Save your texture as a DXT1 DDS with no mipmaps, then try again.");
+    // RGBA8 textures are encoded to the best matching GX format with generated mipmaps; DXT1 is converted directly to CMPR
+    bool IsRGBA8 = (pTex->TexelFormat() == ETexelFormat::RGBA8);
+    bool IsDXT1 = (pTex->TexelFormat() == ETexelFormat::DXT1 && pTex->NumMipMaps() == 1);
+
+    if (!IsRGBA8 && !IsDXT1)
+        QMessageBox::warning(this, "Error", "Can't convert DDS to TXTR! Save your texture as an uncompressed RGBA8 DDS, or a DXT1 DDS with no mipmaps, then try again.");
 
     else
     {
@@ -803,7 +807,7 @@ void CModelEditorWindow::ConvertToTXTR()
 
         else
         {
-            CTextureEncoder::EncodeTXTR(Out, pTex, ETexelFormat::GX_CMPR);
+            CTextureEncoder::EncodeTXTR(Out, pTex);
             QMessageBox::information(this, "Success", "Successfully converted to TXTR!");
         }
     }
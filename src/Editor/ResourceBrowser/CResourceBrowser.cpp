@@ -12,6 +12,7 @@
 #include "Editor/Undo/ICreateDeleteDirectoryCommand.h"
 #include "Editor/Undo/ICreateDeleteResourceCommand.h"
 #include <Core/GameProject/AssetNameGeneration.h>
+#include <Core/GameProject/CAsyncResourceLoader.h>
 #include <Core/GameProject/CAssetNameMap.h>
 
 #include <QCheckBox>
@@ -944,6 +945,8 @@ void CResourceBrowser::GenerateAssetNames()
     // Temporarily set root to null to ensure the window doesn't access the resource store while we're running.
     mpDirectoryModel->SetRoot(mpStore->RootDirectory());
 
+    // Background loads can only be cancelled from this thread, so stop them before handing the store over
+    mpStore->AsyncLoader()->CancelAll();
     QFuture<void> Future = QtConcurrent::run(&::GenerateAssetNames, mpStore->Project());
     Dialog.WaitForResults(Future);
 
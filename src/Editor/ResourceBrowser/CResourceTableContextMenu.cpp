@@ -2,6 +2,7 @@
 #include "CResourceBrowser.h"
 #include "Editor/CEditorApplication.h"
 
+#include <Core/GameProject/CDependencyIndex.h>
 #include <Core/Resource/Scan/CScan.h>
 
 #include <QClipboard>
@@ -168,13 +169,13 @@ void CResourceTableContextMenu::ShowReferencers()
 {
     ASSERT(mpClickedEntry);
 
+    std::vector<CResourceEntry*> Referencers;
+    mpClickedEntry->ResourceStore()->DependencyIndex()->FindReferencers(mpClickedEntry->ID(), Referencers);
+
     QList<CResourceEntry*> EntryList;
 
-    for (CResourceIterator Iter(mpClickedEntry->ResourceStore()); Iter; ++Iter)
-    {
-        if (Iter->Dependencies()->HasDependency(mpClickedEntry->ID()))
-            EntryList << *Iter;
-    }
+    for (CResourceEntry *pEntry : Referencers)
+        EntryList << pEntry;
 
     if (!mpModel->IsDisplayingUserEntryList())
         mpBrowser->SetInspectedEntry(mpClickedEntry);
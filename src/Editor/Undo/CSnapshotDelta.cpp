@@ -0,0 +1,159 @@
+#include "CSnapshotDelta.h"
+#include <Common/Macros.h>
+#include <Common/Math/MathUtil.h>
+#include <cstring>
+
+namespace
+{
+
+/** Header at the start of every delta */
+struct SDeltaHeader
+{
+    uint32 BaseSize;
+    uint32 TargetSize;
+    uint32 PrefixSize;
+    uint32 SuffixSize;
+};
+
+/** Matching stretches shorter than this are cheaper to store as part of the surrounding literal than as a new run */
+const uint32 gkMinMatchRun = 2 * sizeof(uint32);
+
+void WriteValue(std::vector<char>& rData, uint32 Value)
+{
+    const char *pkBytes = reinterpret_cast<const char*>(&Value);
+    rData.insert(rData.end(), pkBytes, pkBytes + sizeof(uint32));
+}
+
+uint32 ReadValue(const char*& rpkData)
+{
+    uint32 Value;
+    memcpy(&Value, rpkData, sizeof(uint32));
+    rpkData += sizeof(uint32);
+    return Value;
+}
+
+}
+
+CSnapshotDelta::CSnapshotDelta()
+    : mMatchesBase(false)
+{
+}
+
+CSnapshotDelta::CSnapshotDelta(const std::vector<char>& rkBase, const std::vector<char>& rkTarget)
+{
+    SDeltaHeader Header;
+    Header.BaseSize = rkBase.size();
+    Header.TargetSize = rkTarget.size();
+
+    // Find the data shared with the base at the start and end
+    uint32 MaxShared = Math::Min(Header.BaseSize, Header.TargetSize);
+    Header.PrefixSize = 0;
+
+    while (Header.PrefixSize < MaxShared && rkBase[Header.PrefixSize] == rkTarget[Header.PrefixSize])
+        Header.PrefixSize++;
+
+    Header.SuffixSize = 0;
+
+    while (Header.SuffixSize < MaxShared - Header.PrefixSize &&
+           rkBase[Header.BaseSize - Header.SuffixSize - 1] == rkTarget[Header.TargetSize - Header.SuffixSize - 1])
+    {
+        Header.SuffixSize++;
+    }
+
+    mMatchesBase = (Header.BaseSize == Header.TargetSize && Header.PrefixSize == Header.TargetSize);
+
+    const char *pkHeader = reinterpret_cast<const char*>(&Header);
+    mData.insert(mData.end(), pkHeader, pkHeader + sizeof(SDeltaHeader));
+
+    // Encode the middle section
+    uint32 MiddleEnd = Header.TargetSize - Header.SuffixSize;
+
+    if (Header.BaseSize == Header.TargetSize)
+    {
+        // Same size; diff the two byte by byte
+        uint32 Offset = Header.PrefixSize;
+
+        while (Offset < MiddleEnd)
+        {
+            uint32 MatchStart = Offset;
+
+            while (Offset < MiddleEnd && rkBase[Offset] == rkTarget[Offset])
+                Offset++;
+
+            uint32 LiteralStart = Offset;
+
+            while (Offset < MiddleEnd)
+            {
+                if (rkBase[Offset] != rkTarget[Offset])
+                {
+                    Offset++;
+                    continue;
+                }
+
+                // End the literal here if the bytes match for long enough to be worth a new run
+                uint32 MatchEnd = Offset;
+
+                while (MatchEnd < MiddleEnd && MatchEnd - Offset < gkMinMatchRun && rkBase[MatchEnd] == rkTarget[MatchEnd])
+                    MatchEnd++;
+
+                if (MatchEnd - Offset >= gkMinMatchRun || MatchEnd == MiddleEnd)
+                    break;
+
+                Offset = MatchEnd;
+            }
+
+            WriteValue(mData, LiteralStart - MatchStart);
+            WriteValue(mData, Offset - LiteralStart);
+            mData.insert(mData.end(), rkTarget.begin() + LiteralStart, rkTarget.begin() + Offset);
+        }
+    }
+    else
+    {
+        // The edit shifted the data; store the middle as-is
+        WriteValue(mData, 0);
+        WriteValue(mData, MiddleEnd - Header.PrefixSize);
+        mData.insert(mData.end(), rkTarget.begin() + Header.PrefixSize, rkTarget.begin() + MiddleEnd);
+    }
+
+    mData.shrink_to_fit();
+}
+
+void CSnapshotDelta::Apply(const std::vector<char>& rkBase, std::vector<char>& rOut) const
+{
+    ASSERT(!IsEmpty());
+
+    SDeltaHeader Header;
+    memcpy(&Header, mData.data(), sizeof(SDeltaHeader));
+    ASSERT(Header.BaseSize == rkBase.size());
+
+    rOut.resize(Header.TargetSize);
+    if (Header.TargetSize == 0) return;
+
+    memcpy(rOut.data(), rkBase.data(), Header.PrefixSize);
+    memcpy(rOut.data() + Header.TargetSize - Header.SuffixSize, rkBase.data() + Header.BaseSize - Header.SuffixSize, Header.SuffixSize);
+
+    const char *pkData = mData.data() + sizeof(SDeltaHeader);
+    const char *pkDataEnd = mData.data() + mData.size();
+    uint32 Offset = Header.PrefixSize;
+
+    while (pkData < pkDataEnd)
+    {
+        uint32 MatchSize = ReadValue(pkData);
+        uint32 LiteralSize = ReadValue(pkData);
+
+        memcpy(rOut.data() + Offset, rkBase.data() + Offset, MatchSize);
+        Offset += MatchSize;
+
+        memcpy(rOut.data() + Offset, pkData, LiteralSize);
+        Offset += LiteralSize;
+        pkData += LiteralSize;
+    }
+
+    ASSERT(Offset == Header.TargetSize - Header.SuffixSize);
+}
+
+void CSnapshotDelta::Clear()
+{
+    std::vector<char>().swap(mData);
+    mMatchesBase = false;
+}
@@ -0,0 +1,36 @@
+#ifndef CSNAPSHOTDELTA_H
+#define CSNAPSHOTDELTA_H
+
+#include <Common/BasicTypes.h>
+#include <vector>
+
+/**
+ * Compact binary difference between two serialized snapshots of the same object.
+ * Undo commands keep one full snapshot of the object's old state and store the new state
+ * as a delta against it. Most edits only change a handful of bytes, so the delta is
+ * usually a tiny fraction of the size of a second snapshot.
+ *
+ * The delta stores the target's common prefix/suffix lengths with the base, and the bytes
+ * in between as a list of runs: a number of bytes that match the base at the same offset,
+ * followed by literal bytes. If the edit changed the size of the data, the middle section
+ * is stored as one literal run.
+ */
+class CSnapshotDelta
+{
+    std::vector<char> mData;
+    bool mMatchesBase;
+
+public:
+    CSnapshotDelta();
+    CSnapshotDelta(const std::vector<char>& rkBase, const std::vector<char>& rkTarget);
+
+    /** Reconstruct the target snapshot. The base must be the same data the delta was encoded against. */
+    void Apply(const std::vector<char>& rkBase, std::vector<char>& rOut) const;
+    void Clear();
+
+    inline bool IsEmpty() const             { return mData.empty(); }
+    inline bool MatchesBase() const         { return mMatchesBase; }
+    inline uint32 MemoryUsage() const       { return mData.capacity(); }
+};
+
+#endif // CSNAPSHOTDELTA_H
@@ -0,0 +1,114 @@
+#include "CUndoStack.h"
+#include "IUndoCommand.h"
+#include <QSettings>
+
+const char* const gkUndoMemoryBudgetSetting = "Editor/UndoMemoryBudgetMB";
+const uint64 gkDefaultUndoMemoryBudgetMB = 128;
+
+namespace
+{
+
+/** Memory used by a command and its children */
+uint64 CommandMemoryUsage(const QUndoCommand* pkCmd)
+{
+    uint64 Usage = 0;
+
+    if (const IUndoCommand* pkUndoCmd = dynamic_cast<const IUndoCommand*>(pkCmd))
+        Usage += pkUndoCmd->UndoMemoryUsage();
+
+    for (int ChildIdx = 0; ChildIdx < pkCmd->childCount(); ChildIdx++)
+        Usage += CommandMemoryUsage(pkCmd->child(ChildIdx));
+
+    return Usage;
+}
+
+/** Release the undo data of a command and its children */
+void ReleaseCommandData(QUndoCommand* pCmd)
+{
+    if (IUndoCommand* pUndoCmd = dynamic_cast<IUndoCommand*>(pCmd))
+        pUndoCmd->ReleaseUndoData();
+
+    for (int ChildIdx = 0; ChildIdx < pCmd->childCount(); ChildIdx++)
+        ReleaseCommandData(const_cast<QUndoCommand*>(pCmd->child(ChildIdx)));
+}
+
+}
+
+CUndoStack::CUndoStack(QObject* pParent /*= 0*/)
+    : QUndoStack(pParent)
+    , mMemoryBudget(DefaultMemoryBudget())
+{
+    connect(this, SIGNAL(indexChanged(int)), this, SLOT(EnforceMemoryBudget()));
+}
+
+uint64 CUndoStack::MemoryUsage() const
+{
+    uint64 Usage = 0;
+
+    for (int CmdIdx = 0; CmdIdx < count(); CmdIdx++)
+        Usage += CommandMemoryUsage(command(CmdIdx));
+
+    return Usage;
+}
+
+void CUndoStack::SetMemoryBudget(uint64 Budget)
+{
+    mMemoryBudget = Budget;
+    EnforceMemoryBudget();
+}
+
+void CUndoStack::RevertToClean()
+{
+    // Commands between the clean state and the current state are never expired, so the clean state
+    // can be restored exactly. If it was discarded (by pushing after undoing past it), undo as far as
+    // possible instead; unlike setIndex(0), undo() skips over expired commands instead of undoing them.
+    if (cleanIndex() != -1)
+        setIndex(cleanIndex());
+    else
+    {
+        while (canUndo())
+            undo();
+    }
+}
+
+void CUndoStack::EnforceMemoryBudget()
+{
+    // A budget of 0 means unlimited
+    if (mMemoryBudget == 0)
+        return;
+
+    // If the clean state was discarded (by pushing after undoing past it), there's no telling which
+    // commands are saved, so nothing is expired until the stack is saved again
+    if (cleanIndex() == -1)
+        return;
+
+    uint64 Usage = MemoryUsage();
+
+    // Only commands that can currently be undone are expired; commands past the current index are
+    // discarded by QUndoStack anyway the next time something is pushed. Commands after the clean
+    // index are unsaved changes, which are kept so that reverting them always works.
+    int EndIdx = qMin(index() - 1, cleanIndex());
+
+    for (int CmdIdx = 0; CmdIdx < EndIdx && Usage > mMemoryBudget; CmdIdx++)
+    {
+        QUndoCommand* pCmd = const_cast<QUndoCommand*>(command(CmdIdx));
+        if (pCmd->isObsolete()) continue;
+
+        Usage -= CommandMemoryUsage(pCmd);
+        ReleaseCommandData(pCmd);
+        pCmd->setObsolete(true);
+    }
+}
+
+// ************ STATIC ************
+uint64 CUndoStack::DefaultMemoryBudget()
+{
+    QSettings Settings;
+    return Settings.value(gkUndoMemoryBudgetSetting, gkDefaultUndoMemoryBudgetMB).toULongLong() * 1024 * 1024;
+}
+
+void CUndoStack::SetDefaultMemoryBudget(uint64 Budget)
+{
+    QSettings Settings;
+    Settings.setValue(gkUndoMemoryBudgetSetting, Budget / (1024 * 1024));
+}
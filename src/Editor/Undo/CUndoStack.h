@@ -0,0 +1,39 @@
+#ifndef CUNDOSTACK_H
+#define CUNDOSTACK_H
+
+#include <Common/BasicTypes.h>
+#include <QUndoStack>
+
+/**
+ * Undo stack that reclaims the undo data of saved history once it exceeds a memory budget.
+ * Whenever the index changes, the oldest commands are expired until the rest fit in the budget.
+ * Expired commands release their undo data and are marked obsolete, so QUndoStack discards
+ * them instead of undoing them; nothing can be undone past an expired command.
+ *
+ * Only commands from before the clean state are ever expired, so unsaved changes can always be
+ * reverted. This means the budget is a cap on saved history, not on total undo memory: until the
+ * first save, or while QUndoStack has discarded the clean state, nothing is expired, and a command
+ * that keeps growing through merges (such as a slider drag) isn't limited at all.
+ */
+class CUndoStack : public QUndoStack
+{
+    Q_OBJECT
+    uint64 mMemoryBudget;
+
+public:
+    explicit CUndoStack(QObject* pParent = 0);
+
+    uint64 MemoryUsage() const;
+    void SetMemoryBudget(uint64 Budget);
+    void RevertToClean();
+
+    inline uint64 MemoryBudget() const  { return mMemoryBudget; }
+
+    static uint64 DefaultMemoryBudget();
+    static void SetDefaultMemoryBudget(uint64 Budget);
+
+public slots:
+    void EnforceMemoryBudget();
+};
+
+#endif // CUNDOSTACK_H
@@ -31,6 +31,12 @@ void IEditPropertyCommand::RestoreObjectStateFromArray(std::vector<char>& rArray
     }
 }
 
+/** Reconstruct the full new data from the delta */
+void IEditPropertyCommand::GetNewData(std::vector<char>& rOut) const
+{
+    mNewDelta.Apply(mOldData, rOut);
+}
+
 IEditPropertyCommand::IEditPropertyCommand(
         IProperty* pProperty,
         CPropertyModel* pModel,
@@ -67,20 +73,31 @@ IEditPropertyCommand::IEditPropertyCommand(
 
 void IEditPropertyCommand::SaveOldData()
 {
+    // The new data is a delta against the old data, so it needs to be re-encoded if it was saved first
+    std::vector<char> NewData;
+
+    if (mSavedNewData)
+        GetNewData(NewData);
+
+    mOldData.clear();
     SaveObjectStateToArray(mOldData);
     mSavedOldData = true;
+
+    if (mSavedNewData)
+        mNewDelta = CSnapshotDelta(mOldData, NewData);
 }
 
 void IEditPropertyCommand::SaveNewData()
 {
-    SaveObjectStateToArray(mNewData);
+    std::vector<char> NewData;
+    SaveObjectStateToArray(NewData);
+    mNewDelta = CSnapshotDelta(mOldData, NewData);
     mSavedNewData = true;
 }
 
 bool IEditPropertyCommand::IsNewDataDifferent()
 {
-    if (mOldData.size() != mNewData.size()) return true;
-    return memcmp(mOldData.data(), mNewData.data(), mNewData.size()) != 0;
+    return !mNewDelta.MatchesBase();
 }
 
 void IEditPropertyCommand::SetEditComplete(bool IsComplete)
@@ -116,8 +133,10 @@ bool IEditPropertyCommand::mergeWith(const QUndoCommand *pkOther)
                         return false;
                 }
 
-                // Match
-                mNewData = pkCmd->mNewData;
+                // Match; re-encode their new data against our old data
+                std::vector<char> NewData;
+                pkCmd->GetNewData(NewData);
+                mNewDelta = CSnapshotDelta(mOldData, NewData);
                 mCommandEnded = pkCmd->mCommandEnded;
                 return true;
             }
@@ -129,6 +148,10 @@ bool IEditPropertyCommand::mergeWith(const QUndoCommand *pkOther)
 
 void IEditPropertyCommand::undo()
 {
+    // Expired commands have no data left to restore
+    if (isObsolete())
+        return;
+
     ASSERT(mSavedOldData && mSavedNewData);
     RestoreObjectStateFromArray(mOldData);
     mCommandEnded = true;
@@ -145,8 +168,13 @@ void IEditPropertyCommand::undo()
 
 void IEditPropertyCommand::redo()
 {
+    if (isObsolete())
+        return;
+
     ASSERT(mSavedOldData && mSavedNewData);
-    RestoreObjectStateFromArray(mNewData);
+    std::vector<char> NewData;
+    GetNewData(NewData);
+    RestoreObjectStateFromArray(NewData);
 
     if (mpModel && mIndex.isValid())
     {
@@ -162,3 +190,14 @@ bool IEditPropertyCommand::AffectsCleanState() const
 {
     return true;
 }
+
+uint32 IEditPropertyCommand::UndoMemoryUsage() const
+{
+    return mOldData.capacity() + mNewDelta.MemoryUsage();
+}
+
+void IEditPropertyCommand::ReleaseUndoData()
+{
+    std::vector<char>().swap(mOldData);
+    mNewDelta.Clear();
+}
@@ -2,15 +2,17 @@
 #define IEDITPROPERTYCOMMAND_H
 
 #include "IUndoCommand.h"
+#include "CSnapshotDelta.h"
 #include "EUndoCommand.h"
 #include "Editor/PropertyEdit/CPropertyModel.h"
 
 class IEditPropertyCommand : public IUndoCommand
 {
 protected:
-    // Has to be std::vector for compatibility with CVectorOutStream
+    // Has to be std::vector for compatibility with CVectorOutStream.
+    // The new data is stored as a delta against the old data.
     std::vector<char> mOldData;
-    std::vector<char> mNewData;
+    CSnapshotDelta mNewDelta;
 
     IProperty* mpProperty;
     CPropertyModel* mpModel;
@@ -25,6 +27,9 @@ protected:
     /** Restore the state of the object properties from the given data buffer */
     void RestoreObjectStateFromArray(std::vector<char>& rArray);
 
+    /** Reconstruct the full new data from the delta */
+    void GetNewData(std::vector<char>& rOut) const;
+
 public:
     IEditPropertyCommand(
             IProperty* pProperty,
@@ -50,6 +55,8 @@ public:
     void undo();
     void redo();
     bool AffectsCleanState() const;
+    uint32 UndoMemoryUsage() const;
+    void ReleaseUndoData();
 };
 
 #endif // IEDITPROPERTYCOMMAND_H
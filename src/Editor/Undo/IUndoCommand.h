@@ -1,6 +1,7 @@
 #ifndef IUNDOCOMMAND
 #define IUNDOCOMMAND
 
+#include <Common/BasicTypes.h>
 #include <QUndoCommand>
 
 class IUndoCommand : public QUndoCommand
@@ -13,6 +14,13 @@ public:
         : QUndoCommand(rkText, pParent) {}
 
     virtual bool AffectsCleanState() const = 0;
+
+    /** Memory used by the command's undo data, in bytes. This counts against the undo stack's memory budget. */
+    virtual uint32 UndoMemoryUsage() const  { return 0; }
+
+    /** Free the command's undo data. Called by the undo stack when it expires the command, after which
+     *  the command is never undone or redone again. */
+    virtual void ReleaseUndoData()          {}
 };
 
 #endif // IUNDOCOMMAND
@@ -2,6 +2,7 @@
 #define TSERIALIZEUNDOCOMMAND_H
 
 #include "IUndoCommand.h"
+#include "CSnapshotDelta.h"
 #include <Common/Common.h>
 
 /**
@@ -12,20 +13,32 @@
  * Commands with IsActionComplete=false will be merged.
  * To prevent merging, push a final command with IsActionComplete=true.
  *
- * The current implementatation is "dumb" and just saves and restores
- * the entire object, including parameters that have not changed. Due
- * to this, it could be memory-intensive and not super performant.
- * As a result, it's probably not a good idea to use this on very
- * large objects right now.
+ * The command keeps a full snapshot of the object's old state, and only
+ * a delta against it for the new state, so commands that only change a
+ * small part of a large object stay small.
  */
 template<typename ObjectT>
 class TSerializeUndoCommand : public IUndoCommand
 {
     ObjectT* mpObject;
     std::vector<char> mOldData;
-    std::vector<char> mNewData;
+    CSnapshotDelta mNewDelta;
     bool mIsActionComplete;
 
+    void SaveState(std::vector<char>& rOut) const
+    {
+        CVectorOutStream Out(&rOut, EEndian::SystemEndian);
+        CBasicBinaryWriter Writer(&Out, 0, EGame::Invalid);
+        mpObject->Serialize(Writer);
+    }
+
+    void RestoreState(std::vector<char>& rData)
+    {
+        CMemoryInStream In(rData.data(), rData.size(), EEndian::SystemEndian);
+        CBasicBinaryReader Reader(&In, CSerialVersion(0,0,EGame::Invalid));
+        mpObject->Serialize(Reader);
+    }
+
 public:
     TSerializeUndoCommand(const QString& kText, ObjectT* pObject, bool IsActionComplete)
         : IUndoCommand(kText)
@@ -33,9 +46,7 @@ public:
         , mIsActionComplete(IsActionComplete)
     {
         // Save old state of object
-        CVectorOutStream Out(&mOldData, EEndian::SystemEndian);
-        CBasicBinaryWriter Writer(&Out, 0, EGame::Invalid);
-        mpObject->Serialize(Writer);
+        SaveState(mOldData);
     }
 
     /** IUndoCommand interface */
@@ -46,39 +57,38 @@ public:
 
     virtual void undo() override
     {
+        // Expired commands have no data left to restore
+        if (isObsolete())
+            return;
+
         // Restore old state of object
-        CMemoryInStream In(&mOldData[0], mOldData.size(), EEndian::SystemEndian);
-        CBasicBinaryReader Reader(&In, CSerialVersion(0,0,EGame::Invalid));
-        mpObject->Serialize(Reader);
+        RestoreState(mOldData);
     }
 
     virtual void redo() override
     {
+        if (isObsolete())
+            return;
+
         // First call when command is pushed - save new state of object
-        if (mNewData.empty())
+        if (mNewDelta.IsEmpty())
         {
-            CVectorOutStream Out(&mNewData, EEndian::SystemEndian);
-            CBasicBinaryWriter Writer(&Out, 0, EGame::Invalid);
-            mpObject->Serialize(Writer);
+            std::vector<char> NewData;
+            SaveState(NewData);
+            mNewDelta = CSnapshotDelta(mOldData, NewData);
 
             // Obsolete command if memory buffers match
-            if (mIsActionComplete)
+            if (mIsActionComplete && mNewDelta.MatchesBase())
             {
-                if (mOldData.size() == mNewData.size())
-                {
-                    if (memcmp(mOldData.data(), mNewData.data(), mNewData.size()) == 0)
-                    {
-                        setObsolete(true);
-                    }
-                }
+                setObsolete(true);
             }
         }
         // Subsequent calls - restore new state of object
         else
         {
-            CMemoryInStream In(&mNewData[0], mNewData.size(), EEndian::SystemEndian);
-            CBasicBinaryReader Reader(&In, CSerialVersion(0,0,EGame::Invalid));
-            mpObject->Serialize(Reader);
+            std::vector<char> NewData;
+            mNewDelta.Apply(mOldData, NewData);
+            RestoreState(NewData);
         }
     }
 
@@ -89,19 +99,16 @@ public:
             const TSerializeUndoCommand* pkSerializeCommand =
                     static_cast<const TSerializeUndoCommand*>(pkOther);
 
-            mNewData = pkSerializeCommand->mNewData;
+            // Re-encode the other command's new state against our old state
+            std::vector<char> NewData;
+            pkSerializeCommand->mNewDelta.Apply(pkSerializeCommand->mOldData, NewData);
+            mNewDelta = CSnapshotDelta(mOldData, NewData);
             mIsActionComplete = pkSerializeCommand->mIsActionComplete;
 
             // Obsolete command if memory buffers match
-            if (mIsActionComplete)
+            if (mIsActionComplete && mNewDelta.MatchesBase())
             {
-                if (mOldData.size() == mNewData.size())
-                {
-                    if (memcmp(mOldData.data(), mNewData.data(), mNewData.size()) == 0)
-                    {
-                        setObsolete(true);
-                    }
-                }
+                setObsolete(true);
             }
 
             return true;
@@ -113,6 +120,17 @@ public:
     {
         return true;
     }
+
+    virtual uint32 UndoMemoryUsage() const override
+    {
+        return mOldData.capacity() + mNewDelta.MemoryUsage();
+    }
+
+    virtual void ReleaseUndoData() override
+    {
+        std::vector<char>().swap(mOldData);
+        mNewDelta.Clear();
+    }
 };
 
 #endif // TSERIALIZEUNDOCOMMAND_H
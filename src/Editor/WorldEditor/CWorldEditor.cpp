@@ -22,6 +22,7 @@
 #include "Editor/Undo/UndoCommands.h"
 
 #include <Common/Log.h>
+#include <Core/GameProject/CAsyncResourceLoader.h>
 #include <Core/GameProject/CGameProject.h>
 #include <Core/Render/CDrawUtil.h>
 #include <Core/Resource/Script/NGameList.h>
@@ -247,6 +248,30 @@ bool CWorldEditor::CloseWorld()
     else return false;
 }
 
+void CWorldEditor::PrefetchArea(CWorld *pWorld, int AreaIndex)
+{
+    // Start loading the area and everything it uses in the background, so SetArea doesn't have to wait for it all
+    CResourceEntry *pAreaEntry = gpResourceStore->FindEntry( pWorld->AreaResourceID(AreaIndex) );
+    if (!pAreaEntry || pAreaEntry->IsLoaded()) return;
+
+    std::vector<CResourceEntry*> Entries;
+    Entries.push_back(pAreaEntry);
+
+    if (pAreaEntry->Dependencies())
+    {
+        std::set<CAssetID> DependencyIDs;
+        pAreaEntry->Dependencies()->GetAllResourceReferences(DependencyIDs);
+
+        for (const CAssetID& rkID : DependencyIDs)
+        {
+            CResourceEntry *pEntry = gpResourceStore->FindEntry(rkID);
+            if (pEntry) Entries.push_back(pEntry);
+        }
+    }
+
+    gpResourceStore->AsyncLoader()->Prefetch(Entries);
+}
+
 bool CWorldEditor::SetArea(CWorld *pWorld, int AreaIndex)
 {
     if (!CloseWorld())
@@ -85,6 +85,7 @@ public:
     ~CWorldEditor();
     bool CloseWorld();
     bool SetArea(CWorld *pWorld, int AreaIndex);
+    void PrefetchArea(CWorld *pWorld, int AreaIndex);
     void ResetCamera();
     bool HasAnyScriptNodesSelected() const;
     bool IsQuickplayEnabled() const;
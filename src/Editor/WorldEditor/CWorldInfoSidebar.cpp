@@ -134,6 +134,9 @@ void CWorldInfoSidebar::OnWorldTreeClicked(QModelIndex Index)
             QString Name = TO_QSTRING( pWorld->AreaInGameName(AttachedIdx) );
             mpUI->AttachedAreasList->addItem(Name);
         }
+
+        // The user will most likely open the area next, so start loading it now
+        Editor()->PrefetchArea(pWorld, AreaIndex);
     }
 }
 
@@ -4,6 +4,7 @@
 #include <Common/Log.h>
 
 #include <Core/NCoreTests.h>
+#include <Core/GameProject/CAsyncResourceLoader.h>
 #include <Core/Resource/Script/NGameList.h>
 
 #include <QApplication>
@@ -51,7 +52,8 @@ public:
         if (!Initialized) QMessageBox::warning(0, "Error", "Couldn't open log file. Logging will not work for this session.");
         qInstallMessageHandler(QtLogRedirect);
 
-        // Create editor resource store
+        // Create editor resource store. Background loads can only be cancelled from this thread.
+        CAsyncResourceLoader::SetMainThread();
         gpEditorStore = new CResourceStore("../resources/");
 
         if (!gpEditorStore->AreAllEntriesValid())